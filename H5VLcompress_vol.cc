@@ -34,7 +34,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <set>
 #include "connector_helpers.h"
+#include "compress_helpers.h"
+#include "selection_helpers.h"
 
 /* Public HDF5 file */
 #include "hdf5.h"
@@ -57,14 +60,132 @@
 #define va_copy(D, S) ((D) = (S))
 #endif
 
+/* Default number of uncompressed bytes per chunk */
+#define H5VL_COMPRESS_VOL_CHUNK_SIZE (1024 * 1024)
+
+/* Chunk index record identification */
+#define H5VL_COMPRESS_VOL_INDEX_MAGIC   0x58444943 /* "CIDX" */
+#define H5VL_COMPRESS_VOL_INDEX_VERSION 2
+
 /************/
 /* Typedefs */
 /************/
 
+/* Location of one compressed chunk in the under dataset */
+typedef struct H5VL_compress_vol_chunk_t {
+  uint64_t off_;            /* Byte offset of the frame */
+  uint64_t size_;           /* Frame size in bytes (0 = never written) */
+  uint32_t crc_;            /* CRC-32C of the frame */
+  uint8_t codec_;           /* Codec recorded in the frame header */
+} H5VL_compress_vol_chunk_t;
+
+/* Trailer at the very end of the under dataset, locating the newest
+ * index record. A record is the dataset metadata (datatype, dataspace,
+ * creation properties, chunk shape) followed by the chunk entries. Each
+ * entry is varint(size << 4 | codec) and, for written chunks, the
+ * zigzag-varint distance from the end of the previous frame plus the
+ * frame CRC. Frames are appended in chunk order, so that distance is
+ * almost always 0 and an entry costs about 8 bytes. */
+typedef struct H5VL_compress_vol_footer_t {
+  uint64_t meta_off_;       /* Offset of the index record */
+  uint32_t meta_size_;      /* Bytes of dataset metadata */
+  uint32_t entries_size_;   /* Bytes of encoded chunk entries */
+  uint32_t meta_crc_;       /* CRC-32C of the metadata */
+  uint32_t entries_crc_;    /* CRC-32C of the chunk entries */
+  uint32_t version_;        /* H5VL_COMPRESS_VOL_INDEX_VERSION */
+  uint32_t magic_;          /* H5VL_COMPRESS_VOL_INDEX_MAGIC */
+} H5VL_compress_vol_footer_t;
+
+/* Per-dataset chunk state. The under dataset is a 1-D, extendible byte
+ * stream holding compressed chunk frames and index records. Frames go to
+ * the best-fitting extent no index record on disk refers to any more,
+ * else are appended; the space of replaced frames and index records is
+ * freed once a newer index record is written, so the stream only grows
+ * past its live data by fragmentation. Space is allocated per process,
+ * so a dataset has a single writer; files opened for writing by several
+ * MPI ranks are refused. Chunks tile the logical dataspace on a regular
+ * n-D grid and are stored as full chunk-shaped arrays in row-major
+ * order, padded at the edges. Opened datasets load the metadata and the
+ * chunk entries lazily. */
+typedef struct H5VL_compress_vol_dset_t {
+  hid_t type_id_;           /* Logical datatype */
+  hid_t space_id_;          /* Logical dataspace */
+  hid_t dcpl_id_;           /* Creation properties given by the user */
+  size_t type_size_;        /* Bytes per element */
+  bool float_;              /* Elements are native float or double */
+  std::vector<hsize_t> dims_;        /* Dataset extent */
+  std::vector<hsize_t> chunk_dims_;  /* Chunk shape */
+  size_t chunk_elmts_;      /* Elements per chunk */
+  hsize_t nelmts_;          /* Elements in the dataset */
+  uint64_t end_;            /* Bytes in the under dataset */
+  std::vector<H5VL_compress_vol_chunk_t> chunks_;  /* Chunk index */
+  std::map<uint64_t, uint64_t> free_;  /* Unused extents, offset -> size */
+  std::set<std::pair<uint64_t, uint64_t>> free_sizes_;  /* The same as (size, offset), for best fit */
+  std::vector<std::pair<uint64_t, uint64_t>> released_;  /* Extents of replaced frames the newest index
+                                                          * record still refers to, as (offset, size) */
+  H5VL_compress_vol_footer_t footer_;  /* Footer of the newest index record */
+  bool meta_loaded_;        /* Datatype, dataspace and layout are known */
+  bool index_loaded_;       /* chunks_ is populated */
+  bool dirty_;              /* chunks_ changed since the last index record */
+} H5VL_compress_vol_dset_t;
+
+/* One chunk moving through the write pipeline */
+typedef struct H5VL_compress_vol_job_t {
+  size_t idx_;                                /* Chunk index */
+  const std::vector<h5::SelPair> *pieces_;    /* Selection pieces inside the chunk */
+  bool covered_;                              /* Selection overwrites the whole chunk */
+  std::vector<char> frame_;                   /* Old frame in, new frame out */
+  uint32_t crc_;                              /* CRC-32C of frame_ */
+  std::future<void> done_;                    /* Set once a worker finished the job */
+  bool ok_;                                   /* Job succeeded */
+} H5VL_compress_vol_job_t;
+
+/* One chunk moving through the read pipeline */
+typedef struct H5VL_compress_vol_read_job_t {
+  size_t idx_;                                /* Chunk index */
+  const std::vector<h5::SelPair> *pieces_;    /* Selection pieces inside the chunk */
+  std::shared_ptr<std::vector<char>> frames_; /* Coalesced frames holding this chunk */
+  size_t frame_off_;                          /* Offset of the frame in frames_ */
+  size_t frame_size_;                         /* Frame size (0 = never written) */
+  uint32_t crc_;                              /* Expected CRC-32C of the frame */
+  std::future<void> done_;                    /* Set once a worker finished the job */
+  bool ok_;                                   /* Job succeeded */
+  bool loose_;                                /* Failed: the frame's bound is looser than the reader's */
+} H5VL_compress_vol_read_job_t;
+
 /********************* */
 /* Function prototypes */
 /********************* */
 
+/* Helper routines */
+static H5VL_compress_vol_dset_t *H5VL_compress_vol_dset_new(hid_t type_id, hid_t space_id, hid_t dcpl_id,
+                                                            size_t chunk_size);
+static void   H5VL_compress_vol_dset_free(H5VL_compress_vol_dset_t *dset);
+static herr_t H5VL_compress_vol_dset_grid(H5VL_compress_vol_dset_t *dset);
+static hsize_t H5VL_compress_vol_chunk_valid(const H5VL_compress_vol_dset_t *dset, size_t idx);
+static herr_t H5VL_compress_vol_dset_load(H5VL_compress_vol_t *o, bool entries, hid_t dxpl_id);
+static herr_t H5VL_compress_vol_index_write(H5VL_compress_vol_t *o, hid_t dxpl_id);
+static herr_t H5VL_compress_vol_under_read(H5VL_compress_vol_t *o, uint64_t off, size_t size, void *buf,
+                                           hid_t dxpl_id);
+static herr_t H5VL_compress_vol_under_write(H5VL_compress_vol_t *o, uint64_t off, const void *buf, size_t size,
+                                            hid_t dxpl_id);
+static void   H5VL_compress_vol_extent_free(H5VL_compress_vol_dset_t *dset, uint64_t off, uint64_t size);
+static bool   H5VL_compress_vol_extent_alloc(H5VL_compress_vol_dset_t *dset, uint64_t size, uint64_t *off);
+static void   H5VL_compress_vol_chunk_set(H5VL_compress_vol_dset_t *dset, size_t idx,
+                                          const H5VL_compress_vol_chunk_t &chunk);
+static bool   H5VL_compress_vol_shared_write(unsigned flags, hid_t fapl_id);
+static herr_t H5VL_compress_vol_read_frame(H5VL_compress_vol_t *o, size_t idx, std::vector<char> &frame,
+                                           hid_t dxpl_id);
+static void   H5VL_compress_vol_run_job(H5VL_compress_vol_t *o, H5VL_compress_vol_job_t *job, const char *src);
+static void   H5VL_compress_vol_run_read_job(H5VL_compress_vol_t *o, H5VL_compress_vol_read_job_t *job,
+                                             char *dst);
+static void   H5VL_compress_vol_bound_error(const H5VL_compress_vol_t *o,
+                                            const H5VL_compress_vol_read_job_t *job);
+static herr_t H5VL_compress_vol_read_one(H5VL_compress_vol_t *o, hid_t mem_type_id, hid_t mem_space_id,
+                                         hid_t file_space_id, hid_t dxpl_id, void *buf);
+static herr_t H5VL_compress_vol_write_one(H5VL_compress_vol_t *o, hid_t mem_type_id, hid_t mem_space_id,
+                                          hid_t file_space_id, hid_t dxpl_id, const void *buf);
+
 /* "Management" callbacks */
 static herr_t H5VL_compress_vol_init(hid_t vipl_id);
 static herr_t H5VL_compress_vol_term(void);
@@ -352,6 +473,9 @@ static const H5VL_class_t H5VL_compress_vol_g = {
 /* The connector identification number, initialized at runtime */
 static hid_t H5VL_COMPRESS_VOL_g = H5I_INVALID_HID;
 
+/* Chunk compression workers, created with the first file */
+static h5::ThreadPool *H5VL_compress_vol_pool_g = nullptr;
+
 H5PL_type_t
 H5PLget_plugin_type(void) {
   return H5PL_TYPE_VOL;
@@ -431,6 +555,10 @@ H5VL_compress_vol_term(void)
   /* Reset VOL ID */
   H5VL_COMPRESS_VOL_g = H5I_INVALID_HID;
 
+  /* Stop the compression workers */
+  delete H5VL_compress_vol_pool_g;
+  H5VL_compress_vol_pool_g = nullptr;
+
   return 0;
 } /* end H5VL_compress_vol_term() */
 
@@ -515,13 +643,31 @@ H5VL_compress_vol_to_str(const void *_info, char **str)
 static herr_t
 H5VL_compress_vol_str_to_info(const char *str, void **_info)
 {
-  H5VL_compress_vol_t *info = (H5VL_compress_vol_t*)malloc(sizeof(H5VL_compress_vol_t));
+  H5VL_compress_vol_t *info = new H5VL_compress_vol_t();
   h5::ParseConn parser;
   parser.parse(str);
+  info->compress_method_ = h5::ParseMethod(parser.GetParam("method", "rle"));
+  info->shuffle_ = h5::ParseShuffle(parser.GetParam("shuffle", "auto"));
+  info->error_mode_ = h5::ParseErrorMode(parser.GetParam("error_mode", "abs"));
+  info->error_bound_ = strtod(parser.GetParam("error_bound", "0").c_str(), nullptr);
+  info->chunk_size_ = h5::ParseSize(parser.GetParam("chunk_size", std::to_string(H5VL_COMPRESS_VOL_CHUNK_SIZE)));
+  info->nthreads_ = h5::ParseSize(parser.GetParam("threads", std::to_string(std::thread::hardware_concurrency())));
+  info->fast_method_ = h5::ParseMethod(parser.GetParam("fast", "lz4"));
+  info->strong_method_ = h5::ParseMethod(parser.GetParam("strong", "zstd"));
+  info->raw_entropy_ = strtod(parser.GetParam("raw_entropy", "7.5").c_str(), nullptr);
+  info->fast_ratio_ = strtod(parser.GetParam("fast_ratio", "0.5").c_str(), nullptr);
+  info->sample_size_ = h5::ParseSize(parser.GetParam("sample", "64k"));
+  if (info->compress_method_ < 0 || info->shuffle_ < 0 || info->error_mode_ < 0 || info->error_bound_ < 0 ||
+      (info->compress_method_ == h5::kCompressLossy && info->error_bound_ == 0) || info->chunk_size_ == 0 || info->chunk_size_ > UINT32_MAX ||
+      info->fast_method_ < 0 || info->fast_method_ == h5::kCompressAuto ||
+      info->strong_method_ < 0 || info->strong_method_ == h5::kCompressAuto ||
+      info->raw_entropy_ <= 0 || info->fast_ratio_ <= 0 || info->sample_size_ == 0) {
+    delete info;
+    return -1;
+  }
   std::string next_vol_name = parser.GetNextVolName();
   std::string next_vol_params = parser.GetNextVolParams();
   info->next_vol_id_ = H5VLregister_connector_by_name(next_vol_name.c_str(), H5P_DEFAULT);
-  info->compress_method_ = 0;
   if (next_vol_params.size()) {
     H5VLconnector_str_to_info(next_vol_params.c_str(), info->next_vol_id_, (void **) &info->next_vol_info_);
   }
@@ -753,6 +899,927 @@ H5VL_compress_vol_attr_close(void *attr, hid_t dxpl_id, void **req)
   return 0;
 } /* end H5VL_compress_vol_attr_close() */
 
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_compress_vol_dset_new
+ *
+ * Purpose:     Create the chunk state for a dataset with the given logical
+ *              datatype and dataspace.
+ *
+ * Return:      Success:    Pointer to the new chunk state
+ *              Failure:    NULL
+ *
+ *-------------------------------------------------------------------------
+ */
+static H5VL_compress_vol_dset_t *
+H5VL_compress_vol_dset_new(hid_t type_id, hid_t space_id, hid_t dcpl_id, size_t chunk_size)
+{
+  H5VL_compress_vol_dset_t *dset = new H5VL_compress_vol_dset_t();
+  hssize_t nelmts = H5Sget_simple_extent_npoints(space_id);
+  int rank = H5Sget_simple_extent_ndims(space_id);
+  dset->type_size_ = H5Tget_size(type_id);
+  if (nelmts < 0 || rank < 0 || dset->type_size_ == 0) {
+    delete dset;
+    return nullptr;
+  }
+
+  /* Use the chunk shape the user asked for, else shrink the longest edge
+   * until a chunk holds about chunk_size bytes. Near-cubic chunks keep
+   * small n-D slices of large fields to a few chunks. */
+  if (rank == 0) {
+    dset->dims_.assign(1, 1);
+    dset->chunk_dims_.assign(1, 1);
+  } else {
+    dset->dims_.resize(rank);
+    dset->chunk_dims_.resize(rank);
+    H5Sget_simple_extent_dims(space_id, dset->dims_.data(), nullptr);
+    if (H5Pget_layout(dcpl_id) == H5D_CHUNKED) {
+      if (H5Pget_chunk(dcpl_id, rank, dset->chunk_dims_.data()) != rank) {
+        delete dset;
+        return nullptr;
+      }
+    } else {
+      hsize_t target = std::max<size_t>(chunk_size / dset->type_size_, 1), elmts = 1;
+      for (int d = 0; d < rank; d++) {
+        dset->chunk_dims_[d] = std::max<hsize_t>(dset->dims_[d], 1);
+        elmts *= dset->chunk_dims_[d];
+      }
+      while (elmts > target) {
+        int d = (int)(std::max_element(dset->chunk_dims_.begin(), dset->chunk_dims_.end()) -
+                      dset->chunk_dims_.begin());
+        elmts /= dset->chunk_dims_[d];
+        dset->chunk_dims_[d] = std::max<hsize_t>(1, (dset->chunk_dims_[d] + 1) / 2);
+        elmts *= dset->chunk_dims_[d];
+      }
+    }
+  }
+  dset->type_id_ = H5Tcopy(type_id);
+  dset->space_id_ = H5Scopy(space_id);
+  H5Sselect_all(dset->space_id_);
+  dset->dcpl_id_ = H5Pcopy(dcpl_id);
+  dset->float_ = H5Tequal(type_id, H5T_NATIVE_FLOAT) > 0 || H5Tequal(type_id, H5T_NATIVE_DOUBLE) > 0;
+  dset->nelmts_ = (hsize_t)nelmts;
+  dset->end_ = 0;
+  H5VL_compress_vol_dset_grid(dset);
+  dset->meta_loaded_ = true;
+  dset->index_loaded_ = true;
+  dset->dirty_ = true;
+  return dset;
+} /* end H5VL_compress_vol_dset_new() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_compress_vol_dset_free
+ *
+ * Purpose:     Release the chunk state of a dataset.
+ *
+ *-------------------------------------------------------------------------
+ */
+static void
+H5VL_compress_vol_dset_free(H5VL_compress_vol_dset_t *dset)
+{
+  if (dset == nullptr)
+    return;
+  if (dset->meta_loaded_) {
+    H5Tclose(dset->type_id_);
+    H5Sclose(dset->space_id_);
+    H5Pclose(dset->dcpl_id_);
+  }
+  delete dset;
+} /* end H5VL_compress_vol_dset_free() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_compress_vol_dset_grid
+ *
+ * Purpose:     Size the chunk index for the grid that dims_ and
+ *              chunk_dims_ describe.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1, a chunk edge is zero
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_compress_vol_dset_grid(H5VL_compress_vol_dset_t *dset)
+{
+  size_t nchunks = 1;
+
+  dset->chunk_elmts_ = 1;
+  for (size_t d = 0; d < dset->chunk_dims_.size(); d++) {
+    if (dset->chunk_dims_[d] == 0)
+      return -1;
+    dset->chunk_elmts_ *= dset->chunk_dims_[d];
+    nchunks *= (dset->dims_[d] + dset->chunk_dims_[d] - 1) / dset->chunk_dims_[d];
+  }
+  dset->chunks_.assign(nchunks, H5VL_compress_vol_chunk_t{});
+  return 0;
+} /* end H5VL_compress_vol_dset_grid() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_compress_vol_chunk_valid
+ *
+ * Purpose:     Count the elements of a chunk that lie inside the dataset.
+ *              Only chunks on the upper edges of the grid hold fewer than
+ *              chunk_elmts_.
+ *
+ * Return:      Number of elements
+ *
+ *-------------------------------------------------------------------------
+ */
+static hsize_t
+H5VL_compress_vol_chunk_valid(const H5VL_compress_vol_dset_t *dset, size_t idx)
+{
+  hsize_t valid = 1;
+
+  for (int d = (int)dset->dims_.size() - 1; d >= 0; --d) {
+    hsize_t grid = (dset->dims_[d] + dset->chunk_dims_[d] - 1) / dset->chunk_dims_[d];
+    hsize_t start = (idx % grid) * dset->chunk_dims_[d];
+    idx /= grid;
+    valid *= std::min<hsize_t>(dset->chunk_dims_[d], dset->dims_[d] - start);
+  }
+  return valid;
+} /* end H5VL_compress_vol_chunk_valid() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_compress_vol_dset_load
+ *
+ * Purpose:     Load the newest index record of an opened dataset. The
+ *              metadata is loaded on first use; the chunk entries only
+ *              when \a entries is set, i.e., on the first read or write.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_compress_vol_dset_load(H5VL_compress_vol_t *o, bool entries, hid_t dxpl_id)
+{
+  H5VL_compress_vol_dset_t *dset = o->dset_;
+  H5VL_compress_vol_footer_t &footer = dset->footer_;
+  std::vector<char> rec;
+  const char *p, *end;
+
+  if (!dset->meta_loaded_) {
+    H5VL_dataset_get_args_t args;
+    hsize_t extent;
+    uint32_t magic;
+    uint8_t version;
+    uint64_t rank, blob_size[3];
+    const char *blob[3];
+
+    /* Find the footer at the end of the byte stream */
+    args.op_type = H5VL_DATASET_GET_SPACE;
+    if (H5VLdataset_get(o->next_vol_info_, o->next_vol_id_, &args, dxpl_id, nullptr) < 0)
+      return -1;
+    H5Sget_simple_extent_dims(args.args.get_space.space_id, &extent, nullptr);
+    H5Sclose(args.args.get_space.space_id);
+    if (extent < sizeof(H5VL_compress_vol_footer_t))
+      return -1;
+    dset->end_ = extent;
+    if (H5VL_compress_vol_under_read(o, extent - sizeof(footer), sizeof(footer), &footer, dxpl_id) < 0)
+      return -1;
+    if (footer.magic_ != H5VL_COMPRESS_VOL_INDEX_MAGIC || footer.version_ != H5VL_COMPRESS_VOL_INDEX_VERSION)
+      return -1;
+
+    /* Decode the dataset metadata */
+    rec.resize(footer.meta_size_);
+    if (H5VL_compress_vol_under_read(o, footer.meta_off_, rec.size(), rec.data(), dxpl_id) < 0)
+      return -1;
+    if (h5::Crc32c(rec.data(), rec.size()) != footer.meta_crc_)
+      return -1;
+    p = rec.data();
+    end = p + rec.size();
+    if (!h5::GetFixed(p, end, magic) || !h5::GetFixed(p, end, version) || !h5::GetVarint(p, end, rank) ||
+        magic != H5VL_COMPRESS_VOL_INDEX_MAGIC || rank == 0 || rank > H5S_MAX_RANK)
+      return -1;
+    dset->chunk_dims_.resize(rank);
+    for (hsize_t &dim : dset->chunk_dims_) {
+      uint64_t v;
+      if (!h5::GetVarint(p, end, v))
+        return -1;
+      dim = v;
+    }
+    for (int i = 0; i < 3; ++i) {
+      if (!h5::GetVarint(p, end, blob_size[i]) || (uint64_t)(end - p) < blob_size[i])
+        return -1;
+      blob[i] = p;
+      p += blob_size[i];
+    }
+    dset->type_id_ = H5Tdecode(blob[0]);
+    dset->space_id_ = H5Sdecode(blob[1]);
+    dset->dcpl_id_ = H5Pdecode(blob[2]);
+    if (dset->type_id_ < 0 || dset->space_id_ < 0 || dset->dcpl_id_ < 0)
+      return -1;
+    dset->type_size_ = H5Tget_size(dset->type_id_);
+    dset->float_ = H5Tequal(dset->type_id_, H5T_NATIVE_FLOAT) > 0 || H5Tequal(dset->type_id_, H5T_NATIVE_DOUBLE) > 0;
+    dset->nelmts_ = (hsize_t)H5Sget_simple_extent_npoints(dset->space_id_);
+    dset->dims_.assign(rank, 1);
+    if (H5Sget_simple_extent_ndims(dset->space_id_) > 0 &&
+        (H5Sget_simple_extent_ndims(dset->space_id_) != (int)rank ||
+         H5Sget_simple_extent_dims(dset->space_id_, dset->dims_.data(), nullptr) < 0))
+      return -1;
+    if (H5VL_compress_vol_dset_grid(dset) < 0)
+      return -1;
+    dset->meta_loaded_ = true;
+  }
+
+  if (entries && !dset->index_loaded_) {
+    uint64_t nchunks, expect = 0;
+
+    rec.resize(footer.entries_size_);
+    if (H5VL_compress_vol_under_read(o, footer.meta_off_ + footer.meta_size_, rec.size(), rec.data(), dxpl_id) < 0)
+      return -1;
+    if (h5::Crc32c(rec.data(), rec.size()) != footer.entries_crc_)
+      return -1;
+    p = rec.data();
+    end = p + rec.size();
+    if (!h5::GetVarint(p, end, nchunks) || nchunks != dset->chunks_.size())
+      return -1;
+    for (H5VL_compress_vol_chunk_t &chunk : dset->chunks_) {
+      uint64_t size_codec, delta;
+      if (!h5::GetVarint(p, end, size_codec))
+        return -1;
+      chunk.size_ = size_codec >> 4;
+      chunk.codec_ = (uint8_t)(size_codec & 0xF);
+      if (chunk.size_ == 0)
+        continue;
+      if (!h5::GetVarint(p, end, delta) || !h5::GetFixed(p, end, chunk.crc_))
+        return -1;
+      chunk.off_ = expect + h5::UnZigZag(delta);
+      expect = chunk.off_ + chunk.size_;
+    }
+
+    /* Whatever lies between the frames and before the index record is free */
+    std::vector<std::pair<uint64_t, uint64_t>> used = {{footer.meta_off_, dset->end_ - footer.meta_off_}};
+    uint64_t pos = 0;
+    for (H5VL_compress_vol_chunk_t &chunk : dset->chunks_)
+      if (chunk.size_ != 0)
+        used.emplace_back(chunk.off_, chunk.size_);
+    std::sort(used.begin(), used.end());
+    for (auto &it : used) {
+      if (it.first > pos)
+        H5VL_compress_vol_extent_free(dset, pos, it.first - pos);
+      pos = std::max(pos, it.first + it.second);
+    }
+    dset->index_loaded_ = true;
+  }
+  return 0;
+} /* end H5VL_compress_vol_dset_load() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_compress_vol_index_write
+ *
+ * Purpose:     Append a new index record and footer to the under dataset.
+ *              The earlier record and the frames it alone referred to
+ *              become free space.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_compress_vol_index_write(H5VL_compress_vol_t *o, hid_t dxpl_id)
+{
+  H5VL_compress_vol_dset_t *dset = o->dset_;
+  H5VL_compress_vol_footer_t footer;
+  std::vector<char> rec;
+  uint64_t expect = 0;
+  size_t blob_size;
+
+  /* Dataset metadata */
+  h5::PutFixed<uint32_t>(rec, H5VL_COMPRESS_VOL_INDEX_MAGIC);
+  h5::PutFixed<uint8_t>(rec, H5VL_COMPRESS_VOL_INDEX_VERSION);
+  h5::PutVarint(rec, dset->chunk_dims_.size());
+  for (hsize_t dim : dset->chunk_dims_)
+    h5::PutVarint(rec, dim);
+  blob_size = 0;
+  H5Tencode(dset->type_id_, nullptr, &blob_size);
+  h5::PutVarint(rec, blob_size);
+  rec.resize(rec.size() + blob_size);
+  if (H5Tencode(dset->type_id_, rec.data() + rec.size() - blob_size, &blob_size) < 0)
+    return -1;
+  blob_size = 0;
+  H5Sencode2(dset->space_id_, nullptr, &blob_size, H5P_DEFAULT);
+  h5::PutVarint(rec, blob_size);
+  rec.resize(rec.size() + blob_size);
+  if (H5Sencode2(dset->space_id_, rec.data() + rec.size() - blob_size, &blob_size, H5P_DEFAULT) < 0)
+    return -1;
+  blob_size = 0;
+  H5Pencode2(dset->dcpl_id_, nullptr, &blob_size, H5P_DEFAULT);
+  h5::PutVarint(rec, blob_size);
+  rec.resize(rec.size() + blob_size);
+  if (H5Pencode2(dset->dcpl_id_, rec.data() + rec.size() - blob_size, &blob_size, H5P_DEFAULT) < 0)
+    return -1;
+  footer.meta_off_ = dset->end_;
+  footer.meta_size_ = (uint32_t)rec.size();
+
+  /* Chunk entries */
+  h5::PutVarint(rec, dset->chunks_.size());
+  for (H5VL_compress_vol_chunk_t &chunk : dset->chunks_) {
+    h5::PutVarint(rec, chunk.size_ << 4 | chunk.codec_);
+    if (chunk.size_ == 0)
+      continue;
+    h5::PutVarint(rec, h5::ZigZag((int64_t)(chunk.off_ - expect)));
+    h5::PutFixed<uint32_t>(rec, chunk.crc_);
+    expect = chunk.off_ + chunk.size_;
+  }
+  footer.entries_size_ = (uint32_t)(rec.size() - footer.meta_size_);
+  footer.meta_crc_ = h5::Crc32c(rec.data(), footer.meta_size_);
+  footer.entries_crc_ = h5::Crc32c(rec.data() + footer.meta_size_, footer.entries_size_);
+  footer.version_ = H5VL_COMPRESS_VOL_INDEX_VERSION;
+  footer.magic_ = H5VL_COMPRESS_VOL_INDEX_MAGIC;
+  rec.insert(rec.end(), (char *)&footer, (char *)&footer + sizeof(footer));
+
+  if (H5VL_compress_vol_under_write(o, dset->end_, rec.data(), rec.size(), dxpl_id) < 0)
+    return -1;
+  if (dset->footer_.magic_ == H5VL_COMPRESS_VOL_INDEX_MAGIC)
+    H5VL_compress_vol_extent_free(dset, dset->footer_.meta_off_,
+                                  (uint64_t)dset->footer_.meta_size_ + dset->footer_.entries_size_ +
+                                      sizeof(H5VL_compress_vol_footer_t));
+  for (auto &it : dset->released_)
+    H5VL_compress_vol_extent_free(dset, it.first, it.second);
+  dset->released_.clear();
+  dset->footer_ = footer;
+  dset->dirty_ = false;
+  return 0;
+} /* end H5VL_compress_vol_index_write() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_compress_vol_under_read
+ *
+ * Purpose:     Read a byte range of the under dataset.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_compress_vol_under_read(H5VL_compress_vol_t *o, uint64_t off, size_t size, void *buf, hid_t dxpl_id)
+{
+  hsize_t extent = o->dset_->end_, start = off, count = size;
+  hid_t type_id = H5T_NATIVE_UINT8;
+  hid_t file_space_id = H5Screate_simple(1, &extent, nullptr);
+  hid_t mem_space_id = H5Screate_simple(1, &count, nullptr);
+  void *under = o->next_vol_info_;
+  herr_t ret_value;
+
+  H5Sselect_hyperslab(file_space_id, H5S_SELECT_SET, &start, nullptr, &count, nullptr);
+  ret_value = H5VLdataset_read(1, &under, o->next_vol_id_, &type_id, &mem_space_id, &file_space_id,
+                               dxpl_id, &buf, nullptr);
+  H5Sclose(file_space_id);
+  H5Sclose(mem_space_id);
+  return ret_value;
+} /* end H5VL_compress_vol_under_read() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_compress_vol_under_write
+ *
+ * Purpose:     Write a byte range of the under dataset, growing it first
+ *              if the range ends past it.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_compress_vol_under_write(H5VL_compress_vol_t *o, uint64_t off, const void *buf, size_t size,
+                              hid_t dxpl_id)
+{
+  hsize_t start = off, count = size, extent = std::max<hsize_t>(o->dset_->end_, start + count);
+  hid_t type_id = H5T_NATIVE_UINT8;
+  hid_t file_space_id, mem_space_id;
+  void *under = o->next_vol_info_;
+  H5VL_dataset_specific_args_t args;
+  herr_t ret_value;
+
+  if (size == 0)
+    return 0;
+  args.op_type = H5VL_DATASET_SET_EXTENT;
+  args.args.set_extent.size = &extent;
+  if (extent > o->dset_->end_ &&
+      H5VLdataset_specific(under, o->next_vol_id_, &args, dxpl_id, nullptr) < 0)
+    return -1;
+
+  file_space_id = H5Screate_simple(1, &extent, nullptr);
+  mem_space_id = H5Screate_simple(1, &count, nullptr);
+  H5Sselect_hyperslab(file_space_id, H5S_SELECT_SET, &start, nullptr, &count, nullptr);
+  ret_value = H5VLdataset_write(1, &under, o->next_vol_id_, &type_id, &mem_space_id, &file_space_id,
+                                dxpl_id, &buf, nullptr);
+  H5Sclose(file_space_id);
+  H5Sclose(mem_space_id);
+  if (ret_value >= 0)
+    o->dset_->end_ = extent;
+  return ret_value;
+} /* end H5VL_compress_vol_under_write() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_compress_vol_extent_free
+ *
+ * Purpose:     Add an extent of the under dataset to the free space,
+ *              merging it with free neighbors.
+ *
+ *-------------------------------------------------------------------------
+ */
+static void
+H5VL_compress_vol_extent_free(H5VL_compress_vol_dset_t *dset, uint64_t off, uint64_t size)
+{
+  auto next = dset->free_.lower_bound(off);
+
+  if (size == 0)
+    return;
+  if (next != dset->free_.begin()) {
+    auto prev = std::prev(next);
+    if (prev->first + prev->second == off) {
+      off = prev->first;
+      size += prev->second;
+      dset->free_sizes_.erase({prev->second, prev->first});
+      dset->free_.erase(prev);
+    }
+  }
+  if (next != dset->free_.end() && off + size == next->first) {
+    size += next->second;
+    dset->free_sizes_.erase({next->second, next->first});
+    dset->free_.erase(next);
+  }
+  dset->free_[off] = size;
+  dset->free_sizes_.insert({size, off});
+} /* end H5VL_compress_vol_extent_free() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_compress_vol_extent_alloc
+ *
+ * Purpose:     Take \a size bytes from the smallest free extent that
+ *              holds them, setting *off to their offset.
+ *
+ * Return:      True if a free extent was large enough
+ *
+ *-------------------------------------------------------------------------
+ */
+static bool
+H5VL_compress_vol_extent_alloc(H5VL_compress_vol_dset_t *dset, uint64_t size, uint64_t *off)
+{
+  auto fit = dset->free_sizes_.lower_bound({size, 0});
+  uint64_t left;
+
+  if (fit == dset->free_sizes_.end())
+    return false;
+  *off = fit->second;
+  left = fit->first - size;
+  dset->free_.erase(fit->second);
+  dset->free_sizes_.erase(fit);
+  if (left != 0) {
+    dset->free_[*off + size] = left;
+    dset->free_sizes_.insert({left, *off + size});
+  }
+  return true;
+} /* end H5VL_compress_vol_extent_alloc() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_compress_vol_chunk_set
+ *
+ * Purpose:     Point a chunk's index entry at its new frame. The old
+ *              frame is released with the next index record.
+ *
+ *-------------------------------------------------------------------------
+ */
+static void
+H5VL_compress_vol_chunk_set(H5VL_compress_vol_dset_t *dset, size_t idx, const H5VL_compress_vol_chunk_t &chunk)
+{
+  H5VL_compress_vol_chunk_t &old = dset->chunks_[idx];
+
+  if (old.size_ != 0)
+    dset->released_.emplace_back(old.off_, old.size_);
+  old = chunk;
+  dset->dirty_ = true;
+} /* end H5VL_compress_vol_chunk_set() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_compress_vol_shared_write
+ *
+ * Purpose:     Whether a file is opened with write intent by several MPI
+ *              ranks, which would allocate overlapping space in the under
+ *              datasets.
+ *
+ * Return:      True if so
+ *
+ *-------------------------------------------------------------------------
+ */
+static bool
+H5VL_compress_vol_shared_write(unsigned flags, hid_t fapl_id)
+{
+#ifdef H5_HAVE_PARALLEL
+  MPI_Comm comm = MPI_COMM_NULL;
+  MPI_Info info = MPI_INFO_NULL;
+  int nranks = 1;
+
+  if (!(flags & (H5F_ACC_RDWR | H5F_ACC_TRUNC | H5F_ACC_EXCL)) || H5Pget_driver(fapl_id) != H5FD_MPIO ||
+      H5Pget_fapl_mpio(fapl_id, &comm, &info) < 0)
+    return false;
+  MPI_Comm_size(comm, &nranks);
+  MPI_Comm_free(&comm);
+  if (info != MPI_INFO_NULL)
+    MPI_Info_free(&info);
+  return nranks > 1;
+#else
+  return false;
+#endif
+} /* end H5VL_compress_vol_shared_write() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_compress_vol_read_frame
+ *
+ * Purpose:     Fetch the compressed frame of one chunk. Chunks that were
+ *              never written yield an empty frame.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_compress_vol_read_frame(H5VL_compress_vol_t *o, size_t idx, std::vector<char> &frame, hid_t dxpl_id)
+{
+  H5VL_compress_vol_chunk_t &chunk = o->dset_->chunks_[idx];
+
+  frame.resize(chunk.size_);
+  if (chunk.size_ == 0)
+    return 0;
+  return H5VL_compress_vol_under_read(o, chunk.off_, chunk.size_, frame.data(), dxpl_id);
+} /* end H5VL_compress_vol_read_frame() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_compress_vol_run_read_job
+ *
+ * Purpose:     Worker side of the read pipeline: decompress one chunk and
+ *              copy the selected pieces of it to their destination.
+ *
+ *-------------------------------------------------------------------------
+ */
+static void
+H5VL_compress_vol_run_read_job(H5VL_compress_vol_t *o, H5VL_compress_vol_read_job_t *job, char *dst)
+{
+  static thread_local std::vector<char> raw;
+  H5VL_compress_vol_dset_t *dset = o->dset_;
+  size_t type_size = dset->type_size_;
+  size_t nbytes = dset->chunk_elmts_ * type_size;
+  const char *frame = job->frames_->data() + job->frame_off_;
+  const char *chunk;
+
+  job->ok_ = false;
+  if (job->frame_size_ != 0 && h5::Crc32c(frame, job->frame_size_) != job->crc_)
+    return;
+  /* Refuse data that was written with a looser bound than this reader allows */
+  job->loose_ = job->frame_size_ != 0 && !h5::WithinBound(frame, job->frame_size_, o->error_mode_, o->error_bound_);
+  if (job->loose_)
+    return;
+  if (job->frame_size_ == 0) {
+    raw.assign(nbytes, 0);
+    chunk = raw.data();
+  } else if ((chunk = h5::RawPayload(frame, job->frame_size_)) == nullptr) {
+    if (!h5::decompress(frame, job->frame_size_, raw) || raw.size() != nbytes)
+      return;
+    chunk = raw.data();
+  }
+  for (const h5::SelPair &piece : *job->pieces_)
+    memcpy(dst + piece.mem_off_ * type_size, chunk + piece.file_off_ * type_size,
+           piece.len_ * type_size);
+  job->ok_ = true;
+} /* end H5VL_compress_vol_run_read_job() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_compress_vol_bound_error
+ *
+ * Purpose:     Push an error naming the bound a refused chunk was written
+ *              with and the bound the reader allows, so the caller can
+ *              tell what to open the file with instead.
+ *
+ *-------------------------------------------------------------------------
+ */
+static void
+H5VL_compress_vol_bound_error(const H5VL_compress_vol_t *o, const H5VL_compress_vol_read_job_t *job)
+{
+  const char *modes[] = {"abs", "rel"};
+  int mode = 0;
+  double bound = 0, abs_bound = 0;
+
+  h5::FrameBound(job->frames_->data() + job->frame_off_, job->frame_size_, &mode, &bound, &abs_bound);
+  if (o->error_bound_ <= 0) {
+    H5Epush2(H5E_DEFAULT, __FILE__, __func__, __LINE__, H5E_ERR_CLS, H5E_DATASET, H5E_READERROR,
+             "chunk %zu was written with a %s error bound of %g (absolute %g), but this reader was not given an "
+             "error_bound and only accepts lossless chunks",
+             job->idx_, modes[mode == h5::kErrorRel], bound, abs_bound);
+    return;
+  }
+  H5Epush2(H5E_DEFAULT, __FILE__, __func__, __LINE__, H5E_ERR_CLS, H5E_DATASET, H5E_READERROR,
+           "chunk %zu was written with a %s error bound of %g (absolute %g), looser than the %s bound of %g "
+           "this reader allows",
+           job->idx_, modes[mode == h5::kErrorRel], bound, abs_bound, modes[o->error_mode_ == h5::kErrorRel],
+           o->error_bound_);
+} /* end H5VL_compress_vol_bound_error() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_compress_vol_read_one
+ *
+ * Purpose:     Read a selection of one dataset. Only the chunks that
+ *              overlap the selection are fetched, with frames that are
+ *              adjacent in the under dataset read together. The workers
+ *              decompress them in parallel and scatter the selected
+ *              pieces straight into the user buffer, unless a datatype
+ *              conversion forces a staging buffer.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_compress_vol_read_one(H5VL_compress_vol_t *o, hid_t mem_type_id, hid_t mem_space_id,
+                           hid_t file_space_id, hid_t dxpl_id, void *buf)
+{
+  H5VL_compress_vol_dset_t *dset = o->dset_;
+  h5::ThreadPool *pool = H5VL_compress_vol_pool_g;
+  size_t window = pool ? 2 * pool->Size() : 1;
+  size_t type_size;
+  bool convert;
+  std::vector<h5::SelPair> pairs, staged;
+  std::map<size_t, std::vector<h5::SelPair>> chunks;
+  std::deque<H5VL_compress_vol_read_job_t> inflight;
+  std::vector<char> packed;
+  char *dst = (char *)buf;
+  hsize_t npoints = 0;
+  herr_t ret_value = 0;
+
+  if (H5VL_compress_vol_dset_load(o, true, dxpl_id) < 0)
+    return -1;
+  type_size = dset->type_size_;
+  convert = H5Tequal(mem_type_id, dset->type_id_) <= 0;
+  h5::ResolveSpaces(dset->space_id_, file_space_id, mem_space_id);
+  if (h5::PairSelections(file_space_id, mem_space_id, pairs) < 0)
+    return -1;
+
+  /* A conversion needs the selection staged densely in the file datatype */
+  if (convert) {
+    staged = pairs;
+    for (h5::SelPair &pair : staged) {
+      pair.mem_off_ = npoints;
+      npoints += pair.len_;
+    }
+    packed.resize(npoints * std::max(type_size, H5Tget_size(mem_type_id)));
+    dst = packed.data();
+  }
+  h5::SplitByChunkGrid(convert ? staged : pairs, dset->dims_, dset->chunk_dims_, chunks);
+
+  auto next = chunks.begin();
+  while (next != chunks.end() || !inflight.empty()) {
+    /* Refill with a run of chunks whose frames are adjacent on disk */
+    if (ret_value >= 0 && next != chunks.end() && inflight.size() <= window / 2) {
+      std::vector<std::map<size_t, std::vector<h5::SelPair>>::iterator> run;
+      uint64_t run_off = 0, run_size = 0;
+      for (; next != chunks.end() && inflight.size() + run.size() < window; ++next) {
+        H5VL_compress_vol_chunk_t &chunk = dset->chunks_[next->first];
+        if (chunk.size_ && run_size && chunk.off_ != run_off + run_size)
+          break;
+        if (chunk.size_ && !run_size)
+          run_off = chunk.off_;
+        run_size += chunk.size_;
+        run.push_back(next);
+      }
+      auto frames = std::make_shared<std::vector<char>>(run_size);
+      if (run_size && H5VL_compress_vol_under_read(o, run_off, run_size, frames->data(), dxpl_id) < 0) {
+        ret_value = -1;
+        run.clear();
+      }
+      for (auto &it : run) {
+        H5VL_compress_vol_chunk_t &chunk = dset->chunks_[it->first];
+        inflight.emplace_back();
+        H5VL_compress_vol_read_job_t *job = &inflight.back();
+        job->idx_ = it->first;
+        job->pieces_ = &it->second;
+        job->frames_ = frames;
+        job->frame_off_ = chunk.size_ ? chunk.off_ - run_off : 0;
+        job->frame_size_ = chunk.size_;
+        job->crc_ = chunk.crc_;
+        job->ok_ = false;
+        job->loose_ = false;
+        if (pool)
+          job->done_ = pool->Submit([o, job, dst]() { H5VL_compress_vol_run_read_job(o, job, dst); });
+        else
+          H5VL_compress_vol_run_read_job(o, job, dst);
+      }
+    }
+    if (inflight.empty())
+      break;
+
+    H5VL_compress_vol_read_job_t &job = inflight.front();
+    if (job.done_.valid())
+      job.done_.wait();
+    if (job.loose_)
+      H5VL_compress_vol_bound_error(o, &job);
+    if (!job.ok_)
+      ret_value = -1;
+    inflight.pop_front();
+  }
+  if (ret_value < 0)
+    return -1;
+
+  if (convert) {
+    if (H5Tconvert(dset->type_id_, mem_type_id, npoints, packed.data(), nullptr, H5P_DEFAULT) < 0)
+      return -1;
+    h5::UnpackPairs(packed.data(), pairs, H5Tget_size(mem_type_id), buf);
+  }
+  return 0;
+} /* end H5VL_compress_vol_read_one() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_compress_vol_run_job
+ *
+ * Purpose:     Worker side of the write pipeline: rebuild one chunk from
+ *              its old frame and the new data, then compress it. Only
+ *              touches memory, never the HDF5 library.
+ *
+ *-------------------------------------------------------------------------
+ */
+static void
+H5VL_compress_vol_run_job(H5VL_compress_vol_t *o, H5VL_compress_vol_job_t *job, const char *src)
+{
+  static thread_local std::vector<char> raw;
+  H5VL_compress_vol_dset_t *dset = o->dset_;
+  size_t type_size = dset->type_size_;
+  size_t nbytes = dset->chunk_elmts_ * type_size;
+  h5::AdaptivePolicy policy{o->fast_method_, o->strong_method_, o->raw_entropy_, o->fast_ratio_, o->sample_size_};
+
+  job->ok_ = false;
+
+  /* Without a codec the frame is just a header and the raw chunk, so the
+   * pieces go straight from the caller's buffer into it */
+  if (o->compress_method_ == h5::kCompressNone) {
+    char *payload = nullptr;
+    if (!job->covered_ && !job->frame_.empty()) {
+      if (h5::Crc32c(job->frame_.data(), job->frame_.size()) != job->crc_)
+        return;
+      payload = (char *)h5::RawPayload(job->frame_.data(), job->frame_.size());
+    }
+    if (payload == nullptr && (job->covered_ || job->frame_.empty())) {
+      h5::ChunkHeader hdr{};
+      hdr.codec_ = h5::kCompressNone;
+      hdr.elmt_size_ = 1;
+      hdr.payload_size_ = hdr.raw_size_ = (uint32_t)nbytes;
+      job->frame_.resize(sizeof(hdr) + nbytes);
+      memcpy(job->frame_.data(), &hdr, sizeof(hdr));
+      payload = job->frame_.data() + sizeof(hdr);
+    }
+    if (payload != nullptr && job->frame_.size() == sizeof(h5::ChunkHeader) + nbytes) {
+      for (const h5::SelPair &piece : *job->pieces_)
+        memcpy(payload + piece.file_off_ * type_size, src + piece.mem_off_ * type_size,
+               piece.len_ * type_size);
+      job->crc_ = h5::Crc32c(job->frame_.data(), job->frame_.size());
+      job->ok_ = true;
+      return;
+    }
+  }
+
+  /* Edge chunks keep their padding zeroed so it compresses away */
+  if (job->covered_ && H5VL_compress_vol_chunk_valid(dset, job->idx_) == dset->chunk_elmts_)
+    raw.resize(nbytes);
+  else if (job->covered_ || job->frame_.empty())
+    raw.assign(nbytes, 0);
+  else if (h5::Crc32c(job->frame_.data(), job->frame_.size()) != job->crc_ ||
+           !h5::decompress(job->frame_.data(), job->frame_.size(), raw) || raw.size() != nbytes)
+    return;
+  for (const h5::SelPair &piece : *job->pieces_)
+    memcpy(raw.data() + piece.file_off_ * type_size, src + piece.mem_off_ * type_size,
+           piece.len_ * type_size);
+  if (o->compress_method_ == h5::kCompressLossy && dset->float_)
+    h5::compress_lossy(o->error_mode_, o->error_bound_, raw.data(), nbytes, type_size, job->frame_);
+  else
+    h5::compress(o->compress_method_, o->shuffle_, raw.data(), nbytes, type_size, job->frame_, &policy);
+  job->crc_ = h5::Crc32c(job->frame_.data(), job->frame_.size());
+  job->ok_ = true;
+} /* end H5VL_compress_vol_run_job() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_compress_vol_write_one
+ *
+ * Purpose:     Write a selection of one dataset. The chunks it touches are
+ *              compressed by the worker pool, a bounded window at a time,
+ *              while this thread stores finished frames in chunk order:
+ *              in free space where one fits, else appended to the under
+ *              dataset.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_compress_vol_write_one(H5VL_compress_vol_t *o, hid_t mem_type_id, hid_t mem_space_id,
+                            hid_t file_space_id, hid_t dxpl_id, const void *buf)
+{
+  H5VL_compress_vol_dset_t *dset = o->dset_;
+  h5::ThreadPool *pool = H5VL_compress_vol_pool_g;
+  size_t window = pool ? 2 * pool->Size() : 1;
+  size_t type_size;
+  std::vector<h5::SelPair> pairs;
+  std::map<size_t, std::vector<h5::SelPair>> chunks;
+  std::deque<H5VL_compress_vol_job_t> inflight;
+  std::vector<char> packed, frames;
+  std::vector<std::pair<size_t, H5VL_compress_vol_chunk_t>> written;
+  const char *src = (const char *)buf;
+  herr_t ret_value = 0;
+
+  if (H5VL_compress_vol_dset_load(o, true, dxpl_id) < 0)
+    return -1;
+  type_size = dset->type_size_;
+  h5::ResolveSpaces(dset->space_id_, file_space_id, mem_space_id);
+  if (h5::PairSelections(file_space_id, mem_space_id, pairs) < 0)
+    return -1;
+
+  /* Convert to the file datatype if needed */
+  if (H5Tequal(mem_type_id, dset->type_id_) <= 0) {
+    size_t mem_type_size = H5Tget_size(mem_type_id);
+    hsize_t npoints = 0;
+    for (h5::SelPair &pair : pairs)
+      npoints += pair.len_;
+    packed.resize(npoints * std::max(type_size, mem_type_size));
+    h5::PackPairs(buf, pairs, mem_type_size, packed.data());
+    if (H5Tconvert(mem_type_id, dset->type_id_, npoints, packed.data(), nullptr, H5P_DEFAULT) < 0)
+      return -1;
+    src = packed.data();
+  }
+
+  h5::SplitByChunkGrid(pairs, dset->dims_, dset->chunk_dims_, chunks);
+  auto next = chunks.begin();
+  while (next != chunks.end() || !inflight.empty()) {
+    /* Keep the workers busy. Old frames of partially written chunks are
+     * fetched here since only this thread may call into HDF5. */
+    while (ret_value >= 0 && next != chunks.end() && inflight.size() < window) {
+      size_t covered = 0;
+      inflight.emplace_back();
+      H5VL_compress_vol_job_t *job = &inflight.back();
+      job->idx_ = next->first;
+      job->pieces_ = &next->second;
+      for (const h5::SelPair &piece : next->second)
+        covered += piece.len_;
+      job->covered_ = covered == H5VL_compress_vol_chunk_valid(dset, job->idx_);
+      job->crc_ = dset->chunks_[job->idx_].crc_;
+      job->ok_ = false;
+      ++next;
+      if (!job->covered_ && H5VL_compress_vol_read_frame(o, job->idx_, job->frame_, dxpl_id) < 0) {
+        ret_value = -1;
+        break;
+      }
+      if (pool)
+        job->done_ = pool->Submit([o, job, src]() { H5VL_compress_vol_run_job(o, job, src); });
+      else
+        H5VL_compress_vol_run_job(o, job, src);
+    }
+    if (inflight.empty())
+      break;
+
+    /* Retire the oldest job so frames land in chunk order */
+    H5VL_compress_vol_job_t &job = inflight.front();
+    if (job.done_.valid())
+      job.done_.wait();
+    if (ret_value >= 0 && job.ok_) {
+      H5VL_compress_vol_chunk_t chunk = {0, job.frame_.size(), job.crc_, (uint8_t)job.frame_[0]};
+
+      /* Refill freed space first; the rest is appended in batches */
+      if (H5VL_compress_vol_extent_alloc(dset, chunk.size_, &chunk.off_)) {
+        if (H5VL_compress_vol_under_write(o, chunk.off_, job.frame_.data(), chunk.size_, dxpl_id) < 0) {
+          H5VL_compress_vol_extent_free(dset, chunk.off_, chunk.size_);
+          ret_value = -1;
+        } else {
+          H5VL_compress_vol_chunk_set(dset, job.idx_, chunk);
+        }
+      } else {
+        chunk.off_ = dset->end_ + frames.size();
+        written.emplace_back(job.idx_, chunk);
+        frames.insert(frames.end(), job.frame_.begin(), job.frame_.end());
+      }
+    } else {
+      ret_value = -1;
+    }
+    inflight.pop_front();
+
+    /* Stream out a batch once it is large enough, or at the end */
+    if (ret_value >= 0 && !frames.empty() &&
+        (frames.size() >= o->chunk_size_ || (inflight.empty() && next == chunks.end()))) {
+      if (H5VL_compress_vol_under_write(o, dset->end_, frames.data(), frames.size(), dxpl_id) < 0) {
+        ret_value = -1;
+        continue;
+      }
+      for (auto &it : written)
+        H5VL_compress_vol_chunk_set(dset, it.first, it.second);
+      written.clear();
+      frames.clear();
+    }
+  }
+
+  return ret_value;
+} /* end H5VL_compress_vol_write_one() */
+
 /*-------------------------------------------------------------------------
  * Function:    H5VL_compress_vol_dataset_create
  *
@@ -770,8 +1837,28 @@ H5VL_compress_vol_dataset_create(void *obj, const H5VL_loc_params_t *loc_params,
 {
   H5VL_compress_vol_t *o = (H5VL_compress_vol_t *)obj;
   H5VL_compress_vol_t *new_obj = new H5VL_compress_vol_t(*o);
-  new_obj->next_vol_info_ = H5VLdataset_create(o->next_vol_info_, loc_params, o->next_vol_id_, name, lcpl_id, type_id, space_id,
-                                               dcpl_id, dapl_id, dxpl_id, req);
+  hsize_t zero = 0, unlimited = H5S_UNLIMITED, under_chunk = o->chunk_size_;
+  hid_t under_space_id = H5Screate_simple(1, &zero, &unlimited);
+  hid_t under_dcpl_id = H5Pcreate(H5P_DATASET_CREATE);
+
+  /* The under dataset only ever holds compressed frames */
+  H5Pset_chunk(under_dcpl_id, 1, &under_chunk);
+  new_obj->next_vol_info_ = H5VLdataset_create(o->next_vol_info_, loc_params, o->next_vol_id_, name, lcpl_id,
+                                               H5T_NATIVE_UINT8, under_space_id, under_dcpl_id, dapl_id, dxpl_id,
+                                               req);
+  H5Sclose(under_space_id);
+  H5Pclose(under_dcpl_id);
+  if (new_obj->next_vol_info_ == nullptr) {
+    delete new_obj;
+    return nullptr;
+  }
+  new_obj->dset_ = H5VL_compress_vol_dset_new(type_id, space_id, dcpl_id, o->chunk_size_);
+  if (new_obj->dset_ == nullptr || H5VL_compress_vol_index_write(new_obj, dxpl_id) < 0) {
+    H5VL_compress_vol_dset_free(new_obj->dset_);
+    H5VLdataset_close(new_obj->next_vol_info_, new_obj->next_vol_id_, dxpl_id, nullptr);
+    delete new_obj;
+    return nullptr;
+  }
   return new_obj;
 } /* end H5VL_compress_vol_dataset_create() */
 
@@ -789,13 +1876,27 @@ static void *
 H5VL_compress_vol_dataset_open(void *obj, const H5VL_loc_params_t *loc_params, const char *name,
                                hid_t dapl_id, hid_t dxpl_id, void **req)
 {
-  return 0;
+  H5VL_compress_vol_t *o = (H5VL_compress_vol_t *)obj;
+  H5VL_compress_vol_t *new_obj = new H5VL_compress_vol_t(*o);
+
+  /* The index is read on first use, so opening is a single under-VOL call */
+  new_obj->next_vol_info_ = H5VLdataset_open(o->next_vol_info_, loc_params, o->next_vol_id_, name, dapl_id,
+                                             dxpl_id, req);
+  if (new_obj->next_vol_info_ == nullptr) {
+    delete new_obj;
+    return nullptr;
+  }
+  new_obj->dset_ = new H5VL_compress_vol_dset_t();
+  return new_obj;
 } /* end H5VL_compress_vol_dataset_open() */
 
 /*-------------------------------------------------------------------------
  * Function:    H5VL_compress_vol_dataset_read
  *
  * Purpose:     Reads data elements from a dataset into a buffer.
+ *              The transfer property list is passed to every under
+ *              VOL call; the read completes before returning, so
+ *              *req is never set.
  *
  * Return:      Success:    0
  *              Failure:    -1
@@ -806,30 +1907,24 @@ static herr_t
 H5VL_compress_vol_dataset_read(size_t count, void *dset[], hid_t mem_type_id[], hid_t mem_space_id[],
                                hid_t file_space_id[], hid_t plist_id, void *buf[], void **req)
 {
-  std::vector<H5VL_compress_vol_t*> obj(count);
   size_t i;                /* Local index variable */
-  herr_t ret_value;
 
-  /* Allocate obj array if necessary */
   for (i = 0; i < count; i++) {
-    /* Get the object */
-    obj[i] = (H5VL_compress_vol_t*)((H5VL_compress_vol_t*)dset[i])->next_vol_info_;
-
-    /* Make sure the class matches */
-    if (((H5VL_compress_vol_t*) dset[i])->next_vol_id_ != ((H5VL_compress_vol_t*) dset[0])->next_vol_id_)
+    if (H5VL_compress_vol_read_one((H5VL_compress_vol_t *)dset[i], mem_type_id[i], mem_space_id[i],
+                                   file_space_id[i], plist_id, buf[i]) < 0)
       return -1;
   }
 
-  ret_value = H5VLdataset_read(count, (void**)obj.data(), ((H5VL_compress_vol_t*)dset[0])->next_vol_id_, mem_type_id,
-                               mem_space_id, file_space_id, plist_id, buf, req);
-
-  return ret_value;
+  return 0;
 } /* end H5VL_compress_vol_dataset_read() */
 
 /*-------------------------------------------------------------------------
  * Function:    H5VL_compress_vol_dataset_write
  *
  * Purpose:     Writes data elements from a buffer into a dataset.
+ *              The transfer property list is passed to every under
+ *              VOL call; the write completes before returning, so
+ *              *req is never set.
  *
  * Return:      Success:    0
  *              Failure:    -1
@@ -840,24 +1935,15 @@ static herr_t
 H5VL_compress_vol_dataset_write(size_t count, void *dset[], hid_t mem_type_id[], hid_t mem_space_id[],
                                 hid_t file_space_id[], hid_t plist_id, const void *buf[], void **req)
 {
-  std::vector<H5VL_compress_vol_t*> obj(count);
   size_t i;                /* Local index variable */
-  herr_t ret_value;
 
-  /* Allocate obj array if necessary */
   for (i = 0; i < count; i++) {
-    /* Get the object */
-    obj[i] = (H5VL_compress_vol_t*)((H5VL_compress_vol_t*)dset[i])->next_vol_info_;
-
-    /* Make sure the class matches */
-    if (((H5VL_compress_vol_t*) dset[i])->next_vol_id_ != ((H5VL_compress_vol_t*) dset[0])->next_vol_id_)
+    if (H5VL_compress_vol_write_one((H5VL_compress_vol_t *)dset[i], mem_type_id[i], mem_space_id[i],
+                                    file_space_id[i], plist_id, buf[i]) < 0)
       return -1;
   }
 
-  ret_value = H5VLdataset_write(count, (void**)obj.data(), ((H5VL_compress_vol_t*)dset[0])->next_vol_id_, mem_type_id,
-                               mem_space_id, file_space_id, plist_id, buf, req);
-
-  return ret_value;
+  return 0;
 } /* end H5VL_compress_vol_dataset_write() */
 
 /*-------------------------------------------------------------------------
@@ -873,7 +1959,32 @@ H5VL_compress_vol_dataset_write(size_t count, void *dset[], hid_t mem_type_id[],
 static herr_t
 H5VL_compress_vol_dataset_get(void *dset, H5VL_dataset_get_args_t *args, hid_t dxpl_id, void **req)
 {
-  return 0;
+  H5VL_compress_vol_t *o = (H5VL_compress_vol_t *)dset;
+
+  /* Report the logical dataset, not the byte stream underneath */
+  switch (args->op_type) {
+    case H5VL_DATASET_GET_SPACE:
+    case H5VL_DATASET_GET_TYPE:
+    case H5VL_DATASET_GET_DCPL:
+      if (H5VL_compress_vol_dset_load(o, false, dxpl_id) < 0)
+        return -1;
+      break;
+    default:
+      break;
+  }
+  switch (args->op_type) {
+    case H5VL_DATASET_GET_SPACE:
+      args->args.get_space.space_id = H5Scopy(o->dset_->space_id_);
+      return 0;
+    case H5VL_DATASET_GET_TYPE:
+      args->args.get_type.type_id = H5Tcopy(o->dset_->type_id_);
+      return 0;
+    case H5VL_DATASET_GET_DCPL:
+      args->args.get_dcpl.dcpl_id = H5Pcopy(o->dset_->dcpl_id_);
+      return 0;
+    default:
+      return H5VLdataset_get(o->next_vol_info_, o->next_vol_id_, args, dxpl_id, req);
+  }
 } /* end H5VL_compress_vol_dataset_get() */
 
 /*-------------------------------------------------------------------------
@@ -889,7 +2000,20 @@ H5VL_compress_vol_dataset_get(void *dset, H5VL_dataset_get_args_t *args, hid_t d
 static herr_t
 H5VL_compress_vol_dataset_specific(void *obj, H5VL_dataset_specific_args_t *args, hid_t dxpl_id, void **req)
 {
-  return 0;
+  H5VL_compress_vol_t *o = (H5VL_compress_vol_t *)obj;
+
+  switch (args->op_type) {
+    case H5VL_DATASET_SET_EXTENT:
+      /* The chunk layout is fixed at creation */
+      return -1;
+    case H5VL_DATASET_FLUSH:
+      if (o->dset_->dirty_ && H5VL_compress_vol_index_write(o, dxpl_id) < 0)
+        return -1;
+      break;
+    default:
+      break;
+  }
+  return H5VLdataset_specific(o->next_vol_info_, o->next_vol_id_, args, dxpl_id, req);
 } /* end H5VL_compress_vol_dataset_specific() */
 
 /*-------------------------------------------------------------------------
@@ -921,7 +2045,16 @@ H5VL_compress_vol_dataset_optional(void *obj, H5VL_optional_args_t *args, hid_t
 static herr_t
 H5VL_compress_vol_dataset_close(void *dset, hid_t dxpl_id, void **req)
 {
-  return 0;
+  H5VL_compress_vol_t *o = (H5VL_compress_vol_t *)dset;
+  herr_t ret_value = 0;
+
+  if (o->dset_->dirty_ && H5VL_compress_vol_index_write(o, dxpl_id) < 0)
+    ret_value = -1;
+  if (H5VLdataset_close(o->next_vol_info_, o->next_vol_id_, dxpl_id, req) < 0)
+    ret_value = -1;
+  H5VL_compress_vol_dset_free(o->dset_);
+  delete o;
+  return ret_value;
 } /* end H5VL_compress_vol_dataset_close() */
 
 /*-------------------------------------------------------------------------
@@ -1040,10 +2173,20 @@ H5VL_compress_vol_file_create(const char *name, unsigned flags, hid_t fcpl_id, h
   H5VL_compress_vol_t *file = new H5VL_compress_vol_t(), *info;
   H5Pget_vol_info(fapl_id, (void **)&info);
   (*file) = (*info);
+  if (H5VL_compress_vol_shared_write(flags, fapl_id)) {
+    delete file;
+    return nullptr;
+  }
   hid_t under_fapl_id = H5Pcopy(fapl_id);
   H5Pset_vol(under_fapl_id, info->next_vol_id_, info->next_vol_info_);
-  H5VLfile_create(name, flags, fcpl_id, under_fapl_id, dxpl_id, req);
+  file->next_vol_info_ = H5VLfile_create(name, flags, fcpl_id, under_fapl_id, dxpl_id, req);
   H5Pclose(under_fapl_id);
+  if (file->next_vol_info_ == nullptr) {
+    delete file;
+    return nullptr;
+  }
+  if (H5VL_compress_vol_pool_g == nullptr && info->nthreads_ > 0)
+    H5VL_compress_vol_pool_g = new h5::ThreadPool(info->nthreads_);
   return file;
 } /* end H5VL_compress_vol_file_create() */
 
@@ -1060,7 +2203,26 @@ H5VL_compress_vol_file_create(const char *name, unsigned flags, hid_t fcpl_id, h
 static void *
 H5VL_compress_vol_file_open(const char *name, unsigned flags, hid_t fapl_id, hid_t dxpl_id, void **req)
 {
-  return 0;
+  H5VL_compress_vol_t *file = new H5VL_compress_vol_t(), *info;
+  H5Pget_vol_info(fapl_id, (void **)&info);
+  (*file) = (*info);
+  if (H5VL_compress_vol_shared_write(flags, fapl_id)) {
+    delete file;
+    return nullptr;
+  }
+  hid_t under_fapl_id = H5Pcopy(fapl_id);
+  H5Pset_vol(under_fapl_id, info->next_vol_id_, info->next_vol_info_);
+  file->next_vol_info_ = H5VLfile_open(name, flags, under_fapl_id, dxpl_id, req);
+  H5Pclose(under_fapl_id);
+  if (file->next_vol_info_ == nullptr) {
+    delete file;
+    return nullptr;
+  }
+
+  /* Each dataset's chunk index is loaded from its footer when it is opened */
+  if (H5VL_compress_vol_pool_g == nullptr && info->nthreads_ > 0)
+    H5VL_compress_vol_pool_g = new h5::ThreadPool(info->nthreads_);
+  return file;
 } /* end H5VL_compress_vol_file_open() */
 
 /*-------------------------------------------------------------------------
@@ -1124,7 +2286,12 @@ H5VL_compress_vol_file_optional(void *file, H5VL_optional_args_t *args, hid_t dx
 static herr_t
 H5VL_compress_vol_file_close(void *file, hid_t dxpl_id, void **req)
 {
-  return 0;
+  H5VL_compress_vol_t *o = (H5VL_compress_vol_t *)file;
+  herr_t ret_value;
+
+  ret_value = H5VLfile_close(o->next_vol_info_, o->next_vol_id_, dxpl_id, req);
+  delete o;
+  return ret_value;
 } /* end H5VL_compress_vol_file_close() */
 
 /*-------------------------------------------------------------------------
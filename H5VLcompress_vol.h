@@ -28,11 +28,25 @@
 #define H5VL_COMPRESS_VOL_VALUE   4 /* VOL connector ID */
 #define H5VL_COMPRESS_VOL_VERSION 0
 
+/* Per-dataset chunk state (private to the connector) */
+struct H5VL_compress_vol_dset_t;
+
 /* Pass-through VOL connector info */
 typedef struct H5VL_compress_vol_t {
   int compress_method_;     /* Compression method */
+  int shuffle_;             /* Shuffle pre-filter */
+  int error_mode_;          /* method=lossy: absolute or relative bound */
+  double error_bound_;      /* method=lossy: error bound; on read, the loosest accepted (0 = lossless only) */
+  int fast_method_;         /* method=auto: codec for easy chunks */
+  int strong_method_;       /* method=auto: codec for harder chunks */
+  double raw_entropy_;      /* method=auto: bits/byte above which chunks stay raw */
+  double fast_ratio_;       /* method=auto: trial ratio below which the fast codec is used */
+  size_t sample_size_;      /* method=auto: bytes sampled per chunk */
+  size_t chunk_size_;       /* Uncompressed bytes per chunk */
+  size_t nthreads_;         /* Compression worker threads */
   hid_t next_vol_id_;       /* VOL ID for under VOL */
   void *next_vol_info_;     /* VOL info for under VOL */
+  struct H5VL_compress_vol_dset_t *dset_;  /* Chunk state (datasets only) */
 } H5VL_compress_vol_t;
 
 #ifdef __cplusplus
@@ -30,11 +30,24 @@
 /* Header files needed */
 /* Do NOT include private HDF5 files here! */
 #include <assert.h>
+#include <math.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <filesystem>
+#include <set>
+#include <mpi.h>
 #include "connector_helpers.h"
+#include "cache_helpers.h"
+#include "io_helpers.h"
+#include "kv_helpers.h"
+#include "selection_helpers.h"
+#include "stage_helpers.h"
 
 /* Public HDF5 file */
 #include "hdf5.h"
@@ -57,14 +70,415 @@
 #define va_copy(D, S) ((D) = (S))
 #endif
 
+/* Default number of bytes per chunk when the dcpl sets no chunk shape */
+#define H5VL_PFS_VOL_CHUNK_SIZE (1024 * 1024)
+
+/* File marking a directory as a container */
+#define H5VL_PFS_VOL_MARKER ".pfs_vol"
+
+/* Dataset metadata file identification */
+#define H5VL_PFS_VOL_META_MAGIC   0x4d534650 /* "PFSM" */
+#define H5VL_PFS_VOL_META_VERSION 1
+
+/* Chunk index entry of a chunk that was never written */
+#define H5VL_PFS_VOL_NO_CHUNK UINT64_MAX
+
+/* Chunk index entries locate a chunk as its subfile (top 16 bits, 0 for
+ * the shared "data" file) and its offset in that subfile */
+#define H5VL_PFS_VOL_LOC(subfile, off)  (((uint64_t)(subfile) << 48) | (off))
+#define H5VL_PFS_VOL_LOC_SUBFILE(loc)   ((uint32_t)((loc) >> 48))
+#define H5VL_PFS_VOL_LOC_OFFSET(loc)    ((loc) & ((UINT64_C(1) << 48) - 1))
+#define H5VL_PFS_VOL_MAX_SUBFILE        0xfffe
+
+/* Subfiling modes: one data file per dataset, per rank or per node */
+#define H5VL_PFS_VOL_SUBFILE_OFF  0
+#define H5VL_PFS_VOL_SUBFILE_RANK 1
+#define H5VL_PFS_VOL_SUBFILE_NODE 2
+
+/* Bytes of chunk I/O staged per batch */
+#define H5VL_PFS_VOL_IO_BATCH (64 * 1024 * 1024)
+
+/* Default I/Os in flight per container for queued engines */
+#define H5VL_PFS_VOL_QUEUE_DEPTH 32
+
+/* Mean bytes per selection run above which mapped reads are advised sequential */
+#define H5VL_PFS_VOL_SEQ_RUN (64 * 1024)
+
+/* Log record identification */
+#define H5VL_PFS_VOL_LOG_MAGIC 0x4c534650 /* "PFSL" */
+
+/* Default log bytes that trigger a merge into the chunk files */
+#define H5VL_PFS_VOL_LOG_COMPACT (256 * 1024 * 1024)
+
+/* Default bytes an aggregator gathers per round of a collective write */
+#define H5VL_PFS_VOL_CB_BUFFER_SIZE (16 * 1024 * 1024)
+
+/* When collective writes use collective buffering
+ * (cb_write=disable|automatic|enable); needs subfiling */
+#define H5VL_PFS_VOL_CB_DISABLE   0
+#define H5VL_PFS_VOL_CB_AUTOMATIC 1
+#define H5VL_PFS_VOL_CB_ENABLE    2
+
+/* Milliseconds between background write-backs of staged chunks */
+#define H5VL_PFS_VOL_STAGE_FLUSH_MS 100
+
+/* Snapshot and log of the metadata store, in the container directory */
+#define H5VL_PFS_VOL_MD_DB  ".pfs_vol.md"
+#define H5VL_PFS_VOL_MD_WAL ".pfs_vol.wal"
+
+/* Log bytes after which the metadata store is checkpointed */
+#define H5VL_PFS_VOL_MD_CHECKPOINT (64 * 1024 * 1024)
+
+/* Object id of the root group */
+#define H5VL_PFS_VOL_ROOT_ID 1
+
+/* Soft links followed while resolving one name, as H5L_NUM_LINKS */
+#define H5VL_PFS_VOL_MAX_SOFT 16
+
+/* Directory holding the datasets' directories, named by object id */
+#define H5VL_PFS_VOL_DSET_DIR ".pfs_vol.d"
+
+/* Async request workers, created with the first file */
+static h5::ThreadPool *H5VL_pfs_vol_pool_g = nullptr;
+
 /************/
 /* Typedefs */
 /************/
 
+/* A chunk held in the write-back cache */
+typedef struct H5VL_pfs_vol_cached_t {
+  int fd_;                  /* Data file the chunk lives in */
+  int dfd_;                 /* Its O_DIRECT descriptor, or -1 */
+  uint64_t off_;            /* Offset of the chunk in it */
+  std::vector<char> data_;  /* The whole chunk */
+  size_t dirty_lo_;         /* Bytes [dirty_lo_, dirty_hi_) are newer than the file */
+  size_t dirty_hi_;
+} H5VL_pfs_vol_cached_t;
+
+/* Elements [lo_, hi_) of a chunk written by this rank during the session,
+ * as reported to rank 0 when a subfiled container is closed */
+typedef struct H5VL_pfs_vol_claim_t {
+  uint64_t chunk_;          /* Chunk index */
+  uint64_t loc_;            /* Location of the chunk in the writer's subfile, once closed */
+  uint64_t lo_;
+  uint64_t hi_;
+  uint64_t seq_;            /* Write sequence: nanoseconds since the epoch, rising per dataset */
+} H5VL_pfs_vol_claim_t;
+
+/* Cached chunks are keyed by dataset and chunk index */
+typedef std::pair<struct H5VL_pfs_vol_dset_t *, size_t> H5VL_pfs_vol_cache_key_t;
+
+/* State shared by a container and all objects opened through it */
+typedef struct H5VL_pfs_vol_file_t {
+  std::string root_;                  /* Container directory */
+  std::unique_ptr<h5::IoEngine> io_;  /* Executes chunk reads and writes */
+  uint32_t subfile_;                  /* Subfile this rank writes, or 0 without subfiling */
+  int subfile_rank_;                  /* This rank's place among the ranks sharing it */
+  int subfile_ranks_;                 /* Ranks sharing it */
+  std::map<std::string, std::vector<H5VL_pfs_vol_claim_t>> owned_;  /* Runs this rank wrote to its subfile,
+                                                                     * per dataset */
+  std::vector<int> aggregators_;      /* Ranks writing collective transfers, ascending; elected on first use */
+  std::unique_ptr<h5::StagePool> stage_;  /* Node-wide staging of chunk writes, or null */
+  std::thread flusher_;               /* Writes staged chunks back in the background (RDWR only) */
+  std::mutex flush_lock_;
+  std::condition_variable flush_cv_;  /* Wakes the flusher before its interval */
+  bool flush_stop_;                   /* Tells the flusher to exit */
+  std::unique_ptr<h5::ArcCache<H5VL_pfs_vol_cache_key_t, H5VL_pfs_vol_cached_t>> cache_;  /* Write-back chunk
+                                                                                         * cache, or null */
+  std::mutex cache_lock_;             /* Guards cache_; taken after a dataset lock */
+  bool cache_failed_;                 /* A write-back on a prefetch worker failed; reported by the next flush */
+  std::unique_ptr<h5::KvStore> md_;   /* Groups, links and attributes */
+  bool md_writer_;                    /* This process persists md_ and removes deleted datasets */
+  std::map<std::string, std::vector<H5VL_pfs_vol_t *>> open_;  /* Open handles per dataset directory; they
+                                                              * share the first one's dset_ */
+  std::set<std::string> unlinked_;    /* Deleted datasets removed once their last handle closes */
+} H5VL_pfs_vol_file_t;
+
+/* Groups, links and attributes are records in the container's metadata
+ * store. Keys are a tag byte, mostly followed by an object id as 8
+ * big-endian bytes so that an object's entries sort together:
+ *   "N"                 next object id (8 big-endian bytes)
+ *   "O" id              object record
+ *   "L" group name      link record
+ *   "C" group corder    link name, in creation order
+ *   "A" object name     attribute record
+ *   "B" object corder   attribute name, in creation order
+ * where corder is a creation order as 8 big-endian bytes. */
+
+/* An object's record */
+typedef struct H5VL_pfs_vol_obj_rec_t {
+  int type_;                /* H5O_TYPE_GROUP or H5O_TYPE_DATASET */
+  uint64_t rc_;             /* Hard links to it */
+  uint64_t nlinks_;         /* Links in it (groups) */
+  uint64_t nattrs_;         /* Attributes on it */
+  uint64_t link_corder_;    /* Creation order of its next link */
+  uint64_t attr_corder_;    /* Creation order of its next attribute */
+  std::string dir_;         /* Directory of a dataset, relative to the container */
+} H5VL_pfs_vol_obj_rec_t;
+
+/* A link's record */
+typedef struct H5VL_pfs_vol_link_rec_t {
+  int type_;                /* H5L_TYPE_HARD or H5L_TYPE_SOFT */
+  uint64_t corder_;         /* Creation order in its group */
+  uint64_t target_;         /* Object linked to (hard links) */
+  std::string path_;        /* Path linked to (soft links) */
+} H5VL_pfs_vol_link_rec_t;
+
+/* An attribute's record */
+typedef struct H5VL_pfs_vol_attr_rec_t {
+  uint64_t corder_;         /* Creation order on its object */
+  std::string type_;        /* Encoded datatype */
+  std::string space_;       /* Encoded dataspace */
+  std::string data_;        /* Values, in the datatype */
+} H5VL_pfs_vol_attr_rec_t;
+
+/* Header of a dataset's "meta" file. It is followed by the encoded
+ * datatype, dataspace and creation properties, then one uint64 per chunk
+ * giving the chunk's location (H5VL_PFS_VOL_LOC). */
+typedef struct H5VL_pfs_vol_meta_t {
+  uint32_t magic_;          /* H5VL_PFS_VOL_META_MAGIC */
+  uint32_t version_;        /* H5VL_PFS_VOL_META_VERSION */
+  uint32_t rank_;           /* Dimensions of the chunk grid */
+  uint32_t type_size_;      /* Bytes of encoded datatype */
+  uint32_t space_size_;     /* Bytes of encoded dataspace */
+  uint32_t dcpl_size_;      /* Bytes of encoded creation properties */
+  uint64_t nchunks_;        /* Chunk index entries */
+  uint64_t end_;            /* Bytes allocated in the data file */
+  uint64_t chunk_dims_[H5S_MAX_RANK];  /* Chunk shape */
+} H5VL_pfs_vol_meta_t;
+
+/* Header of a log record. It is followed by nruns_ (offset, length)
+ * pairs of uint64 giving element runs inside the chunk, then the data
+ * of the runs in order. */
+typedef struct H5VL_pfs_vol_log_rec_t {
+  uint32_t magic_;          /* H5VL_PFS_VOL_LOG_MAGIC */
+  uint32_t nruns_;          /* Runs in the record */
+  uint64_t chunk_;          /* Chunk index */
+  uint32_t crc_;            /* CRC-32C of the whole record, taken with crc_ = 0 */
+  uint32_t reserved_;
+} H5VL_pfs_vol_log_rec_t;
+
+/* Logged elements [key, end_) of a chunk */
+typedef struct H5VL_pfs_vol_extent_t {
+  hsize_t end_;             /* One past the last element */
+  uint64_t log_off_;        /* Log offset of the first element's data */
+} H5VL_pfs_vol_extent_t;
+
+/* Sequential read detection of a dataset, for prefetching */
+typedef struct H5VL_pfs_vol_prefetch_t {
+  std::vector<size_t> chunks_;  /* Chunks the last read moving to new chunks touched */
+  long long stride_;        /* Chunk index step from the read before it, 0 if not a shift */
+  size_t ahead_;            /* Steps past the last read already prefetched */
+  size_t depth_;            /* Steps to keep prefetched */
+  double interval_;         /* Mean seconds the consumer spends per step */
+  double cost_;             /* Mean seconds to prefetch one step */
+  std::chrono::steady_clock::time_point last_;  /* Time of the last step */
+  uint64_t gen_;            /* Bumped by writes, discarding prefetches that raced them */
+} H5VL_pfs_vol_prefetch_t;
+
+/* A dataset stored as fixed-size chunks in one data file, or in one
+ * subfile per rank or node with subfiling. Chunks are allocated at the
+ * end of the writer's file when first written; a chunk is a row-major
+ * array of the full chunk shape, even at the dataset edge. Every handle
+ * of the dataset open through a container shares one of these, freed
+ * when the last closes. */
+typedef struct H5VL_pfs_vol_dset_t {
+  hid_t type_id_;           /* Logical datatype */
+  hid_t space_id_;          /* Logical dataspace */
+  hid_t dcpl_id_;           /* Creation properties given by the user */
+  size_t type_size_;        /* Bytes per element */
+  std::vector<hsize_t> dims_;        /* Current extent (scalars are {1}) */
+  std::vector<hsize_t> max_dims_;    /* Maximum extent */
+  std::vector<hsize_t> chunk_dims_;  /* Chunk shape */
+  size_t chunk_bytes_;      /* Bytes per chunk */
+  std::vector<uint64_t> chunks_;     /* Location of each chunk, row-major over the chunk grid */
+  uint64_t end_;            /* Bytes allocated in the data file */
+  int fd_;                  /* Data file (this rank's subfile with subfiling), or -1 */
+  int dfd_;                 /* Data file opened with O_DIRECT, or -1 */
+  std::map<uint32_t, int> subfiles_;  /* Other subfiles opened for reading */
+  char *map_;               /* Read-only mapping of the data file (mmap mode), or nullptr */
+  size_t map_size_;         /* Bytes mapped */
+  int advice_;              /* Last madvise advice given for the mapping */
+  bool dirty_;              /* Metadata changed since the meta file was written */
+  std::mutex lock_;         /* Serializes chunk I/O and index updates */
+  std::condition_variable idle_;  /* Signaled when pending_ drops to 0 */
+  size_t pending_;          /* Async requests in flight */
+  uint64_t next_turn_;      /* Ticket for the next transfer issued */
+  uint64_t turn_;           /* Ticket of the transfer allowed to run */
+  std::condition_variable turn_cv_;  /* Signaled when turn_ advances */
+  std::vector<char> type_enc_;   /* Encoded datatype, dataspace and dcpl for the meta file */
+  std::vector<char> space_enc_;
+  std::vector<char> dcpl_enc_;
+  int log_fd_;              /* This rank's log (log mode), or -1 */
+  uint64_t log_end_;        /* Bytes in the log */
+  std::map<size_t, std::map<hsize_t, H5VL_pfs_vol_extent_t>> extents_;  /* Logged runs not yet in the chunks, per chunk */
+  bool compact_queued_;     /* A background merge of the log is pending */
+  int stage_;               /* Entry in the staging pool, or -1 if chunks are not staged */
+  std::vector<H5VL_pfs_vol_claim_t> written_;  /* Runs written since the open (subfiling only) */
+  uint64_t seq_;            /* Sequence of the last write recorded in written_ */
+  H5VL_pfs_vol_prefetch_t prefetch_;  /* Read pattern, with prefetch */
+} H5VL_pfs_vol_dset_t;
+
+/* One chunk's share of a read or write */
+typedef struct H5VL_pfs_vol_span_t {
+  size_t idx_;                                /* Chunk index */
+  const std::vector<h5::SelPair> *pieces_;    /* Selection pieces, offsets relative to the chunk */
+  hsize_t lo_;                                /* First element of the chunk touched */
+  hsize_t hi_;                                /* One past the last element touched */
+  bool direct_;                               /* Transfer straight to/from the user buffer */
+  bool staged_;                               /* Done in the staging pool or chunk cache instead */
+  std::vector<char> buf_;                     /* Staged bytes [lo_, hi_) otherwise */
+} H5VL_pfs_vol_span_t;
+
+/* A planned read or write of one dataset */
+typedef struct H5VL_pfs_vol_xfer_t {
+  H5VL_pfs_vol_t *o_;                         /* Dataset */
+  bool write_;                                /* Write (true) or read (false) */
+  std::vector<h5::SelPair> pairs_;            /* Selection as runs of memory and file elements */
+  std::map<size_t, std::vector<h5::SelPair>> chunks_;  /* The runs split over the chunk grid */
+  std::vector<H5VL_pfs_vol_span_t> spans_;    /* Per-chunk share of the transfer */
+  std::vector<char> packed_;                  /* Dense staging in the file datatype, if converting */
+  char *mem_;                                 /* Buffer the pieces' memory offsets index */
+  hid_t mem_type_id_;                         /* Memory datatype of a converting read, or invalid */
+  void *buf_;                                 /* User buffer */
+  hsize_t npoints_;                           /* Elements selected */
+} H5VL_pfs_vol_xfer_t;
+
+/* An async dataset read or write */
+typedef struct H5VL_pfs_vol_req_t {
+  std::mutex lock_;
+  std::condition_variable done_cv_;   /* Signaled when done_ is set */
+  bool done_;                         /* The I/O has finished */
+  herr_t ret_;                        /* Its result */
+  H5VL_request_notify_t cb_;          /* Completion callback from request_notify */
+  void *ctx_;                         /* Its argument */
+  bool notified_;                     /* cb_ was called */
+  int refs_;                          /* Held by the caller's handle and the worker */
+} H5VL_pfs_vol_req_t;
+
 /********************* */
 /* Function prototypes */
 /********************* */
 
+/* Helper routines */
+static H5VL_pfs_vol_t *H5VL_pfs_vol_new_file(const char *name, unsigned flags, hid_t fapl_id);
+static H5VL_pfs_vol_t *H5VL_pfs_vol_new_obj(const H5VL_pfs_vol_t *o, const char *name);
+static herr_t H5VL_pfs_vol_marker_write(const H5VL_pfs_vol_t *file);
+static herr_t H5VL_pfs_vol_marker_read(H5VL_pfs_vol_t *file);
+static H5VL_pfs_vol_dset_t *H5VL_pfs_vol_dset_new(const H5VL_pfs_vol_t *o, hid_t type_id, hid_t space_id,
+                                                  hid_t dcpl_id);
+static H5VL_pfs_vol_dset_t *H5VL_pfs_vol_dset_blank(void);
+static void   H5VL_pfs_vol_dset_free(H5VL_pfs_vol_dset_t *dset);
+static size_t H5VL_pfs_vol_nchunks(const std::vector<hsize_t> &dims, const std::vector<hsize_t> &chunk_dims);
+static herr_t H5VL_pfs_vol_encode(H5VL_pfs_vol_dset_t *dset);
+static herr_t H5VL_pfs_vol_meta_write(H5VL_pfs_vol_t *o);
+static herr_t H5VL_pfs_vol_meta_read(H5VL_pfs_vol_t *o);
+static herr_t H5VL_pfs_vol_dset_load(H5VL_pfs_vol_t *dset);
+static herr_t H5VL_pfs_vol_set_extent(H5VL_pfs_vol_t *o, const hsize_t *size);
+static herr_t H5VL_pfs_vol_xfer_init(H5VL_pfs_vol_t *o, bool write, hid_t mem_type_id, hid_t mem_space_id,
+                                     hid_t file_space_id, const void *buf, H5VL_pfs_vol_xfer_t *xfer);
+static void   H5VL_pfs_vol_xfer_plan(H5VL_pfs_vol_xfer_t *xfer);
+static herr_t H5VL_pfs_vol_xfer_read(H5VL_pfs_vol_xfer_t *xfer);
+static herr_t H5VL_pfs_vol_xfer_read_chunks(H5VL_pfs_vol_xfer_t *xfer);
+static herr_t H5VL_pfs_vol_map(H5VL_pfs_vol_dset_t *dset);
+static herr_t H5VL_pfs_vol_xfer_read_mapped(H5VL_pfs_vol_xfer_t *xfer);
+static herr_t H5VL_pfs_vol_xfer_write(H5VL_pfs_vol_xfer_t *xfer);
+static herr_t H5VL_pfs_vol_xfer_finish(H5VL_pfs_vol_xfer_t *xfer);
+static H5VL_pfs_vol_req_t *H5VL_pfs_vol_xfer_async(std::vector<std::unique_ptr<H5VL_pfs_vol_xfer_t>> &&xfers);
+static void   H5VL_pfs_vol_req_release(H5VL_pfs_vol_req_t *req);
+static void   H5VL_pfs_vol_wait_idle(H5VL_pfs_vol_dset_t *dset);
+static uint64_t H5VL_pfs_vol_turn_take(H5VL_pfs_vol_dset_t *dset);
+static void   H5VL_pfs_vol_turn_wait(H5VL_pfs_vol_dset_t *dset, uint64_t ticket);
+static void   H5VL_pfs_vol_turn_done(H5VL_pfs_vol_dset_t *dset);
+static int    H5VL_pfs_vol_rank(void);
+static bool   H5VL_pfs_vol_mpi(void);
+static herr_t H5VL_pfs_vol_subfile_init(H5VL_pfs_vol_file_t *file, int mode);
+static std::string H5VL_pfs_vol_data_path(const std::string &dir, uint32_t subfile);
+static herr_t H5VL_pfs_vol_data_open(H5VL_pfs_vol_t *o, int flags);
+static herr_t H5VL_pfs_vol_chunk_fds(H5VL_pfs_vol_t *o, uint64_t loc, int *fd, int *dfd);
+static herr_t H5VL_pfs_vol_chunk_alloc(H5VL_pfs_vol_t *o, size_t idx);
+static uint64_t H5VL_pfs_vol_write_seq(H5VL_pfs_vol_dset_t *dset);
+static void   H5VL_pfs_vol_chunk_written(H5VL_pfs_vol_t *o, size_t idx, hsize_t off, hsize_t len, uint64_t seq);
+static herr_t H5VL_pfs_vol_subfile_resolve(H5VL_pfs_vol_t *o, std::vector<H5VL_pfs_vol_claim_t> &claims);
+static herr_t H5VL_pfs_vol_subfile_merge(H5VL_pfs_vol_t *file);
+static bool   H5VL_pfs_vol_collective(const H5VL_pfs_vol_t *o, hid_t dxpl_id);
+static void   H5VL_pfs_vol_cb_init(H5VL_pfs_vol_file_t *file, size_t cb_nodes);
+static herr_t H5VL_pfs_vol_cb_write(H5VL_pfs_vol_xfer_t *xfer);
+static void   H5VL_pfs_vol_log_index(H5VL_pfs_vol_dset_t *dset, size_t idx, hsize_t off, hsize_t len,
+                                     uint64_t log_off);
+static herr_t H5VL_pfs_vol_log_open(H5VL_pfs_vol_t *o);
+static herr_t H5VL_pfs_vol_log_append(H5VL_pfs_vol_xfer_t *xfer);
+static herr_t H5VL_pfs_vol_log_overlay(H5VL_pfs_vol_xfer_t *xfer);
+static herr_t H5VL_pfs_vol_log_compact(H5VL_pfs_vol_t *o, std::unique_lock<std::mutex> *lock);
+static herr_t H5VL_pfs_vol_stage_open(H5VL_pfs_vol_t *file);
+static void   H5VL_pfs_vol_stage_close(H5VL_pfs_vol_file_t *file);
+static void   H5VL_pfs_vol_stage_attach(H5VL_pfs_vol_t *o, bool created);
+static herr_t H5VL_pfs_vol_stage_writeback(std::map<std::string, int> &fds, const char *dir, uint64_t loc,
+                                           const char *buf, size_t size);
+static herr_t H5VL_pfs_vol_stage_flush(H5VL_pfs_vol_t *o);
+static herr_t H5VL_pfs_vol_stage_write(H5VL_pfs_vol_xfer_t *xfer);
+static void   H5VL_pfs_vol_stage_read(H5VL_pfs_vol_xfer_t *xfer);
+static herr_t H5VL_pfs_vol_cache_writeback(H5VL_pfs_vol_file_t *file,
+                                           const std::vector<H5VL_pfs_vol_cached_t *> &chunks);
+static H5VL_pfs_vol_cached_t *H5VL_pfs_vol_cache_insert(H5VL_pfs_vol_file_t *file,
+                                                        const H5VL_pfs_vol_cache_key_t &key,
+                                                        H5VL_pfs_vol_cached_t &&c);
+static herr_t H5VL_pfs_vol_cache_flush(H5VL_pfs_vol_file_t *file, H5VL_pfs_vol_dset_t *dset);
+static herr_t H5VL_pfs_vol_dset_flush(H5VL_pfs_vol_t *o);
+static herr_t H5VL_pfs_vol_cache_drop(H5VL_pfs_vol_t *o);
+static herr_t H5VL_pfs_vol_cache_write(H5VL_pfs_vol_xfer_t *xfer);
+static void   H5VL_pfs_vol_cache_read(H5VL_pfs_vol_xfer_t *xfer);
+static void   H5VL_pfs_vol_prefetch(H5VL_pfs_vol_xfer_t *xfer);
+static void   H5VL_pfs_vol_prefetch_run(H5VL_pfs_vol_t *o, const std::vector<size_t> &targets, size_t steps);
+static std::string H5VL_pfs_vol_md_be(uint64_t val);
+static std::string H5VL_pfs_vol_md_key(char tag, uint64_t id, const std::string &name);
+static void   H5VL_pfs_vol_md_token(uint64_t id, H5O_token_t *token);
+static std::string H5VL_pfs_vol_md_obj_enc(const H5VL_pfs_vol_obj_rec_t &rec);
+static herr_t H5VL_pfs_vol_md_obj_dec(const std::string *val, H5VL_pfs_vol_obj_rec_t *rec);
+static std::string H5VL_pfs_vol_md_link_enc(const H5VL_pfs_vol_link_rec_t &rec);
+static herr_t H5VL_pfs_vol_md_link_dec(const std::string *val, H5VL_pfs_vol_link_rec_t *rec);
+static std::string H5VL_pfs_vol_md_attr_enc(const H5VL_pfs_vol_attr_rec_t &rec);
+static herr_t H5VL_pfs_vol_md_attr_dec(const std::string *val, H5VL_pfs_vol_attr_rec_t *rec);
+static herr_t H5VL_pfs_vol_md_open(H5VL_pfs_vol_t *file);
+static herr_t H5VL_pfs_vol_md_load(H5VL_pfs_vol_file_t *file);
+static herr_t H5VL_pfs_vol_md_migrate(H5VL_pfs_vol_file_t *file, uint64_t parent, const std::string &rel);
+static herr_t H5VL_pfs_vol_md_commit(H5VL_pfs_vol_file_t *file, const h5::KvBatch &batch,
+                                     const std::vector<std::string> &dirs);
+static herr_t H5VL_pfs_vol_md_get_obj(H5VL_pfs_vol_file_t *file, const h5::KvBatch &batch, uint64_t id,
+                                      H5VL_pfs_vol_obj_rec_t *rec);
+static uint64_t H5VL_pfs_vol_md_next_id(H5VL_pfs_vol_file_t *file);
+static herr_t H5VL_pfs_vol_md_create(H5VL_pfs_vol_file_t *file, uint64_t parent, const std::string &name,
+                                     uint64_t id, const H5VL_pfs_vol_obj_rec_t &rec);
+static herr_t H5VL_pfs_vol_md_link(H5VL_pfs_vol_file_t *file, h5::KvBatch &batch, uint64_t parent,
+                                   const std::string &name, H5VL_pfs_vol_link_rec_t link);
+static herr_t H5VL_pfs_vol_md_unlink(H5VL_pfs_vol_file_t *file, h5::KvBatch &batch, uint64_t parent,
+                                     const std::string &name, std::vector<std::string> &dirs);
+static void   H5VL_pfs_vol_md_release(H5VL_pfs_vol_file_t *file, h5::KvBatch &batch, uint64_t id,
+                                      std::vector<std::string> &dirs);
+static herr_t H5VL_pfs_vol_md_walk(H5VL_pfs_vol_file_t *file, uint64_t cur, const std::string &path, int depth,
+                                   uint64_t *id);
+static herr_t H5VL_pfs_vol_md_parent(H5VL_pfs_vol_t *o, const char *name, hid_t lcpl_id, uint64_t *parent,
+                                     std::string *last);
+static herr_t H5VL_pfs_vol_md_names(H5VL_pfs_vol_file_t *file, bool attrs, uint64_t id, H5_index_t idx_type,
+                                    H5_iter_order_t order, std::vector<std::string> &names);
+static herr_t H5VL_pfs_vol_md_locate(H5VL_pfs_vol_t *o, const H5VL_loc_params_t *loc_params, uint64_t *id);
+static herr_t H5VL_pfs_vol_md_link_at(H5VL_pfs_vol_t *o, const H5VL_loc_params_t *loc_params, uint64_t *parent,
+                                      std::string *name);
+static H5VL_pfs_vol_t *H5VL_pfs_vol_md_open_obj(H5VL_pfs_vol_t *o, uint64_t id, H5I_type_t *type);
+static herr_t H5VL_pfs_vol_md_name(H5VL_pfs_vol_file_t *file, uint64_t id, std::string *name);
+static void   H5VL_pfs_vol_md_link_info(const H5VL_pfs_vol_link_rec_t &link, H5L_info2_t *linfo);
+static herr_t H5VL_pfs_vol_md_iterate(H5VL_pfs_vol_file_t *file, hid_t gid, uint64_t group,
+                                      const std::string &prefix, H5VL_link_iterate_args_t *args,
+                                      std::set<uint64_t> &visited);
+static hid_t  H5VL_pfs_vol_md_register(H5VL_pfs_vol_t *o, uint64_t id);
+static herr_t H5VL_pfs_vol_md_attr_find(H5VL_pfs_vol_t *o, const H5VL_loc_params_t *loc_params, const char *name,
+                                        uint64_t *owner, std::string *attr_name);
+static herr_t H5VL_pfs_vol_md_attr_info(H5VL_pfs_vol_file_t *file, uint64_t owner, const std::string &name,
+                                        H5A_info_t *ainfo);
+static herr_t H5VL_pfs_vol_md_convert(hid_t src_type_id, hid_t dst_type_id, size_t n, const void *src, void *dst);
+static herr_t H5VL_pfs_vol_xfer(size_t count, void *dset[], hid_t mem_type_id[], hid_t mem_space_id[],
+                                hid_t file_space_id[], const void *buf[], bool write, hid_t dxpl_id, void **req);
+
 /* "Management" callbacks */
 static herr_t H5VL_pfs_vol_init(hid_t vipl_id);
 static herr_t H5VL_pfs_vol_term(void);
@@ -211,156 +625,4087 @@ static herr_t H5VL_pfs_vol_blob_get(void *obj, const void *blob_id, void *buf, s
 static herr_t H5VL_pfs_vol_blob_specific(void *obj, void *blob_id, H5VL_blob_specific_args_t *args);
 static herr_t H5VL_pfs_vol_blob_optional(void *obj, void *blob_id, H5VL_optional_args_t *args);
 
-/* Token callbacks */
-static herr_t H5VL_pfs_vol_token_cmp(void *obj, const H5O_token_t *token1, const H5O_token_t *token2,
-                                     int *cmp_value);
-static herr_t H5VL_pfs_vol_token_to_str(void *obj, H5I_type_t obj_type, const H5O_token_t *token,
-                                        char **token_str);
-static herr_t H5VL_pfs_vol_token_from_str(void *obj, H5I_type_t obj_type, const char *token_str,
-                                          H5O_token_t *token);
+/* Token callbacks */
+static herr_t H5VL_pfs_vol_token_cmp(void *obj, const H5O_token_t *token1, const H5O_token_t *token2,
+                                     int *cmp_value);
+static herr_t H5VL_pfs_vol_token_to_str(void *obj, H5I_type_t obj_type, const H5O_token_t *token,
+                                        char **token_str);
+static herr_t H5VL_pfs_vol_token_from_str(void *obj, H5I_type_t obj_type, const char *token_str,
+                                          H5O_token_t *token);
+
+/* Generic optional callback */
+static herr_t H5VL_pfs_vol_optional(void *obj, H5VL_optional_args_t *args, hid_t dxpl_id, void **req);
+
+/*******************/
+/* Local variables */
+/*******************/
+
+/* Pass through VOL connector class struct */
+static const H5VL_class_t H5VL_pfs_vol_g = {
+    H5VL_VERSION,                            /* VOL class struct version */
+    (H5VL_class_value_t)H5VL_PFS_VOL_VALUE, /* value        */
+    H5VL_PFS_VOL_NAME,                      /* name         */
+    H5VL_PFS_VOL_VERSION,                   /* connector version */
+    H5VL_CAP_FLAG_ASYNC,                     /* capability flags */
+    H5VL_pfs_vol_init,                  /* initialize   */
+    H5VL_pfs_vol_term,                  /* terminate    */
+    {
+        /* info_cls */
+        sizeof(H5VL_pfs_vol_t), /* size    */
+        H5VL_pfs_vol_info_copy,      /* copy    */
+        H5VL_pfs_vol_info_cmp,       /* compare */
+        H5VL_pfs_vol_info_free,      /* free    */
+        H5VL_pfs_vol_to_str,    /* to_str  */
+        H5VL_pfs_vol_str_to_info     /* from_str */
+    },
+    {
+        /* wrap_cls */
+        H5VL_pfs_vol_get_object,    /* get_object   */
+        H5VL_pfs_vol_get_wrap_ctx,  /* get_wrap_ctx */
+        H5VL_pfs_vol_wrap_object,   /* wrap_object  */
+        H5VL_pfs_vol_unwrap_object, /* unwrap_object */
+        H5VL_pfs_vol_free_wrap_ctx  /* free_wrap_ctx */
+    },
+    {
+        /* attribute_cls */
+        H5VL_pfs_vol_attr_create,   /* create */
+        H5VL_pfs_vol_attr_open,     /* open */
+        H5VL_pfs_vol_attr_read,     /* read */
+        H5VL_pfs_vol_attr_write,    /* write */
+        H5VL_pfs_vol_attr_get,      /* get */
+        H5VL_pfs_vol_attr_specific, /* specific */
+        H5VL_pfs_vol_attr_optional, /* optional */
+        H5VL_pfs_vol_attr_close     /* close */
+    },
+    {
+        /* dataset_cls */
+        H5VL_pfs_vol_dataset_create,   /* create */
+        H5VL_pfs_vol_dataset_open,     /* open */
+        H5VL_pfs_vol_dataset_read,     /* read */
+        H5VL_pfs_vol_dataset_write,    /* write */
+        H5VL_pfs_vol_dataset_get,      /* get */
+        H5VL_pfs_vol_dataset_specific, /* specific */
+        H5VL_pfs_vol_dataset_optional, /* optional */
+        H5VL_pfs_vol_dataset_close     /* close */
+    },
+    {
+        /* datatype_cls */
+        H5VL_pfs_vol_datatype_commit,   /* commit */
+        H5VL_pfs_vol_datatype_open,     /* open */
+        H5VL_pfs_vol_datatype_get,      /* get_size */
+        H5VL_pfs_vol_datatype_specific, /* specific */
+        H5VL_pfs_vol_datatype_optional, /* optional */
+        H5VL_pfs_vol_datatype_close     /* close */
+    },
+    {
+        /* file_cls */
+        H5VL_pfs_vol_file_create,   /* create */
+        H5VL_pfs_vol_file_open,     /* open */
+        H5VL_pfs_vol_file_get,      /* get */
+        H5VL_pfs_vol_file_specific, /* specific */
+        H5VL_pfs_vol_file_optional, /* optional */
+        H5VL_pfs_vol_file_close     /* close */
+    },
+    {
+        /* group_cls */
+        H5VL_pfs_vol_group_create,   /* create */
+        H5VL_pfs_vol_group_open,     /* open */
+        H5VL_pfs_vol_group_get,      /* get */
+        H5VL_pfs_vol_group_specific, /* specific */
+        H5VL_pfs_vol_group_optional, /* optional */
+        H5VL_pfs_vol_group_close     /* close */
+    },
+    {
+        /* link_cls */
+        H5VL_pfs_vol_link_create,   /* create */
+        H5VL_pfs_vol_link_copy,     /* copy */
+        H5VL_pfs_vol_link_move,     /* move */
+        H5VL_pfs_vol_link_get,      /* get */
+        H5VL_pfs_vol_link_specific, /* specific */
+        H5VL_pfs_vol_link_optional  /* optional */
+    },
+    {
+        /* object_cls */
+        H5VL_pfs_vol_object_open,     /* open */
+        H5VL_pfs_vol_object_copy,     /* copy */
+        H5VL_pfs_vol_object_get,      /* get */
+        H5VL_pfs_vol_object_specific, /* specific */
+        H5VL_pfs_vol_object_optional  /* optional */
+    },
+    {
+        /* introspect_cls */
+        H5VL_pfs_vol_introspect_get_conn_cls,  /* get_conn_cls */
+        H5VL_pfs_vol_introspect_get_cap_flags, /* get_cap_flags */
+        H5VL_pfs_vol_introspect_opt_query,     /* opt_query */
+    },
+    {
+        /* request_cls */
+        H5VL_pfs_vol_request_wait,     /* wait */
+        H5VL_pfs_vol_request_notify,   /* notify */
+        H5VL_pfs_vol_request_cancel,   /* cancel */
+        H5VL_pfs_vol_request_specific, /* specific */
+        H5VL_pfs_vol_request_optional, /* optional */
+        H5VL_pfs_vol_request_free      /* free */
+    },
+    {
+        /* blob_cls */
+        H5VL_pfs_vol_blob_put,      /* put */
+        H5VL_pfs_vol_blob_get,      /* get */
+        H5VL_pfs_vol_blob_specific, /* specific */
+        H5VL_pfs_vol_blob_optional  /* optional */
+    },
+    {
+        /* token_cls */
+        H5VL_pfs_vol_token_cmp,     /* cmp */
+        H5VL_pfs_vol_token_to_str,  /* to_str */
+        H5VL_pfs_vol_token_from_str /* from_str */
+    },
+    H5VL_pfs_vol_optional /* optional */
+};
+
+/* The connector identification number, initialized at runtime */
+static hid_t H5VL_PFS_VOL_g = H5I_INVALID_HID;
+
+H5PL_type_t
+H5PLget_plugin_type(void) {
+  return H5PL_TYPE_VOL;
+}
+
+const void*
+H5PLget_plugin_info(void) {
+  return &H5VL_pfs_vol_g;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_new_file
+ *
+ * Purpose:     Create the object for a container, taking the connector
+ *              settings from the fapl.
+ *
+ * Return:      Success:    The new object
+ *              Failure:    nullptr (the I/O engine or subfiles could not
+ *                          be set up, or several ranks would log to
+ *                          one data file)
+ *
+ *-------------------------------------------------------------------------
+ */
+static H5VL_pfs_vol_t *
+H5VL_pfs_vol_new_file(const char *name, unsigned flags, hid_t fapl_id)
+{
+  H5VL_pfs_vol_t *file = new H5VL_pfs_vol_t(), *info = nullptr;
+  H5Pget_vol_info(fapl_id, (void **)&info);
+  if (info == nullptr && H5VL_pfs_vol_str_to_info("", (void **)&info) < 0) {
+    delete file;
+    return nullptr;
+  }
+  file->path_ = name;
+  file->flags_ = flags;
+  file->chunk_size_ = info->chunk_size_;
+  file->stripe_size_ = info->stripe_size_;
+  file->stripe_count_ = info->stripe_count_;
+  file->align_ = info->align_;
+  file->io_engine_ = info->io_engine_;
+  file->queue_depth_ = info->queue_depth_;
+  file->sqpoll_ = info->sqpoll_;
+  file->mmap_ = info->mmap_;
+  file->log_ = info->log_;
+  file->log_compact_ = info->log_compact_;
+  file->nthreads_ = info->nthreads_;
+  file->subfiling_ = info->subfiling_;
+  file->cb_write_ = info->cb_write_;
+  file->cb_nodes_ = info->cb_nodes_;
+  file->cb_buffer_size_ = info->cb_buffer_size_;
+  file->stage_size_ = info->stage_size_;
+  file->stage_block_ = info->stage_block_;
+  file->cache_size_ = info->cache_size_;
+  file->prefetch_ = info->prefetch_;
+  file->file_ = std::make_shared<H5VL_pfs_vol_file_t>();
+  file->id_ = H5VL_PFS_VOL_ROOT_ID;
+  file->file_->root_ = name;
+  file->file_->io_ = h5::MakeIoEngine(info->io_engine_, info->queue_depth_, info->sqpoll_);
+  if (info->cache_size_)
+    file->file_->cache_ =
+        std::make_unique<h5::ArcCache<H5VL_pfs_vol_cache_key_t, H5VL_pfs_vol_cached_t>>(info->cache_size_);
+  file->dset_ = nullptr;
+  if (H5VL_pfs_vol_pool_g == nullptr && info->nthreads_ > 0)
+    H5VL_pfs_vol_pool_g = new h5::ThreadPool(info->nthreads_);
+  H5VL_pfs_vol_info_free(info);
+  if (H5VL_pfs_vol_subfile_init(file->file_.get(), file->subfiling_) < 0 || file->file_->io_ == nullptr) {
+    delete file;
+    return nullptr;
+  }
+
+  /* Each rank merges its own log, allocating chunks at the end of the
+   * file it writes. Only subfiles keep those allocations apart, so
+   * without subfiling logging needs a single writer. */
+  if (file->log_ && file->file_->subfile_ == 0 && H5VL_pfs_vol_mpi()) {
+    int nranks = 1;
+    MPI_Comm_size(MPI_COMM_WORLD, &nranks);
+    if (nranks > 1) {
+      delete file;
+      return nullptr;
+    }
+  }
+  return file;
+} /* end H5VL_pfs_vol_new_file() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_new_obj
+ *
+ * Purpose:     Create an object named \a name below \a o, sharing its
+ *              container state.
+ *
+ * Return:      The new object
+ *
+ *-------------------------------------------------------------------------
+ */
+static H5VL_pfs_vol_t *
+H5VL_pfs_vol_new_obj(const H5VL_pfs_vol_t *o, const char *name)
+{
+  H5VL_pfs_vol_t *new_obj = new H5VL_pfs_vol_t();
+  new_obj->flags_ = o->flags_;
+  new_obj->chunk_size_ = o->chunk_size_;
+  new_obj->stripe_size_ = o->stripe_size_;
+  new_obj->stripe_count_ = o->stripe_count_;
+  new_obj->align_ = o->align_;
+  new_obj->io_engine_ = o->io_engine_;
+  new_obj->queue_depth_ = o->queue_depth_;
+  new_obj->sqpoll_ = o->sqpoll_;
+  new_obj->mmap_ = o->mmap_;
+  new_obj->log_ = o->log_;
+  new_obj->log_compact_ = o->log_compact_;
+  new_obj->nthreads_ = o->nthreads_;
+  new_obj->subfiling_ = o->subfiling_;
+  new_obj->cb_write_ = o->cb_write_;
+  new_obj->cb_nodes_ = o->cb_nodes_;
+  new_obj->cb_buffer_size_ = o->cb_buffer_size_;
+  new_obj->stage_size_ = o->stage_size_;
+  new_obj->stage_block_ = o->stage_block_;
+  new_obj->cache_size_ = o->cache_size_;
+  new_obj->prefetch_ = o->prefetch_;
+  new_obj->id_ = o->id_;
+  new_obj->file_ = o->file_;
+  new_obj->dset_ = nullptr;
+
+  /* Absolute names start at the container root */
+  if (name[0] == '/')
+    new_obj->path_ = o->file_->root_;
+  else
+    new_obj->path_ = o->path_;
+  while (name[0] == '/')
+    ++name;
+  if (name[0] != '\0')
+    new_obj->path_ += std::string("/") + name;
+  return new_obj;
+} /* end H5VL_pfs_vol_new_obj() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_marker_write
+ *
+ * Purpose:     Write the marker file tagging a directory as a container.
+ *              It records the container's data layout settings, as
+ *              connector parameters, so later opens place chunks the
+ *              same way.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_marker_write(const H5VL_pfs_vol_t *file)
+{
+  std::string marker = file->path_ + "/" H5VL_PFS_VOL_MARKER;
+  std::string params = "stripe_size=" + std::to_string(file->stripe_size_) +
+                       ":stripe_count=" + std::to_string(file->stripe_count_) +
+                       ":align=" + std::to_string(file->align_);
+  h5::IoOp op;
+  int fd = open(marker.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+  if (fd < 0)
+    return -1;
+  op = h5::IoOp{fd, true, (void *)params.data(), params.size(), 0, 0};
+  if (h5::PosixIoEngine::Run(op) < 0) {
+    close(fd);
+    return -1;
+  }
+  close(fd);
+  return 0;
+} /* end H5VL_pfs_vol_marker_write() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_marker_read
+ *
+ * Purpose:     Check that a directory is a container and take the data
+ *              layout settings recorded in its marker file, overriding
+ *              those of the fapl. Empty markers (older containers) keep
+ *              the fapl's.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1 (not a container)
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_marker_read(H5VL_pfs_vol_t *file)
+{
+  std::string marker = file->path_ + "/" H5VL_PFS_VOL_MARKER;
+  std::string params;
+  h5::ParseConn parser;
+  struct stat st;
+  h5::IoOp op;
+  int fd = open(marker.c_str(), O_RDONLY);
+
+  if (fd < 0)
+    return -1;
+  if (fstat(fd, &st) < 0) {
+    close(fd);
+    return -1;
+  }
+  params.resize(st.st_size);
+  op = h5::IoOp{fd, false, params.data(), params.size(), 0, 0};
+  if (h5::PosixIoEngine::Run(op) < 0) {
+    close(fd);
+    return -1;
+  }
+  close(fd);
+  if (params.empty())
+    return 0;
+  parser.parse(params);
+  file->stripe_size_ = h5::ParseSize(parser.GetParam("stripe_size", "0"));
+  file->stripe_count_ = h5::ParseSize(parser.GetParam("stripe_count", "0"));
+  file->align_ = h5::ParseSize(parser.GetParam("align", "0"));
+  return 0;
+} /* end H5VL_pfs_vol_marker_read() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_nchunks
+ *
+ * Purpose:     Number of chunks in the grid covering \a dims.
+ *
+ * Return:      The chunk count
+ *
+ *-------------------------------------------------------------------------
+ */
+static size_t
+H5VL_pfs_vol_nchunks(const std::vector<hsize_t> &dims, const std::vector<hsize_t> &chunk_dims)
+{
+  size_t nchunks = 1;
+  for (size_t d = 0; d < dims.size(); d++)
+    nchunks *= (dims[d] + chunk_dims[d] - 1) / chunk_dims[d];
+  return nchunks;
+} /* end H5VL_pfs_vol_nchunks() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_dset_new
+ *
+ * Purpose:     Lay out a new dataset. The chunk shape comes from the dcpl
+ *              if it sets one; otherwise the leading dimensions are cut
+ *              until a chunk holds about chunk_size_ bytes.
+ *
+ * Return:      Success:    The layout
+ *              Failure:    nullptr
+ *
+ *-------------------------------------------------------------------------
+ */
+static H5VL_pfs_vol_dset_t *
+H5VL_pfs_vol_dset_new(const H5VL_pfs_vol_t *o, hid_t type_id, hid_t space_id, hid_t dcpl_id)
+{
+  H5VL_pfs_vol_dset_t *dset = H5VL_pfs_vol_dset_blank();
+  int rank = H5Sget_simple_extent_ndims(space_id);
+
+  dset->type_id_ = H5Tcopy(type_id);
+  dset->space_id_ = H5Scopy(space_id);
+  dset->dcpl_id_ = H5Pcopy(dcpl_id);
+  dset->type_size_ = H5Tget_size(type_id);
+  if (dset->type_id_ < 0 || dset->space_id_ < 0 || dset->dcpl_id_ < 0 || dset->type_size_ == 0 || rank < 0) {
+    H5VL_pfs_vol_dset_free(dset);
+    return nullptr;
+  }
+  if (rank == 0) {
+    dset->dims_.assign(1, 1);
+    dset->max_dims_.assign(1, 1);
+    dset->chunk_dims_.assign(1, 1);
+  } else {
+    dset->dims_.resize(rank);
+    dset->max_dims_.resize(rank);
+    dset->chunk_dims_.resize(rank);
+    H5Sget_simple_extent_dims(space_id, dset->dims_.data(), dset->max_dims_.data());
+    if (H5Pget_layout(dcpl_id) == H5D_CHUNKED) {
+      if (H5Pget_chunk(dcpl_id, rank, dset->chunk_dims_.data()) != rank) {
+        H5VL_pfs_vol_dset_free(dset);
+        return nullptr;
+      }
+    } else {
+      size_t bytes = dset->type_size_;
+      for (int d = 0; d < rank; d++) {
+        dset->chunk_dims_[d] = std::max<hsize_t>(dset->dims_[d], 1);
+        bytes *= dset->chunk_dims_[d];
+      }
+      for (int d = 0; d < rank && bytes > o->chunk_size_; d++) {
+        size_t rest = bytes / dset->chunk_dims_[d];
+        dset->chunk_dims_[d] = std::max<hsize_t>(1, o->chunk_size_ / rest);
+        bytes = rest * dset->chunk_dims_[d];
+      }
+    }
+  }
+  dset->chunk_bytes_ = dset->type_size_;
+  for (hsize_t dim : dset->chunk_dims_)
+    dset->chunk_bytes_ *= dim;
+  dset->chunks_.assign(H5VL_pfs_vol_nchunks(dset->dims_, dset->chunk_dims_), H5VL_PFS_VOL_NO_CHUNK);
+  dset->end_ = 0;
+  dset->dirty_ = true;
+  if (H5VL_pfs_vol_encode(dset) < 0) {
+    H5VL_pfs_vol_dset_free(dset);
+    return nullptr;
+  }
+  return dset;
+} /* end H5VL_pfs_vol_dset_new() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_dset_blank
+ *
+ * Purpose:     A dataset layout with no datatype, dataspace or files yet,
+ *              to be filled in by H5VL_pfs_vol_dset_new or from a meta
+ *              file.
+ *
+ * Return:      The layout
+ *
+ *-------------------------------------------------------------------------
+ */
+static H5VL_pfs_vol_dset_t *
+H5VL_pfs_vol_dset_blank(void)
+{
+  H5VL_pfs_vol_dset_t *dset = new H5VL_pfs_vol_dset_t();
+  dset->type_id_ = H5I_INVALID_HID;
+  dset->space_id_ = H5I_INVALID_HID;
+  dset->dcpl_id_ = H5I_INVALID_HID;
+  dset->type_size_ = 0;
+  dset->chunk_bytes_ = 0;
+  dset->end_ = 0;
+  dset->fd_ = -1;
+  dset->dfd_ = -1;
+  dset->map_ = nullptr;
+  dset->map_size_ = 0;
+  dset->dirty_ = false;
+  dset->pending_ = 0;
+  dset->next_turn_ = 0;
+  dset->turn_ = 0;
+  dset->log_fd_ = -1;
+  dset->log_end_ = 0;
+  dset->compact_queued_ = false;
+  dset->stage_ = -1;
+  dset->seq_ = 0;
+  dset->prefetch_.stride_ = 0;
+  dset->prefetch_.ahead_ = 0;
+  dset->prefetch_.depth_ = 0;
+  dset->prefetch_.interval_ = 0;
+  dset->prefetch_.cost_ = 0;
+  dset->prefetch_.gen_ = 0;
+  return dset;
+} /* end H5VL_pfs_vol_dset_blank() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_dset_free
+ *
+ * Purpose:     Release a dataset layout and close its data files.
+ *
+ *-------------------------------------------------------------------------
+ */
+static void
+H5VL_pfs_vol_dset_free(H5VL_pfs_vol_dset_t *dset)
+{
+  if (dset == nullptr)
+    return;
+  if (dset->type_id_ >= 0)
+    H5Tclose(dset->type_id_);
+  if (dset->space_id_ >= 0)
+    H5Sclose(dset->space_id_);
+  if (dset->dcpl_id_ >= 0)
+    H5Pclose(dset->dcpl_id_);
+  if (dset->fd_ >= 0)
+    close(dset->fd_);
+  if (dset->dfd_ >= 0)
+    close(dset->dfd_);
+  for (auto &it : dset->subfiles_)
+    close(it.second);
+  if (dset->map_)
+    munmap(dset->map_, dset->map_size_);
+  if (dset->log_fd_ >= 0)
+    close(dset->log_fd_);
+  delete dset;
+} /* end H5VL_pfs_vol_dset_free() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_encode
+ *
+ * Purpose:     Encode the datatype, dataspace and dcpl for the meta file.
+ *              They are kept so that the meta file can be rewritten
+ *              without HDF5 calls, e.g., by a background log merge.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_encode(H5VL_pfs_vol_dset_t *dset)
+{
+  size_t type_size = 0, space_size = 0, dcpl_size = 0;
+
+  if (H5Tencode(dset->type_id_, nullptr, &type_size) < 0 ||
+      H5Sencode2(dset->space_id_, nullptr, &space_size, H5P_DEFAULT) < 0 ||
+      H5Pencode2(dset->dcpl_id_, nullptr, &dcpl_size, H5P_DEFAULT) < 0)
+    return -1;
+  dset->type_enc_.resize(type_size);
+  dset->space_enc_.resize(space_size);
+  dset->dcpl_enc_.resize(dcpl_size);
+  if (H5Tencode(dset->type_id_, dset->type_enc_.data(), &type_size) < 0 ||
+      H5Sencode2(dset->space_id_, dset->space_enc_.data(), &space_size, H5P_DEFAULT) < 0 ||
+      H5Pencode2(dset->dcpl_id_, dset->dcpl_enc_.data(), &dcpl_size, H5P_DEFAULT) < 0)
+    return -1;
+  return 0;
+} /* end H5VL_pfs_vol_encode() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_meta_write
+ *
+ * Purpose:     Write the dataset's meta file. The new contents go to a
+ *              temporary file that is renamed over the old one, so a
+ *              crash leaves either the old or the new metadata.
+ *
+ *              With subfiling only rank 0 writes it; the chunks the
+ *              other ranks placed in their subfiles reach it through
+ *              H5VL_pfs_vol_subfile_merge when the container is closed.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_meta_write(H5VL_pfs_vol_t *o)
+{
+  H5VL_pfs_vol_dset_t *dset = o->dset_;
+  H5VL_pfs_vol_meta_t meta = {};
+  std::vector<char> rec;
+  std::string path = o->path_ + "/meta", tmp = path + ".tmp";
+  size_t type_size = dset->type_enc_.size(), space_size = dset->space_enc_.size(),
+         dcpl_size = dset->dcpl_enc_.size();
+  h5::IoOp op;
+  int fd;
+
+  if (o->file_->subfile_ && H5VL_pfs_vol_rank() != 0) {
+    dset->dirty_ = false;
+    return 0;
+  }
+  rec.resize(sizeof(meta) + type_size + space_size + dcpl_size + dset->chunks_.size() * sizeof(uint64_t));
+  memcpy(rec.data() + sizeof(meta), dset->type_enc_.data(), type_size);
+  memcpy(rec.data() + sizeof(meta) + type_size, dset->space_enc_.data(), space_size);
+  memcpy(rec.data() + sizeof(meta) + type_size + space_size, dset->dcpl_enc_.data(), dcpl_size);
+  memcpy(rec.data() + sizeof(meta) + type_size + space_size + dcpl_size, dset->chunks_.data(),
+         dset->chunks_.size() * sizeof(uint64_t));
+  meta.magic_ = H5VL_PFS_VOL_META_MAGIC;
+  meta.version_ = H5VL_PFS_VOL_META_VERSION;
+  meta.rank_ = (uint32_t)dset->chunk_dims_.size();
+  meta.type_size_ = (uint32_t)type_size;
+  meta.space_size_ = (uint32_t)space_size;
+  meta.dcpl_size_ = (uint32_t)dcpl_size;
+  meta.nchunks_ = dset->chunks_.size();
+  meta.end_ = dset->end_;
+  for (size_t d = 0; d < dset->chunk_dims_.size(); d++)
+    meta.chunk_dims_[d] = dset->chunk_dims_[d];
+  memcpy(rec.data(), &meta, sizeof(meta));
+
+  fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    return -1;
+  op = h5::IoOp{fd, true, rec.data(), rec.size(), 0, 0};
+  if (h5::PosixIoEngine::Run(op) < 0) {
+    close(fd);
+    return -1;
+  }
+  close(fd);
+  if (rename(tmp.c_str(), path.c_str()) < 0)
+    return -1;
+  dset->dirty_ = false;
+  return 0;
+} /* end H5VL_pfs_vol_meta_write() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_meta_read
+ *
+ * Purpose:     Load a dataset's layout from its meta file.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_meta_read(H5VL_pfs_vol_t *o)
+{
+  H5VL_pfs_vol_dset_t *dset = o->dset_;
+  H5VL_pfs_vol_meta_t meta;
+  std::vector<char> rec;
+  std::string path = o->path_ + "/meta";
+  struct stat st;
+  const char *p;
+  h5::IoOp op;
+  int fd, rank;
+
+  fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return -1;
+  if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(meta)) {
+    close(fd);
+    return -1;
+  }
+  rec.resize(st.st_size);
+  op = h5::IoOp{fd, false, rec.data(), rec.size(), 0, 0};
+  if (h5::PosixIoEngine::Run(op) < 0) {
+    close(fd);
+    return -1;
+  }
+  close(fd);
+  memcpy(&meta, rec.data(), sizeof(meta));
+  if (meta.magic_ != H5VL_PFS_VOL_META_MAGIC || meta.version_ != H5VL_PFS_VOL_META_VERSION ||
+      meta.rank_ == 0 || meta.rank_ > H5S_MAX_RANK ||
+      rec.size() != sizeof(meta) + (size_t)meta.type_size_ + meta.space_size_ + meta.dcpl_size_ +
+                         meta.nchunks_ * sizeof(uint64_t))
+    return -1;
+
+  p = rec.data() + sizeof(meta);
+  dset->type_enc_.assign(p, p + meta.type_size_);
+  dset->space_enc_.assign(p + meta.type_size_, p + meta.type_size_ + meta.space_size_);
+  dset->dcpl_enc_.assign(p + meta.type_size_ + meta.space_size_,
+                         p + meta.type_size_ + meta.space_size_ + meta.dcpl_size_);
+  dset->type_id_ = H5Tdecode(p);
+  dset->space_id_ = H5Sdecode(p + meta.type_size_);
+  dset->dcpl_id_ = H5Pdecode(p + meta.type_size_ + meta.space_size_);
+  if (dset->type_id_ < 0 || dset->space_id_ < 0 || dset->dcpl_id_ < 0)
+    return -1;
+  dset->type_size_ = H5Tget_size(dset->type_id_);
+  rank = H5Sget_simple_extent_ndims(dset->space_id_);
+  if (rank == 0) {
+    dset->dims_.assign(1, 1);
+    dset->max_dims_.assign(1, 1);
+  } else {
+    dset->dims_.resize(rank);
+    dset->max_dims_.resize(rank);
+    H5Sget_simple_extent_dims(dset->space_id_, dset->dims_.data(), dset->max_dims_.data());
+  }
+  if (dset->dims_.size() != meta.rank_)
+    return -1;
+  dset->chunk_dims_.assign(meta.chunk_dims_, meta.chunk_dims_ + meta.rank_);
+  dset->chunk_bytes_ = dset->type_size_;
+  for (hsize_t dim : dset->chunk_dims_)
+    dset->chunk_bytes_ *= dim;
+  if (meta.nchunks_ != H5VL_pfs_vol_nchunks(dset->dims_, dset->chunk_dims_))
+    return -1;
+  dset->chunks_.resize(meta.nchunks_);
+  memcpy(dset->chunks_.data(), p + meta.type_size_ + meta.space_size_ + meta.dcpl_size_,
+         meta.nchunks_ * sizeof(uint64_t));
+  dset->end_ = meta.end_;
+  dset->dirty_ = false;
+  return 0;
+} /* end H5VL_pfs_vol_meta_read() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_dset_load
+ *
+ * Purpose:     Load the dataset in the directory \a dset->path_ and open
+ *              its data files.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_dset_load(H5VL_pfs_vol_t *dset)
+{
+  H5VL_pfs_vol_dset_t *d;
+
+  dset->dset_ = d = H5VL_pfs_vol_dset_blank();
+  if (H5VL_pfs_vol_meta_read(dset) < 0 ||
+      H5VL_pfs_vol_data_open(dset, (dset->flags_ & H5F_ACC_RDWR) ? O_RDWR | O_CREAT : O_RDONLY) < 0 ||
+      (dset->log_ && H5VL_pfs_vol_log_open(dset) < 0)) {
+    H5VL_pfs_vol_dset_free(d);
+    dset->dset_ = nullptr;
+    return -1;
+  }
+
+  /* The meta file's end is rank 0's; allocate after what this subfile holds */
+  if (dset->file_->subfile_) {
+    d->end_ = 0;
+    for (uint64_t loc : d->chunks_)
+      if (loc != H5VL_PFS_VOL_NO_CHUNK && H5VL_PFS_VOL_LOC_SUBFILE(loc) == dset->file_->subfile_)
+        d->end_ = std::max<uint64_t>(d->end_, H5VL_PFS_VOL_LOC_OFFSET(loc) + d->chunk_bytes_);
+  }
+  H5VL_pfs_vol_stage_attach(dset, false);
+  return 0;
+} /* end H5VL_pfs_vol_dset_load() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_set_extent
+ *
+ * Purpose:     Change the dataset's extent. The chunk index is rebuilt
+ *              for the new chunk grid; chunks that fall outside the new
+ *              extent are dropped (their space is not reused).
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_set_extent(H5VL_pfs_vol_t *o, const hsize_t *size)
+{
+  H5VL_pfs_vol_dset_t *dset = o->dset_;
+  int rank = H5Sget_simple_extent_ndims(dset->space_id_);
+  std::vector<hsize_t> dims(size, size + rank), old_grid(rank), new_grid(rank), coord(rank);
+  std::vector<uint64_t> chunks;
+
+  if (rank <= 0)
+    return -1;
+
+  /* Logged runs are indexed by chunk, so merge them before the grid changes */
+  if (dset->log_fd_ >= 0 && H5VL_pfs_vol_log_compact(o, nullptr) < 0)
+    return -1;
+
+  /* So are cached and staged chunks */
+  if (H5VL_pfs_vol_cache_drop(o) < 0 || H5VL_pfs_vol_stage_flush(o) < 0)
+    return -1;
+  if (dset->stage_ >= 0)
+    o->file_->stage_->Forget(dset->stage_);
+  for (int d = 0; d < rank; d++) {
+    if (dset->max_dims_[d] != H5S_UNLIMITED && dims[d] > dset->max_dims_[d])
+      return -1;
+    old_grid[d] = (dset->dims_[d] + dset->chunk_dims_[d] - 1) / dset->chunk_dims_[d];
+    new_grid[d] = (dims[d] + dset->chunk_dims_[d] - 1) / dset->chunk_dims_[d];
+  }
+  chunks.assign(H5VL_pfs_vol_nchunks(dims, dset->chunk_dims_), H5VL_PFS_VOL_NO_CHUNK);
+  for (size_t idx = 0; idx < dset->chunks_.size(); idx++) {
+    size_t rem = idx, new_idx = 0;
+    bool inside = true;
+    if (dset->chunks_[idx] == H5VL_PFS_VOL_NO_CHUNK)
+      continue;
+    for (int d = rank - 1; d >= 0; d--) {
+      coord[d] = rem % old_grid[d];
+      rem /= old_grid[d];
+      inside = inside && coord[d] < new_grid[d];
+    }
+    if (!inside)
+      continue;
+    for (int d = 0; d < rank; d++)
+      new_idx = new_idx * new_grid[d] + coord[d];
+    chunks[new_idx] = dset->chunks_[idx];
+  }
+  if (H5Sset_extent_simple(dset->space_id_, rank, dims.data(), dset->max_dims_.data()) < 0 ||
+      H5VL_pfs_vol_encode(dset) < 0)
+    return -1;
+  dset->dims_ = dims;
+  dset->chunks_.swap(chunks);
+  dset->dirty_ = true;
+  dset->prefetch_.chunks_.clear();
+  dset->prefetch_.ahead_ = 0;
+  dset->prefetch_.gen_++;
+  return 0;
+} /* end H5VL_pfs_vol_set_extent() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_xfer_init
+ *
+ * Purpose:     Plan a read or write of one dataset: pair the selections,
+ *              convert the data of a write to the file datatype, and work
+ *              out the part of each chunk the selection touches, as the
+ *              element range [lo_, hi_) covering its pieces. A chunk
+ *              touched by a single piece can be transferred directly to
+ *              or from the user buffer.
+ *
+ *              All HDF5 calls of a transfer happen here and in
+ *              H5VL_pfs_vol_xfer_finish, so the chunk I/O in between can
+ *              run on a worker thread.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_xfer_init(H5VL_pfs_vol_t *o, bool write, hid_t mem_type_id, hid_t mem_space_id,
+                       hid_t file_space_id, const void *buf, H5VL_pfs_vol_xfer_t *xfer)
+{
+  H5VL_pfs_vol_dset_t *dset = o->dset_;
+  size_t type_size = dset->type_size_;
+  size_t mem_type_size = H5Tget_size(mem_type_id);
+  bool convert = H5Tequal(mem_type_id, dset->type_id_) <= 0;
+  std::vector<h5::SelPair> staged;
+
+  xfer->o_ = o;
+  xfer->write_ = write;
+  xfer->mem_ = (char *)buf;
+  xfer->mem_type_id_ = H5I_INVALID_HID;
+  xfer->buf_ = (void *)buf;
+  xfer->npoints_ = 0;
+  h5::ResolveSpaces(dset->space_id_, file_space_id, mem_space_id);
+  if (h5::PairSelections(file_space_id, mem_space_id, xfer->pairs_) < 0)
+    return -1;
+  for (const h5::SelPair &pair : xfer->pairs_)
+    xfer->npoints_ += pair.len_;
+
+  /* A conversion goes through a dense buffer in the file datatype */
+  if (convert) {
+    xfer->packed_.resize(xfer->npoints_ * std::max(type_size, mem_type_size));
+    xfer->mem_ = xfer->packed_.data();
+    if (write) {
+      h5::PackPairs(buf, xfer->pairs_, mem_type_size, xfer->packed_.data());
+      if (H5Tconvert(mem_type_id, dset->type_id_, xfer->npoints_, xfer->packed_.data(), nullptr, H5P_DEFAULT) < 0)
+        return -1;
+    } else {
+      xfer->mem_type_id_ = mem_type_id;
+      staged = xfer->pairs_;
+      hsize_t packed = 0;
+      for (h5::SelPair &pair : staged) {
+        pair.mem_off_ = packed;
+        packed += pair.len_;
+      }
+    }
+  }
+  h5::SplitByChunkGrid(staged.empty() ? xfer->pairs_ : staged, dset->dims_, dset->chunk_dims_, xfer->chunks_);
+  H5VL_pfs_vol_xfer_plan(xfer);
+  return 0;
+} /* end H5VL_pfs_vol_xfer_init() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_xfer_plan
+ *
+ * Purpose:     Work out the span of each chunk in xfer->chunks_.
+ *
+ *-------------------------------------------------------------------------
+ */
+static void
+H5VL_pfs_vol_xfer_plan(H5VL_pfs_vol_xfer_t *xfer)
+{
+  xfer->spans_.clear();
+  xfer->spans_.reserve(xfer->chunks_.size());
+  for (auto &it : xfer->chunks_) {
+    H5VL_pfs_vol_span_t span;
+    span.idx_ = it.first;
+    span.pieces_ = &it.second;
+    span.lo_ = it.second.front().file_off_;
+    span.hi_ = span.lo_;
+    for (const h5::SelPair &piece : it.second) {
+      span.lo_ = std::min(span.lo_, piece.file_off_);
+      span.hi_ = std::max<hsize_t>(span.hi_, piece.file_off_ + piece.len_);
+    }
+    span.direct_ = it.second.size() == 1;
+    span.staged_ = false;
+    xfer->spans_.push_back(std::move(span));
+  }
+} /* end H5VL_pfs_vol_xfer_plan() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_xfer_read
+ *
+ * Purpose:     Read a planned transfer: chunks in the chunk cache or the
+ *              staging pool from there, the others from the mapping in
+ *              mmap mode or through the I/O engine otherwise, then any
+ *              newer data in the log. Reads may start a prefetch.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_xfer_read(H5VL_pfs_vol_xfer_t *xfer)
+{
+  H5VL_pfs_vol_dset_t *dset = xfer->o_->dset_;
+  std::lock_guard<std::mutex> guard(dset->lock_);
+
+  if (xfer->o_->file_->cache_)
+    H5VL_pfs_vol_cache_read(xfer);
+  if (xfer->o_->file_->stage_ && dset->stage_ >= 0)
+    H5VL_pfs_vol_stage_read(xfer);
+  if ((xfer->o_->mmap_ ? H5VL_pfs_vol_xfer_read_mapped(xfer) : H5VL_pfs_vol_xfer_read_chunks(xfer)) < 0)
+    return -1;
+  if (!dset->extents_.empty())
+    return H5VL_pfs_vol_log_overlay(xfer);
+  if (xfer->o_->prefetch_)
+    H5VL_pfs_vol_prefetch(xfer);
+  return 0;
+} /* end H5VL_pfs_vol_xfer_read() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_xfer_read_chunks
+ *
+ * Purpose:     Read the chunks of a planned transfer through the I/O
+ *              engine. Only the covered range of each chunk is read;
+ *              chunks that were never written read as zeros.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_xfer_read_chunks(H5VL_pfs_vol_xfer_t *xfer)
+{
+  H5VL_pfs_vol_dset_t *dset = xfer->o_->dset_;
+  size_t type_size = dset->type_size_;
+  std::vector<H5VL_pfs_vol_span_t> &spans = xfer->spans_;
+  std::vector<h5::IoOp> ops;
+  char *dst = xfer->mem_;
+
+  for (size_t first = 0; first < spans.size();) {
+    size_t last = first, staged_bytes = 0;
+
+    /* Issue a batch of chunk reads */
+    ops.clear();
+    for (; last < spans.size() && staged_bytes < H5VL_PFS_VOL_IO_BATCH; last++) {
+      H5VL_pfs_vol_span_t &span = spans[last];
+      uint64_t loc = dset->chunks_[span.idx_];
+      size_t size = (span.hi_ - span.lo_) * type_size;
+      int fd, dfd;
+      void *to;
+      if (span.staged_)
+        continue;
+      if (loc == H5VL_PFS_VOL_NO_CHUNK) {
+        for (const h5::SelPair &piece : *span.pieces_)
+          memset(dst + piece.mem_off_ * type_size, 0, piece.len_ * type_size);
+        continue;
+      }
+      if (H5VL_pfs_vol_chunk_fds(xfer->o_, loc, &fd, &dfd) < 0)
+        return -1;
+      if (span.direct_) {
+        to = dst + span.pieces_->front().mem_off_ * type_size;
+      } else {
+        span.buf_.resize(size);
+        to = span.buf_.data();
+        staged_bytes += size;
+      }
+      ops.push_back(h5::IoOp{fd, false, to, size, H5VL_PFS_VOL_LOC_OFFSET(loc) + span.lo_ * type_size, 0, dfd});
+    }
+    if (!ops.empty() && xfer->o_->file_->io_->Submit(ops.data(), ops.size()) < 0)
+      return -1;
+
+    /* Scatter staged ranges */
+    for (; first < last; first++) {
+      H5VL_pfs_vol_span_t &span = spans[first];
+      if (span.direct_ || span.staged_ || dset->chunks_[span.idx_] == H5VL_PFS_VOL_NO_CHUNK)
+        continue;
+      for (const h5::SelPair &piece : *span.pieces_)
+        memcpy(dst + piece.mem_off_ * type_size, span.buf_.data() + (piece.file_off_ - span.lo_) * type_size,
+               piece.len_ * type_size);
+      std::vector<char>().swap(span.buf_);
+    }
+  }
+  return 0;
+} /* end H5VL_pfs_vol_xfer_read_chunks() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_map
+ *
+ * Purpose:     Make sure the read-only mapping of a dataset's data file
+ *              covers everything written to it. The file is only
+ *              remapped once chunks were allocated past the mapped
+ *              length and the file actually grew.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_map(H5VL_pfs_vol_dset_t *dset)
+{
+  struct stat st;
+  void *map;
+
+  if (dset->fd_ < 0 || dset->end_ <= dset->map_size_)
+    return 0;
+  if (fstat(dset->fd_, &st) < 0)
+    return -1;
+  if ((size_t)st.st_size <= dset->map_size_)
+    return 0;
+  map = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, dset->fd_, 0);
+  if (map == MAP_FAILED)
+    return -1;
+  if (dset->map_)
+    munmap(dset->map_, dset->map_size_);
+  dset->map_ = (char *)map;
+  dset->map_size_ = st.st_size;
+  dset->advice_ = MADV_NORMAL;
+  return 0;
+} /* end H5VL_pfs_vol_map() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_xfer_read_mapped
+ *
+ * Purpose:     Read the chunks of a planned transfer by copying straight
+ *              from the mapped data file into the destination, with no
+ *              staging. The mapping is advised sequential when the
+ *              selection is made of long runs and random otherwise.
+ *              Bytes past the end of the file read as zeros. Chunks in
+ *              other ranks' subfiles are read with pread.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_xfer_read_mapped(H5VL_pfs_vol_xfer_t *xfer)
+{
+  H5VL_pfs_vol_dset_t *dset = xfer->o_->dset_;
+  size_t type_size = dset->type_size_;
+  char *dst = xfer->mem_;
+  int advice;
+
+  if (H5VL_pfs_vol_map(dset) < 0)
+    return -1;
+  advice = xfer->npoints_ * type_size >= xfer->pairs_.size() * H5VL_PFS_VOL_SEQ_RUN ? MADV_SEQUENTIAL
+                                                                                    : MADV_RANDOM;
+  if (dset->map_ && advice != dset->advice_ && madvise(dset->map_, dset->map_size_, advice) == 0)
+    dset->advice_ = advice;
+
+  for (const H5VL_pfs_vol_span_t &span : xfer->spans_) {
+    uint64_t loc = dset->chunks_[span.idx_], off = H5VL_PFS_VOL_LOC_OFFSET(loc);
+    if (span.staged_)
+      continue;
+    if (loc != H5VL_PFS_VOL_NO_CHUNK && H5VL_PFS_VOL_LOC_SUBFILE(loc) != xfer->o_->file_->subfile_) {
+      int fd, dfd;
+      if (H5VL_pfs_vol_chunk_fds(xfer->o_, loc, &fd, &dfd) < 0)
+        return -1;
+      for (const h5::SelPair &piece : *span.pieces_) {
+        h5::IoOp op{fd, false, dst + piece.mem_off_ * type_size, piece.len_ * type_size,
+                    off + piece.file_off_ * type_size, 0};
+        if (h5::PosixIoEngine::Run(op) < 0)
+          return -1;
+      }
+      continue;
+    }
+    for (const h5::SelPair &piece : *span.pieces_) {
+      char *to = dst + piece.mem_off_ * type_size;
+      size_t size = piece.len_ * type_size, avail = 0;
+      if (loc != H5VL_PFS_VOL_NO_CHUNK) {
+        uint64_t from = off + piece.file_off_ * type_size;
+        avail = from < dset->map_size_ ? std::min<uint64_t>(size, dset->map_size_ - from) : 0;
+        memcpy(to, dset->map_ + from, avail);
+      }
+      memset(to + avail, 0, size - avail);
+    }
+  }
+  return 0;
+} /* end H5VL_pfs_vol_xfer_read_mapped() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_xfer_write
+ *
+ * Purpose:     Write the chunks of a planned transfer. Each chunk touched
+ *              gets one write covering the selected range. Ranges with
+ *              gaps between pieces are read first so the gaps keep their
+ *              old contents; chunks written for the first time, or held
+ *              in another rank's subfile, are allocated in this rank's
+ *              data file by H5VL_pfs_vol_chunk_alloc. With a chunk cache
+ *              or a staging pool, chunks that fit in it are written
+ *              there instead.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_xfer_write(H5VL_pfs_vol_xfer_t *xfer)
+{
+  H5VL_pfs_vol_dset_t *dset = xfer->o_->dset_;
+  h5::IoEngine *io = xfer->o_->file_->io_.get();
+  size_t type_size = dset->type_size_;
+  std::vector<H5VL_pfs_vol_span_t> &spans = xfer->spans_;
+  std::vector<h5::IoOp> ops;
+  const char *src = xfer->mem_;
+  uint64_t seq;
+
+  if (xfer->o_->log_)
+    return H5VL_pfs_vol_log_append(xfer);
+
+  std::lock_guard<std::mutex> guard(dset->lock_);
+  dset->prefetch_.gen_++;
+  seq = H5VL_pfs_vol_write_seq(dset);
+  if (xfer->o_->file_->cache_ && H5VL_pfs_vol_cache_write(xfer) < 0)
+    return -1;
+  if (xfer->o_->file_->stage_ && dset->stage_ >= 0 && H5VL_pfs_vol_stage_write(xfer) < 0)
+    return -1;
+  for (size_t first = 0; first < spans.size();) {
+    size_t last = first, staged_bytes = 0;
+
+    /* Stage a batch, reading the old contents of ranges with gaps */
+    ops.clear();
+    for (; last < spans.size() && staged_bytes < H5VL_PFS_VOL_IO_BATCH; last++) {
+      H5VL_pfs_vol_span_t &span = spans[last];
+      hsize_t covered = 0;
+      bool fresh = dset->chunks_[span.idx_] == H5VL_PFS_VOL_NO_CHUNK;
+      if (span.staged_)
+        continue;
+      if (H5VL_pfs_vol_chunk_alloc(xfer->o_, span.idx_) < 0)
+        return -1;
+      for (const h5::SelPair &piece : *span.pieces_)
+        H5VL_pfs_vol_chunk_written(xfer->o_, span.idx_, piece.file_off_, piece.len_, seq);
+      if (span.direct_)
+        continue;
+      for (const h5::SelPair &piece : *span.pieces_)
+        covered += piece.len_;
+      span.buf_.assign((span.hi_ - span.lo_) * type_size, 0);
+      staged_bytes += span.buf_.size();
+      if (!fresh && covered != span.hi_ - span.lo_)
+        ops.push_back(h5::IoOp{dset->fd_, false, span.buf_.data(), span.buf_.size(),
+                               H5VL_PFS_VOL_LOC_OFFSET(dset->chunks_[span.idx_]) + span.lo_ * type_size, 0,
+                               dset->dfd_});
+    }
+    if (!ops.empty() && io->Submit(ops.data(), ops.size()) < 0)
+      return -1;
+
+    /* Merge in the new data and write the batch */
+    ops.clear();
+    for (; first < last; first++) {
+      H5VL_pfs_vol_span_t &span = spans[first];
+      uint64_t off = H5VL_PFS_VOL_LOC_OFFSET(dset->chunks_[span.idx_]) + span.lo_ * type_size;
+      size_t size = (span.hi_ - span.lo_) * type_size;
+      if (span.staged_)
+        continue;
+      if (span.direct_) {
+        ops.push_back(h5::IoOp{dset->fd_, true, (void *)(src + span.pieces_->front().mem_off_ * type_size), size,
+                               off, 0, dset->dfd_});
+        continue;
+      }
+      for (const h5::SelPair &piece : *span.pieces_)
+        memcpy(span.buf_.data() + (piece.file_off_ - span.lo_) * type_size, src + piece.mem_off_ * type_size,
+               piece.len_ * type_size);
+      ops.push_back(h5::IoOp{dset->fd_, true, span.buf_.data(), size, off, 0, dset->dfd_});
+    }
+    if (!ops.empty() && io->Submit(ops.data(), ops.size()) < 0)
+      return -1;
+  }
+  return 0;
+} /* end H5VL_pfs_vol_xfer_write() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_xfer_finish
+ *
+ * Purpose:     Convert the data of a read to the memory datatype.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_xfer_finish(H5VL_pfs_vol_xfer_t *xfer)
+{
+  if (xfer->write_ || xfer->mem_type_id_ == H5I_INVALID_HID)
+    return 0;
+  if (H5Tconvert(xfer->o_->dset_->type_id_, xfer->mem_type_id_, xfer->npoints_, xfer->packed_.data(), nullptr,
+                 H5P_DEFAULT) < 0)
+    return -1;
+  h5::UnpackPairs(xfer->packed_.data(), xfer->pairs_, H5Tget_size(xfer->mem_type_id_), xfer->buf_);
+  return 0;
+} /* end H5VL_pfs_vol_xfer_finish() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_xfer_async
+ *
+ * Purpose:     Run the chunk I/O of planned transfers on the request
+ *              workers. The caller keeps the buffers alive until the
+ *              request completes, as for any HDF5 async operation. Each
+ *              transfer takes its dataset's next turn here, so the
+ *              transfers of a dataset run in the order they were issued.
+ *              The notify callback is left to request_wait, which runs
+ *              on the application thread.
+ *
+ * Return:      The request
+ *
+ *-------------------------------------------------------------------------
+ */
+static H5VL_pfs_vol_req_t *
+H5VL_pfs_vol_xfer_async(std::vector<std::unique_ptr<H5VL_pfs_vol_xfer_t>> &&xfers)
+{
+  H5VL_pfs_vol_req_t *req = new H5VL_pfs_vol_req_t();
+  auto owned = std::make_shared<std::vector<std::unique_ptr<H5VL_pfs_vol_xfer_t>>>(std::move(xfers));
+  std::vector<uint64_t> tickets;
+
+  req->done_ = false;
+  req->ret_ = 0;
+  req->cb_ = nullptr;
+  req->ctx_ = nullptr;
+  req->notified_ = false;
+  req->refs_ = 2;
+  for (auto &xfer : *owned) {
+    tickets.push_back(H5VL_pfs_vol_turn_take(xfer->o_->dset_));
+    std::lock_guard<std::mutex> guard(xfer->o_->dset_->lock_);
+    xfer->o_->dset_->pending_++;
+  }
+  H5VL_pfs_vol_pool_g->Submit([req, owned, tickets]() {
+    herr_t ret_value = 0;
+    for (size_t i = 0; i < owned->size(); i++) {
+      H5VL_pfs_vol_xfer_t *xfer = (*owned)[i].get();
+      H5VL_pfs_vol_dset_t *dset = xfer->o_->dset_;
+      H5VL_pfs_vol_turn_wait(dset, tickets[i]);
+      if ((xfer->write_ ? H5VL_pfs_vol_xfer_write(xfer) : H5VL_pfs_vol_xfer_read(xfer)) < 0)
+        ret_value = -1;
+      H5VL_pfs_vol_turn_done(dset);
+      std::lock_guard<std::mutex> guard(dset->lock_);
+      if (--dset->pending_ == 0)
+        dset->idle_.notify_all();
+    }
+    {
+      std::lock_guard<std::mutex> guard(req->lock_);
+      req->done_ = true;
+      req->ret_ = ret_value;
+    }
+    req->done_cv_.notify_all();
+    H5VL_pfs_vol_req_release(req);
+  });
+  return req;
+} /* end H5VL_pfs_vol_xfer_async() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_req_release
+ *
+ * Purpose:     Drop one reference to a request, freeing it with the last.
+ *
+ *-------------------------------------------------------------------------
+ */
+static void
+H5VL_pfs_vol_req_release(H5VL_pfs_vol_req_t *req)
+{
+  bool last;
+  {
+    std::lock_guard<std::mutex> guard(req->lock_);
+    last = --req->refs_ == 0;
+  }
+  if (last)
+    delete req;
+} /* end H5VL_pfs_vol_req_release() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_wait_idle
+ *
+ * Purpose:     Wait for the async requests on a dataset to finish.
+ *
+ *-------------------------------------------------------------------------
+ */
+static void
+H5VL_pfs_vol_wait_idle(H5VL_pfs_vol_dset_t *dset)
+{
+  std::unique_lock<std::mutex> guard(dset->lock_);
+  dset->idle_.wait(guard, [dset]() { return dset->pending_ == 0; });
+} /* end H5VL_pfs_vol_wait_idle() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_turn_take
+ *
+ * Purpose:     Hand out the next turn on a dataset to a transfer being
+ *              issued. Transfers run in ticket order, so a read issued
+ *              after an async write sees its data.
+ *
+ * Return:      The ticket
+ *
+ *-------------------------------------------------------------------------
+ */
+static uint64_t
+H5VL_pfs_vol_turn_take(H5VL_pfs_vol_dset_t *dset)
+{
+  std::lock_guard<std::mutex> guard(dset->lock_);
+  return dset->next_turn_++;
+} /* end H5VL_pfs_vol_turn_take() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_turn_wait
+ *
+ * Purpose:     Wait until the transfers issued before \a ticket ran.
+ *
+ *-------------------------------------------------------------------------
+ */
+static void
+H5VL_pfs_vol_turn_wait(H5VL_pfs_vol_dset_t *dset, uint64_t ticket)
+{
+  std::unique_lock<std::mutex> guard(dset->lock_);
+  dset->turn_cv_.wait(guard, [dset, ticket]() { return dset->turn_ == ticket; });
+} /* end H5VL_pfs_vol_turn_wait() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_turn_done
+ *
+ * Purpose:     Pass the turn on a dataset to the next transfer.
+ *
+ *-------------------------------------------------------------------------
+ */
+static void
+H5VL_pfs_vol_turn_done(H5VL_pfs_vol_dset_t *dset)
+{
+  {
+    std::lock_guard<std::mutex> guard(dset->lock_);
+    dset->turn_++;
+  }
+  dset->turn_cv_.notify_all();
+} /* end H5VL_pfs_vol_turn_done() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_rank
+ *
+ * Purpose:     This process's rank in MPI_COMM_WORLD, or 0 without MPI.
+ *
+ *-------------------------------------------------------------------------
+ */
+static int
+H5VL_pfs_vol_rank(void)
+{
+  int initialized = 0, rank = 0;
+  MPI_Initialized(&initialized);
+  if (initialized)
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  return rank;
+} /* end H5VL_pfs_vol_rank() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_mpi
+ *
+ * Purpose:     Whether MPI can be used: it is initialized and not yet
+ *              finalized.
+ *
+ *-------------------------------------------------------------------------
+ */
+static bool
+H5VL_pfs_vol_mpi(void)
+{
+  int initialized = 0, finalized = 0;
+  MPI_Initialized(&initialized);
+  MPI_Finalized(&finalized);
+  return initialized && !finalized;
+} /* end H5VL_pfs_vol_mpi() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_subfile_init
+ *
+ * Purpose:     Pick the subfile this rank writes. Subfiles are numbered
+ *              from 1: rank + 1 with a subfile per rank, and the lowest
+ *              rank on the node + 1 with a subfile per node. Collective
+ *              over MPI_COMM_WORLD in the per-node mode.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1 (too many ranks to number the subfiles)
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_subfile_init(H5VL_pfs_vol_file_t *file, int mode)
+{
+  int rank = H5VL_pfs_vol_rank(), leader = rank;
+  MPI_Comm node;
+
+  file->subfile_ = 0;
+  file->subfile_rank_ = 0;
+  file->subfile_ranks_ = 1;
+  if (mode == H5VL_PFS_VOL_SUBFILE_OFF)
+    return 0;
+  if (mode == H5VL_PFS_VOL_SUBFILE_NODE && H5VL_pfs_vol_mpi()) {
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node);
+    MPI_Comm_rank(node, &file->subfile_rank_);
+    MPI_Comm_size(node, &file->subfile_ranks_);
+    MPI_Allreduce(MPI_IN_PLACE, &leader, 1, MPI_INT, MPI_MIN, node);
+    MPI_Comm_free(&node);
+  }
+  if (leader + 1 > H5VL_PFS_VOL_MAX_SUBFILE)
+    return -1;
+  file->subfile_ = (uint32_t)leader + 1;
+  return 0;
+} /* end H5VL_pfs_vol_subfile_init() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_data_path
+ *
+ * Purpose:     Path of a data file of the dataset in \a dir: "data" for
+ *              subfile 0 and "data.<subfile>" otherwise.
+ *
+ *-------------------------------------------------------------------------
+ */
+static std::string
+H5VL_pfs_vol_data_path(const std::string &dir, uint32_t subfile)
+{
+  return dir + (subfile ? "/data." + std::to_string(subfile) : std::string("/data"));
+} /* end H5VL_pfs_vol_data_path() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_data_open
+ *
+ * Purpose:     Open the data file this rank writes. Engines using
+ *              O_DIRECT get a second descriptor; without one (e.g., on
+ *              file systems that refuse O_DIRECT) they use buffered I/O.
+ *              New data files get the container's stripe layout. A
+ *              read-only open of a data file that was never created (all
+ *              chunks live in subfiles) leaves fd_ at -1.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_data_open(H5VL_pfs_vol_t *o, int flags)
+{
+  H5VL_pfs_vol_dset_t *dset = o->dset_;
+  std::string data = H5VL_pfs_vol_data_path(o->path_, o->file_->subfile_);
+
+  if (flags & O_CREAT)
+    h5::CreateStriped(data, o->stripe_size_, o->stripe_count_);
+  dset->fd_ = open(data.c_str(), flags, 0644);
+  if (dset->fd_ < 0)
+    return errno == ENOENT && (flags & O_ACCMODE) == O_RDONLY ? 0 : -1;
+  if (o->file_->io_->Alignment())
+    dset->dfd_ = open(data.c_str(), (flags & O_ACCMODE) | O_DIRECT);
+  return 0;
+} /* end H5VL_pfs_vol_data_open() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_chunk_fds
+ *
+ * Purpose:     Descriptors to read the chunk at \a loc through. Other
+ *              ranks' subfiles are opened read-only on first use and
+ *              read with buffered I/O. The caller holds the dataset lock.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_chunk_fds(H5VL_pfs_vol_t *o, uint64_t loc, int *fd, int *dfd)
+{
+  H5VL_pfs_vol_dset_t *dset = o->dset_;
+  uint32_t subfile = H5VL_PFS_VOL_LOC_SUBFILE(loc);
+  auto it = dset->subfiles_.find(subfile);
+
+  if (subfile == o->file_->subfile_) {
+    *fd = dset->fd_;
+    *dfd = dset->dfd_;
+    return *fd < 0 ? -1 : 0;
+  }
+  if (it == dset->subfiles_.end()) {
+    int sfd = open(H5VL_pfs_vol_data_path(o->path_, subfile).c_str(), O_RDONLY);
+    if (sfd < 0)
+      return -1;
+    it = dset->subfiles_.emplace(subfile, sfd).first;
+  }
+  *fd = it->second;
+  *dfd = -1;
+  return 0;
+} /* end H5VL_pfs_vol_chunk_fds() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_chunk_alloc
+ *
+ * Purpose:     Make sure a chunk about to be written lives in the data
+ *              file this rank writes. A chunk never written is allocated
+ *              at the end of it; a chunk held in another subfile is
+ *              copied over whole first, so ranks never write each
+ *              other's subfiles while the container is open; elements
+ *              other ranks wrote to the chunk in the meantime are
+ *              patched in at close by H5VL_pfs_vol_subfile_resolve.
+ *              Chunks go in the slots of an
+ *              h5::ExtentLayout for the engine's O_DIRECT alignment,
+ *              align_ and stripe_size_; ranks sharing a subfile take
+ *              turns on the slots and so never allocate the same bytes.
+ *              The caller holds the dataset lock.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_chunk_alloc(H5VL_pfs_vol_t *o, size_t idx)
+{
+  H5VL_pfs_vol_dset_t *dset = o->dset_;
+  H5VL_pfs_vol_file_t *file = o->file_.get();
+  h5::ExtentLayout layout(dset->chunk_bytes_, std::max(file->io_->Alignment(), o->align_), o->stripe_size_);
+  uint64_t old = dset->chunks_[idx], off, slot, n = file->subfile_ranks_;
+
+  if (old != H5VL_PFS_VOL_NO_CHUNK && H5VL_PFS_VOL_LOC_SUBFILE(old) == file->subfile_)
+    return 0;
+  if (dset->fd_ < 0)
+    return -1;
+
+  /* Chunks sit on O_DIRECT blocks, the configured alignment and inside stripes */
+  slot = layout.FirstSlot(dset->end_);
+  slot += (file->subfile_rank_ + n - slot % n) % n;
+  off = layout.Offset(slot);
+  if (off + dset->chunk_bytes_ > H5VL_PFS_VOL_LOC_OFFSET(UINT64_MAX))
+    return -1;
+
+  if (old != H5VL_PFS_VOL_NO_CHUNK) {
+    std::vector<char> buf(dset->chunk_bytes_);
+    h5::IoOp op;
+    int fd, dfd;
+    if (H5VL_pfs_vol_chunk_fds(o, old, &fd, &dfd) < 0)
+      return -1;
+    op = h5::IoOp{fd, false, buf.data(), buf.size(), H5VL_PFS_VOL_LOC_OFFSET(old), 0, dfd};
+    if (file->io_->Submit(&op, 1) < 0)
+      return -1;
+    op = h5::IoOp{dset->fd_, true, buf.data(), buf.size(), off, 0, dset->dfd_};
+    if (file->io_->Submit(&op, 1) < 0)
+      return -1;
+  }
+  dset->chunks_[idx] = H5VL_PFS_VOL_LOC(file->subfile_, off);
+  dset->end_ = off + dset->chunk_bytes_;
+  dset->dirty_ = true;
+  return 0;
+} /* end H5VL_pfs_vol_chunk_alloc() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_write_seq
+ *
+ * Purpose:     Stamp a write of a dataset for H5VL_pfs_vol_subfile_merge:
+ *              the wall clock in nanoseconds, kept rising per dataset.
+ *              Ranks writing the same elements without synchronizing in
+ *              between race as they would on one file; otherwise the
+ *              stamps order their writes. The caller holds the dataset
+ *              lock.
+ *
+ *-------------------------------------------------------------------------
+ */
+static uint64_t
+H5VL_pfs_vol_write_seq(H5VL_pfs_vol_dset_t *dset)
+{
+  uint64_t now = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     std::chrono::system_clock::now().time_since_epoch())
+                     .count();
+
+  dset->seq_ = std::max(dset->seq_ + 1, now);
+  return dset->seq_;
+} /* end H5VL_pfs_vol_write_seq() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_chunk_written
+ *
+ * Purpose:     Note that elements [off, off + len) of a chunk were
+ *              written with sequence seq, for the claims handed to rank
+ *              0 at close. Only subfiled containers keep the notes. The
+ *              caller holds the dataset lock.
+ *
+ *-------------------------------------------------------------------------
+ */
+static void
+H5VL_pfs_vol_chunk_written(H5VL_pfs_vol_t *o, size_t idx, hsize_t off, hsize_t len, uint64_t seq)
+{
+  std::vector<H5VL_pfs_vol_claim_t> &written = o->dset_->written_;
+
+  if (o->file_->subfile_ == 0 || len == 0)
+    return;
+  if (!written.empty() && written.back().chunk_ == idx && written.back().seq_ == seq &&
+      written.back().hi_ == off)
+    written.back().hi_ = off + len;
+  else
+    written.push_back(H5VL_pfs_vol_claim_t{idx, H5VL_PFS_VOL_NO_CHUNK, off, off + len, seq});
+} /* end H5VL_pfs_vol_chunk_written() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_subfile_resolve
+ *
+ * Purpose:     Settle one chunk claimed by several writers in a session.
+ *              The copy of the latest writer becomes the chunk. Each
+ *              element goes to the writer with the latest run covering
+ *              it, and elements won by other writers are copied into
+ *              that copy. A writer's copy of a chunk first written
+ *              elsewhere starts as the whole old chunk, so the elements
+ *              other ranks wrote must be patched back in. Rank 0 does
+ *              this while every rank waits in the merge, so no subfile
+ *              is being written.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_subfile_resolve(H5VL_pfs_vol_t *o, std::vector<H5VL_pfs_vol_claim_t> &claims)
+{
+  typedef std::pair<uint64_t, const H5VL_pfs_vol_claim_t *> run_t;  /* (end, writer) */
+  H5VL_pfs_vol_dset_t *dset = o->dset_;
+  size_t type_size = dset->type_size_;
+  std::map<uint64_t, run_t> painted;
+  std::map<uint32_t, int> fds;
+  const H5VL_pfs_vol_claim_t *base;
+  herr_t ret_value = 0;
+
+  std::stable_sort(claims.begin(), claims.end(),
+                   [](const H5VL_pfs_vol_claim_t &a, const H5VL_pfs_vol_claim_t &b) { return a.seq_ < b.seq_; });
+  base = &claims.back();
+  dset->chunks_[base->chunk_] = base->loc_;
+
+  /* Paint the runs oldest first, so each element ends up with its last writer */
+  for (const H5VL_pfs_vol_claim_t &c : claims) {
+    auto it = painted.lower_bound(c.lo_);
+    if (it != painted.begin()) {
+      auto prev = std::prev(it);
+      if (prev->second.first > c.lo_) {
+        if (prev->second.first > c.hi_)
+          painted[c.hi_] = prev->second;
+        prev->second.first = c.lo_;
+      }
+    }
+    while (it != painted.end() && it->first < c.hi_) {
+      if (it->second.first > c.hi_) {
+        run_t tail = it->second;
+        painted.erase(it);
+        painted[c.hi_] = tail;
+        break;
+      }
+      it = painted.erase(it);
+    }
+    painted[c.lo_] = run_t(c.hi_, &c);
+  }
+
+  /* Copy the elements other writers won into the chosen copy */
+  for (auto &it : painted) {
+    const H5VL_pfs_vol_claim_t *c = it.second.second;
+    std::vector<char> buf;
+    h5::IoOp op;
+    if (c->loc_ == base->loc_)
+      continue;
+    for (uint64_t loc : {c->loc_, base->loc_}) {
+      uint32_t subfile = H5VL_PFS_VOL_LOC_SUBFILE(loc);
+      if (fds.count(subfile) == 0)
+        fds[subfile] = open(H5VL_pfs_vol_data_path(o->path_, subfile).c_str(), O_RDWR);
+    }
+    if (fds[H5VL_PFS_VOL_LOC_SUBFILE(c->loc_)] < 0 || fds[H5VL_PFS_VOL_LOC_SUBFILE(base->loc_)] < 0) {
+      ret_value = -1;
+      break;
+    }
+    buf.resize((it.second.first - it.first) * type_size);
+    op = h5::IoOp{fds[H5VL_PFS_VOL_LOC_SUBFILE(c->loc_)], false, buf.data(), buf.size(),
+                  H5VL_PFS_VOL_LOC_OFFSET(c->loc_) + it.first * type_size, 0};
+    if (h5::PosixIoEngine::Run(op) < 0) {
+      ret_value = -1;
+      break;
+    }
+    op = h5::IoOp{fds[H5VL_PFS_VOL_LOC_SUBFILE(base->loc_)], true, buf.data(), buf.size(),
+                  H5VL_PFS_VOL_LOC_OFFSET(base->loc_) + it.first * type_size, 0};
+    if (h5::PosixIoEngine::Run(op) < 0) {
+      ret_value = -1;
+      break;
+    }
+  }
+  for (auto &it : fds) {
+    if (it.second >= 0)
+      close(it.second);
+  }
+  return ret_value;
+} /* end H5VL_pfs_vol_subfile_resolve() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_subfile_merge
+ *
+ * Purpose:     Build the global chunk map of a subfiled container as it
+ *              is closed. Every rank sends rank 0 the runs it wrote to
+ *              its subfile this session, as noted by
+ *              H5VL_pfs_vol_dataset_close, and rank 0 records their
+ *              locations in the meta files. Chunks from earlier sessions
+ *              keep the location the meta file already gives them.
+ *              Where several ranks wrote the same chunk,
+ *              H5VL_pfs_vol_subfile_resolve combines them by write
+ *              sequence. Collective over MPI_COMM_WORLD.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1 (on all ranks)
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_subfile_merge(H5VL_pfs_vol_t *file)
+{
+  std::map<std::string, std::map<uint64_t, std::vector<H5VL_pfs_vol_claim_t>>> merged;
+  std::vector<char> local, all;
+  std::vector<int> sizes, displs;
+  int rank = H5VL_pfs_vol_rank(), nranks = 1, size, ret = 0;
+  bool mpi = H5VL_pfs_vol_mpi();
+
+  /* Pack (path bytes, claims) counts, the path and the claims per dataset */
+  for (auto &it : file->file_->owned_) {
+    uint64_t counts[2] = {it.first.size(), it.second.size()};
+    local.insert(local.end(), (const char *)counts, (const char *)(counts + 2));
+    local.insert(local.end(), it.first.begin(), it.first.end());
+    local.insert(local.end(), (const char *)it.second.data(), (const char *)(it.second.data() + it.second.size()));
+  }
+  file->file_->owned_.clear();
+  if (mpi) {
+    MPI_Comm_size(MPI_COMM_WORLD, &nranks);
+    size = (int)local.size();
+    sizes.resize(nranks);
+    displs.resize(nranks);
+    MPI_Gather(&size, 1, MPI_INT, sizes.data(), 1, MPI_INT, 0, MPI_COMM_WORLD);
+    for (int r = 1; r < nranks; r++)
+      displs[r] = displs[r - 1] + sizes[r - 1];
+    if (rank == 0)
+      all.resize(displs[nranks - 1] + sizes[nranks - 1]);
+    MPI_Gatherv(local.data(), size, MPI_CHAR, all.data(), sizes.data(), displs.data(), MPI_CHAR, 0,
+                MPI_COMM_WORLD);
+  } else {
+    all.swap(local);
+  }
+
+  if (rank == 0) {
+    for (const char *p = all.data(), *end = p + all.size(); p < end;) {
+      uint64_t counts[2];
+      memcpy(counts, p, sizeof(counts));
+      p += sizeof(counts);
+      std::map<uint64_t, std::vector<H5VL_pfs_vol_claim_t>> &chunks = merged[std::string(p, counts[0])];
+      p += counts[0];
+      for (uint64_t i = 0; i < counts[1]; i++, p += sizeof(H5VL_pfs_vol_claim_t)) {
+        H5VL_pfs_vol_claim_t c;
+        memcpy(&c, p, sizeof(c));
+        chunks[c.chunk_].push_back(c);
+      }
+    }
+    for (auto &it : merged) {
+      H5VL_pfs_vol_t *o = H5VL_pfs_vol_new_obj(file, "");
+      o->path_ = it.first;
+      o->dset_ = H5VL_pfs_vol_dset_blank();
+      if (H5VL_pfs_vol_meta_read(o) < 0) {
+        ret = -1;
+      } else {
+        for (auto &chunk : it.second)
+          if (chunk.first < o->dset_->chunks_.size() && H5VL_pfs_vol_subfile_resolve(o, chunk.second) < 0)
+            ret = -1;
+        if (H5VL_pfs_vol_meta_write(o) < 0)
+          ret = -1;
+      }
+      H5VL_pfs_vol_dset_free(o->dset_);
+      delete o;
+    }
+  }
+
+  /* Nobody returns (and maybe reopens) before the meta files are final */
+  if (mpi)
+    MPI_Bcast(&ret, 1, MPI_INT, 0, MPI_COMM_WORLD);
+  return ret;
+} /* end H5VL_pfs_vol_subfile_merge() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_collective
+ *
+ * Purpose:     Whether a write may go through the aggregators: only
+ *              when the dxpl asks for collective MPI-IO, so that every
+ *              rank is known to take part, and never with
+ *              cb_write=disable. Only subfiled containers are shared by
+ *              the ranks (without subfiling each rank keeps its own
+ *              container and metadata), so others never aggregate. Runs
+ *              without MPI or with a single rank are never collective.
+ *
+ *-------------------------------------------------------------------------
+ */
+static bool
+H5VL_pfs_vol_collective(const H5VL_pfs_vol_t *o, hid_t dxpl_id)
+{
+  int nranks = 1;
+#ifdef H5_HAVE_PARALLEL
+  H5FD_mpio_xfer_t mode = H5FD_MPIO_INDEPENDENT;
+#endif
+
+  if (o->cb_write_ == H5VL_PFS_VOL_CB_DISABLE || o->file_->subfile_ == 0 || !H5VL_pfs_vol_mpi())
+    return false;
+  MPI_Comm_size(MPI_COMM_WORLD, &nranks);
+  if (nranks == 1)
+    return false;
+#ifdef H5_HAVE_PARALLEL
+  return H5Pget_dxpl_mpio(dxpl_id, &mode) >= 0 && mode == H5FD_MPIO_COLLECTIVE;
+#else
+  return false;
+#endif
+} /* end H5VL_pfs_vol_collective() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_cb_init
+ *
+ * Purpose:     Elect the aggregators of a container: cb_nodes ranks
+ *              (one per node when 0), taken round-robin over the nodes
+ *              so that they spread evenly. Collective over
+ *              MPI_COMM_WORLD.
+ *
+ *-------------------------------------------------------------------------
+ */
+static void
+H5VL_pfs_vol_cb_init(H5VL_pfs_vol_file_t *file, size_t cb_nodes)
+{
+  int rank, nranks, mine[2];
+  std::vector<int> all, order;
+  size_t nnodes = 0;
+  MPI_Comm node;
+
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nranks);
+  MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node);
+  MPI_Comm_rank(node, &mine[0]);
+  mine[1] = rank;
+  MPI_Allreduce(MPI_IN_PLACE, &mine[1], 1, MPI_INT, MPI_MIN, node);
+  MPI_Comm_free(&node);
+  all.resize(2 * nranks);
+  MPI_Allgather(mine, 2, MPI_INT, all.data(), 2, MPI_INT, MPI_COMM_WORLD);
+
+  /* Order the ranks by their place on their node, then by node */
+  order.resize(nranks);
+  for (int r = 0; r < nranks; r++) {
+    order[r] = r;
+    nnodes += all[2 * r] == 0;
+  }
+  std::sort(order.begin(), order.end(), [&all](int a, int b) {
+    return std::make_pair(all[2 * a], all[2 * a + 1]) < std::make_pair(all[2 * b], all[2 * b + 1]);
+  });
+  if (cb_nodes == 0)
+    cb_nodes = nnodes;
+  file->aggregators_.assign(order.begin(), order.begin() + std::min<size_t>(cb_nodes, nranks));
+  std::sort(file->aggregators_.begin(), file->aggregators_.end());
+} /* end H5VL_pfs_vol_cb_init() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_cb_write
+ *
+ * Purpose:     Write a planned transfer in two phases, as ROMIO's
+ *              collective buffering does. The range of chunks written
+ *              by any rank is cut into one domain of whole chunks per
+ *              aggregator, so no two aggregators touch the same chunk.
+ *              In each round every rank sends its pieces of the next
+ *              cb_buffer_size_ bytes of each domain to the owning
+ *              aggregator, which then writes them as one transfer with
+ *              a single write per chunk. Rounds nobody has data for are
+ *              skipped. Each aggregator allocates the chunks of its
+ *              domain in its own subfile. Collective over
+ *              MPI_COMM_WORLD.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1 (on all ranks)
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_cb_write(H5VL_pfs_vol_xfer_t *xfer)
+{
+  typedef std::map<size_t, std::vector<h5::SelPair>>::const_iterator chunk_it;
+  H5VL_pfs_vol_t *o = xfer->o_;
+  H5VL_pfs_vol_dset_t *dset = o->dset_;
+  H5VL_pfs_vol_file_t *file = o->file_.get();
+  size_t type_size = dset->type_size_, naggr;
+  uint64_t range[2] = {UINT64_MAX, UINT64_MAX}, lo, nchunks, per, cpr;
+  std::vector<uint8_t> touched;
+  std::map<uint64_t, std::vector<chunk_it>> rounds;
+  std::vector<int> counts, rcounts, scnt, sdispl, rcnt, rdispl;
+  int nranks, ret = 0;
+
+  if (file->aggregators_.empty())
+    H5VL_pfs_vol_cb_init(file, o->cb_nodes_);
+  naggr = file->aggregators_.size();
+  MPI_Comm_size(MPI_COMM_WORLD, &nranks);
+
+  /* The chunks written by anyone */
+  if (!xfer->chunks_.empty()) {
+    range[0] = xfer->chunks_.begin()->first;
+    range[1] = UINT64_MAX - xfer->chunks_.rbegin()->first;
+  }
+  MPI_Allreduce(MPI_IN_PLACE, range, 2, MPI_UINT64_T, MPI_MIN, MPI_COMM_WORLD);
+  if (range[0] == UINT64_MAX)
+    return 0;
+  lo = range[0];
+  nchunks = UINT64_MAX - range[1] - lo + 1;
+  per = (nchunks + naggr - 1) / naggr;
+  cpr = std::min<uint64_t>(per, std::max<uint64_t>(o->cb_buffer_size_ / dset->chunk_bytes_, 1));
+  touched.assign((nchunks + 7) / 8, 0);
+  for (chunk_it it = xfer->chunks_.begin(); it != xfer->chunks_.end(); ++it) {
+    uint64_t rel = it->first - lo;
+    touched[rel / 8] |= (uint8_t)(1 << (rel % 8));
+    rounds[rel % per / cpr].push_back(it);
+  }
+  MPI_Allreduce(MPI_IN_PLACE, touched.data(), (int)touched.size(), MPI_UINT8_T, MPI_BOR, MPI_COMM_WORLD);
+
+  auto layout = [nranks](const std::vector<int> &c, int field, std::vector<int> &cnt, std::vector<int> &displ) {
+    size_t total = 0;
+    cnt.resize(nranks);
+    displ.resize(nranks);
+    for (int p = 0; p < nranks; p++) {
+      cnt[p] = c[2 * p + field];
+      displ[p] = (int)total;
+      total += cnt[p];
+    }
+    return total;
+  };
+  for (uint64_t r = 0; r < (per + cpr - 1) / cpr; r++) {
+    std::vector<uint64_t> srecs, rrecs;
+    std::vector<char> sdata, rdata;
+    bool active = false;
+    for (uint64_t a = 0; a < naggr && !active; a++)
+      for (uint64_t rel = a * per + r * cpr; rel < std::min(nchunks, a * per + (r + 1) * cpr) && !active; rel++)
+        active = touched[rel / 8] >> (rel % 8) & 1;
+    if (!active)
+      continue;
+
+    /* Pack (chunk, offset, length) records and data for each aggregator.
+     * Chunks ascend, so the destinations do too. */
+    counts.assign(2 * nranks, 0);
+    auto mine = rounds.find(r);
+    if (mine != rounds.end()) {
+      for (chunk_it it : mine->second) {
+        int dest = file->aggregators_[(it->first - lo) / per];
+        for (const h5::SelPair &piece : it->second) {
+          const char *from = xfer->mem_ + piece.mem_off_ * type_size;
+          srecs.insert(srecs.end(), {(uint64_t)it->first, (uint64_t)piece.file_off_, (uint64_t)piece.len_});
+          sdata.insert(sdata.end(), from, from + piece.len_ * type_size);
+          counts[2 * dest] += 3;
+          counts[2 * dest + 1] += (int)(piece.len_ * type_size);
+        }
+      }
+    }
+    rcounts.resize(2 * nranks);
+    MPI_Alltoall(counts.data(), 2, MPI_INT, rcounts.data(), 2, MPI_INT, MPI_COMM_WORLD);
+    layout(counts, 0, scnt, sdispl);
+    rrecs.resize(layout(rcounts, 0, rcnt, rdispl));
+    MPI_Alltoallv(srecs.data(), scnt.data(), sdispl.data(), MPI_UINT64_T, rrecs.data(), rcnt.data(),
+                  rdispl.data(), MPI_UINT64_T, MPI_COMM_WORLD);
+    layout(counts, 1, scnt, sdispl);
+    rdata.resize(layout(rcounts, 1, rcnt, rdispl));
+    MPI_Alltoallv(sdata.data(), scnt.data(), sdispl.data(), MPI_BYTE, rdata.data(), rcnt.data(), rdispl.data(),
+                  MPI_BYTE, MPI_COMM_WORLD);
+
+    /* Aggregators write what they gathered, later ranks' pieces landing
+     * over earlier ones where they overlap */
+    if (!rrecs.empty()) {
+      H5VL_pfs_vol_xfer_t agg;
+      hsize_t mem_off = 0;
+      agg.o_ = o;
+      agg.write_ = true;
+      agg.mem_ = rdata.data();
+      agg.mem_type_id_ = H5I_INVALID_HID;
+      agg.buf_ = rdata.data();
+      for (size_t i = 0; i + 2 < rrecs.size(); i += 3) {
+        agg.chunks_[rrecs[i]].push_back(h5::SelPair{rrecs[i + 1], mem_off, rrecs[i + 2]});
+        mem_off += rrecs[i + 2];
+      }
+      agg.npoints_ = mem_off;
+      H5VL_pfs_vol_xfer_plan(&agg);
+      if (H5VL_pfs_vol_xfer_write(&agg) < 0)
+        ret = -1;
+    }
+  }
+  MPI_Allreduce(MPI_IN_PLACE, &ret, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+  return ret;
+} /* end H5VL_pfs_vol_cb_write() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_log_index
+ *
+ * Purpose:     Record that elements [off, off + len) of a chunk are in
+ *              the log at byte log_off, replacing whatever the index
+ *              held for those elements.
+ *
+ *-------------------------------------------------------------------------
+ */
+static void
+H5VL_pfs_vol_log_index(H5VL_pfs_vol_dset_t *dset, size_t idx, hsize_t off, hsize_t len, uint64_t log_off)
+{
+  std::map<hsize_t, H5VL_pfs_vol_extent_t> &extents = dset->extents_[idx];
+  hsize_t end = off + len;
+  auto it = extents.lower_bound(off);
+
+  /* Trim an extent starting before off, keeping any part past end */
+  if (it != extents.begin()) {
+    auto prev = std::prev(it);
+    if (prev->second.end_ > off) {
+      if (prev->second.end_ > end)
+        extents[end] = H5VL_pfs_vol_extent_t{prev->second.end_,
+                                             prev->second.log_off_ + (end - prev->first) * dset->type_size_};
+      prev->second.end_ = off;
+    }
+  }
+
+  /* Drop extents inside [off, end), keeping the tail of the last one */
+  while (it != extents.end() && it->first < end) {
+    if (it->second.end_ > end) {
+      H5VL_pfs_vol_extent_t tail{it->second.end_, it->second.log_off_ + (end - it->first) * dset->type_size_};
+      extents.erase(it);
+      extents[end] = tail;
+      break;
+    }
+    it = extents.erase(it);
+  }
+  extents[off] = H5VL_pfs_vol_extent_t{end, log_off};
+} /* end H5VL_pfs_vol_log_index() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_log_open
+ *
+ * Purpose:     Open this rank's log of a dataset and rebuild the extent
+ *              index from the records in it. Replay stops at the first
+ *              record that is torn (from a crash mid-append) or fails its
+ *              CRC, and the log is cut off there. Read-only opens index
+ *              an existing log without changing it.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_log_open(H5VL_pfs_vol_t *o)
+{
+  H5VL_pfs_vol_dset_t *dset = o->dset_;
+  std::string path = o->path_ + "/log." + std::to_string(H5VL_pfs_vol_rank());
+  std::vector<char> log;
+  struct stat st;
+  uint64_t pos = 0;
+  h5::IoOp op;
+
+  if (o->flags_ & H5F_ACC_RDWR) {
+    dset->log_fd_ = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+  } else {
+    dset->log_fd_ = open(path.c_str(), O_RDONLY);
+    if (dset->log_fd_ < 0 && errno == ENOENT)
+      return 0;
+  }
+  if (dset->log_fd_ < 0 || fstat(dset->log_fd_, &st) < 0)
+    return -1;
+  log.resize(st.st_size);
+  op = h5::IoOp{dset->log_fd_, false, log.data(), log.size(), 0, 0};
+  if (h5::PosixIoEngine::Run(op) < 0)
+    return -1;
+
+  while (pos + sizeof(H5VL_pfs_vol_log_rec_t) <= log.size()) {
+    H5VL_pfs_vol_log_rec_t rec;
+    std::vector<uint64_t> runs;
+    uint64_t payload, bytes = 0;
+    uint32_t zero = 0;
+    memcpy(&rec, log.data() + pos, sizeof(rec));
+    if (rec.magic_ != H5VL_PFS_VOL_LOG_MAGIC || rec.chunk_ >= dset->chunks_.size() ||
+        pos + sizeof(rec) + (uint64_t)rec.nruns_ * 2 * sizeof(uint64_t) > log.size())
+      break;
+    runs.resize(rec.nruns_ * 2);
+    memcpy(runs.data(), log.data() + pos + sizeof(rec), runs.size() * sizeof(uint64_t));
+    payload = pos + sizeof(rec) + runs.size() * sizeof(uint64_t);
+    for (uint32_t r = 0; r < rec.nruns_; r++)
+      bytes += runs[2 * r + 1] * dset->type_size_;
+    if (payload + bytes > log.size())
+      break;
+    memcpy(log.data() + pos + offsetof(H5VL_pfs_vol_log_rec_t, crc_), &zero, sizeof(zero));
+    if (h5::Crc32c(log.data() + pos, payload + bytes - pos) != rec.crc_)
+      break;
+    for (uint32_t r = 0; r < rec.nruns_; r++) {
+      H5VL_pfs_vol_log_index(dset, rec.chunk_, runs[2 * r], runs[2 * r + 1], payload);
+      H5VL_pfs_vol_chunk_written(o, rec.chunk_, runs[2 * r], runs[2 * r + 1], 1);
+      payload += runs[2 * r + 1] * dset->type_size_;
+    }
+    pos = payload;
+  }
+  if (pos < log.size() && (o->flags_ & H5F_ACC_RDWR) && ftruncate(dset->log_fd_, pos) < 0)
+    return -1;
+  dset->log_end_ = pos;
+  return 0;
+} /* end H5VL_pfs_vol_log_open() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_log_append
+ *
+ * Purpose:     Write a planned transfer as one append to the log: a
+ *              record per chunk holding its runs and their data. The
+ *              chunk files are not touched; once the log passes
+ *              log_compact_ bytes it is merged into them, in the
+ *              background when there are request workers.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_log_append(H5VL_pfs_vol_xfer_t *xfer)
+{
+  H5VL_pfs_vol_t *o = xfer->o_;
+  H5VL_pfs_vol_dset_t *dset = o->dset_;
+  size_t type_size = dset->type_size_;
+  std::vector<char> buf;
+  size_t size = 0;
+  uint64_t seq;
+  char *p;
+  h5::IoOp op;
+  std::lock_guard<std::mutex> guard(dset->lock_);
+
+  for (const H5VL_pfs_vol_span_t &span : xfer->spans_) {
+    size += sizeof(H5VL_pfs_vol_log_rec_t) + span.pieces_->size() * 2 * sizeof(uint64_t);
+    for (const h5::SelPair &piece : *span.pieces_)
+      size += piece.len_ * type_size;
+  }
+  if (size == 0)
+    return 0;
+  buf.resize(size);
+  p = buf.data();
+  for (const H5VL_pfs_vol_span_t &span : xfer->spans_) {
+    H5VL_pfs_vol_log_rec_t rec{H5VL_PFS_VOL_LOG_MAGIC, (uint32_t)span.pieces_->size(), span.idx_, 0, 0};
+    char *start = p;
+    memcpy(p, &rec, sizeof(rec));
+    p += sizeof(rec);
+    for (const h5::SelPair &piece : *span.pieces_) {
+      uint64_t run[2] = {piece.file_off_, piece.len_};
+      memcpy(p, run, sizeof(run));
+      p += sizeof(run);
+    }
+    for (const h5::SelPair &piece : *span.pieces_) {
+      memcpy(p, xfer->mem_ + piece.mem_off_ * type_size, piece.len_ * type_size);
+      p += piece.len_ * type_size;
+    }
+    rec.crc_ = h5::Crc32c(start, p - start);
+    memcpy(start + offsetof(H5VL_pfs_vol_log_rec_t, crc_), &rec.crc_, sizeof(rec.crc_));
+  }
+  op = h5::IoOp{dset->log_fd_, true, buf.data(), size, dset->log_end_, 0};
+  if (o->file_->io_->Submit(&op, 1) < 0)
+    return -1;
+
+  /* Index the runs where their data landed */
+  seq = H5VL_pfs_vol_write_seq(dset);
+  for (const H5VL_pfs_vol_span_t &span : xfer->spans_) {
+    dset->log_end_ += sizeof(H5VL_pfs_vol_log_rec_t) + span.pieces_->size() * 2 * sizeof(uint64_t);
+    for (const h5::SelPair &piece : *span.pieces_) {
+      H5VL_pfs_vol_log_index(dset, span.idx_, piece.file_off_, piece.len_, dset->log_end_);
+      H5VL_pfs_vol_chunk_written(o, span.idx_, piece.file_off_, piece.len_, seq);
+      dset->log_end_ += piece.len_ * type_size;
+    }
+  }
+
+  if (dset->log_end_ < o->log_compact_ || dset->compact_queued_)
+    return 0;
+  if (H5VL_pfs_vol_pool_g == nullptr)
+    return H5VL_pfs_vol_log_compact(o, nullptr);
+  dset->compact_queued_ = true;
+  dset->pending_++;
+  H5VL_pfs_vol_pool_g->Submit([o]() {
+    H5VL_pfs_vol_dset_t *dset = o->dset_;
+    std::unique_lock<std::mutex> lock(dset->lock_);
+    H5VL_pfs_vol_log_compact(o, &lock);
+    dset->compact_queued_ = false;
+    if (--dset->pending_ == 0)
+      dset->idle_.notify_all();
+  });
+  return 0;
+} /* end H5VL_pfs_vol_log_append() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_log_overlay
+ *
+ * Purpose:     Copy logged data over the parts of a planned read it
+ *              covers, after the chunks themselves were read.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_log_overlay(H5VL_pfs_vol_xfer_t *xfer)
+{
+  H5VL_pfs_vol_dset_t *dset = xfer->o_->dset_;
+  size_t type_size = dset->type_size_;
+  std::vector<h5::IoOp> ops;
+
+  for (const H5VL_pfs_vol_span_t &span : xfer->spans_) {
+    auto chunk = dset->extents_.find(span.idx_);
+    if (chunk == dset->extents_.end())
+      continue;
+    const std::map<hsize_t, H5VL_pfs_vol_extent_t> &extents = chunk->second;
+    for (const h5::SelPair &piece : *span.pieces_) {
+      hsize_t end = piece.file_off_ + piece.len_;
+      auto it = extents.upper_bound(piece.file_off_);
+      if (it != extents.begin() && std::prev(it)->second.end_ > piece.file_off_)
+        --it;
+      for (; it != extents.end() && it->first < end; ++it) {
+        hsize_t lo = std::max(piece.file_off_, it->first), hi = std::min(end, it->second.end_);
+        ops.push_back(h5::IoOp{dset->log_fd_, false, xfer->mem_ + (piece.mem_off_ + lo - piece.file_off_) * type_size,
+                               (hi - lo) * type_size, it->second.log_off_ + (lo - it->first) * type_size, 0});
+      }
+    }
+  }
+  if (!ops.empty() && xfer->o_->file_->io_->Submit(ops.data(), ops.size()) < 0)
+    return -1;
+  return 0;
+} /* end H5VL_pfs_vol_log_overlay() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_log_compact
+ *
+ * Purpose:     Merge the logged data into the chunk files, make it and
+ *              the chunk index durable, then drop it from the extent
+ *              index and empty the log. A crash before the log is
+ *              emptied just replays it. The caller knows the dataset is
+ *              idle, or passes the dataset lock it holds in \a lock:
+ *              the copy then runs unlocked over the extents indexed at
+ *              the start, and only the index update takes the lock
+ *              again. Runs appended meanwhile stay indexed, and the log
+ *              is only emptied if nothing was appended.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_log_compact(H5VL_pfs_vol_t *o, std::unique_lock<std::mutex> *lock)
+{
+  H5VL_pfs_vol_dset_t *dset = o->dset_;
+  h5::IoEngine *io = o->file_->io_.get();
+  size_t type_size = dset->type_size_;
+  std::map<size_t, std::map<hsize_t, H5VL_pfs_vol_extent_t>> extents;
+  std::map<size_t, uint64_t> offs;
+  std::vector<std::vector<char>> bufs;
+  std::vector<h5::IoOp> reads, writes;
+  size_t staged_bytes = 0;
+  uint64_t log_end = dset->log_end_;
+  int fd = dset->fd_, dfd = dset->dfd_;
+
+  if (dset->extents_.empty())
+    return 0;
+  for (auto &chunk : dset->extents_) {
+    if (H5VL_pfs_vol_chunk_alloc(o, chunk.first) < 0)
+      return -1;
+    offs[chunk.first] = H5VL_PFS_VOL_LOC_OFFSET(dset->chunks_[chunk.first]);
+  }
+  extents = dset->extents_;
+
+  /* Logged bytes never change and only compaction writes the chunk files
+   * in log mode, so the copy needs no lock */
+  if (lock)
+    lock->unlock();
+  for (auto chunk = extents.begin(); chunk != extents.end(); ++chunk) {
+    for (auto &it : chunk->second) {
+      size_t size = (it.second.end_ - it.first) * type_size;
+      bufs.emplace_back(size);
+      reads.push_back(h5::IoOp{dset->log_fd_, false, bufs.back().data(), size, it.second.log_off_, 0});
+      writes.push_back(h5::IoOp{fd, true, bufs.back().data(), size, offs[chunk->first] + it.first * type_size, 0, dfd});
+      staged_bytes += size;
+    }
+
+    /* Move a batch once enough is staged, and at the end */
+    if (staged_bytes >= H5VL_PFS_VOL_IO_BATCH || std::next(chunk) == extents.end()) {
+      if (io->Submit(reads.data(), reads.size()) < 0 || io->Submit(writes.data(), writes.size()) < 0) {
+        if (lock)
+          lock->lock();
+        return -1;
+      }
+      bufs.clear();
+      reads.clear();
+      writes.clear();
+      staged_bytes = 0;
+    }
+  }
+  if (fdatasync(fd) < 0) {
+    if (lock)
+      lock->lock();
+    return -1;
+  }
+  if (lock)
+    lock->lock();
+
+  /* Swap in the index: what was logged before the copy is in the chunks now */
+  if (H5VL_pfs_vol_meta_write(o) < 0)
+    return -1;
+  for (auto chunk = dset->extents_.begin(); chunk != dset->extents_.end();) {
+    for (auto it = chunk->second.begin(); it != chunk->second.end();)
+      it = it->second.log_off_ < log_end ? chunk->second.erase(it) : std::next(it);
+    chunk = chunk->second.empty() ? dset->extents_.erase(chunk) : std::next(chunk);
+  }
+  if (dset->log_end_ == log_end) {
+    if (ftruncate(dset->log_fd_, 0) < 0)
+      return -1;
+    dset->log_end_ = 0;
+  }
+  return 0;
+} /* end H5VL_pfs_vol_log_compact() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_stage_open
+ *
+ * Purpose:     Attach a container to its node-wide staging pool, a POSIX
+ *              shared memory segment named after the container's
+ *              canonical path, so every process on the node opening the
+ *              container shares it. Writable opens also start a thread
+ *              writing staged chunks back every
+ *              H5VL_PFS_VOL_STAGE_FLUSH_MS, or sooner when the pool
+ *              fills up. Does nothing unless stage_size_ is set.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_stage_open(H5VL_pfs_vol_t *file)
+{
+  H5VL_pfs_vol_file_t *f = file->file_.get();
+  std::error_code ec;
+  std::string root;
+  char name[64];
+
+  if (file->stage_size_ == 0)
+    return 0;
+  root = std::filesystem::canonical(file->path_, ec).string();
+  if (ec)
+    return -1;
+  snprintf(name, sizeof(name), "/pfs_vol.%016llx", (unsigned long long)h5::StableHash(root));
+  f->stage_ = std::make_unique<h5::StagePool>();
+  if (f->stage_->Attach(name, file->stage_size_, file->stage_block_) < 0) {
+    f->stage_.reset();
+    return -1;
+  }
+  if (!(file->flags_ & H5F_ACC_RDWR))
+    return 0;
+  f->flush_stop_ = false;
+  f->flusher_ = std::thread([f]() {
+    std::unique_lock<std::mutex> lock(f->flush_lock_);
+    while (!f->flush_stop_) {
+      std::map<std::string, int> fds;
+      f->flush_cv_.wait_for(lock, std::chrono::milliseconds(H5VL_PFS_VOL_STAGE_FLUSH_MS));
+      lock.unlock();
+
+      /* Failures are retried next round; chunks failing too often are dropped and flushes report them */
+      f->stage_->Flush(-1, [&fds](const char *dir, uint64_t loc, const char *buf, size_t size) {
+        return H5VL_pfs_vol_stage_writeback(fds, dir, loc, buf, size);
+      });
+      for (auto &it : fds)
+        close(it.second);
+      lock.lock();
+    }
+  });
+  return 0;
+} /* end H5VL_pfs_vol_stage_open() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_stage_close
+ *
+ * Purpose:     Stop the flusher, write back whatever is still staged
+ *              (e.g., by a process that died) and detach from the
+ *              staging pool. The last process on the node to detach
+ *              removes the pool.
+ *
+ *-------------------------------------------------------------------------
+ */
+static void
+H5VL_pfs_vol_stage_close(H5VL_pfs_vol_file_t *file)
+{
+  std::map<std::string, int> fds;
+
+  if (file->stage_ == nullptr)
+    return;
+  if (file->flusher_.joinable()) {
+    {
+      std::lock_guard<std::mutex> guard(file->flush_lock_);
+      file->flush_stop_ = true;
+    }
+    file->flush_cv_.notify_all();
+    file->flusher_.join();
+    file->stage_->Flush(-1, [&fds](const char *dir, uint64_t loc, const char *buf, size_t size) {
+      return H5VL_pfs_vol_stage_writeback(fds, dir, loc, buf, size);
+    });
+    for (auto &it : fds)
+      close(it.second);
+  }
+  file->stage_.reset();
+} /* end H5VL_pfs_vol_stage_close() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_stage_attach
+ *
+ * Purpose:     Register a dataset whose chunks fit a staging block with
+ *              the container's staging pool, under its canonical path.
+ *              A newly created dataset forgets clean chunks left over
+ *              from an earlier dataset of the same name.
+ *
+ *-------------------------------------------------------------------------
+ */
+static void
+H5VL_pfs_vol_stage_attach(H5VL_pfs_vol_t *o, bool created)
+{
+  h5::StagePool *stage = o->file_->stage_.get();
+  std::error_code ec;
+  std::string path;
+
+  if (stage == nullptr || o->dset_->chunk_bytes_ > stage->BlockSize())
+    return;
+  path = std::filesystem::canonical(o->path_, ec).string();
+  if (ec)
+    return;
+  o->dset_->stage_ = stage->Dataset(path);
+  if (created && o->dset_->stage_ >= 0)
+    stage->Forget(o->dset_->stage_);
+} /* end H5VL_pfs_vol_stage_attach() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_stage_writeback
+ *
+ * Purpose:     Write a staged chunk back to its data file in the
+ *              dataset directory \a dir. Files are opened on first use
+ *              and kept in \a fds for the caller to close.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_stage_writeback(std::map<std::string, int> &fds, const char *dir, uint64_t loc, const char *buf,
+                             size_t size)
+{
+  std::string data = H5VL_pfs_vol_data_path(dir, H5VL_PFS_VOL_LOC_SUBFILE(loc));
+  auto it = fds.find(data);
+  h5::IoOp op;
+
+  if (it == fds.end()) {
+    int fd = open(data.c_str(), O_WRONLY);
+    if (fd < 0)
+      return -1;
+    it = fds.emplace(data, fd).first;
+  }
+  op = h5::IoOp{it->second, true, (void *)buf, size, H5VL_PFS_VOL_LOC_OFFSET(loc), 0};
+  return h5::PosixIoEngine::Run(op) < 0 ? -1 : 0;
+} /* end H5VL_pfs_vol_stage_writeback() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_stage_flush
+ *
+ * Purpose:     Write back the staged chunks of a dataset, whichever
+ *              process on the node staged them.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_stage_flush(H5VL_pfs_vol_t *o)
+{
+  std::map<std::string, int> fds;
+  herr_t ret_value;
+
+  if (o->file_->stage_ == nullptr || o->dset_->stage_ < 0)
+    return 0;
+  ret_value = o->file_->stage_->Flush(o->dset_->stage_, [&fds](const char *dir, uint64_t loc, const char *buf,
+                                                                 size_t size) {
+    return H5VL_pfs_vol_stage_writeback(fds, dir, loc, buf, size);
+  });
+  for (auto &it : fds)
+    close(it.second);
+  return ret_value;
+} /* end H5VL_pfs_vol_stage_flush() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_stage_write
+ *
+ * Purpose:     Write the spans of a planned transfer into the staging
+ *              pool instead of the data files, setting staged_ on those
+ *              that went in. A chunk not yet staged is allocated as for
+ *              any write and brought into a block whole, read from its
+ *              data file or zeroed if never written; later writes to it
+ *              only copy memory until the flusher writes it back. Spans
+ *              that find no free block are left to the caller and wake
+ *              the flusher. The caller holds the dataset lock.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_stage_write(H5VL_pfs_vol_xfer_t *xfer)
+{
+  H5VL_pfs_vol_dset_t *dset = xfer->o_->dset_;
+  H5VL_pfs_vol_file_t *file = xfer->o_->file_.get();
+  size_t type_size = dset->type_size_;
+  const char *src = xfer->mem_;
+  uint64_t seq = H5VL_pfs_vol_write_seq(dset);
+  bool full = false;
+
+  for (H5VL_pfs_vol_span_t &span : xfer->spans_) {
+    bool fresh = dset->chunks_[span.idx_] == H5VL_PFS_VOL_NO_CHUNK;
+    uint64_t loc;
+    int ret;
+    if (H5VL_pfs_vol_chunk_alloc(xfer->o_, span.idx_) < 0)
+      return -1;
+    loc = dset->chunks_[span.idx_];
+    ret = file->stage_->Write(
+        dset->stage_, span.idx_, loc, dset->chunk_bytes_,
+        [&](char *buf) {
+          h5::IoOp op{dset->fd_, false, buf, dset->chunk_bytes_, H5VL_PFS_VOL_LOC_OFFSET(loc), 0, dset->dfd_};
+          if (fresh) {
+            memset(buf, 0, dset->chunk_bytes_);
+            return 0;
+          }
+          return file->io_->Submit(&op, 1) < 0 ? -1 : 0;
+        },
+        [&](char *buf) {
+          for (const h5::SelPair &piece : *span.pieces_)
+            memcpy(buf + piece.file_off_ * type_size, src + piece.mem_off_ * type_size, piece.len_ * type_size);
+        });
+    if (ret < 0)
+      return -1;
+    span.staged_ = ret == 0;
+    full = full || ret > 0;
+    if (span.staged_) {
+      for (const h5::SelPair &piece : *span.pieces_)
+        H5VL_pfs_vol_chunk_written(xfer->o_, span.idx_, piece.file_off_, piece.len_, seq);
+    }
+  }
+  if (full)
+    file->flush_cv_.notify_one();
+  return 0;
+} /* end H5VL_pfs_vol_stage_write() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_stage_read
+ *
+ * Purpose:     Serve the spans of a planned read whose chunks are
+ *              resident in the staging pool, setting staged_ on them.
+ *              Chunks staged by other processes on the node are served
+ *              too, before they reach the data files. The caller holds
+ *              the dataset lock.
+ *
+ *-------------------------------------------------------------------------
+ */
+static void
+H5VL_pfs_vol_stage_read(H5VL_pfs_vol_xfer_t *xfer)
+{
+  H5VL_pfs_vol_dset_t *dset = xfer->o_->dset_;
+  size_t type_size = dset->type_size_;
+  char *dst = xfer->mem_;
+
+  for (H5VL_pfs_vol_span_t &span : xfer->spans_)
+    span.staged_ = xfer->o_->file_->stage_->Read(dset->stage_, span.idx_, [&](const char *buf) {
+      for (const h5::SelPair &piece : *span.pieces_)
+        memcpy(dst + piece.mem_off_ * type_size, buf + piece.file_off_ * type_size, piece.len_ * type_size);
+    });
+} /* end H5VL_pfs_vol_stage_read() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_cache_writeback
+ *
+ * Purpose:     Write the dirty bytes of cached chunks back to their data
+ *              files, one write per chunk covering everything changed
+ *              since the last write-back, and mark them clean. The caller
+ *              holds the cache lock.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_cache_writeback(H5VL_pfs_vol_file_t *file, const std::vector<H5VL_pfs_vol_cached_t *> &chunks)
+{
+  std::vector<h5::IoOp> ops;
+
+  for (H5VL_pfs_vol_cached_t *c : chunks)
+    if (c->dirty_lo_ < c->dirty_hi_)
+      ops.push_back(h5::IoOp{c->fd_, true, c->data_.data() + c->dirty_lo_, c->dirty_hi_ - c->dirty_lo_,
+                             c->off_ + c->dirty_lo_, 0, c->dfd_});
+  if (!ops.empty() && file->io_->Submit(ops.data(), ops.size()) < 0)
+    return -1;
+  for (H5VL_pfs_vol_cached_t *c : chunks)
+    c->dirty_lo_ = c->dirty_hi_ = 0;
+  return 0;
+} /* end H5VL_pfs_vol_cache_writeback() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_cache_insert
+ *
+ * Purpose:     Cache chunk \a c after a miss, writing back the chunks
+ *              evicted to make room. If that write-back fails, the
+ *              evicted chunks are taken back, still dirty, in place of
+ *              \a c, and the error is returned. The caller holds the
+ *              cache lock.
+ *
+ * Return:      Success:    The cached chunk
+ *              Failure:    nullptr
+ *
+ *-------------------------------------------------------------------------
+ */
+static H5VL_pfs_vol_cached_t *
+H5VL_pfs_vol_cache_insert(H5VL_pfs_vol_file_t *file, const H5VL_pfs_vol_cache_key_t &key,
+                          H5VL_pfs_vol_cached_t &&c)
+{
+  std::vector<std::pair<H5VL_pfs_vol_cache_key_t, H5VL_pfs_vol_cached_t>> evicted;
+  std::vector<H5VL_pfs_vol_cached_t *> victims;
+  size_t size = c.data_.size();
+  H5VL_pfs_vol_cached_t *cached = file->cache_->Put(key, std::move(c), size, evicted);
+
+  for (auto &it : evicted)
+    victims.push_back(&it.second);
+  if (H5VL_pfs_vol_cache_writeback(file, victims) < 0) {
+    file->cache_->Erase(key);
+    for (auto &it : evicted) {
+      size_t bytes = it.second.data_.size();
+      file->cache_->Restore(it.first, std::move(it.second), bytes);
+    }
+    return nullptr;
+  }
+  return cached;
+} /* end H5VL_pfs_vol_cache_insert() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_cache_flush
+ *
+ * Purpose:     Write back the dirty cached chunks of \a dset, or of every
+ *              dataset if null. They stay cached.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_cache_flush(H5VL_pfs_vol_file_t *file, H5VL_pfs_vol_dset_t *dset)
+{
+  std::vector<H5VL_pfs_vol_cached_t *> chunks;
+
+  bool failed;
+
+  if (file->cache_ == nullptr)
+    return 0;
+  std::lock_guard<std::mutex> guard(file->cache_lock_);
+  file->cache_->ForEach([&](const H5VL_pfs_vol_cache_key_t &key, H5VL_pfs_vol_cached_t &c) {
+    if (dset == nullptr || key.first == dset)
+      chunks.push_back(&c);
+  });
+  failed = file->cache_failed_;
+  file->cache_failed_ = false;
+  return H5VL_pfs_vol_cache_writeback(file, chunks) < 0 || failed ? -1 : 0;
+} /* end H5VL_pfs_vol_cache_flush() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_cache_drop
+ *
+ * Purpose:     Write back and forget the cached chunks of a dataset, as
+ *              it is closed or its chunk grid changes.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_cache_drop(H5VL_pfs_vol_t *o)
+{
+  H5VL_pfs_vol_file_t *file = o->file_.get();
+  std::vector<std::pair<H5VL_pfs_vol_cache_key_t, H5VL_pfs_vol_cached_t>> evicted;
+  std::vector<H5VL_pfs_vol_cached_t *> chunks;
+
+  if (file->cache_ == nullptr)
+    return 0;
+  std::lock_guard<std::mutex> guard(file->cache_lock_);
+  file->cache_->EraseIf([o](const H5VL_pfs_vol_cache_key_t &key) { return key.first == o->dset_; }, evicted);
+  for (auto &it : evicted)
+    chunks.push_back(&it.second);
+  return H5VL_pfs_vol_cache_writeback(file, chunks);
+} /* end H5VL_pfs_vol_cache_drop() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_dset_flush
+ *
+ * Purpose:     Make a dataset durable, once its async requests finished.
+ *              Data moves down the tiers first: staged chunks, then the
+ *              log, then cached chunks. The meta file follows, since it
+ *              indexes the chunks they allocated, and the data file is
+ *              synced last.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_dset_flush(H5VL_pfs_vol_t *o)
+{
+  H5VL_pfs_vol_dset_t *dset = o->dset_;
+
+  H5VL_pfs_vol_wait_idle(dset);
+  if ((o->flags_ & H5F_ACC_RDWR) == 0)
+    return 0;
+  if (H5VL_pfs_vol_stage_flush(o) < 0)
+    return -1;
+  if (dset->log_fd_ >= 0 && H5VL_pfs_vol_log_compact(o, nullptr) < 0)
+    return -1;
+  if (H5VL_pfs_vol_cache_flush(o->file_.get(), dset) < 0)
+    return -1;
+  if (dset->dirty_ && H5VL_pfs_vol_meta_write(o) < 0)
+    return -1;
+  return dset->fd_ >= 0 && fdatasync(dset->fd_) < 0 ? -1 : 0;
+} /* end H5VL_pfs_vol_dset_flush() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_cache_write
+ *
+ * Purpose:     Write the spans of a planned transfer into the chunk
+ *              cache, setting staged_ on them. A chunk missing from the
+ *              cache is allocated as for any write and brought in whole:
+ *              read from its data file, or zeroed if never written or
+ *              about to be overwritten entirely. Repeated writes to a
+ *              cached chunk only widen its dirty range, so they reach
+ *              the file as one write on eviction or flush. Chunks larger
+ *              than the cache are left to the caller. A prefetched chunk
+ *              of another rank's subfile is moved into this rank's
+ *              subfile before it is dirtied, since the cached copy only
+ *              holds a read-only descriptor. The caller holds the
+ *              dataset lock.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_cache_write(H5VL_pfs_vol_xfer_t *xfer)
+{
+  H5VL_pfs_vol_dset_t *dset = xfer->o_->dset_;
+  H5VL_pfs_vol_file_t *file = xfer->o_->file_.get();
+  size_t type_size = dset->type_size_;
+  const char *src = xfer->mem_;
+  uint64_t seq = H5VL_pfs_vol_write_seq(dset);
+
+  if (dset->chunk_bytes_ > file->cache_->Capacity())
+    return 0;
+  for (H5VL_pfs_vol_span_t &span : xfer->spans_) {
+    H5VL_pfs_vol_cache_key_t key(dset, span.idx_);
+    H5VL_pfs_vol_cached_t *c;
+    std::unique_lock<std::mutex> lock(file->cache_lock_);
+
+    c = file->cache_->Get(key);
+    if (c != nullptr && H5VL_PFS_VOL_LOC_SUBFILE(dset->chunks_[span.idx_]) != file->subfile_) {
+      int fd, dfd;
+      lock.unlock();
+      if (H5VL_pfs_vol_chunk_alloc(xfer->o_, span.idx_) < 0 ||
+          H5VL_pfs_vol_chunk_fds(xfer->o_, dset->chunks_[span.idx_], &fd, &dfd) < 0)
+        return -1;
+      lock.lock();
+      if ((c = file->cache_->Get(key)) != nullptr) {
+        c->fd_ = fd;
+        c->dfd_ = dfd;
+        c->off_ = H5VL_PFS_VOL_LOC_OFFSET(dset->chunks_[span.idx_]);
+      }
+    }
+    if (c == nullptr) {
+      H5VL_pfs_vol_cached_t fill;
+      bool fresh = dset->chunks_[span.idx_] == H5VL_PFS_VOL_NO_CHUNK;
+      hsize_t covered = 0;
+      int fd, dfd;
+
+      /* Only this dataset's lock holder inserts its chunks, so read unlocked */
+      lock.unlock();
+      for (const h5::SelPair &piece : *span.pieces_)
+        covered += piece.len_;
+      if (H5VL_pfs_vol_chunk_alloc(xfer->o_, span.idx_) < 0 ||
+          H5VL_pfs_vol_chunk_fds(xfer->o_, dset->chunks_[span.idx_], &fd, &dfd) < 0)
+        return -1;
+      fill.fd_ = fd;
+      fill.dfd_ = dfd;
+      fill.off_ = H5VL_PFS_VOL_LOC_OFFSET(dset->chunks_[span.idx_]);
+      fill.data_.assign(dset->chunk_bytes_, 0);
+      fill.dirty_lo_ = fill.dirty_hi_ = 0;
+      if (!fresh && covered * type_size != dset->chunk_bytes_) {
+        h5::IoOp op{fd, false, fill.data_.data(), fill.data_.size(), fill.off_, 0, dfd};
+        if (file->io_->Submit(&op, 1) < 0)
+          return -1;
+      }
+      lock.lock();
+      if ((c = H5VL_pfs_vol_cache_insert(file, key, std::move(fill))) == nullptr)
+        return -1;
+    }
+    for (const h5::SelPair &piece : *span.pieces_)
+      memcpy(c->data_.data() + piece.file_off_ * type_size, src + piece.mem_off_ * type_size,
+             piece.len_ * type_size);
+    if (c->dirty_lo_ == c->dirty_hi_) {
+      c->dirty_lo_ = span.lo_ * type_size;
+      c->dirty_hi_ = span.hi_ * type_size;
+    } else {
+      c->dirty_lo_ = std::min<size_t>(c->dirty_lo_, span.lo_ * type_size);
+      c->dirty_hi_ = std::max<size_t>(c->dirty_hi_, span.hi_ * type_size);
+    }
+    for (const h5::SelPair &piece : *span.pieces_)
+      H5VL_pfs_vol_chunk_written(xfer->o_, span.idx_, piece.file_off_, piece.len_, seq);
+    span.staged_ = true;
+  }
+  return 0;
+} /* end H5VL_pfs_vol_cache_write() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_cache_read
+ *
+ * Purpose:     Serve the spans of a planned read whose chunks are cached,
+ *              setting staged_ on them. Misses do not fill the cache;
+ *              only writes bring chunks in. The caller holds the dataset
+ *              lock.
+ *
+ *-------------------------------------------------------------------------
+ */
+static void
+H5VL_pfs_vol_cache_read(H5VL_pfs_vol_xfer_t *xfer)
+{
+  H5VL_pfs_vol_dset_t *dset = xfer->o_->dset_;
+  H5VL_pfs_vol_file_t *file = xfer->o_->file_.get();
+  size_t type_size = dset->type_size_;
+  char *dst = xfer->mem_;
+  std::lock_guard<std::mutex> guard(file->cache_lock_);
+
+  for (H5VL_pfs_vol_span_t &span : xfer->spans_) {
+    H5VL_pfs_vol_cached_t *c = file->cache_->Get(H5VL_pfs_vol_cache_key_t(dset, span.idx_));
+    if (c == nullptr)
+      continue;
+    for (const h5::SelPair &piece : *span.pieces_)
+      memcpy(dst + piece.mem_off_ * type_size, c->data_.data() + piece.file_off_ * type_size,
+             piece.len_ * type_size);
+    span.staged_ = true;
+  }
+} /* end H5VL_pfs_vol_cache_read() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_prefetch
+ *
+ * Purpose:     Follow the chunks successive reads of a dataset touch and
+ *              prefetch ahead of a sequential or strided scan. A read
+ *              that touches the chunks of the previous one shifted by
+ *              the same step as the time before confirms the pattern;
+ *              the chunks of the next pf_depth_ steps are then read into
+ *              the chunk cache on a request worker. Reads staying within
+ *              the same chunks do not count as steps.
+ *
+ *              The depth adapts to the consumer: it covers the time a
+ *              step takes to prefetch divided by the time the consumer
+ *              spends per step, plus one, capped by the prefetch
+ *              parameter and half the cache. The caller holds the
+ *              dataset lock.
+ *
+ *-------------------------------------------------------------------------
+ */
+static void
+H5VL_pfs_vol_prefetch(H5VL_pfs_vol_xfer_t *xfer)
+{
+  H5VL_pfs_vol_t *o = xfer->o_;
+  H5VL_pfs_vol_dset_t *dset = o->dset_;
+  H5VL_pfs_vol_prefetch_t *pf = &dset->prefetch_;
+  H5VL_pfs_vol_file_t *file = o->file_.get();
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  std::vector<size_t> chunks, targets;
+  long long stride = 0;
+  bool shifted, seq;
+  size_t depth, ahead;
+
+  for (const H5VL_pfs_vol_span_t &span : xfer->spans_)
+    chunks.push_back(span.idx_);
+  if (chunks.empty() || chunks == pf->chunks_)
+    return;
+
+  /* Is this the previous read moved by the same step again? */
+  shifted = !pf->chunks_.empty() && chunks.size() == pf->chunks_.size();
+  if (shifted)
+    stride = (long long)chunks[0] - (long long)pf->chunks_[0];
+  for (size_t i = 1; shifted && i < chunks.size(); i++)
+    shifted = (long long)chunks[i] - (long long)pf->chunks_[i] == stride;
+  seq = shifted && stride == pf->stride_;
+  if (seq) {
+    double interval = std::chrono::duration<double>(now - pf->last_).count();
+    pf->interval_ = pf->interval_ > 0 ? 0.75 * pf->interval_ + 0.25 * interval : interval;
+    pf->ahead_ = pf->ahead_ ? pf->ahead_ - 1 : 0;
+  } else {
+    pf->ahead_ = 0;
+  }
+  pf->stride_ = shifted ? stride : 0;
+  pf->chunks_ = chunks;
+  pf->last_ = now;
+  if (!seq || H5VL_pfs_vol_pool_g == nullptr)
+    return;
+
+  /* Cover the prefetch latency at the consumer's pace */
+  depth = 2;
+  if (pf->cost_ > 0 && pf->interval_ > 0)
+    depth = (size_t)std::ceil(pf->cost_ / pf->interval_) + 1;
+  depth = std::min({depth, o->prefetch_, file->cache_->Capacity() / 2 / (chunks.size() * dset->chunk_bytes_)});
+  if (pf->ahead_ >= depth)
+    return;
+
+  for (ahead = pf->ahead_ + 1; ahead <= depth; ahead++) {
+    bool inside = true;
+    for (size_t c : chunks) {
+      long long idx = (long long)c + (long long)ahead * stride;
+      if (idx < 0 || (size_t)idx >= dset->chunks_.size()) {
+        inside = false;
+        break;
+      }
+      if (dset->chunks_[idx] != H5VL_PFS_VOL_NO_CHUNK)
+        targets.push_back((size_t)idx);
+    }
+    if (!inside)
+      break;
+  }
+  if (targets.empty())
+    return;
+  pf->depth_ = depth;
+  dset->pending_++;
+  H5VL_pfs_vol_pool_g->Submit(
+      [o, targets, steps = ahead - 1 - pf->ahead_]() { H5VL_pfs_vol_prefetch_run(o, targets, steps); });
+  pf->ahead_ = ahead - 1;
+} /* end H5VL_pfs_vol_prefetch() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_prefetch_run
+ *
+ * Purpose:     Read the chunks \a targets of a dataset into the chunk
+ *              cache, as clean chunks, and update the measured time to
+ *              prefetch one of the \a steps steps they make up. Chunks
+ *              already cached are skipped, and a chunk is discarded if
+ *              the dataset was written while it was read. The reads run
+ *              without the dataset lock; read errors only cost the
+ *              prefetch. Writing back the chunks an insert evicts may
+ *              fail too; that stops the prefetch and fails the next
+ *              cache flush, since nobody waits on this worker.
+ *
+ *-------------------------------------------------------------------------
+ */
+static void
+H5VL_pfs_vol_prefetch_run(H5VL_pfs_vol_t *o, const std::vector<size_t> &targets, size_t steps)
+{
+  H5VL_pfs_vol_dset_t *dset = o->dset_;
+  H5VL_pfs_vol_file_t *file = o->file_.get();
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  double cost;
+
+  for (size_t idx : targets) {
+    H5VL_pfs_vol_cache_key_t key(dset, idx);
+    H5VL_pfs_vol_cached_t c;
+    uint64_t gen, loc;
+    h5::IoOp op;
+    int fd, dfd;
+    {
+      std::lock_guard<std::mutex> guard(dset->lock_);
+      std::lock_guard<std::mutex> cache_guard(file->cache_lock_);
+      gen = dset->prefetch_.gen_;
+      loc = dset->chunks_[idx];
+      if (file->cache_->Contains(key) || loc == H5VL_PFS_VOL_NO_CHUNK ||
+          H5VL_pfs_vol_chunk_fds(o, loc, &fd, &dfd) < 0)
+        continue;
+    }
+    c.fd_ = fd;
+    c.dfd_ = dfd;
+    c.off_ = H5VL_PFS_VOL_LOC_OFFSET(loc);
+    c.data_.resize(dset->chunk_bytes_);
+    c.dirty_lo_ = c.dirty_hi_ = 0;
+    op = h5::IoOp{fd, false, c.data_.data(), c.data_.size(), c.off_, 0, dfd};
+    if (file->io_->Submit(&op, 1) < 0)
+      continue;
+    std::lock_guard<std::mutex> guard(dset->lock_);
+    std::lock_guard<std::mutex> cache_guard(file->cache_lock_);
+    if (gen == dset->prefetch_.gen_ && !file->cache_->Contains(key) &&
+        H5VL_pfs_vol_cache_insert(file, key, std::move(c)) == nullptr) {
+      file->cache_failed_ = true;
+      break;
+    }
+  }
+
+  cost = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / std::max<size_t>(steps, 1);
+  std::lock_guard<std::mutex> guard(dset->lock_);
+  dset->prefetch_.cost_ = dset->prefetch_.cost_ > 0 ? 0.75 * dset->prefetch_.cost_ + 0.25 * cost : cost;
+  if (--dset->pending_ == 0)
+    dset->idle_.notify_all();
+} /* end H5VL_pfs_vol_prefetch_run() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_md_be
+ *
+ * Purpose:     Encode \a val as 8 big-endian bytes, which sort as the
+ *              number does.
+ *
+ * Return:      The encoding
+ *
+ *-------------------------------------------------------------------------
+ */
+static std::string
+H5VL_pfs_vol_md_be(uint64_t val)
+{
+  std::string out(8, '\0');
+  for (int i = 0; i < 8; i++)
+    out[i] = (char)(val >> (56 - 8 * i));
+  return out;
+} /* end H5VL_pfs_vol_md_be() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_md_key
+ *
+ * Purpose:     Key of the metadata store entry tagged \a tag for object
+ *              \a id and \a name.
+ *
+ * Return:      The key
+ *
+ *-------------------------------------------------------------------------
+ */
+static std::string
+H5VL_pfs_vol_md_key(char tag, uint64_t id, const std::string &name)
+{
+  return std::string(1, tag) + H5VL_pfs_vol_md_be(id) + name;
+} /* end H5VL_pfs_vol_md_key() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_md_token
+ *
+ * Purpose:     The object token of object \a id: its id in the first
+ *              eight bytes, the rest zero.
+ *
+ *-------------------------------------------------------------------------
+ */
+static void
+H5VL_pfs_vol_md_token(uint64_t id, H5O_token_t *token)
+{
+  memset(token, 0, sizeof(*token));
+  memcpy(token, &id, sizeof(id));
+} /* end H5VL_pfs_vol_md_token() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_md_obj_enc
+ *
+ * Purpose:     Encode an object record.
+ *
+ * Return:      The encoding
+ *
+ *-------------------------------------------------------------------------
+ */
+static std::string
+H5VL_pfs_vol_md_obj_enc(const H5VL_pfs_vol_obj_rec_t &rec)
+{
+  std::vector<char> out;
+  h5::PutVarint(out, rec.type_);
+  h5::PutVarint(out, rec.rc_);
+  h5::PutVarint(out, rec.nlinks_);
+  h5::PutVarint(out, rec.nattrs_);
+  h5::PutVarint(out, rec.link_corder_);
+  h5::PutVarint(out, rec.attr_corder_);
+  out.insert(out.end(), rec.dir_.begin(), rec.dir_.end());
+  return std::string(out.begin(), out.end());
+} /* end H5VL_pfs_vol_md_obj_enc() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_md_obj_dec
+ *
+ * Purpose:     Decode an object record.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1 (no record, or a malformed one)
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_md_obj_dec(const std::string *val, H5VL_pfs_vol_obj_rec_t *rec)
+{
+  const char *p, *end;
+  uint64_t type;
+
+  if (val == nullptr)
+    return -1;
+  p = val->data();
+  end = p + val->size();
+  if (!h5::GetVarint(p, end, type) || !h5::GetVarint(p, end, rec->rc_) || !h5::GetVarint(p, end, rec->nlinks_) ||
+      !h5::GetVarint(p, end, rec->nattrs_) || !h5::GetVarint(p, end, rec->link_corder_) ||
+      !h5::GetVarint(p, end, rec->attr_corder_))
+    return -1;
+  rec->type_ = (int)type;
+  rec->dir_.assign(p, end);
+  return 0;
+} /* end H5VL_pfs_vol_md_obj_dec() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_md_link_enc
+ *
+ * Purpose:     Encode a link record.
+ *
+ * Return:      The encoding
+ *
+ *-------------------------------------------------------------------------
+ */
+static std::string
+H5VL_pfs_vol_md_link_enc(const H5VL_pfs_vol_link_rec_t &rec)
+{
+  std::vector<char> out;
+  h5::PutVarint(out, rec.type_);
+  h5::PutVarint(out, rec.corder_);
+  h5::PutVarint(out, rec.target_);
+  out.insert(out.end(), rec.path_.begin(), rec.path_.end());
+  return std::string(out.begin(), out.end());
+} /* end H5VL_pfs_vol_md_link_enc() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_md_link_dec
+ *
+ * Purpose:     Decode a link record.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1 (no record, or a malformed one)
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_md_link_dec(const std::string *val, H5VL_pfs_vol_link_rec_t *rec)
+{
+  const char *p, *end;
+  uint64_t type;
+
+  if (val == nullptr)
+    return -1;
+  p = val->data();
+  end = p + val->size();
+  if (!h5::GetVarint(p, end, type) || !h5::GetVarint(p, end, rec->corder_) || !h5::GetVarint(p, end, rec->target_))
+    return -1;
+  rec->type_ = (int)type;
+  rec->path_.assign(p, end);
+  return 0;
+} /* end H5VL_pfs_vol_md_link_dec() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_md_attr_enc
+ *
+ * Purpose:     Encode an attribute record.
+ *
+ * Return:      The encoding
+ *
+ *-------------------------------------------------------------------------
+ */
+static std::string
+H5VL_pfs_vol_md_attr_enc(const H5VL_pfs_vol_attr_rec_t &rec)
+{
+  std::vector<char> out;
+  h5::PutVarint(out, rec.corder_);
+  h5::PutVarint(out, rec.type_.size());
+  out.insert(out.end(), rec.type_.begin(), rec.type_.end());
+  h5::PutVarint(out, rec.space_.size());
+  out.insert(out.end(), rec.space_.begin(), rec.space_.end());
+  out.insert(out.end(), rec.data_.begin(), rec.data_.end());
+  return std::string(out.begin(), out.end());
+} /* end H5VL_pfs_vol_md_attr_enc() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_md_attr_dec
+ *
+ * Purpose:     Decode an attribute record.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1 (no record, or a malformed one)
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_md_attr_dec(const std::string *val, H5VL_pfs_vol_attr_rec_t *rec)
+{
+  const char *p, *end;
+  uint64_t type_size, space_size;
+
+  if (val == nullptr)
+    return -1;
+  p = val->data();
+  end = p + val->size();
+  if (!h5::GetVarint(p, end, rec->corder_) || !h5::GetVarint(p, end, type_size) ||
+      (uint64_t)(end - p) < type_size)
+    return -1;
+  rec->type_.assign(p, type_size);
+  p += type_size;
+  if (!h5::GetVarint(p, end, space_size) || (uint64_t)(end - p) < space_size)
+    return -1;
+  rec->space_.assign(p, space_size);
+  rec->data_.assign(p + space_size, end);
+  return 0;
+} /* end H5VL_pfs_vol_md_attr_dec() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_md_open
+ *
+ * Purpose:     Open the container's metadata store. Rank 0 (or a lone
+ *              process) persists it; with subfiling the other ranks
+ *              load it after rank 0 and then apply the same collective
+ *              changes in memory only.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_md_open(H5VL_pfs_vol_t *file)
+{
+  H5VL_pfs_vol_file_t *f = file->file_.get();
+  bool mpi = f->subfile_ && H5VL_pfs_vol_mpi();
+  int rank = H5VL_pfs_vol_rank(), ok = 1;
+
+  f->md_ = std::make_unique<h5::KvStore>();
+  f->md_writer_ = (file->flags_ & H5F_ACC_RDWR) && (f->subfile_ == 0 || rank == 0);
+  if (!mpi || rank == 0)
+    ok = H5VL_pfs_vol_md_load(f) == 0;
+  if (mpi) {
+    MPI_Bcast(&ok, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    if (ok && rank != 0)
+      ok = H5VL_pfs_vol_md_load(f) == 0;
+  }
+  return ok ? 0 : -1;
+} /* end H5VL_pfs_vol_md_open() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_md_load
+ *
+ * Purpose:     Load the metadata store, setting up the root group in a
+ *              new one. Containers from before the store kept groups as
+ *              directories; their tree is read into the store once.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_md_load(H5VL_pfs_vol_file_t *file)
+{
+  std::string db = file->root_ + "/" H5VL_PFS_VOL_MD_DB, wal = file->root_ + "/" H5VL_PFS_VOL_MD_WAL;
+  bool present = h5::KvStore::Present(db, wal);
+  std::error_code ec;
+
+  if (file->md_->Open(db, wal, file->md_writer_) < 0)
+    return -1;
+  if (file->md_->Get("N") == nullptr) {
+    H5VL_pfs_vol_obj_rec_t root = {};
+    h5::KvBatch batch;
+    root.type_ = H5O_TYPE_GROUP;
+    root.rc_ = 1;
+    batch.Put("N", H5VL_pfs_vol_md_be(H5VL_PFS_VOL_ROOT_ID + 1));
+    batch.Put(H5VL_pfs_vol_md_key('O', H5VL_PFS_VOL_ROOT_ID, ""), H5VL_pfs_vol_md_obj_enc(root));
+    if (H5VL_pfs_vol_md_commit(file, batch, {}) < 0 ||
+        (!present && H5VL_pfs_vol_md_migrate(file, H5VL_PFS_VOL_ROOT_ID, "") < 0))
+      return -1;
+  }
+  if (file->md_writer_) {
+    std::filesystem::create_directories(file->root_ + "/" H5VL_PFS_VOL_DSET_DIR, ec);
+    if (ec)
+      return -1;
+  }
+  return file->md_->Sync();
+} /* end H5VL_pfs_vol_md_load() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_md_migrate
+ *
+ * Purpose:     Record the directories below \a rel (relative to the
+ *              container) as the links of group \a parent: those with a
+ *              "meta" file as datasets kept where they are, the others
+ *              as groups. Names are taken in sorted order so that every
+ *              rank assigns the same ids.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_md_migrate(H5VL_pfs_vol_file_t *file, uint64_t parent, const std::string &rel)
+{
+  std::vector<std::string> names;
+  std::error_code ec;
+
+  for (const auto &entry : std::filesystem::directory_iterator(file->root_ + rel, ec)) {
+    std::string name = entry.path().filename().string();
+    if (entry.is_directory(ec) && name.compare(0, strlen(H5VL_PFS_VOL_MARKER), H5VL_PFS_VOL_MARKER) != 0)
+      names.push_back(name);
+  }
+  if (ec)
+    return -1;
+  std::sort(names.begin(), names.end());
+  for (const std::string &name : names) {
+    H5VL_pfs_vol_obj_rec_t rec = {};
+    std::string sub = rel + "/" + name;
+    uint64_t id = H5VL_pfs_vol_md_next_id(file);
+    rec.type_ = std::filesystem::exists(file->root_ + sub + "/meta", ec) ? H5O_TYPE_DATASET : H5O_TYPE_GROUP;
+    if (rec.type_ == H5O_TYPE_DATASET)
+      rec.dir_ = sub.substr(1);
+    if (H5VL_pfs_vol_md_create(file, parent, name, id, rec) < 0 ||
+        (rec.type_ == H5O_TYPE_GROUP && H5VL_pfs_vol_md_migrate(file, id, sub) < 0))
+      return -1;
+  }
+  return 0;
+} /* end H5VL_pfs_vol_md_migrate() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_md_commit
+ *
+ * Purpose:     Apply a batch to the metadata store, checkpointing it
+ *              once its log grows past H5VL_PFS_VOL_MD_CHECKPOINT, then
+ *              remove the directories \a dirs of the datasets the batch
+ *              deleted. The log is synced first, so a crash never leaves
+ *              a link to a removed directory. Datasets that are still
+ *              open are removed when their last handle closes.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_md_commit(H5VL_pfs_vol_file_t *file, const h5::KvBatch &batch, const std::vector<std::string> &dirs)
+{
+  std::error_code ec;
+
+  if (file->md_->Write(batch) < 0)
+    return -1;
+  if (file->md_->LogSize() > H5VL_PFS_VOL_MD_CHECKPOINT && file->md_->Checkpoint() < 0)
+    return -1;
+  if (dirs.empty())
+    return 0;
+  if (file->md_writer_ && file->md_->Sync() < 0)
+    return -1;
+  for (const std::string &dir : dirs) {
+    std::string path = file->root_ + "/" + dir;
+    file->owned_.erase(path);
+    if (file->open_.count(path))
+      file->unlinked_.insert(path);
+    else if (file->md_writer_)
+      std::filesystem::remove_all(path, ec);
+  }
+  return 0;
+} /* end H5VL_pfs_vol_md_commit() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_md_get_obj
+ *
+ * Purpose:     Read the record of object \a id as \a batch leaves it.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1 (no such object)
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_md_get_obj(H5VL_pfs_vol_file_t *file, const h5::KvBatch &batch, uint64_t id,
+                        H5VL_pfs_vol_obj_rec_t *rec)
+{
+  return H5VL_pfs_vol_md_obj_dec(batch.Get(*file->md_, H5VL_pfs_vol_md_key('O', id, "")), rec);
+} /* end H5VL_pfs_vol_md_get_obj() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_md_next_id
+ *
+ * Purpose:     The id the next object created will get.
+ *
+ * Return:      The id
+ *
+ *-------------------------------------------------------------------------
+ */
+static uint64_t
+H5VL_pfs_vol_md_next_id(H5VL_pfs_vol_file_t *file)
+{
+  const std::string *val = file->md_->Get("N");
+  uint64_t id = 0;
+
+  if (val == nullptr || val->size() != 8)
+    return H5VL_PFS_VOL_ROOT_ID + 1;
+  for (unsigned char c : *val)
+    id = (id << 8) | c;
+  return id;
+} /* end H5VL_pfs_vol_md_next_id() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_md_create
+ *
+ * Purpose:     Add object \a id, the one H5VL_pfs_vol_md_next_id gave,
+ *              with record \a rec, hard linked as \a name in group
+ *              \a parent.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1 (\a parent is no group, or already has
+ *                          \a name)
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_md_create(H5VL_pfs_vol_file_t *file, uint64_t parent, const std::string &name, uint64_t id,
+                       const H5VL_pfs_vol_obj_rec_t &rec)
+{
+  H5VL_pfs_vol_link_rec_t link = {H5L_TYPE_HARD, 0, id, std::string()};
+  h5::KvBatch batch;
+
+  batch.Put("N", H5VL_pfs_vol_md_be(id + 1));
+  batch.Put(H5VL_pfs_vol_md_key('O', id, ""), H5VL_pfs_vol_md_obj_enc(rec));
+  if (H5VL_pfs_vol_md_link(file, batch, parent, name, link) < 0)
+    return -1;
+  return H5VL_pfs_vol_md_commit(file, batch, {});
+} /* end H5VL_pfs_vol_md_create() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_md_link
+ *
+ * Purpose:     Add \a link as \a name in group \a parent to \a batch,
+ *              counting it on a hard link's target.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1 (bad name, \a parent is no group or
+ *                          already has \a name, or no target)
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_md_link(H5VL_pfs_vol_file_t *file, h5::KvBatch &batch, uint64_t parent, const std::string &name,
+                     H5VL_pfs_vol_link_rec_t link)
+{
+  std::string key = H5VL_pfs_vol_md_key('L', parent, name);
+  H5VL_pfs_vol_obj_rec_t rec;
+
+  if (name.empty() || name == "." || name.find('/') != std::string::npos ||
+      H5VL_pfs_vol_md_get_obj(file, batch, parent, &rec) < 0 || rec.type_ != H5O_TYPE_GROUP ||
+      batch.Get(*file->md_, key) != nullptr)
+    return -1;
+  link.corder_ = rec.link_corder_++;
+  rec.nlinks_++;
+  batch.Put(key, H5VL_pfs_vol_md_link_enc(link));
+  batch.Put(H5VL_pfs_vol_md_key('C', parent, H5VL_pfs_vol_md_be(link.corder_)), name);
+  batch.Put(H5VL_pfs_vol_md_key('O', parent, ""), H5VL_pfs_vol_md_obj_enc(rec));
+  if (link.type_ == H5L_TYPE_HARD) {
+    if (H5VL_pfs_vol_md_get_obj(file, batch, link.target_, &rec) < 0)
+      return -1;
+    rec.rc_++;
+    batch.Put(H5VL_pfs_vol_md_key('O', link.target_, ""), H5VL_pfs_vol_md_obj_enc(rec));
+  }
+  return 0;
+} /* end H5VL_pfs_vol_md_link() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_md_unlink
+ *
+ * Purpose:     Add the removal of link \a name of group \a parent to
+ *              \a batch, releasing a hard link's target.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1 (no such link)
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_md_unlink(H5VL_pfs_vol_file_t *file, h5::KvBatch &batch, uint64_t parent, const std::string &name,
+                       std::vector<std::string> &dirs)
+{
+  std::string key = H5VL_pfs_vol_md_key('L', parent, name);
+  H5VL_pfs_vol_link_rec_t link;
+  H5VL_pfs_vol_obj_rec_t rec;
+
+  if (H5VL_pfs_vol_md_link_dec(batch.Get(*file->md_, key), &link) < 0 ||
+      H5VL_pfs_vol_md_get_obj(file, batch, parent, &rec) < 0)
+    return -1;
+  rec.nlinks_--;
+  batch.Delete(key);
+  batch.Delete(H5VL_pfs_vol_md_key('C', parent, H5VL_pfs_vol_md_be(link.corder_)));
+  batch.Put(H5VL_pfs_vol_md_key('O', parent, ""), H5VL_pfs_vol_md_obj_enc(rec));
+  if (link.type_ == H5L_TYPE_HARD)
+    H5VL_pfs_vol_md_release(file, batch, link.target_, dirs);
+  return 0;
+} /* end H5VL_pfs_vol_md_unlink() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_md_release
+ *
+ * Purpose:     Drop one hard link to object \a id in \a batch. With the
+ *              last one the object goes with its attributes: a group
+ *              releases its links in turn, a dataset's directory is
+ *              added to \a dirs for removal once the batch is applied.
+ *              Objects the batch already removed are skipped, so cycles
+ *              of hard links end.
+ *
+ *-------------------------------------------------------------------------
+ */
+static void
+H5VL_pfs_vol_md_release(H5VL_pfs_vol_file_t *file, h5::KvBatch &batch, uint64_t id, std::vector<std::string> &dirs)
+{
+  H5VL_pfs_vol_obj_rec_t rec;
+  std::string prefix;
+
+  if (H5VL_pfs_vol_md_get_obj(file, batch, id, &rec) < 0)
+    return;
+  if (rec.rc_ > 1) {
+    rec.rc_--;
+    batch.Put(H5VL_pfs_vol_md_key('O', id, ""), H5VL_pfs_vol_md_obj_enc(rec));
+    return;
+  }
+  batch.Delete(H5VL_pfs_vol_md_key('O', id, ""));
+  prefix = H5VL_pfs_vol_md_key('A', id, "");
+  for (auto it = file->md_->Seek(prefix); it != file->md_->End() && it->first.compare(0, prefix.size(), prefix) == 0;
+       ++it) {
+    H5VL_pfs_vol_attr_rec_t attr;
+    batch.Delete(it->first);
+    if (H5VL_pfs_vol_md_attr_dec(&it->second, &attr) == 0)
+      batch.Delete(H5VL_pfs_vol_md_key('B', id, H5VL_pfs_vol_md_be(attr.corder_)));
+  }
+  if (rec.type_ == H5O_TYPE_DATASET) {
+    dirs.push_back(rec.dir_);
+    return;
+  }
+  prefix = H5VL_pfs_vol_md_key('L', id, "");
+  for (auto it = file->md_->Seek(prefix); it != file->md_->End() && it->first.compare(0, prefix.size(), prefix) == 0;
+       ++it) {
+    H5VL_pfs_vol_link_rec_t link;
+    if (H5VL_pfs_vol_md_link_dec(batch.Get(*file->md_, it->first), &link) < 0)
+      continue;
+    batch.Delete(it->first);
+    batch.Delete(H5VL_pfs_vol_md_key('C', id, H5VL_pfs_vol_md_be(link.corder_)));
+    if (link.type_ == H5L_TYPE_HARD)
+      H5VL_pfs_vol_md_release(file, batch, link.target_, dirs);
+  }
+} /* end H5VL_pfs_vol_md_release() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_md_walk
+ *
+ * Purpose:     Resolve \a path from group \a cur (from the root group if
+ *              it is absolute), one link lookup per component. Soft links
+ *              are resolved from the group holding them, up to
+ *              H5VL_PFS_VOL_MAX_SOFT deep.
+ *
+ * Return:      Success:    0, with the object in *id
+ *              Failure:    -1 (a component is missing)
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_md_walk(H5VL_pfs_vol_file_t *file, uint64_t cur, const std::string &path, int depth, uint64_t *id)
+{
+  size_t pos = 0, end;
+
+  if (depth > H5VL_PFS_VOL_MAX_SOFT)
+    return -1;
+  if (!path.empty() && path[0] == '/')
+    cur = H5VL_PFS_VOL_ROOT_ID;
+  for (; pos < path.size(); pos = end + 1) {
+    H5VL_pfs_vol_link_rec_t link;
+    std::string name;
+    end = path.find('/', pos);
+    if (end == std::string::npos)
+      end = path.size();
+    name = path.substr(pos, end - pos);
+    if (name.empty() || name == ".")
+      continue;
+    if (H5VL_pfs_vol_md_link_dec(file->md_->Get(H5VL_pfs_vol_md_key('L', cur, name)), &link) < 0)
+      return -1;
+    if (link.type_ == H5L_TYPE_HARD)
+      cur = link.target_;
+    else if (H5VL_pfs_vol_md_walk(file, cur, link.path_, depth + 1, &cur) < 0)
+      return -1;
+  }
+  *id = cur;
+  return 0;
+} /* end H5VL_pfs_vol_md_walk() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_md_parent
+ *
+ * Purpose:     Split \a name, relative to \a o, into the group that is
+ *              to hold it and its last component. Missing groups on the
+ *              way are created if the lcpl asks for intermediate groups.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_md_parent(H5VL_pfs_vol_t *o, const char *name, hid_t lcpl_id, uint64_t *parent, std::string *last)
+{
+  H5VL_pfs_vol_file_t *file = o->file_.get();
+  std::string path = name ? name : "";
+  uint64_t cur = o->id_;
+  unsigned crt_intmd = 0;
+  size_t pos, end;
+
+  while (!path.empty() && path.back() == '/')
+    path.pop_back();
+  pos = path.rfind('/');
+  *last = pos == std::string::npos ? path : path.substr(pos + 1);
+  path.resize(pos == std::string::npos ? 0 : pos + 1);
+  if (last->empty() || *last == ".")
+    return -1;
+  if (lcpl_id != H5P_DEFAULT && H5Pget_create_intermediate_group(lcpl_id, &crt_intmd) < 0)
+    return -1;
+  if (!crt_intmd)
+    return H5VL_pfs_vol_md_walk(file, cur, path, 0, parent);
+
+  if (!path.empty() && path[0] == '/')
+    cur = H5VL_PFS_VOL_ROOT_ID;
+  for (pos = 0; pos < path.size(); pos = end + 1) {
+    H5VL_pfs_vol_obj_rec_t rec = {};
+    std::string comp;
+    uint64_t id;
+    end = path.find('/', pos);
+    comp = path.substr(pos, end - pos);
+    if (comp.empty() || comp == ".")
+      continue;
+    if (H5VL_pfs_vol_md_walk(file, cur, comp, 0, &id) < 0) {
+      rec.type_ = H5O_TYPE_GROUP;
+      id = H5VL_pfs_vol_md_next_id(file);
+      if (H5VL_pfs_vol_md_create(file, cur, comp, id, rec) < 0)
+        return -1;
+    }
+    cur = id;
+  }
+  *parent = cur;
+  return 0;
+} /* end H5VL_pfs_vol_md_parent() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_md_names
+ *
+ * Purpose:     The names of the links of group \a id, or of the
+ *              attributes of object \a id, by name or creation order.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1 (unknown index)
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_md_names(H5VL_pfs_vol_file_t *file, bool attrs, uint64_t id, H5_index_t idx_type,
+                      H5_iter_order_t order, std::vector<std::string> &names)
+{
+  bool by_name = idx_type == H5_INDEX_NAME;
+  std::string prefix;
+
+  if (!by_name && idx_type != H5_INDEX_CRT_ORDER)
+    return -1;
+  prefix = H5VL_pfs_vol_md_key(by_name ? (attrs ? 'A' : 'L') : (attrs ? 'B' : 'C'), id, "");
+  for (auto it = file->md_->Seek(prefix); it != file->md_->End() && it->first.compare(0, prefix.size(), prefix) == 0;
+       ++it)
+    names.push_back(by_name ? it->first.substr(prefix.size()) : it->second);
+  if (order == H5_ITER_DEC)
+    std::reverse(names.begin(), names.end());
+  return 0;
+} /* end H5VL_pfs_vol_md_names() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_md_locate
+ *
+ * Purpose:     The object \a loc_params designate relative to \a o.
+ *
+ * Return:      Success:    0, with the object in *id
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_md_locate(H5VL_pfs_vol_t *o, const H5VL_loc_params_t *loc_params, uint64_t *id)
+{
+  H5VL_pfs_vol_file_t *file = o->file_.get();
+  H5VL_pfs_vol_link_rec_t link;
+  std::string name;
+  uint64_t group;
+
+  switch (loc_params->type) {
+    case H5VL_OBJECT_BY_SELF:
+      *id = o->id_;
+      return 0;
+    case H5VL_OBJECT_BY_NAME:
+      return H5VL_pfs_vol_md_walk(file, o->id_, loc_params->loc_data.loc_by_name.name, 0, id);
+    case H5VL_OBJECT_BY_TOKEN:
+      memcpy(id, loc_params->loc_data.loc_by_token.token, sizeof(*id));
+      return file->md_->Get(H5VL_pfs_vol_md_key('O', *id, "")) ? 0 : -1;
+    case H5VL_OBJECT_BY_IDX:
+      if (H5VL_pfs_vol_md_link_at(o, loc_params, &group, &name) < 0 ||
+          H5VL_pfs_vol_md_link_dec(file->md_->Get(H5VL_pfs_vol_md_key('L', group, name)), &link) < 0)
+        return -1;
+      if (link.type_ == H5L_TYPE_HARD) {
+        *id = link.target_;
+        return 0;
+      }
+      return H5VL_pfs_vol_md_walk(file, group, link.path_, 1, id);
+    default:
+      return -1;
+  }
+} /* end H5VL_pfs_vol_md_locate() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_md_link_at
+ *
+ * Purpose:     The link \a loc_params designate relative to \a o, by
+ *              name or by index in a group. Indexes are found by walking
+ *              the group's links in order.
+ *
+ * Return:      Success:    0, with the group in *parent and the link's
+ *                          name in *name
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_md_link_at(H5VL_pfs_vol_t *o, const H5VL_loc_params_t *loc_params, uint64_t *parent,
+                        std::string *name)
+{
+  const H5VL_loc_by_idx_t *by_idx = &loc_params->loc_data.loc_by_idx;
+  std::vector<std::string> names;
+
+  switch (loc_params->type) {
+    case H5VL_OBJECT_BY_NAME:
+      return H5VL_pfs_vol_md_parent(o, loc_params->loc_data.loc_by_name.name, H5P_DEFAULT, parent, name);
+    case H5VL_OBJECT_BY_IDX:
+      if (H5VL_pfs_vol_md_walk(o->file_.get(), o->id_, by_idx->name, 0, parent) < 0 ||
+          H5VL_pfs_vol_md_names(o->file_.get(), false, *parent, by_idx->idx_type, by_idx->order, names) < 0 ||
+          by_idx->n >= names.size())
+        return -1;
+      *name = names[by_idx->n];
+      return 0;
+    default:
+      return -1;
+  }
+} /* end H5VL_pfs_vol_md_link_at() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_md_open_obj
+ *
+ * Purpose:     Open object \a id through \a o, setting *type to its
+ *              identifier type.
+ *
+ * Return:      Success:    The new object
+ *              Failure:    nullptr
+ *
+ *-------------------------------------------------------------------------
+ */
+static H5VL_pfs_vol_t *
+H5VL_pfs_vol_md_open_obj(H5VL_pfs_vol_t *o, uint64_t id, H5I_type_t *type)
+{
+  H5VL_pfs_vol_obj_rec_t rec;
+  H5VL_pfs_vol_t *obj;
+
+  if (H5VL_pfs_vol_md_get_obj(o->file_.get(), h5::KvBatch(), id, &rec) < 0)
+    return nullptr;
+  obj = H5VL_pfs_vol_new_obj(o, "");
+  obj->path_ = o->file_->root_;
+  obj->id_ = id;
+  if (rec.type_ == H5O_TYPE_GROUP) {
+    *type = H5I_GROUP;
+    return obj;
+  }
+  obj->path_ += "/" + rec.dir_;
+
+  /* Handles of an open dataset share its state, so that they allocate
+   * chunks from one end and keep one index */
+  std::vector<H5VL_pfs_vol_t *> &open = o->file_->open_[obj->path_];
+  if (!open.empty())
+    obj->dset_ = open.front()->dset_;
+  else if (H5VL_pfs_vol_dset_load(obj) < 0) {
+    o->file_->open_.erase(obj->path_);
+    delete obj;
+    return nullptr;
+  }
+  open.push_back(obj);
+  *type = H5I_DATASET;
+  return obj;
+} /* end H5VL_pfs_vol_md_open_obj() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_md_name
+ *
+ * Purpose:     An absolute path of object \a id, found breadth-first from
+ *              the root group. Objects do not remember the name they were
+ *              opened by, so this visits the groups on the way.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1 (not linked from the root group)
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_md_name(H5VL_pfs_vol_file_t *file, uint64_t id, std::string *name)
+{
+  std::deque<std::pair<uint64_t, std::string>> queue = {{H5VL_PFS_VOL_ROOT_ID, ""}};
+  std::set<uint64_t> seen = {H5VL_PFS_VOL_ROOT_ID};
+
+  if (id == H5VL_PFS_VOL_ROOT_ID) {
+    *name = "/";
+    return 0;
+  }
+  while (!queue.empty()) {
+    std::pair<uint64_t, std::string> cur = queue.front();
+    std::string prefix = H5VL_pfs_vol_md_key('L', cur.first, "");
+    queue.pop_front();
+    for (auto it = file->md_->Seek(prefix);
+         it != file->md_->End() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+      H5VL_pfs_vol_link_rec_t link;
+      std::string path = cur.second + "/" + it->first.substr(prefix.size());
+      if (H5VL_pfs_vol_md_link_dec(&it->second, &link) < 0 || link.type_ != H5L_TYPE_HARD)
+        continue;
+      if (link.target_ == id) {
+        *name = path;
+        return 0;
+      }
+      if (seen.insert(link.target_).second)
+        queue.emplace_back(link.target_, path);
+    }
+  }
+  return -1;
+} /* end H5VL_pfs_vol_md_name() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_md_link_info
+ *
+ * Purpose:     Fill \a linfo from a link record.
+ *
+ *-------------------------------------------------------------------------
+ */
+static void
+H5VL_pfs_vol_md_link_info(const H5VL_pfs_vol_link_rec_t &link, H5L_info2_t *linfo)
+{
+  memset(linfo, 0, sizeof(*linfo));
+  linfo->type = (H5L_type_t)link.type_;
+  linfo->corder_valid = true;
+  linfo->corder = (int64_t)link.corder_;
+  linfo->cset = H5T_CSET_ASCII;
+  if (link.type_ == H5L_TYPE_HARD)
+    H5VL_pfs_vol_md_token(link.target_, &linfo->u.token);
+  else
+    linfo->u.val_size = link.path_.size() + 1;
+} /* end H5VL_pfs_vol_md_link_info() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_md_iterate
+ *
+ * Purpose:     Call the iteration's callback on the links of \a group,
+ *              naming them \a prefix plus their name, and descend into
+ *              the groups not yet in \a visited when recursive. \a gid
+ *              is the group the iteration started from.
+ *
+ * Return:      Success:    0, or the first non-zero callback return
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_md_iterate(H5VL_pfs_vol_file_t *file, hid_t gid, uint64_t group, const std::string &prefix,
+                        H5VL_link_iterate_args_t *args, std::set<uint64_t> &visited)
+{
+  hsize_t *idx = prefix.empty() ? args->idx_p : nullptr;
+  std::vector<std::string> names;
+  herr_t ret = 0;
+
+  if (H5VL_pfs_vol_md_names(file, false, group, args->idx_type, args->order, names) < 0)
+    return -1;
+  for (size_t i = idx ? *idx : 0; i < names.size() && ret == 0; i++) {
+    std::string path = prefix + names[i];
+    H5VL_pfs_vol_link_rec_t link;
+    H5L_info2_t linfo;
+    if (H5VL_pfs_vol_md_link_dec(file->md_->Get(H5VL_pfs_vol_md_key('L', group, names[i])), &link) < 0)
+      return -1;
+    H5VL_pfs_vol_md_link_info(link, &linfo);
+    ret = args->op(gid, path.c_str(), &linfo, args->op_data);
+    if (idx)
+      *idx = i + 1;
+    if (ret == 0 && args->recursive && link.type_ == H5L_TYPE_HARD && visited.insert(link.target_).second)
+      ret = H5VL_pfs_vol_md_iterate(file, gid, link.target_, path + "/", args, visited);
+  }
+  return ret;
+} /* end H5VL_pfs_vol_md_iterate() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_md_register
+ *
+ * Purpose:     Open object \a id through \a o under a new identifier,
+ *              for handing to iteration callbacks. The identifier is
+ *              the caller's to release.
+ *
+ * Return:      Success:    The identifier
+ *              Failure:    H5I_INVALID_HID
+ *
+ *-------------------------------------------------------------------------
+ */
+static hid_t
+H5VL_pfs_vol_md_register(H5VL_pfs_vol_t *o, uint64_t id)
+{
+  H5I_type_t type;
+  H5VL_pfs_vol_t *obj = H5VL_pfs_vol_md_open_obj(o, id, &type);
+  hid_t obj_id;
+
+  if (obj == nullptr)
+    return H5I_INVALID_HID;
+  obj_id = H5VLwrap_register(obj, type);
+  if (obj_id < 0) {
+    if (type == H5I_DATASET)
+      H5VL_pfs_vol_dataset_close(obj, H5P_DEFAULT, nullptr);
+    else
+      H5VL_pfs_vol_group_close(obj, H5P_DEFAULT, nullptr);
+  }
+  return obj_id;
+} /* end H5VL_pfs_vol_md_register() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_md_attr_find
+ *
+ * Purpose:     The attribute \a loc_params and \a name designate
+ *              relative to \a o: \a o itself if it is an attribute and
+ *              no name is given, else \a name on the object located, or
+ *              the attribute at an index of it.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_md_attr_find(H5VL_pfs_vol_t *o, const H5VL_loc_params_t *loc_params, const char *name,
+                          uint64_t *owner, std::string *attr_name)
+{
+  const H5VL_loc_by_idx_t *by_idx = &loc_params->loc_data.loc_by_idx;
+  std::vector<std::string> names;
+
+  if (loc_params->type == H5VL_OBJECT_BY_SELF && name == nullptr && !o->attr_.empty()) {
+    *owner = o->id_;
+    *attr_name = o->attr_;
+    return 0;
+  }
+  if (loc_params->type == H5VL_OBJECT_BY_IDX) {
+    if (H5VL_pfs_vol_md_walk(o->file_.get(), o->id_, by_idx->name, 0, owner) < 0 ||
+        H5VL_pfs_vol_md_names(o->file_.get(), true, *owner, by_idx->idx_type, by_idx->order, names) < 0 ||
+        by_idx->n >= names.size())
+      return -1;
+    *attr_name = names[by_idx->n];
+    return 0;
+  }
+  if (name == nullptr || H5VL_pfs_vol_md_locate(o, loc_params, owner) < 0)
+    return -1;
+  *attr_name = name;
+  return 0;
+} /* end H5VL_pfs_vol_md_attr_find() */
 
-/* Generic optional callback */
-static herr_t H5VL_pfs_vol_optional(void *obj, H5VL_optional_args_t *args, hid_t dxpl_id, void **req);
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_md_attr_info
+ *
+ * Purpose:     Fill \a ainfo for attribute \a name of object \a owner.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1 (no such attribute)
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_md_attr_info(H5VL_pfs_vol_file_t *file, uint64_t owner, const std::string &name, H5A_info_t *ainfo)
+{
+  H5VL_pfs_vol_attr_rec_t rec;
 
-/*******************/
-/* Local variables */
-/*******************/
+  if (H5VL_pfs_vol_md_attr_dec(file->md_->Get(H5VL_pfs_vol_md_key('A', owner, name)), &rec) < 0)
+    return -1;
+  ainfo->corder_valid = true;
+  ainfo->corder = (H5O_msg_crt_idx_t)rec.corder_;
+  ainfo->cset = H5T_CSET_ASCII;
+  ainfo->data_size = rec.data_.size();
+  return 0;
+} /* end H5VL_pfs_vol_md_attr_info() */
 
-/* Pass through VOL connector class struct */
-static const H5VL_class_t H5VL_pfs_vol_g = {
-    H5VL_VERSION,                            /* VOL class struct version */
-    (H5VL_class_value_t)H5VL_PFS_VOL_VALUE, /* value        */
-    H5VL_PFS_VOL_NAME,                      /* name         */
-    H5VL_PFS_VOL_VERSION,                   /* connector version */
-    0,                                       /* capability flags */
-    H5VL_pfs_vol_init,                  /* initialize   */
-    H5VL_pfs_vol_term,                  /* terminate    */
-    {
-        /* info_cls */
-        sizeof(H5VL_pfs_vol_t), /* size    */
-        H5VL_pfs_vol_info_copy,      /* copy    */
-        H5VL_pfs_vol_info_cmp,       /* compare */
-        H5VL_pfs_vol_info_free,      /* free    */
-        H5VL_pfs_vol_to_str,    /* to_str  */
-        H5VL_pfs_vol_str_to_info     /* from_str */
-    },
-    {
-        /* wrap_cls */
-        H5VL_pfs_vol_get_object,    /* get_object   */
-        H5VL_pfs_vol_get_wrap_ctx,  /* get_wrap_ctx */
-        H5VL_pfs_vol_wrap_object,   /* wrap_object  */
-        H5VL_pfs_vol_unwrap_object, /* unwrap_object */
-        H5VL_pfs_vol_free_wrap_ctx  /* free_wrap_ctx */
-    },
-    {
-        /* attribute_cls */
-        H5VL_pfs_vol_attr_create,   /* create */
-        H5VL_pfs_vol_attr_open,     /* open */
-        H5VL_pfs_vol_attr_read,     /* read */
-        H5VL_pfs_vol_attr_write,    /* write */
-        H5VL_pfs_vol_attr_get,      /* get */
-        H5VL_pfs_vol_attr_specific, /* specific */
-        H5VL_pfs_vol_attr_optional, /* optional */
-        H5VL_pfs_vol_attr_close     /* close */
-    },
-    {
-        /* dataset_cls */
-        H5VL_pfs_vol_dataset_create,   /* create */
-        H5VL_pfs_vol_dataset_open,     /* open */
-        H5VL_pfs_vol_dataset_read,     /* read */
-        H5VL_pfs_vol_dataset_write,    /* write */
-        H5VL_pfs_vol_dataset_get,      /* get */
-        H5VL_pfs_vol_dataset_specific, /* specific */
-        H5VL_pfs_vol_dataset_optional, /* optional */
-        H5VL_pfs_vol_dataset_close     /* close */
-    },
-    {
-        /* datatype_cls */
-        H5VL_pfs_vol_datatype_commit,   /* commit */
-        H5VL_pfs_vol_datatype_open,     /* open */
-        H5VL_pfs_vol_datatype_get,      /* get_size */
-        H5VL_pfs_vol_datatype_specific, /* specific */
-        H5VL_pfs_vol_datatype_optional, /* optional */
-        H5VL_pfs_vol_datatype_close     /* close */
-    },
-    {
-        /* file_cls */
-        H5VL_pfs_vol_file_create,   /* create */
-        H5VL_pfs_vol_file_open,     /* open */
-        H5VL_pfs_vol_file_get,      /* get */
-        H5VL_pfs_vol_file_specific, /* specific */
-        H5VL_pfs_vol_file_optional, /* optional */
-        H5VL_pfs_vol_file_close     /* close */
-    },
-    {
-        /* group_cls */
-        H5VL_pfs_vol_group_create,   /* create */
-        H5VL_pfs_vol_group_open,     /* open */
-        H5VL_pfs_vol_group_get,      /* get */
-        H5VL_pfs_vol_group_specific, /* specific */
-        H5VL_pfs_vol_group_optional, /* optional */
-        H5VL_pfs_vol_group_close     /* close */
-    },
-    {
-        /* link_cls */
-        H5VL_pfs_vol_link_create,   /* create */
-        H5VL_pfs_vol_link_copy,     /* copy */
-        H5VL_pfs_vol_link_move,     /* move */
-        H5VL_pfs_vol_link_get,      /* get */
-        H5VL_pfs_vol_link_specific, /* specific */
-        H5VL_pfs_vol_link_optional  /* optional */
-    },
-    {
-        /* object_cls */
-        H5VL_pfs_vol_object_open,     /* open */
-        H5VL_pfs_vol_object_copy,     /* copy */
-        H5VL_pfs_vol_object_get,      /* get */
-        H5VL_pfs_vol_object_specific, /* specific */
-        H5VL_pfs_vol_object_optional  /* optional */
-    },
-    {
-        /* introspect_cls */
-        H5VL_pfs_vol_introspect_get_conn_cls,  /* get_conn_cls */
-        H5VL_pfs_vol_introspect_get_cap_flags, /* get_cap_flags */
-        H5VL_pfs_vol_introspect_opt_query,     /* opt_query */
-    },
-    {
-        /* request_cls */
-        H5VL_pfs_vol_request_wait,     /* wait */
-        H5VL_pfs_vol_request_notify,   /* notify */
-        H5VL_pfs_vol_request_cancel,   /* cancel */
-        H5VL_pfs_vol_request_specific, /* specific */
-        H5VL_pfs_vol_request_optional, /* optional */
-        H5VL_pfs_vol_request_free      /* free */
-    },
-    {
-        /* blob_cls */
-        H5VL_pfs_vol_blob_put,      /* put */
-        H5VL_pfs_vol_blob_get,      /* get */
-        H5VL_pfs_vol_blob_specific, /* specific */
-        H5VL_pfs_vol_blob_optional  /* optional */
-    },
-    {
-        /* token_cls */
-        H5VL_pfs_vol_token_cmp,     /* cmp */
-        H5VL_pfs_vol_token_to_str,  /* to_str */
-        H5VL_pfs_vol_token_from_str /* from_str */
-    },
-    H5VL_pfs_vol_optional /* optional */
-};
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_md_convert
+ *
+ * Purpose:     Convert \a n elements of \a src from one datatype to
+ *              another into \a dst. \a dst's current values serve as the
+ *              background of compound conversions.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_md_convert(hid_t src_type_id, hid_t dst_type_id, size_t n, const void *src, void *dst)
+{
+  size_t src_size = H5Tget_size(src_type_id), dst_size = H5Tget_size(dst_type_id);
+  std::vector<char> buf, bkg;
 
-/* The connector identification number, initialized at runtime */
-static hid_t H5VL_PFS_VOL_g = H5I_INVALID_HID;
+  if (src_size == 0 || dst_size == 0)
+    return -1;
+  if (H5Tequal(src_type_id, dst_type_id) > 0) {
+    memcpy(dst, src, n * src_size);
+    return 0;
+  }
+  buf.resize(n * std::max(src_size, dst_size));
+  bkg.resize(buf.size());
+  memcpy(buf.data(), src, n * src_size);
+  memcpy(bkg.data(), dst, n * dst_size);
+  if (H5Tconvert(src_type_id, dst_type_id, n, buf.data(), bkg.data(), H5P_DEFAULT) < 0)
+    return -1;
+  memcpy(dst, buf.data(), n * dst_size);
+  return 0;
+} /* end H5VL_pfs_vol_md_convert() */
 
-H5PL_type_t
-H5PLget_plugin_type(void) {
-  return H5PL_TYPE_VOL;
-}
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_pfs_vol_xfer
+ *
+ * Purpose:     Read or write a list of datasets. With a request pointer
+ *              and request workers, the chunk I/O runs in the background
+ *              and *req receives the request; reads that need a datatype
+ *              conversion are always synchronous. Writes the dxpl asks
+ *              to be collective go through the aggregators instead.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_pfs_vol_xfer(size_t count, void *dset[], hid_t mem_type_id[], hid_t mem_space_id[], hid_t file_space_id[],
+                  const void *buf[], bool write, hid_t dxpl_id, void **req)
+{
+  std::vector<std::unique_ptr<H5VL_pfs_vol_xfer_t>> xfers(count);
+  bool collective = write && count > 0 && H5VL_pfs_vol_collective((H5VL_pfs_vol_t *)dset[0], dxpl_id);
+  bool async = req != nullptr && H5VL_pfs_vol_pool_g != nullptr;
 
-const void*
-H5PLget_plugin_info(void) {
-  return &H5VL_pfs_vol_g;
-}
+  for (size_t i = 0; i < count; i++) {
+    H5VL_pfs_vol_t *o = (H5VL_pfs_vol_t *)dset[i];
+    if (write && (o->flags_ & H5F_ACC_RDWR) == 0)
+      return -1;
+    xfers[i] = std::make_unique<H5VL_pfs_vol_xfer_t>();
+    if (H5VL_pfs_vol_xfer_init(o, write, mem_type_id[i], mem_space_id[i], file_space_id[i], buf[i],
+                               xfers[i].get()) < 0)
+      return -1;
+    if (xfers[i]->mem_type_id_ != H5I_INVALID_HID)
+      async = false;
+  }
+
+  /* cb_write=automatic aggregates only when some rank writes part of a
+   * chunk, as ROMIO's does only for interleaved accesses; all ranks agree */
+  if (collective && ((H5VL_pfs_vol_t *)dset[0])->cb_write_ == H5VL_PFS_VOL_CB_AUTOMATIC) {
+    int partial = 0;
+    for (auto &xfer : xfers) {
+      for (auto &chunk : xfer->chunks_) {
+        hsize_t n = 0;
+        for (const h5::SelPair &piece : chunk.second)
+          n += piece.len_;
+        partial |= n * xfer->o_->dset_->type_size_ != xfer->o_->dset_->chunk_bytes_;
+      }
+    }
+    MPI_Allreduce(MPI_IN_PLACE, &partial, 1, MPI_INT, MPI_LOR, MPI_COMM_WORLD);
+    collective = partial != 0;
+  }
+  async = async && !collective;
+  if (async) {
+    *req = H5VL_pfs_vol_xfer_async(std::move(xfers));
+    return 0;
+  }
+  /* Synchronous transfers also wait for the async ones issued before */
+  for (auto &xfer : xfers) {
+    H5VL_pfs_vol_dset_t *d = xfer->o_->dset_;
+    herr_t ret;
+    H5VL_pfs_vol_turn_wait(d, H5VL_pfs_vol_turn_take(d));
+    if (collective)
+      ret = H5VL_pfs_vol_cb_write(xfer.get());
+    else if (write)
+      ret = H5VL_pfs_vol_xfer_write(xfer.get());
+    else if ((ret = H5VL_pfs_vol_xfer_read(xfer.get())) >= 0)
+      ret = H5VL_pfs_vol_xfer_finish(xfer.get());
+    H5VL_pfs_vol_turn_done(d);
+    if (ret < 0)
+      return -1;
+  }
+  return 0;
+} /* end H5VL_pfs_vol_xfer() */
 
 /*-------------------------------------------------------------------------
  * Function:    H5VL_pfs_vol_register
@@ -431,6 +4776,9 @@ H5VL_pfs_vol_term(void)
   /* Reset VOL ID */
   H5VL_PFS_VOL_g = H5I_INVALID_HID;
 
+  delete H5VL_pfs_vol_pool_g;
+  H5VL_pfs_vol_pool_g = nullptr;
+
   return 0;
 } /* end H5VL_pfs_vol_term() */
 
@@ -447,7 +4795,7 @@ H5VL_pfs_vol_term(void)
 static void *
 H5VL_pfs_vol_info_copy(const void *_info)
 {
-  return 0;
+  return new H5VL_pfs_vol_t(*(const H5VL_pfs_vol_t *)_info);
 } /* end H5VL_pfs_vol_info_copy() */
 
 /*---------------------------------------------------------------------------
@@ -483,6 +4831,7 @@ H5VL_pfs_vol_info_cmp(int *cmp_value, const void *_info1, const void *_info2)
 static herr_t
 H5VL_pfs_vol_info_free(void *_info)
 {
+  delete (H5VL_pfs_vol_t *)_info;
   return 0;
 } /* end H5VL_pfs_vol_info_free() */
 
@@ -515,6 +4864,55 @@ H5VL_pfs_vol_to_str(const void *_info, char **str)
 static herr_t
 H5VL_pfs_vol_str_to_info(const char *str, void **_info)
 {
+  H5VL_pfs_vol_t *info = new H5VL_pfs_vol_t();
+  h5::ParseConn parser;
+  parser.parse(str);
+  info->flags_ = 0;
+  info->chunk_size_ = h5::ParseSize(parser.GetParam("chunk_size", std::to_string(H5VL_PFS_VOL_CHUNK_SIZE)));
+  info->stripe_size_ = h5::ParseSize(parser.GetParam("stripe_size", "0"));
+  info->stripe_count_ = h5::ParseSize(parser.GetParam("stripe_count", "0"));
+  info->align_ = h5::ParseSize(parser.GetParam("align", "0"));
+#ifdef HDF5_VOLS_ENABLE_LIBAIO
+  info->io_engine_ = h5::ParseIoEngine(parser.GetParam("io", "aio"));
+#else
+  info->io_engine_ = h5::ParseIoEngine(parser.GetParam("io", "posix"));
+#endif
+  info->queue_depth_ = h5::ParseSize(parser.GetParam("queue_depth", std::to_string(H5VL_PFS_VOL_QUEUE_DEPTH)));
+  info->sqpoll_ = parser.GetParam("sqpoll", "0") == "1";
+  info->mmap_ = parser.GetParam("mmap", "0") == "1";
+  info->log_ = parser.GetParam("log", "0") == "1";
+  info->log_compact_ = h5::ParseSize(parser.GetParam("log_compact", std::to_string(H5VL_PFS_VOL_LOG_COMPACT)));
+  info->nthreads_ = h5::ParseSize(parser.GetParam("threads", std::to_string(std::thread::hardware_concurrency())));
+  std::string subfiling = parser.GetParam("subfiling", "off");
+  info->subfiling_ = subfiling == "off"    ? H5VL_PFS_VOL_SUBFILE_OFF
+                     : subfiling == "rank" ? H5VL_PFS_VOL_SUBFILE_RANK
+                     : subfiling == "node" ? H5VL_PFS_VOL_SUBFILE_NODE
+                                           : -1;
+  std::string cb_write = parser.GetParam("cb_write", "automatic");
+  info->cb_write_ = cb_write == "disable"     ? H5VL_PFS_VOL_CB_DISABLE
+                    : cb_write == "automatic" ? H5VL_PFS_VOL_CB_AUTOMATIC
+                    : cb_write == "enable"    ? H5VL_PFS_VOL_CB_ENABLE
+                                              : -1;
+  info->cb_nodes_ = h5::ParseSize(parser.GetParam("cb_nodes", "0"));
+  info->cb_buffer_size_ =
+      h5::ParseSize(parser.GetParam("cb_buffer_size", std::to_string(H5VL_PFS_VOL_CB_BUFFER_SIZE)));
+  info->stage_size_ = h5::ParseSize(parser.GetParam("stage_size", "0"));
+  info->stage_block_ = h5::ParseSize(parser.GetParam("stage_block", std::to_string(H5VL_PFS_VOL_CHUNK_SIZE)));
+  info->cache_size_ = h5::ParseSize(parser.GetParam("cache_size", "0"));
+  info->prefetch_ = h5::ParseSize(parser.GetParam("prefetch", "0"));
+  info->dset_ = nullptr;
+  if (info->chunk_size_ == 0 || info->io_engine_ < 0 || info->queue_depth_ == 0 || info->log_compact_ == 0 ||
+      info->subfiling_ < 0 || info->cb_write_ < 0 || info->cb_buffer_size_ == 0 || info->stage_block_ == 0 ||
+      (info->cb_write_ == H5VL_PFS_VOL_CB_ENABLE && info->subfiling_ == H5VL_PFS_VOL_SUBFILE_OFF) ||
+      (info->stage_size_ && info->log_) || (info->cache_size_ && (info->log_ || info->stage_size_)) ||
+      (info->prefetch_ && !info->cache_size_) || (info->align_ & (info->align_ - 1)) != 0) {
+    delete info;
+    return -1;
+  }
+
+  /* Set return value */
+  *_info = info;
+
   return 0;
 } /* end H5VL_pfs_vol_str_to_info() */
 
@@ -531,8 +4929,7 @@ H5VL_pfs_vol_str_to_info(const char *str, void **_info)
 static void *
 H5VL_pfs_vol_get_object(const void *obj)
 {
-  const H5VL_pfs_vol_t *o = (const H5VL_pfs_vol_t *)obj;
-  return 0;
+  return (void *)obj;
 } /* end H5VL_pfs_vol_get_object() */
 
 /*---------------------------------------------------------------------------
@@ -617,7 +5014,44 @@ static void *
 H5VL_pfs_vol_attr_create(void *obj, const H5VL_loc_params_t *loc_params, const char *name, hid_t type_id,
                          hid_t space_id, hid_t acpl_id, hid_t aapl_id, hid_t dxpl_id, void **req)
 {
-  return 0;
+  H5VL_pfs_vol_t *o = (H5VL_pfs_vol_t *)obj;
+  H5VL_pfs_vol_file_t *file = o->file_.get();
+  hssize_t npoints = H5Sget_simple_extent_npoints(space_id);
+  size_t type_size = 0, space_size = 0;
+  H5VL_pfs_vol_attr_rec_t rec;
+  H5VL_pfs_vol_obj_rec_t owner_rec;
+  H5VL_pfs_vol_t *attr;
+  h5::KvBatch batch;
+  std::string key;
+  uint64_t owner;
+
+  /* Values are kept in the attribute's record, so variable-length data
+   * (which would point outside it) is not supported */
+  if (name == nullptr || npoints < 0 || H5Tdetect_class(type_id, H5T_VLEN) != 0 || H5Tis_variable_str(type_id) != 0 ||
+      H5VL_pfs_vol_md_locate(o, loc_params, &owner) < 0 ||
+      H5VL_pfs_vol_md_get_obj(file, batch, owner, &owner_rec) < 0)
+    return nullptr;
+  key = H5VL_pfs_vol_md_key('A', owner, name);
+  if (file->md_->Get(key) != nullptr || H5Tencode(type_id, nullptr, &type_size) < 0 ||
+      H5Sencode2(space_id, nullptr, &space_size, H5P_DEFAULT) < 0)
+    return nullptr;
+  rec.type_.resize(type_size);
+  rec.space_.resize(space_size);
+  if (H5Tencode(type_id, rec.type_.data(), &type_size) < 0 ||
+      H5Sencode2(space_id, rec.space_.data(), &space_size, H5P_DEFAULT) < 0)
+    return nullptr;
+  rec.data_.assign(npoints * H5Tget_size(type_id), '\0');
+  rec.corder_ = owner_rec.attr_corder_++;
+  owner_rec.nattrs_++;
+  batch.Put(key, H5VL_pfs_vol_md_attr_enc(rec));
+  batch.Put(H5VL_pfs_vol_md_key('B', owner, H5VL_pfs_vol_md_be(rec.corder_)), name);
+  batch.Put(H5VL_pfs_vol_md_key('O', owner, ""), H5VL_pfs_vol_md_obj_enc(owner_rec));
+  if (H5VL_pfs_vol_md_commit(file, batch, {}) < 0)
+    return nullptr;
+  attr = H5VL_pfs_vol_new_obj(o, "");
+  attr->id_ = owner;
+  attr->attr_ = name;
+  return attr;
 } /* end H5VL_pfs_vol_attr_create() */
 
 /*-------------------------------------------------------------------------
@@ -634,7 +5068,18 @@ static void *
 H5VL_pfs_vol_attr_open(void *obj, const H5VL_loc_params_t *loc_params, const char *name, hid_t aapl_id,
                        hid_t dxpl_id, void **req)
 {
-  return nullptr;
+  H5VL_pfs_vol_t *o = (H5VL_pfs_vol_t *)obj;
+  H5VL_pfs_vol_t *attr;
+  std::string attr_name;
+  uint64_t owner;
+
+  if (H5VL_pfs_vol_md_attr_find(o, loc_params, name, &owner, &attr_name) < 0 ||
+      o->file_->md_->Get(H5VL_pfs_vol_md_key('A', owner, attr_name)) == nullptr)
+    return nullptr;
+  attr = H5VL_pfs_vol_new_obj(o, "");
+  attr->id_ = owner;
+  attr->attr_ = attr_name;
+  return attr;
 } /* end H5VL_pfs_vol_attr_open() */
 
 /*-------------------------------------------------------------------------
@@ -650,7 +5095,18 @@ H5VL_pfs_vol_attr_open(void *obj, const H5VL_loc_params_t *loc_params, const cha
 static herr_t
 H5VL_pfs_vol_attr_read(void *attr, hid_t mem_type_id, void *buf, hid_t dxpl_id, void **req)
 {
-  return 0;
+  H5VL_pfs_vol_t *o = (H5VL_pfs_vol_t *)attr;
+  H5VL_pfs_vol_attr_rec_t rec;
+  hid_t type_id;
+  herr_t ret;
+
+  if (H5VL_pfs_vol_md_attr_dec(o->file_->md_->Get(H5VL_pfs_vol_md_key('A', o->id_, o->attr_)), &rec) < 0 ||
+      (type_id = H5Tdecode(rec.type_.data())) < 0)
+    return -1;
+  ret = H5VL_pfs_vol_md_convert(type_id, mem_type_id, rec.data_.size() / H5Tget_size(type_id), rec.data_.data(),
+                                buf);
+  H5Tclose(type_id);
+  return ret;
 } /* end H5VL_pfs_vol_attr_read() */
 
 /*-------------------------------------------------------------------------
@@ -666,7 +5122,22 @@ H5VL_pfs_vol_attr_read(void *attr, hid_t mem_type_id, void *buf, hid_t dxpl_id,
 static herr_t
 H5VL_pfs_vol_attr_write(void *attr, hid_t mem_type_id, const void *buf, hid_t dxpl_id, void **req)
 {
-  return 0;
+  H5VL_pfs_vol_t *o = (H5VL_pfs_vol_t *)attr;
+  std::string key = H5VL_pfs_vol_md_key('A', o->id_, o->attr_);
+  H5VL_pfs_vol_attr_rec_t rec;
+  h5::KvBatch batch;
+  hid_t type_id;
+  herr_t ret;
+
+  if (H5VL_pfs_vol_md_attr_dec(o->file_->md_->Get(key), &rec) < 0 || (type_id = H5Tdecode(rec.type_.data())) < 0)
+    return -1;
+  ret = H5VL_pfs_vol_md_convert(mem_type_id, type_id, rec.data_.size() / H5Tget_size(type_id), buf,
+                                rec.data_.data());
+  H5Tclose(type_id);
+  if (ret < 0)
+    return -1;
+  batch.Put(key, H5VL_pfs_vol_md_attr_enc(rec));
+  return H5VL_pfs_vol_md_commit(o->file_.get(), batch, {});
 } /* end H5VL_pfs_vol_attr_write() */
 
 /*-------------------------------------------------------------------------
@@ -682,7 +5153,50 @@ H5VL_pfs_vol_attr_write(void *attr, hid_t mem_type_id, const void *buf, hid_t dx
 static herr_t
 H5VL_pfs_vol_attr_get(void *obj, H5VL_attr_get_args_t *args, hid_t dxpl_id, void **req)
 {
-  return 0;
+  H5VL_pfs_vol_t *o = (H5VL_pfs_vol_t *)obj;
+  H5VL_pfs_vol_attr_rec_t rec;
+  std::string name;
+  uint64_t owner;
+
+  switch (args->op_type) {
+    case H5VL_ATTR_GET_ACPL:
+      args->args.get_acpl.acpl_id = H5Pcreate(H5P_ATTRIBUTE_CREATE);
+      return args->args.get_acpl.acpl_id < 0 ? -1 : 0;
+    case H5VL_ATTR_GET_INFO:
+      if (H5VL_pfs_vol_md_attr_find(o, &args->args.get_info.loc_params, args->args.get_info.attr_name, &owner,
+                                    &name) < 0)
+        return -1;
+      return H5VL_pfs_vol_md_attr_info(o->file_.get(), owner, name, args->args.get_info.ainfo);
+    case H5VL_ATTR_GET_NAME:
+      if (H5VL_pfs_vol_md_attr_find(o, &args->args.get_name.loc_params, nullptr, &owner, &name) < 0)
+        return -1;
+      if (args->args.get_name.buf && args->args.get_name.buf_size) {
+        size_t n = std::min(name.size(), args->args.get_name.buf_size - 1);
+        memcpy(args->args.get_name.buf, name.data(), n);
+        args->args.get_name.buf[n] = '\0';
+      }
+      *args->args.get_name.attr_name_len = name.size();
+      return 0;
+    default:
+      break;
+  }
+
+  /* The rest ask about the attribute itself */
+  if (H5VL_pfs_vol_md_attr_dec(o->file_->md_->Get(H5VL_pfs_vol_md_key('A', o->id_, o->attr_)), &rec) < 0)
+    return -1;
+  switch (args->op_type) {
+    case H5VL_ATTR_GET_SPACE:
+      args->args.get_space.space_id = H5Sdecode(rec.space_.data());
+      return args->args.get_space.space_id < 0 ? -1 : 0;
+    case H5VL_ATTR_GET_TYPE:
+      args->args.get_type.type_id = H5Tdecode(rec.type_.data());
+      return args->args.get_type.type_id < 0 ? -1 : 0;
+    case H5VL_ATTR_GET_STORAGE_SIZE:
+      *args->args.get_storage_size.data_size = rec.data_.size();
+      return 0;
+    default:
+      return -1;
+  }
 } /* end H5VL_pfs_vol_attr_get() */
 
 /*-------------------------------------------------------------------------
@@ -699,7 +5213,74 @@ static herr_t
 H5VL_pfs_vol_attr_specific(void *obj, const H5VL_loc_params_t *loc_params,
                            H5VL_attr_specific_args_t *args, hid_t dxpl_id, void **req)
 {
-  return 0;
+  H5VL_pfs_vol_t *o = (H5VL_pfs_vol_t *)obj;
+  H5VL_pfs_vol_file_t *file = o->file_.get();
+  std::vector<std::string> names;
+  H5VL_pfs_vol_attr_rec_t rec;
+  H5VL_pfs_vol_obj_rec_t owner_rec;
+  h5::KvBatch batch;
+  std::string name, key;
+  uint64_t owner;
+
+  if (H5VL_pfs_vol_md_locate(o, loc_params, &owner) < 0)
+    return -1;
+  switch (args->op_type) {
+    case H5VL_ATTR_DELETE:
+    case H5VL_ATTR_DELETE_BY_IDX:
+      if (args->op_type == H5VL_ATTR_DELETE) {
+        name = args->args.del.name;
+      } else {
+        if (H5VL_pfs_vol_md_names(file, true, owner, args->args.delete_by_idx.idx_type,
+                                  args->args.delete_by_idx.order, names) < 0 ||
+            args->args.delete_by_idx.n >= names.size())
+          return -1;
+        name = names[args->args.delete_by_idx.n];
+      }
+      key = H5VL_pfs_vol_md_key('A', owner, name);
+      if (H5VL_pfs_vol_md_attr_dec(file->md_->Get(key), &rec) < 0 ||
+          H5VL_pfs_vol_md_get_obj(file, batch, owner, &owner_rec) < 0)
+        return -1;
+      owner_rec.nattrs_--;
+      batch.Delete(key);
+      batch.Delete(H5VL_pfs_vol_md_key('B', owner, H5VL_pfs_vol_md_be(rec.corder_)));
+      batch.Put(H5VL_pfs_vol_md_key('O', owner, ""), H5VL_pfs_vol_md_obj_enc(owner_rec));
+      return H5VL_pfs_vol_md_commit(file, batch, {});
+    case H5VL_ATTR_EXISTS:
+      *args->args.exists.exists = file->md_->Get(H5VL_pfs_vol_md_key('A', owner, args->args.exists.name)) != nullptr;
+      return 0;
+    case H5VL_ATTR_ITER: {
+      hsize_t *idx = args->args.iterate.idx;
+      herr_t ret = 0;
+      hid_t loc_id;
+      if (H5VL_pfs_vol_md_names(file, true, owner, args->args.iterate.idx_type, args->args.iterate.order, names) < 0 ||
+          (loc_id = H5VL_pfs_vol_md_register(o, owner)) < 0)
+        return -1;
+      for (size_t i = idx ? *idx : 0; i < names.size() && ret == 0; i++) {
+        H5A_info_t ainfo;
+        if (H5VL_pfs_vol_md_attr_info(file, owner, names[i], &ainfo) < 0) {
+          ret = -1;
+          break;
+        }
+        ret = args->args.iterate.op(loc_id, names[i].c_str(), &ainfo, args->args.iterate.op_data);
+        if (idx)
+          *idx = i + 1;
+      }
+      H5Idec_ref(loc_id);
+      return ret;
+    }
+    case H5VL_ATTR_RENAME:
+      key = H5VL_pfs_vol_md_key('A', owner, args->args.rename.new_name);
+      if (H5VL_pfs_vol_md_attr_dec(file->md_->Get(H5VL_pfs_vol_md_key('A', owner, args->args.rename.old_name)),
+                                   &rec) < 0 ||
+          file->md_->Get(key) != nullptr)
+        return -1;
+      batch.Delete(H5VL_pfs_vol_md_key('A', owner, args->args.rename.old_name));
+      batch.Put(key, H5VL_pfs_vol_md_attr_enc(rec));
+      batch.Put(H5VL_pfs_vol_md_key('B', owner, H5VL_pfs_vol_md_be(rec.corder_)), args->args.rename.new_name);
+      return H5VL_pfs_vol_md_commit(file, batch, {});
+    default:
+      return -1;
+  }
 } /* end H5VL_pfs_vol_attr_specific() */
 
 /*-------------------------------------------------------------------------
@@ -731,6 +5312,7 @@ H5VL_pfs_vol_attr_optional(void *obj, H5VL_optional_args_t *args, hid_t dxpl_id,
 static herr_t
 H5VL_pfs_vol_attr_close(void *attr, hid_t dxpl_id, void **req)
 {
+  delete (H5VL_pfs_vol_t *)attr;
   return 0;
 } /* end H5VL_pfs_vol_attr_close() */
 
@@ -749,7 +5331,43 @@ H5VL_pfs_vol_dataset_create(void *obj, const H5VL_loc_params_t *loc_params, cons
                             hid_t lcpl_id, hid_t type_id, hid_t space_id, hid_t dcpl_id, hid_t dapl_id,
                             hid_t dxpl_id, void **req)
 {
-  H5VL_pfs_vol_t *dset = new H5VL_pfs_vol_t();
+  H5VL_pfs_vol_t *o = (H5VL_pfs_vol_t *)obj;
+  H5VL_pfs_vol_obj_rec_t rec = {};
+  H5VL_pfs_vol_t *dset;
+  bool subfiled = o->file_->subfile_ != 0;
+  std::string last;
+  uint64_t parent, id;
+
+  if (H5VL_pfs_vol_md_parent(o, name, lcpl_id, &parent, &last) < 0)
+    return nullptr;
+  id = H5VL_pfs_vol_md_next_id(o->file_.get());
+  rec.type_ = H5O_TYPE_DATASET;
+  rec.dir_ = H5VL_PFS_VOL_DSET_DIR "/" + std::to_string(id);
+  dset = H5VL_pfs_vol_new_obj(o, "");
+  dset->path_ = o->file_->root_ + "/" + rec.dir_;
+  dset->id_ = id;
+
+  /* Each dataset is a directory, named by its object id, holding its
+   * "meta" file and its data file(s). With subfiling every rank creates
+   * the dataset, each adding its subfile, so the directory may already
+   * be there. */
+  if (mkdir(dset->path_.c_str(), 0755) < 0 && !(subfiled && errno == EEXIST)) {
+    delete dset;
+    return nullptr;
+  }
+  dset->dset_ = H5VL_pfs_vol_dset_new(dset, type_id, space_id, dcpl_id);
+  if (dset->dset_ == nullptr || H5VL_pfs_vol_data_open(dset, O_RDWR | O_CREAT | (subfiled ? 0 : O_TRUNC)) < 0 ||
+      H5VL_pfs_vol_meta_write(dset) < 0 || (dset->log_ && H5VL_pfs_vol_log_open(dset) < 0) ||
+      H5VL_pfs_vol_md_create(o->file_.get(), parent, last, id, rec) < 0) {
+    std::error_code ec;
+    H5VL_pfs_vol_dset_free(dset->dset_);
+    if (!subfiled)
+      std::filesystem::remove_all(dset->path_, ec);
+    delete dset;
+    return nullptr;
+  }
+  H5VL_pfs_vol_stage_attach(dset, true);
+  o->file_->open_[dset->path_].push_back(dset);
   return dset;
 } /* end H5VL_pfs_vol_dataset_create() */
 
@@ -767,8 +5385,15 @@ static void *
 H5VL_pfs_vol_dataset_open(void *obj, const H5VL_loc_params_t *loc_params, const char *name,
                           hid_t dapl_id, hid_t dxpl_id, void **req)
 {
-  H5VL_pfs_vol_t *dset = new H5VL_pfs_vol_t();
-  return dset;
+  H5VL_pfs_vol_t *o = (H5VL_pfs_vol_t *)obj;
+  H5VL_pfs_vol_obj_rec_t rec;
+  H5I_type_t type;
+  uint64_t id;
+
+  if (H5VL_pfs_vol_md_walk(o->file_.get(), o->id_, name, 0, &id) < 0 ||
+      H5VL_pfs_vol_md_get_obj(o->file_.get(), h5::KvBatch(), id, &rec) < 0 || rec.type_ != H5O_TYPE_DATASET)
+    return nullptr;
+  return H5VL_pfs_vol_md_open_obj(o, id, &type);
 } /* end H5VL_pfs_vol_dataset_open() */
 
 /*-------------------------------------------------------------------------
@@ -785,7 +5410,8 @@ static herr_t
 H5VL_pfs_vol_dataset_read(size_t count, void *dset[], hid_t mem_type_id[], hid_t mem_space_id[],
                           hid_t file_space_id[], hid_t plist_id, void *buf[], void **req)
 {
-  return 0;
+  return H5VL_pfs_vol_xfer(count, dset, mem_type_id, mem_space_id, file_space_id, (const void **)buf, false,
+                           plist_id, req);
 } /* end H5VL_pfs_vol_dataset_read() */
 
 /*-------------------------------------------------------------------------
@@ -802,7 +5428,7 @@ static herr_t
 H5VL_pfs_vol_dataset_write(size_t count, void *dset[], hid_t mem_type_id[], hid_t mem_space_id[],
                            hid_t file_space_id[], hid_t plist_id, const void *buf[], void **req)
 {
-  return 0;
+  return H5VL_pfs_vol_xfer(count, dset, mem_type_id, mem_space_id, file_space_id, buf, true, plist_id, req);
 } /* end H5VL_pfs_vol_dataset_write() */
 
 /*-------------------------------------------------------------------------
@@ -818,7 +5444,43 @@ H5VL_pfs_vol_dataset_write(size_t count, void *dset[], hid_t mem_type_id[], hid_
 static herr_t
 H5VL_pfs_vol_dataset_get(void *dset, H5VL_dataset_get_args_t *args, hid_t dxpl_id, void **req)
 {
-  return 0;
+  H5VL_pfs_vol_t *o = (H5VL_pfs_vol_t *)dset;
+  H5VL_pfs_vol_dset_t *d = o->dset_;
+
+  switch (args->op_type) {
+    case H5VL_DATASET_GET_SPACE:
+      args->args.get_space.space_id = H5Scopy(d->space_id_);
+      return args->args.get_space.space_id < 0 ? -1 : 0;
+    case H5VL_DATASET_GET_TYPE:
+      args->args.get_type.type_id = H5Tcopy(d->type_id_);
+      return args->args.get_type.type_id < 0 ? -1 : 0;
+    case H5VL_DATASET_GET_DCPL:
+      args->args.get_dcpl.dcpl_id = H5Pcopy(d->dcpl_id_);
+      return args->args.get_dcpl.dcpl_id < 0 ? -1 : 0;
+    case H5VL_DATASET_GET_DAPL:
+      args->args.get_dapl.dapl_id = H5Pcreate(H5P_DATASET_ACCESS);
+      return args->args.get_dapl.dapl_id < 0 ? -1 : 0;
+    case H5VL_DATASET_GET_STORAGE_SIZE: {
+      std::lock_guard<std::mutex> guard(d->lock_);
+      size_t nalloc = 0;
+      for (uint64_t off : d->chunks_)
+        nalloc += off != H5VL_PFS_VOL_NO_CHUNK;
+      *args->args.get_storage_size.storage_size = nalloc * d->chunk_bytes_;
+      return 0;
+    }
+    case H5VL_DATASET_GET_SPACE_STATUS: {
+      std::lock_guard<std::mutex> guard(d->lock_);
+      size_t nalloc = 0;
+      for (uint64_t off : d->chunks_)
+        nalloc += off != H5VL_PFS_VOL_NO_CHUNK;
+      *args->args.get_space_status.status = nalloc == 0                ? H5D_SPACE_STATUS_NOT_ALLOCATED
+                                            : nalloc < d->chunks_.size() ? H5D_SPACE_STATUS_PART_ALLOCATED
+                                                                       : H5D_SPACE_STATUS_ALLOCATED;
+      return 0;
+    }
+    default:
+      return -1;
+  }
 } /* end H5VL_pfs_vol_dataset_get() */
 
 /*-------------------------------------------------------------------------
@@ -834,7 +5496,19 @@ H5VL_pfs_vol_dataset_get(void *dset, H5VL_dataset_get_args_t *args, hid_t dxpl_i
 static herr_t
 H5VL_pfs_vol_dataset_specific(void *obj, H5VL_dataset_specific_args_t *args, hid_t dxpl_id, void **req)
 {
-  return 0;
+  H5VL_pfs_vol_t *o = (H5VL_pfs_vol_t *)obj;
+
+  switch (args->op_type) {
+    case H5VL_DATASET_SET_EXTENT:
+      H5VL_pfs_vol_wait_idle(o->dset_);
+      return H5VL_pfs_vol_set_extent(o, args->args.set_extent.size);
+    case H5VL_DATASET_FLUSH:
+      return H5VL_pfs_vol_dset_flush(o);
+    case H5VL_DATASET_REFRESH:
+      return 0;
+    default:
+      return -1;
+  }
 } /* end H5VL_pfs_vol_dataset_specific() */
 
 /*-------------------------------------------------------------------------
@@ -856,7 +5530,8 @@ H5VL_pfs_vol_dataset_optional(void *obj, H5VL_optional_args_t *args, hid_t dxpl_
 /*-------------------------------------------------------------------------
  * Function:    H5VL_pfs_vol_dataset_close
  *
- * Purpose:     Closes a dataset.
+ * Purpose:     Closes a dataset handle. The dataset's shared state is
+ *              written out and freed with its last handle.
  *
  * Return:      Success:    0
  *              Failure:    -1, dataset not closed.
@@ -866,7 +5541,59 @@ H5VL_pfs_vol_dataset_optional(void *obj, H5VL_optional_args_t *args, hid_t dxpl_
 static herr_t
 H5VL_pfs_vol_dataset_close(void *dset, hid_t dxpl_id, void **req)
 {
-  return 0;
+  H5VL_pfs_vol_t *o = (H5VL_pfs_vol_t *)dset;
+  std::vector<H5VL_pfs_vol_t *> &open = o->file_->open_[o->path_];
+  herr_t ret_value = 0;
+
+  /* Async requests of this handle use it until they finish */
+  H5VL_pfs_vol_wait_idle(o->dset_);
+  open.erase(std::remove(open.begin(), open.end(), o), open.end());
+  if (!open.empty()) {
+    delete o;
+    return 0;
+  }
+  o->file_->open_.erase(o->path_);
+
+  if ((o->flags_ & H5F_ACC_RDWR) && H5VL_pfs_vol_stage_flush(o) < 0)
+    ret_value = -1;
+  if (o->dset_->log_fd_ >= 0 && (o->flags_ & H5F_ACC_RDWR) && H5VL_pfs_vol_log_compact(o, nullptr) < 0)
+    ret_value = -1;
+  if (H5VL_pfs_vol_cache_drop(o) < 0)
+    ret_value = -1;
+  if (o->dset_->stage_ >= 0 && o->file_->stage_)
+    o->file_->stage_->Release(o->dset_->stage_);
+  if (o->dset_->dirty_ && H5VL_pfs_vol_meta_write(o) < 0)
+    ret_value = -1;
+
+  /* Hand the runs written since the open to the map built at file close */
+  if (o->file_->subfile_ && (o->flags_ & H5F_ACC_RDWR) && !o->dset_->written_.empty() &&
+      !o->file_->unlinked_.count(o->path_)) {
+    std::vector<H5VL_pfs_vol_claim_t> &owned = o->file_->owned_[o->path_];
+    for (H5VL_pfs_vol_claim_t claim : o->dset_->written_) {
+      uint64_t loc = o->dset_->chunks_[claim.chunk_];
+      if (loc == H5VL_PFS_VOL_NO_CHUNK || H5VL_PFS_VOL_LOC_SUBFILE(loc) != o->file_->subfile_)
+        continue;
+      claim.loc_ = loc;
+      owned.push_back(claim);
+    }
+  }
+  if (o->dset_->fd_ >= 0)
+    o->file_->io_->Release(o->dset_->fd_);
+  if (o->dset_->log_fd_ >= 0)
+    o->file_->io_->Release(o->dset_->log_fd_);
+  if (o->dset_->dfd_ >= 0)
+    o->file_->io_->Release(o->dset_->dfd_);
+  for (auto &it : o->dset_->subfiles_)
+    o->file_->io_->Release(it.second);
+  H5VL_pfs_vol_dset_free(o->dset_);
+
+  /* The last handle of a deleted dataset takes its directory along */
+  if (o->file_->unlinked_.erase(o->path_) && o->file_->md_writer_) {
+    std::error_code ec;
+    std::filesystem::remove_all(o->path_, ec);
+  }
+  delete o;
+  return ret_value;
 } /* end H5VL_pfs_vol_dataset_close() */
 
 /*-------------------------------------------------------------------------
@@ -982,8 +5709,36 @@ static void *
 H5VL_pfs_vol_file_create(const char *name, unsigned flags, hid_t fcpl_id, hid_t fapl_id, hid_t dxpl_id,
                          void **req)
 {
-  H5VL_pfs_vol_t *file = new H5VL_pfs_vol_t();
-  file->path_ = name;
+  H5VL_pfs_vol_t *file = H5VL_pfs_vol_new_file(name, flags | H5F_ACC_RDWR, fapl_id);
+  std::string marker;
+  std::error_code ec;
+  int ok = 1;
+
+  if (file == nullptr)
+    return nullptr;
+  marker = file->path_ + "/" H5VL_PFS_VOL_MARKER;
+
+  /* A container is a directory tagged with a marker file. Only an
+   * existing container is truncated, never an arbitrary directory.
+   * With subfiling all ranks create the container; rank 0 sets it up. */
+  if (file->file_->subfile_ == 0 || H5VL_pfs_vol_rank() == 0) {
+    if (std::filesystem::exists(file->path_, ec)) {
+      if ((flags & H5F_ACC_EXCL) || access(marker.c_str(), F_OK) < 0)
+        ok = 0;
+      else
+        std::filesystem::remove_all(file->path_, ec);
+    }
+    if (ok) {
+      std::filesystem::create_directories(file->path_, ec);
+      ok = !ec && H5VL_pfs_vol_marker_write(file) == 0;
+    }
+  }
+  if (file->file_->subfile_ && H5VL_pfs_vol_mpi())
+    MPI_Bcast(&ok, 1, MPI_INT, 0, MPI_COMM_WORLD);
+  if (!ok || H5VL_pfs_vol_md_open(file) < 0 || H5VL_pfs_vol_stage_open(file) < 0) {
+    delete file;
+    return nullptr;
+  }
   return file;
 } /* end H5VL_pfs_vol_file_create() */
 
@@ -1000,8 +5755,14 @@ H5VL_pfs_vol_file_create(const char *name, unsigned flags, hid_t fcpl_id, hid_t
 static void *
 H5VL_pfs_vol_file_open(const char *name, unsigned flags, hid_t fapl_id, hid_t dxpl_id, void **req)
 {
-  H5VL_pfs_vol_t *file = new H5VL_pfs_vol_t();
-  file->path_ = name;
+  H5VL_pfs_vol_t *file = H5VL_pfs_vol_new_file(name, flags, fapl_id);
+
+  if (file == nullptr)
+    return nullptr;
+  if (H5VL_pfs_vol_marker_read(file) < 0 || H5VL_pfs_vol_md_open(file) < 0 || H5VL_pfs_vol_stage_open(file) < 0) {
+    delete file;
+    return nullptr;
+  }
   return file;
 } /* end H5VL_pfs_vol_file_open() */
 
@@ -1018,7 +5779,31 @@ H5VL_pfs_vol_file_open(const char *name, unsigned flags, hid_t fapl_id, hid_t dx
 static herr_t
 H5VL_pfs_vol_file_get(void *file, H5VL_file_get_args_t *args, hid_t dxpl_id, void **req)
 {
-  return 0;
+  H5VL_pfs_vol_t *o = (H5VL_pfs_vol_t *)file;
+
+  switch (args->op_type) {
+    case H5VL_FILE_GET_FCPL:
+      args->args.get_fcpl.fcpl_id = H5Pcreate(H5P_FILE_CREATE);
+      return args->args.get_fcpl.fcpl_id < 0 ? -1 : 0;
+    case H5VL_FILE_GET_FAPL:
+      args->args.get_fapl.fapl_id = H5Pcreate(H5P_FILE_ACCESS);
+      return args->args.get_fapl.fapl_id < 0 ? -1 : 0;
+    case H5VL_FILE_GET_INTENT:
+      *args->args.get_intent.flags = o->flags_ & H5F_ACC_RDWR;
+      return 0;
+    case H5VL_FILE_GET_NAME: {
+      const std::string &root = o->file_->root_;
+      if (args->args.get_name.buf && args->args.get_name.buf_size) {
+        size_t n = std::min(root.size(), args->args.get_name.buf_size - 1);
+        memcpy(args->args.get_name.buf, root.data(), n);
+        args->args.get_name.buf[n] = '\0';
+      }
+      *args->args.get_name.file_name_len = root.size();
+      return 0;
+    }
+    default:
+      return -1;
+  }
 } /* end H5VL_pfs_vol_file_get() */
 
 /*-------------------------------------------------------------------------
@@ -1034,7 +5819,32 @@ H5VL_pfs_vol_file_get(void *file, H5VL_file_get_args_t *args, hid_t dxpl_id, voi
 static herr_t
 H5VL_pfs_vol_file_specific(void *file, H5VL_file_specific_args_t *args, hid_t dxpl_id, void **req)
 {
-  return 0;
+  H5VL_pfs_vol_t *o = (H5VL_pfs_vol_t *)file;
+
+  switch (args->op_type) {
+    case H5VL_FILE_FLUSH: {
+      herr_t ret = 0;
+      for (auto &it : o->file_->open_)
+        if (H5VL_pfs_vol_dset_flush(it.second.front()) < 0)
+          ret = -1;
+      return ret < 0 || o->file_->md_->Sync() < 0 ? -1 : 0;
+    }
+    case H5VL_FILE_IS_ACCESSIBLE: {
+      std::string marker = std::string(args->args.is_accessible.filename) + "/" H5VL_PFS_VOL_MARKER;
+      *args->args.is_accessible.accessible = access(marker.c_str(), F_OK) == 0;
+      return 0;
+    }
+    case H5VL_FILE_DELETE: {
+      std::string path = args->args.del.filename;
+      std::error_code ec;
+      if (access((path + "/" H5VL_PFS_VOL_MARKER).c_str(), F_OK) < 0)
+        return -1;
+      std::filesystem::remove_all(path, ec);
+      return ec ? -1 : 0;
+    }
+    default:
+      return -1;
+  }
 } /* end H5VL_pfs_vol_file_specific() */
 
 /*-------------------------------------------------------------------------
@@ -1066,7 +5876,18 @@ H5VL_pfs_vol_file_optional(void *file, H5VL_optional_args_t *args, hid_t dxpl_id
 static herr_t
 H5VL_pfs_vol_file_close(void *file, hid_t dxpl_id, void **req)
 {
-  return 0;
+  H5VL_pfs_vol_t *o = (H5VL_pfs_vol_t *)file;
+  herr_t ret_value = 0;
+
+  if (H5VL_pfs_vol_cache_flush(o->file_.get(), nullptr) < 0)
+    ret_value = -1;
+  if (o->file_->subfile_ && (o->flags_ & H5F_ACC_RDWR) && H5VL_pfs_vol_subfile_merge(o) < 0)
+    ret_value = -1;
+  H5VL_pfs_vol_stage_close(o->file_.get());
+  if (o->file_->md_->Close() < 0)
+    ret_value = -1;
+  delete o;
+  return ret_value;
 } /* end H5VL_pfs_vol_file_close() */
 
 /*-------------------------------------------------------------------------
@@ -1083,7 +5904,23 @@ static void *
 H5VL_pfs_vol_group_create(void *obj, const H5VL_loc_params_t *loc_params, const char *name,
                           hid_t lcpl_id, hid_t gcpl_id, hid_t gapl_id, hid_t dxpl_id, void **req)
 {
-  return 0;
+  H5VL_pfs_vol_t *o = (H5VL_pfs_vol_t *)obj;
+  H5VL_pfs_vol_obj_rec_t rec = {};
+  H5VL_pfs_vol_t *group;
+  std::string last;
+  uint64_t parent, id;
+
+  /* Groups are records in the metadata store only */
+  if (H5VL_pfs_vol_md_parent(o, name, lcpl_id, &parent, &last) < 0)
+    return nullptr;
+  rec.type_ = H5O_TYPE_GROUP;
+  id = H5VL_pfs_vol_md_next_id(o->file_.get());
+  if (H5VL_pfs_vol_md_create(o->file_.get(), parent, last, id, rec) < 0)
+    return nullptr;
+  group = H5VL_pfs_vol_new_obj(o, "");
+  group->path_ = o->file_->root_;
+  group->id_ = id;
+  return group;
 } /* end H5VL_pfs_vol_group_create() */
 
 /*-------------------------------------------------------------------------
@@ -1100,7 +5937,15 @@ static void *
 H5VL_pfs_vol_group_open(void *obj, const H5VL_loc_params_t *loc_params, const char *name, hid_t gapl_id,
                         hid_t dxpl_id, void **req)
 {
-  return 0;
+  H5VL_pfs_vol_t *o = (H5VL_pfs_vol_t *)obj;
+  H5VL_pfs_vol_obj_rec_t rec;
+  H5I_type_t type;
+  uint64_t id;
+
+  if (H5VL_pfs_vol_md_walk(o->file_.get(), o->id_, name, 0, &id) < 0 ||
+      H5VL_pfs_vol_md_get_obj(o->file_.get(), h5::KvBatch(), id, &rec) < 0 || rec.type_ != H5O_TYPE_GROUP)
+    return nullptr;
+  return H5VL_pfs_vol_md_open_obj(o, id, &type);
 } /* end H5VL_pfs_vol_group_open() */
 
 /*-------------------------------------------------------------------------
@@ -1116,7 +5961,28 @@ H5VL_pfs_vol_group_open(void *obj, const H5VL_loc_params_t *loc_params, const ch
 static herr_t
 H5VL_pfs_vol_group_get(void *obj, H5VL_group_get_args_t *args, hid_t dxpl_id, void **req)
 {
-  return 0;
+  H5VL_pfs_vol_t *o = (H5VL_pfs_vol_t *)obj;
+  H5VL_pfs_vol_obj_rec_t rec;
+  uint64_t id;
+
+  switch (args->op_type) {
+    case H5VL_GROUP_GET_GCPL:
+      args->args.get_gcpl.gcpl_id = H5Pcreate(H5P_GROUP_CREATE);
+      return args->args.get_gcpl.gcpl_id < 0 ? -1 : 0;
+    case H5VL_GROUP_GET_INFO: {
+      H5G_info_t *ginfo = args->args.get_info.ginfo;
+      if (H5VL_pfs_vol_md_locate(o, &args->args.get_info.loc_params, &id) < 0 ||
+          H5VL_pfs_vol_md_get_obj(o->file_.get(), h5::KvBatch(), id, &rec) < 0 || rec.type_ != H5O_TYPE_GROUP)
+        return -1;
+      ginfo->storage_type = H5G_STORAGE_TYPE_DENSE;
+      ginfo->nlinks = rec.nlinks_;
+      ginfo->max_corder = (int64_t)rec.link_corder_;
+      ginfo->mounted = false;
+      return 0;
+    }
+    default:
+      return -1;
+  }
 } /* end H5VL_pfs_vol_group_get() */
 
 /*-------------------------------------------------------------------------
@@ -1132,7 +5998,16 @@ H5VL_pfs_vol_group_get(void *obj, H5VL_group_get_args_t *args, hid_t dxpl_id, vo
 static herr_t
 H5VL_pfs_vol_group_specific(void *obj, H5VL_group_specific_args_t *args, hid_t dxpl_id, void **req)
 {
-  return 0;
+  H5VL_pfs_vol_t *o = (H5VL_pfs_vol_t *)obj;
+
+  switch (args->op_type) {
+    case H5VL_GROUP_FLUSH:
+      return o->file_->md_->Sync();
+    case H5VL_GROUP_REFRESH:
+      return 0;
+    default:
+      return -1;
+  }
 } /* end H5VL_pfs_vol_group_specific() */
 
 /*-------------------------------------------------------------------------
@@ -1164,6 +6039,7 @@ H5VL_pfs_vol_group_optional(void *obj, H5VL_optional_args_t *args, hid_t dxpl_id
 static herr_t
 H5VL_pfs_vol_group_close(void *grp, hid_t dxpl_id, void **req)
 {
+  delete (H5VL_pfs_vol_t *)grp;
   return 0;
 } /* end H5VL_pfs_vol_group_close() */
 
@@ -1181,7 +6057,37 @@ static herr_t
 H5VL_pfs_vol_link_create(H5VL_link_create_args_t *args, void *obj, const H5VL_loc_params_t *loc_params,
                          hid_t lcpl_id, hid_t lapl_id, hid_t dxpl_id, void **req)
 {
-  return 0;
+  H5VL_pfs_vol_t *o = (H5VL_pfs_vol_t *)obj;
+  H5VL_pfs_vol_link_rec_t link = {};
+  h5::KvBatch batch;
+  std::string last;
+  uint64_t parent;
+
+  switch (args->op_type) {
+    case H5VL_LINK_CREATE_HARD: {
+      H5VL_pfs_vol_t *cur = (H5VL_pfs_vol_t *)args->args.hard.curr_obj;
+      if (cur == nullptr)
+        cur = o;
+      if (o == nullptr)
+        o = cur;
+      link.type_ = H5L_TYPE_HARD;
+      if (cur == nullptr || H5VL_pfs_vol_md_locate(cur, &args->args.hard.curr_loc_params, &link.target_) < 0)
+        return -1;
+      break;
+    }
+    case H5VL_LINK_CREATE_SOFT:
+      link.type_ = H5L_TYPE_SOFT;
+      link.path_ = args->args.soft.target;
+      break;
+    default:
+      /* External and user-defined links are not supported */
+      return -1;
+  }
+  if (loc_params->type != H5VL_OBJECT_BY_NAME ||
+      H5VL_pfs_vol_md_parent(o, loc_params->loc_data.loc_by_name.name, lcpl_id, &parent, &last) < 0 ||
+      H5VL_pfs_vol_md_link(o->file_.get(), batch, parent, last, link) < 0)
+    return -1;
+  return H5VL_pfs_vol_md_commit(o->file_.get(), batch, {});
 } /* end H5VL_pfs_vol_link_create() */
 
 /*-------------------------------------------------------------------------
@@ -1204,7 +6110,22 @@ H5VL_pfs_vol_link_copy(void *src_obj, const H5VL_loc_params_t *loc_params1, void
                        const H5VL_loc_params_t *loc_params2, hid_t lcpl_id, hid_t lapl_id, hid_t dxpl_id,
                        void **req)
 {
-  return 0;
+  H5VL_pfs_vol_t *src = (H5VL_pfs_vol_t *)src_obj;
+  H5VL_pfs_vol_t *dst = dst_obj ? (H5VL_pfs_vol_t *)dst_obj : src;
+  H5VL_pfs_vol_file_t *file = src->file_.get();
+  H5VL_pfs_vol_link_rec_t link;
+  h5::KvBatch batch;
+  std::string src_name, dst_name;
+  uint64_t src_parent, dst_parent;
+
+  if (loc_params2->type != H5VL_OBJECT_BY_NAME || H5VL_pfs_vol_md_link_at(src, loc_params1, &src_parent, &src_name) < 0 ||
+      H5VL_pfs_vol_md_link_dec(file->md_->Get(H5VL_pfs_vol_md_key('L', src_parent, src_name)), &link) < 0 ||
+      H5VL_pfs_vol_md_parent(dst, loc_params2->loc_data.loc_by_name.name, lcpl_id, &dst_parent, &dst_name) < 0 ||
+      H5VL_pfs_vol_md_link(file, batch, dst_parent, dst_name, link) < 0)
+    return -1;
+
+  /* A hard link gains a reference to its target */
+  return H5VL_pfs_vol_md_commit(file, batch, {});
 } /* end H5VL_pfs_vol_link_copy() */
 
 /*-------------------------------------------------------------------------
@@ -1227,7 +6148,26 @@ H5VL_pfs_vol_link_move(void *src_obj, const H5VL_loc_params_t *loc_params1, void
                        const H5VL_loc_params_t *loc_params2, hid_t lcpl_id, hid_t lapl_id, hid_t dxpl_id,
                        void **req)
 {
-  return 0;
+  H5VL_pfs_vol_t *src = (H5VL_pfs_vol_t *)src_obj;
+  H5VL_pfs_vol_t *dst = dst_obj ? (H5VL_pfs_vol_t *)dst_obj : src;
+  H5VL_pfs_vol_file_t *file = src->file_.get();
+  H5VL_pfs_vol_link_rec_t link;
+  std::vector<std::string> dirs;
+  h5::KvBatch batch;
+  std::string src_name, dst_name;
+  uint64_t src_parent, dst_parent;
+
+  if (loc_params2->type != H5VL_OBJECT_BY_NAME || H5VL_pfs_vol_md_link_at(src, loc_params1, &src_parent, &src_name) < 0 ||
+      H5VL_pfs_vol_md_link_dec(file->md_->Get(H5VL_pfs_vol_md_key('L', src_parent, src_name)), &link) < 0 ||
+      H5VL_pfs_vol_md_parent(dst, loc_params2->loc_data.loc_by_name.name, lcpl_id, &dst_parent, &dst_name) < 0 ||
+      H5VL_pfs_vol_md_link(file, batch, dst_parent, dst_name, link) < 0)
+    return -1;
+
+  /* Dropping the source after adding the destination leaves the
+   * target's reference count where it was */
+  if (H5VL_pfs_vol_md_unlink(file, batch, src_parent, src_name, dirs) < 0)
+    return -1;
+  return H5VL_pfs_vol_md_commit(file, batch, dirs);
 } /* end H5VL_pfs_vol_link_move() */
 
 /*-------------------------------------------------------------------------
@@ -1244,7 +6184,37 @@ static herr_t
 H5VL_pfs_vol_link_get(void *obj, const H5VL_loc_params_t *loc_params, H5VL_link_get_args_t *args,
                       hid_t dxpl_id, void **req)
 {
-  return 0;
+  H5VL_pfs_vol_t *o = (H5VL_pfs_vol_t *)obj;
+  H5VL_pfs_vol_link_rec_t link;
+  std::string name;
+  uint64_t parent;
+
+  if (H5VL_pfs_vol_md_link_at(o, loc_params, &parent, &name) < 0 ||
+      H5VL_pfs_vol_md_link_dec(o->file_->md_->Get(H5VL_pfs_vol_md_key('L', parent, name)), &link) < 0)
+    return -1;
+  switch (args->op_type) {
+    case H5VL_LINK_GET_INFO:
+      H5VL_pfs_vol_md_link_info(link, args->args.get_info.linfo);
+      return 0;
+    case H5VL_LINK_GET_NAME:
+      if (args->args.get_name.name && args->args.get_name.name_size) {
+        size_t n = std::min(name.size(), args->args.get_name.name_size - 1);
+        memcpy(args->args.get_name.name, name.data(), n);
+        args->args.get_name.name[n] = '\0';
+      }
+      *args->args.get_name.name_len = name.size();
+      return 0;
+    case H5VL_LINK_GET_VAL:
+      if (link.type_ != H5L_TYPE_SOFT)
+        return -1;
+      if (args->args.get_val.buf && args->args.get_val.buf_size) {
+        size_t n = std::min(link.path_.size() + 1, args->args.get_val.buf_size);
+        memcpy(args->args.get_val.buf, link.path_.c_str(), n);
+      }
+      return 0;
+    default:
+      return -1;
+  }
 } /* end H5VL_pfs_vol_link_get() */
 
 /*-------------------------------------------------------------------------
@@ -1261,7 +6231,38 @@ static herr_t
 H5VL_pfs_vol_link_specific(void *obj, const H5VL_loc_params_t *loc_params,
                            H5VL_link_specific_args_t *args, hid_t dxpl_id, void **req)
 {
-  return 0;
+  H5VL_pfs_vol_t *o = (H5VL_pfs_vol_t *)obj;
+  H5VL_pfs_vol_file_t *file = o->file_.get();
+  std::vector<std::string> dirs;
+  h5::KvBatch batch;
+  std::string name;
+  uint64_t parent;
+
+  switch (args->op_type) {
+    case H5VL_LINK_DELETE:
+      if (H5VL_pfs_vol_md_link_at(o, loc_params, &parent, &name) < 0 ||
+          H5VL_pfs_vol_md_unlink(file, batch, parent, name, dirs) < 0)
+        return -1;
+      return H5VL_pfs_vol_md_commit(file, batch, dirs);
+    case H5VL_LINK_EXISTS:
+      /* A missing intermediate group means the link does not exist */
+      *args->args.exists.exists = H5VL_pfs_vol_md_link_at(o, loc_params, &parent, &name) == 0 &&
+                                  file->md_->Get(H5VL_pfs_vol_md_key('L', parent, name)) != nullptr;
+      return 0;
+    case H5VL_LINK_ITER: {
+      std::set<uint64_t> visited;
+      herr_t ret;
+      hid_t gid;
+      if (H5VL_pfs_vol_md_locate(o, loc_params, &parent) < 0 || (gid = H5VL_pfs_vol_md_register(o, parent)) < 0)
+        return -1;
+      visited.insert(parent);
+      ret = H5VL_pfs_vol_md_iterate(file, gid, parent, "", &args->args.iterate, visited);
+      H5Idec_ref(gid);
+      return ret;
+    }
+    default:
+      return -1;
+  }
 } /* end H5VL_pfs_vol_link_specific() */
 
 /*-------------------------------------------------------------------------
@@ -1295,7 +6296,12 @@ static void *
 H5VL_pfs_vol_object_open(void *obj, const H5VL_loc_params_t *loc_params, H5I_type_t *opened_type,
                          hid_t dxpl_id, void **req)
 {
-  return 0;
+  H5VL_pfs_vol_t *o = (H5VL_pfs_vol_t *)obj;
+  uint64_t id;
+
+  if (H5VL_pfs_vol_md_locate(o, loc_params, &id) < 0)
+    return nullptr;
+  return H5VL_pfs_vol_md_open_obj(o, id, opened_type);
 } /* end H5VL_pfs_vol_object_open() */
 
 /*-------------------------------------------------------------------------
@@ -1313,7 +6319,8 @@ H5VL_pfs_vol_object_copy(void *src_obj, const H5VL_loc_params_t *src_loc_params,
                          void *dst_obj, const H5VL_loc_params_t *dst_loc_params, const char *dst_name,
                          hid_t ocpypl_id, hid_t lcpl_id, hid_t dxpl_id, void **req)
 {
-  return 0;
+  /* Copying would duplicate dataset directories; not supported */
+  return -1;
 } /* end H5VL_pfs_vol_object_copy() */
 
 /*-------------------------------------------------------------------------
@@ -1330,7 +6337,42 @@ static herr_t
 H5VL_pfs_vol_object_get(void *obj, const H5VL_loc_params_t *loc_params, H5VL_object_get_args_t *args,
                         hid_t dxpl_id, void **req)
 {
-  return 0;
+  H5VL_pfs_vol_t *o = (H5VL_pfs_vol_t *)obj;
+  H5VL_pfs_vol_file_t *file = o->file_.get();
+  H5VL_pfs_vol_obj_rec_t rec;
+  std::string name;
+  uint64_t id;
+
+  if (H5VL_pfs_vol_md_locate(o, loc_params, &id) < 0 || H5VL_pfs_vol_md_get_obj(file, h5::KvBatch(), id, &rec) < 0)
+    return -1;
+  switch (args->op_type) {
+    case H5VL_OBJECT_GET_NAME:
+      if (H5VL_pfs_vol_md_name(file, id, &name) < 0)
+        return -1;
+      if (args->args.get_name.buf && args->args.get_name.buf_size) {
+        size_t n = std::min(name.size(), args->args.get_name.buf_size - 1);
+        memcpy(args->args.get_name.buf, name.data(), n);
+        args->args.get_name.buf[n] = '\0';
+      }
+      if (args->args.get_name.name_len)
+        *args->args.get_name.name_len = name.size();
+      return 0;
+    case H5VL_OBJECT_GET_TYPE:
+      *args->args.get_type.obj_type = (H5O_type_t)rec.type_;
+      return 0;
+    case H5VL_OBJECT_GET_INFO: {
+      H5O_info2_t *oinfo = args->args.get_info.oinfo;
+      memset(oinfo, 0, sizeof(*oinfo));
+      H5VL_pfs_vol_md_token(id, &oinfo->token);
+      oinfo->type = (H5O_type_t)rec.type_;
+      oinfo->rc = rec.rc_;
+      oinfo->num_attrs = rec.nattrs_;
+      return 0;
+    }
+    default:
+      /* The file an object belongs to is not handed out separately */
+      return -1;
+  }
 } /* end H5VL_pfs_vol_object_get() */
 
 /*-------------------------------------------------------------------------
@@ -1347,7 +6389,41 @@ static herr_t
 H5VL_pfs_vol_object_specific(void *obj, const H5VL_loc_params_t *loc_params,
                              H5VL_object_specific_args_t *args, hid_t dxpl_id, void **req)
 {
-  return 0;
+  H5VL_pfs_vol_t *o = (H5VL_pfs_vol_t *)obj;
+  H5VL_pfs_vol_file_t *file = o->file_.get();
+  std::vector<std::string> dirs;
+  H5VL_pfs_vol_obj_rec_t rec;
+  h5::KvBatch batch;
+  uint64_t id;
+
+  switch (args->op_type) {
+    case H5VL_OBJECT_CHANGE_REF_COUNT: {
+      int delta = args->args.change_rc.delta;
+      if (H5VL_pfs_vol_md_locate(o, loc_params, &id) < 0 || H5VL_pfs_vol_md_get_obj(file, batch, id, &rec) < 0)
+        return -1;
+      if (delta >= 0) {
+        rec.rc_ += delta;
+        batch.Put(H5VL_pfs_vol_md_key('O', id, ""), H5VL_pfs_vol_md_obj_enc(rec));
+      }
+      for (; delta < 0; delta++)
+        H5VL_pfs_vol_md_release(file, batch, id, dirs);
+      return H5VL_pfs_vol_md_commit(file, batch, dirs);
+    }
+    case H5VL_OBJECT_EXISTS:
+      *args->args.exists.exists = H5VL_pfs_vol_md_locate(o, loc_params, &id) == 0;
+      return 0;
+    case H5VL_OBJECT_LOOKUP:
+      if (H5VL_pfs_vol_md_locate(o, loc_params, &id) < 0)
+        return -1;
+      H5VL_pfs_vol_md_token(id, args->args.lookup.token_ptr);
+      return 0;
+    case H5VL_OBJECT_FLUSH:
+      return file->md_->Sync() < 0 ? -1 : 0;
+    case H5VL_OBJECT_REFRESH:
+      return 0;
+    default:
+      return -1;
+  }
 } /* end H5VL_pfs_vol_object_specific() */
 
 /*-------------------------------------------------------------------------
@@ -1395,6 +6471,7 @@ H5VL_pfs_vol_introspect_get_conn_cls(void *obj, H5VL_get_conn_lvl_t lvl, const H
 herr_t
 H5VL_pfs_vol_introspect_get_cap_flags(const void *_info, uint64_t *cap_flags)
 {
+  *cap_flags = H5VL_pfs_vol_g.cap_flags;
   return 0;
 } /* end H5VL_pfs_vol_introspect_get_cap_flags() */
 
@@ -1429,6 +6506,26 @@ H5VL_pfs_vol_introspect_opt_query(void *obj, H5VL_subclass_t cls, int opt_type,
 static herr_t
 H5VL_pfs_vol_request_wait(void *obj, uint64_t timeout, H5VL_request_status_t *status)
 {
+  H5VL_pfs_vol_req_t *req = (H5VL_pfs_vol_req_t *)obj;
+  std::unique_lock<std::mutex> guard(req->lock_);
+
+  if (timeout == H5ES_WAIT_FOREVER)
+    req->done_cv_.wait(guard, [req]() { return req->done_; });
+  else
+    req->done_cv_.wait_for(guard, std::chrono::nanoseconds(timeout), [req]() { return req->done_; });
+  if (!req->done_) {
+    *status = H5VL_REQUEST_STATUS_IN_PROGRESS;
+    return 0;
+  }
+  *status = req->ret_ < 0 ? H5VL_REQUEST_STATUS_FAIL : H5VL_REQUEST_STATUS_SUCCEED;
+
+  /* The callback may call into HDF5, so only run it on the caller's thread */
+  if (req->cb_ && !req->notified_) {
+    H5VL_request_notify_t cb = req->cb_;
+    req->notified_ = true;
+    guard.unlock();
+    return cb(req->ctx_, *status);
+  }
   return 0;
 } /* end H5VL_pfs_vol_request_wait() */
 
@@ -1436,7 +6533,8 @@ H5VL_pfs_vol_request_wait(void *obj, uint64_t timeout, H5VL_request_status_t *st
  * Function:    H5VL_pfs_vol_request_notify
  *
  * Purpose:     Registers a user callback to be invoked when an asynchronous
- *              operation completes
+ *              operation completes. It runs from request_wait, or right
+ *              away if the operation already completed.
  *
  * Note:        Releases the request, if connector callback succeeds
  *
@@ -1448,7 +6546,19 @@ H5VL_pfs_vol_request_wait(void *obj, uint64_t timeout, H5VL_request_status_t *st
 static herr_t
 H5VL_pfs_vol_request_notify(void *obj, H5VL_request_notify_t cb, void *ctx)
 {
-  return 0;
+  H5VL_pfs_vol_req_t *req = (H5VL_pfs_vol_req_t *)obj;
+  {
+    std::lock_guard<std::mutex> guard(req->lock_);
+    if (!req->done_) {
+      req->cb_ = cb;
+      req->ctx_ = ctx;
+      return 0;
+    }
+    req->notified_ = true;
+  }
+
+  /* Already complete: call back right away */
+  return cb(ctx, req->ret_ < 0 ? H5VL_REQUEST_STATUS_FAIL : H5VL_REQUEST_STATUS_SUCCEED);
 } /* end H5VL_pfs_vol_request_notify() */
 
 /*-------------------------------------------------------------------------
@@ -1466,6 +6576,8 @@ H5VL_pfs_vol_request_notify(void *obj, H5VL_request_notify_t cb, void *ctx)
 static herr_t
 H5VL_pfs_vol_request_cancel(void *obj, H5VL_request_status_t *status)
 {
+  /* Queued kernel I/O cannot be taken back */
+  *status = H5VL_REQUEST_STATUS_CANT_CANCEL;
   return 0;
 } /* end H5VL_pfs_vol_request_cancel() */
 
@@ -1515,6 +6627,7 @@ H5VL_pfs_vol_request_optional(void *obj, H5VL_optional_args_t *args)
 static herr_t
 H5VL_pfs_vol_request_free(void *obj)
 {
+  H5VL_pfs_vol_req_release((H5VL_pfs_vol_req_t *)obj);
   return 0;
 } /* end H5VL_pfs_vol_request_free() */
 
@@ -1592,6 +6705,11 @@ H5VL_pfs_vol_blob_optional(void *obj, void *blob_id, H5VL_optional_args_t *args)
 static herr_t
 H5VL_pfs_vol_token_cmp(void *obj, const H5O_token_t *token1, const H5O_token_t *token2, int *cmp_value)
 {
+  uint64_t id1, id2;
+
+  memcpy(&id1, token1, sizeof(id1));
+  memcpy(&id2, token2, sizeof(id2));
+  *cmp_value = id1 < id2 ? -1 : id1 > id2 ? 1 : 0;
   return 0;
 } /* end H5VL_pfs_vol_token_cmp() */
 
@@ -1608,6 +6726,13 @@ H5VL_pfs_vol_token_cmp(void *obj, const H5O_token_t *token1, const H5O_token_t *
 static herr_t
 H5VL_pfs_vol_token_to_str(void *obj, H5I_type_t obj_type, const H5O_token_t *token, char **token_str)
 {
+  uint64_t id;
+
+  memcpy(&id, token, sizeof(id));
+  *token_str = (char *)malloc(17);
+  if (*token_str == nullptr)
+    return -1;
+  snprintf(*token_str, 17, "%016llx", (unsigned long long)id);
   return 0;
 } /* end H5VL_pfs_vol_token_to_str() */
 
@@ -1624,6 +6749,14 @@ H5VL_pfs_vol_token_to_str(void *obj, H5I_type_t obj_type, const H5O_token_t *tok
 static herr_t
 H5VL_pfs_vol_token_from_str(void *obj, H5I_type_t obj_type, const char *token_str, H5O_token_t *token)
 {
+  unsigned long long id;
+  char *end;
+
+  errno = 0;
+  id = strtoull(token_str, &end, 16);
+  if (errno || end == token_str || *end != '\0')
+    return -1;
+  H5VL_pfs_vol_md_token(id, token);
   return 0;
 } /* end H5VL_pfs_vol_token_from_str() */
 
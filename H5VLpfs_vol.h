@@ -18,6 +18,8 @@
 #define H5VLpfs_vol_H
 
 /* Public headers needed by this file */
+#include <memory>
+#include <string>
 #include <H5PLpublic.h>
 #include "H5VLpublic.h" /* Virtual Object Layer                 */
 
@@ -29,9 +31,40 @@
 #define H5VL_PFS_VOL_VALUE   6 /* VOL connector ID */
 #define H5VL_PFS_VOL_VERSION 0
 
+/* State shared by a container and its objects (private to the connector) */
+struct H5VL_pfs_vol_file_t;
+
+/* Per-dataset chunk layout (private to the connector) */
+struct H5VL_pfs_vol_dset_t;
+
 /* Pass-through VOL connector info */
 typedef struct H5VL_pfs_vol_t {
-  std::string path_;
+  std::string path_;                  /* Directory of the container or dataset */
+  unsigned flags_;                    /* H5F_ACC_* flags the container was opened with */
+  size_t chunk_size_;                 /* Target chunk bytes when the dcpl sets no chunk shape */
+  size_t stripe_size_;                /* Stripe bytes of the data files, or 0 */
+  size_t stripe_count_;               /* Stripes (OSTs) per data file, or 0 */
+  size_t align_;                      /* Power of two chunks are aligned to, or 0 */
+  int io_engine_;                     /* h5::IoEngineKind running chunk I/O */
+  size_t queue_depth_;                /* I/Os in flight per container for queued engines */
+  bool sqpoll_;                       /* Let a kernel thread poll the io_uring submission queue */
+  bool mmap_;                         /* Serve dataset reads from mappings of the data files */
+  bool log_;                          /* Append writes to per-rank logs instead of updating chunks
+                                       * (subfiled containers or a single rank) */
+  size_t log_compact_;                /* Log bytes that trigger a merge into the chunks */
+  size_t nthreads_;                   /* Async request workers */
+  int subfiling_;                     /* H5VL_PFS_VOL_SUBFILE_*: who shares a data file */
+  int cb_write_;                      /* H5VL_PFS_VOL_CB_*: when writes use collective buffering */
+  size_t cb_nodes_;                   /* Aggregators for collective writes, 0 for one per node */
+  size_t cb_buffer_size_;             /* Bytes an aggregator gathers per round */
+  size_t stage_size_;                 /* Bytes of the node-wide write staging pool, or 0 */
+  size_t stage_block_;                /* Bytes per staging block; larger chunks are not staged */
+  size_t cache_size_;                 /* Bytes of the write-back chunk cache, or 0 */
+  size_t prefetch_;                   /* Most steps of a sequential read to prefetch, or 0 */
+  uint64_t id_;                       /* Object id in the metadata store (objects only) */
+  std::string attr_;                  /* Attribute name (attributes only) */
+  std::shared_ptr<struct H5VL_pfs_vol_file_t> file_;  /* Container state (objects only) */
+  struct H5VL_pfs_vol_dset_t *dset_;  /* Chunk layout (datasets only) */
 } H5VL_pfs_vol_t;
 
 #ifdef __cplusplus
@@ -34,7 +34,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
 #include "connector_helpers.h"
+#include "erasure_helpers.h"
+#include "selection_helpers.h"
 
 /* Public HDF5 file */
 #include "hdf5.h"
@@ -61,10 +67,145 @@
 /* Typedefs */
 /************/
 
+/* The completion callback registered on one replica's request token */
+typedef struct H5VL_replicate_vol_ack_t {
+  struct H5VL_replicate_vol_state_t *state_;  /* Write tracking of the file */
+  struct H5VL_replicate_vol_write_t *w_;      /* The write */
+  size_t replica_;                            /* The replica running it */
+} H5VL_replicate_vol_ack_t;
+
+/* A write some replicas may still be running. Every under VOL call is
+ * made on the application's thread, with a request token so that under
+ * VOLs which run asynchronously can overlap. A token that takes a
+ * completion callback reports back on its own; any other is completed by
+ * later calls into the connector. When the write may outlive the
+ * dataset_write call, the replicas write from private copies of the
+ * caller's buffers and dataspaces. */
+typedef struct H5VL_replicate_vol_write_t {
+  size_t count_;                              /* Datasets written */
+  std::vector<hid_t> vol_id_;                 /* Under VOL of each replica */
+  std::vector<std::vector<void *>> obj_;      /* Under objects, per replica */
+  std::vector<void *> req_;                   /* Request token still to be polled, or nullptr */
+  std::vector<H5VL_replicate_vol_ack_t> ack_; /* Completion callback context of each replica */
+  std::vector<bool> issued_;                  /* Replica's under VOL was handed the write */
+  std::vector<std::vector<char>> bufs_;       /* Packed copies of the selections */
+  std::vector<const void *> buf_;             /* Pointers into bufs_ */
+  std::vector<hid_t> mem_type_id_;            /* Copied memory datatypes */
+  std::vector<hid_t> mem_space_id_;           /* 1-D spaces matching bufs_ */
+  std::vector<hid_t> file_space_id_;          /* Copied file selections */
+  hid_t plist_id_;                            /* Copied transfer properties */
+  bool owned_;                                /* The ids and buffers above are copies */
+  std::vector<bool> done_;                    /* Replica finished */
+  size_t acked_;                              /* Replicas that succeeded */
+  size_t failed_;                             /* Replicas that failed */
+  uint64_t seq_;                              /* Issue order among the file's writes */
+  std::chrono::steady_clock::time_point start_;  /* When the write was issued */
+} H5VL_replicate_vol_write_t;
+
+/* Write tracking shared by a file and all objects opened through it */
+typedef struct H5VL_replicate_vol_state_t {
+  std::vector<std::deque<std::shared_ptr<H5VL_replicate_vol_write_t>>> queue_;  /* Per replica, its unfinished
+                                                                                 * writes in issue order */
+  std::mutex lock_;                           /* Guards everything below */
+  std::condition_variable done_cv_;           /* Signaled whenever a replica finishes a write */
+  std::list<std::shared_ptr<H5VL_replicate_vol_write_t>> pending_;  /* Unfinished writes */
+  std::list<std::shared_ptr<H5VL_replicate_vol_write_t>> retired_;  /* Finished, ids not yet closed */
+  std::vector<H5VL_replicate_vol_status_t> status_;  /* Per-replica health */
+  uint64_t seq_ = 0;                          /* Writes issued so far */
+  uint64_t done_ = 0;                         /* Replica completions so far */
+  size_t current_ = 0;                        /* A replica holding every acknowledged write */
+  uint64_t current_seq_ = 0;                  /* Newest write current_ acknowledged */
+} H5VL_replicate_vol_state_t;
+
+/* Header at the start of every under dataset of an erasure-coded dataset,
+ * followed by the encoded datatype, dataspace and creation properties */
+typedef struct H5VL_replicate_vol_ec_header_t {
+  uint32_t magic_;          /* H5VL_REPLICATE_VOL_EC_MAGIC */
+  uint32_t version_;        /* H5VL_REPLICATE_VOL_EC_VERSION */
+  uint32_t data_;           /* Data shards per stripe */
+  uint32_t parity_;         /* Parity shards per stripe */
+  uint32_t shard_;          /* Shard stored in this under dataset */
+  uint32_t type_size_;      /* Bytes of encoded datatype */
+  uint32_t space_size_;     /* Bytes of encoded dataspace */
+  uint32_t dcpl_size_;      /* Bytes of encoded creation properties */
+  uint64_t unit_elmts_;     /* Elements per shard unit */
+  uint64_t data_off_;       /* Offset of the first shard unit */
+} H5VL_replicate_vol_ec_header_t;
+
+/* An erasure-coded dataset. The elements, in row-major order, are cut
+ * into stripes of k units of unit_elmts_ elements. Unit j of stripe s is
+ * stored on under VOL j at data_off_ + s * unit bytes; under VOL k + p
+ * holds parity p of the stripe at the same offset. The last stripe is
+ * zero-padded. */
+typedef struct H5VL_replicate_vol_ec_t {
+  hid_t type_id_;           /* Logical datatype */
+  hid_t space_id_;          /* Logical dataspace */
+  hid_t dcpl_id_;           /* Creation properties given by the user */
+  size_t type_size_;        /* Bytes per element */
+  hsize_t nelmts_;          /* Elements in the dataset */
+  size_t unit_elmts_;       /* Elements per shard unit */
+  uint64_t data_off_;       /* Offset of the first shard unit */
+  uint64_t extent_;         /* Bytes in each under dataset */
+} H5VL_replicate_vol_ec_t;
+
+/* Arguments of the get_status file operation */
+typedef struct H5VL_replicate_vol_get_status_args_t {
+  size_t *nreplicas_;                   /* Capacity of status_ in, replicas out */
+  H5VL_replicate_vol_status_t *status_; /* Health of each replica */
+} H5VL_replicate_vol_get_status_args_t;
+
 /********************* */
 /* Function prototypes */
 /********************* */
 
+/* Helper routines */
+static H5VL_replicate_vol_t *H5VL_replicate_vol_new_obj(const H5VL_replicate_vol_t *o);
+static std::string H5VL_replicate_vol_replica_name(const char *name, size_t replica);
+static std::shared_ptr<H5VL_replicate_vol_write_t> H5VL_replicate_vol_write_new(
+    H5VL_replicate_vol_t *o, size_t count, void *dset[], hid_t mem_type_id[], hid_t mem_space_id[],
+    hid_t file_space_id[], hid_t plist_id, const void *buf[], bool copy);
+static void **H5VL_replicate_vol_unwrap(size_t count, void *dset[], size_t replica, void **obj);
+static void   H5VL_replicate_vol_write_done(H5VL_replicate_vol_state_t *state, H5VL_replicate_vol_write_t *w,
+                                            size_t replica, herr_t status);
+static void   H5VL_replicate_vol_write_issue(H5VL_replicate_vol_state_t *state, H5VL_replicate_vol_write_t *w,
+                                             size_t replica);
+static herr_t H5VL_replicate_vol_write_notify(void *ctx, H5VL_request_status_t status);
+static void   H5VL_replicate_vol_write_poll(H5VL_replicate_vol_state_t *state, H5VL_replicate_vol_write_t *w,
+                                            size_t replica, uint64_t timeout);
+static bool   H5VL_replicate_vol_write_finished(H5VL_replicate_vol_state_t *state, H5VL_replicate_vol_write_t *w,
+                                                size_t replica, bool wait);
+static void   H5VL_replicate_vol_strand(H5VL_replicate_vol_state_t *state, size_t replica, uint64_t timeout);
+static void   H5VL_replicate_vol_progress(H5VL_replicate_vol_state_t *state, uint64_t timeout);
+static herr_t H5VL_replicate_vol_wait(void *req, hid_t vol_id, herr_t status);
+static void   H5VL_replicate_vol_reap(H5VL_replicate_vol_state_t *state);
+static void   H5VL_replicate_vol_drain(H5VL_replicate_vol_t *o);
+static void   H5VL_replicate_vol_rank(H5VL_replicate_vol_state_t *state, size_t bytes, std::vector<size_t> &order);
+static void   H5VL_replicate_vol_observe(H5VL_replicate_vol_state_t *state, size_t replica, size_t bytes,
+                                         double seconds);
+static herr_t H5VL_replicate_vol_status(H5VL_replicate_vol_t *o, size_t *nreplicas,
+                                        H5VL_replicate_vol_status_t *status);
+static herr_t H5VL_replicate_vol_split_read(H5VL_replicate_vol_t *o, hid_t mem_type_id, hid_t mem_space_id,
+                                            hid_t file_space_id, hid_t plist_id, void *buf,
+                                            const std::vector<size_t> &order);
+static H5VL_replicate_vol_ec_t *H5VL_replicate_vol_ec_new(const H5VL_replicate_vol_t *o, hid_t type_id,
+                                                          hid_t space_id, hid_t dcpl_id);
+static void   H5VL_replicate_vol_ec_free(H5VL_replicate_vol_ec_t *ec);
+static herr_t H5VL_replicate_vol_ec_under_io(H5VL_replicate_vol_t *o, size_t shard, uint64_t off, size_t size,
+                                             void *buf, bool write, hid_t *spaces, void **req);
+static herr_t H5VL_replicate_vol_ec_header_write(H5VL_replicate_vol_t *o);
+static herr_t H5VL_replicate_vol_ec_load(H5VL_replicate_vol_t *o);
+static void   H5VL_replicate_vol_ec_slices(size_t n, const std::function<void(size_t, size_t)> &fn);
+static void   H5VL_replicate_vol_ec_io(H5VL_replicate_vol_t *o, const std::vector<size_t> &shards, size_t s0,
+                                       size_t n, std::vector<std::vector<char>> &bufs, bool write,
+                                       std::vector<herr_t> &status);
+static herr_t H5VL_replicate_vol_ec_read_stripes(H5VL_replicate_vol_t *o, size_t s0, size_t n,
+                                                 const std::vector<bool> &need,
+                                                 std::vector<std::vector<char>> &bufs);
+static herr_t H5VL_replicate_vol_ec_read(H5VL_replicate_vol_t *o, hid_t mem_type_id, hid_t mem_space_id,
+                                         hid_t file_space_id, void *buf);
+static herr_t H5VL_replicate_vol_ec_write(H5VL_replicate_vol_t *o, hid_t mem_type_id, hid_t mem_space_id,
+                                          hid_t file_space_id, const void *buf);
+
 /* "Management" callbacks */
 static herr_t H5VL_replicate_vol_init(hid_t vipl_id);
 static herr_t H5VL_replicate_vol_term(void);
@@ -362,6 +503,1277 @@ H5PLget_plugin_info(void) {
 /* The connector identification number, initialized at runtime */
 static hid_t H5VL_REPLICATE_VOL_g = H5I_INVALID_HID;
 
+/* Name and value of the file operation behind H5VL_replicate_vol_get_status */
+#define H5VL_REPLICATE_VOL_GET_STATUS_OP "replicate_vol_get_status"
+static int H5VL_replicate_vol_get_status_op_g = -1;
+
+/* Weight of a new sample in the read latency/bandwidth averages */
+#define H5VL_REPLICATE_VOL_EWMA_ALPHA 0.2
+
+/* Reads below this size only update the latency average */
+#define H5VL_REPLICATE_VOL_SMALL_READ (64 * 1024)
+
+/* Erasure-coded under dataset identification */
+#define H5VL_REPLICATE_VOL_EC_MAGIC   0x53434552 /* "RECS" */
+#define H5VL_REPLICATE_VOL_EC_VERSION 1
+
+/* Shard units start at a multiple of this in each under dataset */
+#define H5VL_REPLICATE_VOL_EC_ALIGN 4096
+
+/* Stripe bytes encoded and written per round of under VOL calls */
+#define H5VL_REPLICATE_VOL_EC_BATCH (8 * 1024 * 1024)
+
+/* Milliseconds between checks of request tokens that take no completion callback */
+#define H5VL_REPLICATE_VOL_POLL_MS 1
+
+/* Smallest run of stripe bytes handed to one coding worker */
+#define H5VL_REPLICATE_VOL_EC_SLICE (64 * 1024)
+
+/* Erasure-coding workers, created with the first file. They only run
+ * Reed-Solomon arithmetic on memory; every HDF5 call stays on the
+ * application thread. */
+static h5::ThreadPool *H5VL_replicate_vol_pool_g = nullptr;
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_replicate_vol_new_obj
+ *
+ * Purpose:     Create an object with the same replica set as \a o, with
+ *              no under objects yet.
+ *
+ * Return:      The new object
+ *
+ *-------------------------------------------------------------------------
+ */
+static H5VL_replicate_vol_t *
+H5VL_replicate_vol_new_obj(const H5VL_replicate_vol_t *o)
+{
+  H5VL_replicate_vol_t *new_obj = new H5VL_replicate_vol_t();
+  new_obj->nthreads_ = o->nthreads_;
+  new_obj->quorum_ = o->quorum_;
+  new_obj->split_size_ = o->split_size_;
+  new_obj->ec_data_ = o->ec_data_;
+  new_obj->ec_parity_ = o->ec_parity_;
+  new_obj->ec_unit_ = o->ec_unit_;
+  new_obj->ec_ = nullptr;
+  new_obj->state_ = o->state_;
+  new_obj->next_vol_id_ = o->next_vol_id_;
+  new_obj->next_vol_info_.assign(o->next_vol_id_.size(), nullptr);
+  return new_obj;
+} /* end H5VL_replicate_vol_new_obj() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_replicate_vol_replica_name
+ *
+ * Purpose:     Name of the container holding one replica. Replica 0 keeps
+ *              the name given by the application; the others get a ".rN"
+ *              suffix so replicas on the same file system do not collide.
+ *
+ * Return:      The container name
+ *
+ *-------------------------------------------------------------------------
+ */
+static std::string
+H5VL_replicate_vol_replica_name(const char *name, size_t replica)
+{
+  if (replica == 0)
+    return name;
+  return std::string(name) + ".r" + std::to_string(replica);
+} /* end H5VL_replicate_vol_replica_name() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_replicate_vol_unwrap
+ *
+ * Purpose:     Collect the under objects of replica \a replica of
+ *              \a count datasets into \a obj. A single dataset needs no
+ *              copy: its own array of under objects is returned.
+ *
+ * Return:      The under objects
+ *
+ *-------------------------------------------------------------------------
+ */
+static void **
+H5VL_replicate_vol_unwrap(size_t count, void *dset[], size_t replica, void **obj)
+{
+  if (count == 1)
+    return &((H5VL_replicate_vol_t *)dset[0])->next_vol_info_[replica];
+  for (size_t i = 0; i < count; i++)
+    obj[i] = ((H5VL_replicate_vol_t *)dset[i])->next_vol_info_[replica];
+  return obj;
+} /* end H5VL_replicate_vol_unwrap() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_replicate_vol_write_new
+ *
+ * Purpose:     Capture a write for replicas that may finish after
+ *              dataset_write returns: pack each memory selection into a
+ *              private buffer described by a 1-D dataspace, and copy the
+ *              datatypes, file selections and transfer properties. When
+ *              \a copy is false (every replica is waited for) the
+ *              caller's buffers and ids are used as-is.
+ *
+ * Return:      Success:    The captured write
+ *              Failure:    nullptr
+ *
+ *-------------------------------------------------------------------------
+ */
+static std::shared_ptr<H5VL_replicate_vol_write_t>
+H5VL_replicate_vol_write_new(H5VL_replicate_vol_t *o, size_t count, void *dset[], hid_t mem_type_id[],
+                             hid_t mem_space_id[], hid_t file_space_id[], hid_t plist_id, const void *buf[],
+                             bool copy)
+{
+  auto w = std::make_shared<H5VL_replicate_vol_write_t>();
+  size_t nreplicas = o->next_vol_id_.size();
+
+  w->count_ = count;
+  w->vol_id_ = o->next_vol_id_;
+  w->obj_.assign(nreplicas, std::vector<void *>(count));
+  w->req_.assign(nreplicas, nullptr);
+  w->ack_.resize(nreplicas);
+  for (size_t r = 0; r < nreplicas; r++)
+    w->ack_[r] = H5VL_replicate_vol_ack_t{o->state_.get(), w.get(), r};
+  w->issued_.assign(nreplicas, false);
+  w->done_.assign(nreplicas, false);
+  w->acked_ = 0;
+  w->failed_ = 0;
+  w->seq_ = 0;
+  w->start_ = std::chrono::steady_clock::now();
+  w->owned_ = copy;
+  for (size_t i = 0; i < count; i++) {
+    for (size_t r = 0; r < nreplicas; r++)
+      w->obj_[r][i] = ((H5VL_replicate_vol_t *)dset[i])->next_vol_info_[r];
+  }
+  if (!copy) {
+    w->buf_.assign(buf, buf + count);
+    w->mem_type_id_.assign(mem_type_id, mem_type_id + count);
+    w->mem_space_id_.assign(mem_space_id, mem_space_id + count);
+    w->file_space_id_.assign(file_space_id, file_space_id + count);
+    w->plist_id_ = plist_id;
+    return w;
+  }
+
+  w->bufs_.resize(count);
+  w->buf_.resize(count);
+  w->plist_id_ = H5Pcopy(plist_id);
+  for (size_t i = 0; i < count; i++) {
+    H5VL_replicate_vol_t *d = (H5VL_replicate_vol_t *)dset[i];
+    std::vector<h5::SelSeq> seqs;
+    hid_t dset_space_id = H5I_INVALID_HID, mem_space = mem_space_id[i], file_space = file_space_id[i];
+    size_t type_size = H5Tget_size(mem_type_id[i]);
+    hsize_t npoints = 0;
+
+    /* Find the memory selection */
+    if (mem_space == H5S_ALL && file_space == H5S_ALL) {
+      H5VL_dataset_get_args_t args;
+      args.op_type = H5VL_DATASET_GET_SPACE;
+      if (H5VLdataset_get(d->next_vol_info_[0], d->next_vol_id_[0], &args, H5P_DATASET_XFER_DEFAULT, nullptr) < 0)
+        return nullptr;
+      dset_space_id = args.args.get_space.space_id;
+    }
+    h5::ResolveSpaces(dset_space_id, file_space, mem_space);
+    if (h5::GetSelectionSeqs(mem_space, seqs) < 0) {
+      if (dset_space_id >= 0)
+        H5Sclose(dset_space_id);
+      return nullptr;
+    }
+    if (dset_space_id >= 0)
+      H5Sclose(dset_space_id);
+
+    /* Pack it */
+    for (h5::SelSeq &seq : seqs)
+      npoints += seq.len_;
+    w->bufs_[i].resize(npoints * type_size);
+    npoints = 0;
+    for (h5::SelSeq &seq : seqs) {
+      memcpy(w->bufs_[i].data() + npoints * type_size, (const char *)buf[i] + seq.off_ * type_size,
+             seq.len_ * type_size);
+      npoints += seq.len_;
+    }
+    w->buf_[i] = w->bufs_[i].data();
+    w->mem_type_id_.push_back(H5Tcopy(mem_type_id[i]));
+    w->mem_space_id_.push_back(H5Screate_simple(1, &npoints, nullptr));
+    w->file_space_id_.push_back(file_space_id[i] == H5S_ALL ? H5S_ALL : H5Scopy(file_space_id[i]));
+  }
+  return w;
+} /* end H5VL_replicate_vol_write_new() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_replicate_vol_write_done
+ *
+ * Purpose:     Record that one replica finished a write, and wake any
+ *              thread waiting for it. The first replica to acknowledge
+ *              the newest write becomes the current one. Makes no HDF5
+ *              calls, so under VOLs may run it from their own threads.
+ *
+ *-------------------------------------------------------------------------
+ */
+static void
+H5VL_replicate_vol_write_done(H5VL_replicate_vol_state_t *state, H5VL_replicate_vol_write_t *w, size_t replica,
+                              herr_t status)
+{
+  std::unique_lock<std::mutex> lock(state->lock_);
+  H5VL_replicate_vol_status_t &health = state->status_[replica];
+
+  w->done_[replica] = true;
+  if (status < 0) {
+    ++w->failed_;
+    ++health.failed_;
+  } else {
+    ++w->acked_;
+    if (w->seq_ > state->current_seq_) {
+      state->current_ = replica;
+      state->current_seq_ = w->seq_;
+    }
+  }
+  health.healthy_ = status >= 0;
+  ++state->done_;
+  if (w->acked_ + w->failed_ == w->done_.size()) {
+    for (auto it = state->pending_.begin(); it != state->pending_.end(); ++it) {
+      if (it->get() == w) {
+        state->retired_.splice(state->retired_.end(), state->pending_, it);
+        break;
+      }
+    }
+  }
+  state->done_cv_.notify_all();
+} /* end H5VL_replicate_vol_write_done() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_replicate_vol_write_issue
+ *
+ * Purpose:     Hand one replica's share of a write to its under VOL. A
+ *              synchronous under VOL finishes it here. An asynchronous
+ *              one returns a request token: if it takes a completion
+ *              callback the under VOL owns it from then on, otherwise it
+ *              stays in w->req_ for H5VL_replicate_vol_write_poll.
+ *
+ *-------------------------------------------------------------------------
+ */
+static void
+H5VL_replicate_vol_write_issue(H5VL_replicate_vol_state_t *state, H5VL_replicate_vol_write_t *w, size_t replica)
+{
+  herr_t status;
+
+  w->req_[replica] = nullptr;
+  w->issued_[replica] = true;
+  status = H5VLdataset_write(w->count_, w->obj_[replica].data(), w->vol_id_[replica], w->mem_type_id_.data(),
+                             w->mem_space_id_.data(), w->file_space_id_.data(), w->plist_id_, w->buf_.data(),
+                             &w->req_[replica]);
+  if (status < 0 || w->req_[replica] == nullptr) {
+    H5VL_replicate_vol_write_done(state, w, replica, H5VL_replicate_vol_wait(w->req_[replica],
+                                                                            w->vol_id_[replica], status));
+    w->req_[replica] = nullptr;
+  } else if (H5VLrequest_notify(w->req_[replica], w->vol_id_[replica], H5VL_replicate_vol_write_notify,
+                                &w->ack_[replica]) >= 0) {
+    w->req_[replica] = nullptr;
+  }
+} /* end H5VL_replicate_vol_write_issue() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_replicate_vol_write_notify
+ *
+ * Purpose:     Completion callback of a replica's request token.
+ *
+ * Return:      0
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_replicate_vol_write_notify(void *ctx, H5VL_request_status_t status)
+{
+  H5VL_replicate_vol_ack_t *ack = (H5VL_replicate_vol_ack_t *)ctx;
+
+  H5VL_replicate_vol_write_done(ack->state_, ack->w_, ack->replica_, status == H5VL_REQUEST_STATUS_SUCCEED ? 0 : -1);
+  return 0;
+} /* end H5VL_replicate_vol_write_notify() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_replicate_vol_write_poll
+ *
+ * Purpose:     Wait up to \a timeout nanoseconds for one replica's share
+ *              of a write, recording it once it finished.
+ *
+ *-------------------------------------------------------------------------
+ */
+static void
+H5VL_replicate_vol_write_poll(H5VL_replicate_vol_state_t *state, H5VL_replicate_vol_write_t *w, size_t replica,
+                              uint64_t timeout)
+{
+  H5VL_request_status_t status = H5VL_REQUEST_STATUS_FAIL;
+  void *req = w->req_[replica];
+
+  if (req == nullptr)
+    return;
+  if (H5VLrequest_wait(req, w->vol_id_[replica], timeout, &status) >= 0 &&
+      status == H5VL_REQUEST_STATUS_IN_PROGRESS)
+    return;
+  H5VLrequest_free(req, w->vol_id_[replica]);
+  w->req_[replica] = nullptr;
+  H5VL_replicate_vol_write_done(state, w, replica, status == H5VL_REQUEST_STATUS_SUCCEED ? 0 : -1);
+} /* end H5VL_replicate_vol_write_poll() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_replicate_vol_write_finished
+ *
+ * Purpose:     Whether one replica finished a write. With \a wait, first
+ *              block until its completion callback ran.
+ *
+ *-------------------------------------------------------------------------
+ */
+static bool
+H5VL_replicate_vol_write_finished(H5VL_replicate_vol_state_t *state, H5VL_replicate_vol_write_t *w, size_t replica,
+                                  bool wait)
+{
+  std::unique_lock<std::mutex> lock(state->lock_);
+
+  if (wait)
+    state->done_cv_.wait(lock, [&]() { return (bool)w->done_[replica]; });
+  return w->done_[replica];
+} /* end H5VL_replicate_vol_write_finished() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_replicate_vol_strand
+ *
+ * Purpose:     Advance the write queue of one replica. Its under VOL only
+ *              ever has the oldest unfinished write, so writes land in
+ *              issue order even when they run asynchronously. Waits up to
+ *              \a timeout nanoseconds for each running write; with
+ *              H5ES_WAIT_FOREVER the queue is drained.
+ *
+ *-------------------------------------------------------------------------
+ */
+static void
+H5VL_replicate_vol_strand(H5VL_replicate_vol_state_t *state, size_t replica, uint64_t timeout)
+{
+  auto &queue = state->queue_[replica];
+
+  while (!queue.empty()) {
+    H5VL_replicate_vol_write_t *w = queue.front().get();
+    if (!w->issued_[replica])
+      H5VL_replicate_vol_write_issue(state, w, replica);
+    if (w->req_[replica])
+      H5VL_replicate_vol_write_poll(state, w, replica, timeout);
+    if (!H5VL_replicate_vol_write_finished(state, w, replica,
+                                           timeout == H5ES_WAIT_FOREVER && w->req_[replica] == nullptr))
+      return;
+    queue.pop_front();
+  }
+} /* end H5VL_replicate_vol_strand() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_replicate_vol_progress
+ *
+ * Purpose:     Advance the write queue of every replica.
+ *
+ *-------------------------------------------------------------------------
+ */
+static void
+H5VL_replicate_vol_progress(H5VL_replicate_vol_state_t *state, uint64_t timeout)
+{
+  for (size_t r = 0; r < state->queue_.size(); r++)
+    H5VL_replicate_vol_strand(state, r, timeout);
+} /* end H5VL_replicate_vol_progress() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_replicate_vol_wait
+ *
+ * Purpose:     Finish an under VOL call that returned \a status and,
+ *              if it went asynchronous, the request token \a req.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_replicate_vol_wait(void *req, hid_t vol_id, herr_t status)
+{
+  H5VL_request_status_t req_status = H5VL_REQUEST_STATUS_FAIL;
+
+  if (req == nullptr)
+    return status < 0 ? -1 : 0;
+  if (status >= 0)
+    H5VLrequest_wait(req, vol_id, H5ES_WAIT_FOREVER, &req_status);
+  H5VLrequest_free(req, vol_id);
+  return req_status == H5VL_REQUEST_STATUS_SUCCEED ? 0 : -1;
+} /* end H5VL_replicate_vol_wait() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_replicate_vol_reap
+ *
+ * Purpose:     Close the ids held by finished writes. Runs on the calling
+ *              thread so ids are never released by a worker.
+ *
+ *-------------------------------------------------------------------------
+ */
+static void
+H5VL_replicate_vol_reap(H5VL_replicate_vol_state_t *state)
+{
+  std::list<std::shared_ptr<H5VL_replicate_vol_write_t>> retired;
+  {
+    std::unique_lock<std::mutex> lock(state->lock_);
+    retired.swap(state->retired_);
+  }
+  for (auto &w : retired) {
+    if (!w->owned_)
+      continue;
+    for (size_t i = 0; i < w->count_; i++) {
+      H5Tclose(w->mem_type_id_[i]);
+      H5Sclose(w->mem_space_id_[i]);
+      if (w->file_space_id_[i] != H5S_ALL)
+        H5Sclose(w->file_space_id_[i]);
+    }
+    H5Pclose(w->plist_id_);
+  }
+} /* end H5VL_replicate_vol_reap() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_replicate_vol_drain
+ *
+ * Purpose:     Wait until every replica has finished every write issued
+ *              through the file of \a o.
+ *
+ *-------------------------------------------------------------------------
+ */
+static void
+H5VL_replicate_vol_drain(H5VL_replicate_vol_t *o)
+{
+  H5VL_replicate_vol_state_t *state = o->state_.get();
+
+  if (state == nullptr)
+    return;
+  H5VL_replicate_vol_progress(state, H5ES_WAIT_FOREVER);
+  H5VL_replicate_vol_reap(state);
+} /* end H5VL_replicate_vol_drain() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_replicate_vol_rank
+ *
+ * Purpose:     Order the replicas that can serve a read of \a bytes by
+ *              predicted time (latency + bytes / bandwidth). Unhealthy
+ *              replicas and replicas with writes still pending are left
+ *              out. Replicas without samples predict 0, so each gets
+ *              tried early.
+ *
+ *-------------------------------------------------------------------------
+ */
+static void
+H5VL_replicate_vol_rank(H5VL_replicate_vol_state_t *state, size_t bytes, std::vector<size_t> &order)
+{
+  std::vector<double> cost;
+  std::unique_lock<std::mutex> lock(state->lock_);
+
+  for (size_t r = 0; r < state->status_.size(); r++) {
+    H5VL_replicate_vol_status_t &health = state->status_[r];
+    bool stale = false;
+    for (auto &w : state->pending_)
+      stale = stale || !w->done_[r];
+    if (!health.healthy_ || stale)
+      continue;
+    order.push_back(r);
+    cost.push_back(health.read_latency_ + (health.read_bandwidth_ > 0 ? bytes / health.read_bandwidth_ : 0));
+  }
+  std::vector<size_t> idx(order.size());
+  for (size_t i = 0; i < idx.size(); i++)
+    idx[i] = i;
+  std::stable_sort(idx.begin(), idx.end(), [&](size_t a, size_t b) { return cost[a] < cost[b]; });
+  std::vector<size_t> sorted;
+  for (size_t i : idx)
+    sorted.push_back(order[i]);
+  order.swap(sorted);
+
+  /* With every replica behind, read from the one holding the newest
+   * acknowledged write once it caught up */
+  if (order.empty())
+    order.push_back(state->current_);
+} /* end H5VL_replicate_vol_rank() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_replicate_vol_observe
+ *
+ * Purpose:     Fold one completed read into the replica's averages.
+ *
+ *-------------------------------------------------------------------------
+ */
+static void
+H5VL_replicate_vol_observe(H5VL_replicate_vol_state_t *state, size_t replica, size_t bytes, double seconds)
+{
+  std::unique_lock<std::mutex> lock(state->lock_);
+  H5VL_replicate_vol_status_t &health = state->status_[replica];
+  const double alpha = H5VL_REPLICATE_VOL_EWMA_ALPHA;
+
+  if (bytes < H5VL_REPLICATE_VOL_SMALL_READ) {
+    health.read_latency_ = health.read_latency_ > 0 ? (1 - alpha) * health.read_latency_ + alpha * seconds
+                                                    : seconds;
+  } else if (seconds > 0) {
+    double bw = bytes / seconds;
+    health.read_bandwidth_ = health.read_bandwidth_ > 0 ? (1 - alpha) * health.read_bandwidth_ + alpha * bw : bw;
+  }
+} /* end H5VL_replicate_vol_observe() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_replicate_vol_split_read
+ *
+ * Purpose:     Read one dataset selection from several replicas at once.
+ *              The file selection is cut into slabs along its first
+ *              dimension, sized by each replica's bandwidth. Each slab is
+ *              read into a packed buffer; since hyperslab selections
+ *              iterate in row-major order, concatenating the slabs gives
+ *              the selection's element order, which is then scattered to
+ *              the memory selection. The slab reads are all issued from
+ *              this thread with request tokens, so replicas behind
+ *              asynchronous under VOLs serve them concurrently.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_replicate_vol_split_read(H5VL_replicate_vol_t *o, hid_t mem_type_id, hid_t mem_space_id, hid_t file_space_id,
+                              hid_t plist_id, void *buf, const std::vector<size_t> &order)
+{
+  H5VL_replicate_vol_state_t *state = o->state_.get();
+  size_t type_size = H5Tget_size(mem_type_id);
+  int rank = H5Sget_simple_extent_ndims(file_space_id);
+  std::vector<hsize_t> dims(rank), lo(rank), hi(rank), start(rank), count(rank);
+  std::vector<double> weight;
+  std::vector<hid_t> piece_space, piece_mem;
+  std::vector<std::vector<char>> piece_buf;
+  std::vector<herr_t> status;
+  std::vector<void *> reqs;
+  std::vector<std::chrono::steady_clock::time_point> t0;
+  std::vector<h5::SelSeq> seqs;
+  double total = 0;
+  hsize_t row, nrows;
+  herr_t ret_value = 0;
+
+  H5Sget_simple_extent_dims(file_space_id, dims.data(), nullptr);
+  if (H5Sget_select_bounds(file_space_id, lo.data(), hi.data()) < 0)
+    return -1;
+  nrows = hi[0] - lo[0] + 1;
+  for (size_t r : order)
+    H5VL_replicate_vol_strand(state, r, H5ES_WAIT_FOREVER);
+
+  /* Rows per replica, proportional to measured bandwidth */
+  {
+    std::unique_lock<std::mutex> lock(state->lock_);
+    for (size_t r : order) {
+      double bw = state->status_[r].read_bandwidth_;
+      weight.push_back(bw > 0 ? bw : 1);
+      total += weight.back();
+    }
+  }
+  row = lo[0];
+  for (size_t p = 0; p < order.size() && row <= hi[0]; p++) {
+    hsize_t rows = p + 1 == order.size() ? hi[0] + 1 - row
+                                         : std::max<hsize_t>(1, (hsize_t)(nrows * weight[p] / total));
+    rows = std::min<hsize_t>(rows, hi[0] + 1 - row);
+    hid_t space = H5Scopy(file_space_id);
+    hssize_t npoints;
+    for (int d = 0; d < rank; d++) {
+      start[d] = 0;
+      count[d] = dims[d];
+    }
+    start[0] = row;
+    count[0] = rows;
+    row += rows;
+    H5Sselect_hyperslab(space, H5S_SELECT_AND, start.data(), nullptr, count.data(), nullptr);
+    npoints = H5Sget_select_npoints(space);
+    hsize_t n = npoints > 0 ? (hsize_t)npoints : 0;
+    piece_space.push_back(space);
+    piece_mem.push_back(H5Screate_simple(1, &n, nullptr));
+    piece_buf.emplace_back(n * type_size);
+  }
+
+  /* Issue every slab, then collect them */
+  status.assign(piece_space.size(), 0);
+  reqs.assign(piece_space.size(), nullptr);
+  t0.resize(piece_space.size());
+  for (size_t p = 0; p < piece_space.size(); p++) {
+    void *obj = o->next_vol_info_[order[p]];
+    void *dst = piece_buf[p].data();
+    t0[p] = std::chrono::steady_clock::now();
+    status[p] = H5VLdataset_read(1, &obj, o->next_vol_id_[order[p]], &mem_type_id, &piece_mem[p], &piece_space[p],
+                                 plist_id, &dst, &reqs[p]);
+  }
+  for (size_t p = 0; p < piece_space.size(); p++) {
+    status[p] = H5VL_replicate_vol_wait(reqs[p], o->next_vol_id_[order[p]], status[p]);
+    if (status[p] >= 0)
+      H5VL_replicate_vol_observe(state, order[p], piece_buf[p].size(),
+                                 std::chrono::duration<double>(std::chrono::steady_clock::now() - t0[p]).count());
+  }
+
+  /* Retry failed slabs from the current replica */
+  for (size_t p = 0; p < piece_space.size(); p++) {
+    size_t current;
+    if (status[p] >= 0)
+      continue;
+    {
+      std::unique_lock<std::mutex> lock(state->lock_);
+      current = state->current_;
+    }
+    H5VL_replicate_vol_strand(state, current, H5ES_WAIT_FOREVER);
+    void *obj = o->next_vol_info_[current];
+    void *dst = piece_buf[p].data();
+    if (H5VLdataset_read(1, &obj, o->next_vol_id_[current], &mem_type_id, &piece_mem[p], &piece_space[p],
+                         plist_id, &dst, nullptr) < 0)
+      ret_value = -1;
+  }
+
+  /* Scatter the concatenated slabs to the memory selection */
+  if (ret_value >= 0 && h5::GetSelectionSeqs(mem_space_id, seqs) >= 0) {
+    size_t p = 0, off = 0;
+    for (h5::SelSeq &seq : seqs) {
+      size_t left = seq.len_ * type_size, dst = seq.off_ * type_size;
+      while (left) {
+        while (off == piece_buf[p].size()) {
+          ++p;
+          off = 0;
+        }
+        size_t len = std::min(left, piece_buf[p].size() - off);
+        memcpy((char *)buf + dst, piece_buf[p].data() + off, len);
+        off += len;
+        dst += len;
+        left -= len;
+      }
+    }
+  } else {
+    ret_value = -1;
+  }
+
+  for (size_t p = 0; p < piece_space.size(); p++) {
+    H5Sclose(piece_space[p]);
+    H5Sclose(piece_mem[p]);
+  }
+  return ret_value;
+} /* end H5VL_replicate_vol_split_read() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_replicate_vol_ec_new
+ *
+ * Purpose:     Describe a new erasure-coded dataset.
+ *
+ * Return:      Success:    The layout
+ *              Failure:    nullptr
+ *
+ *-------------------------------------------------------------------------
+ */
+static H5VL_replicate_vol_ec_t *
+H5VL_replicate_vol_ec_new(const H5VL_replicate_vol_t *o, hid_t type_id, hid_t space_id, hid_t dcpl_id)
+{
+  H5VL_replicate_vol_ec_t *ec = new H5VL_replicate_vol_ec_t();
+  size_t stripe_elmts, type_size = 0, space_size = 0, dcpl_size = 0, meta_size;
+  hssize_t nelmts = H5Sget_simple_extent_npoints(space_id);
+
+  ec->type_id_ = H5Tcopy(type_id);
+  ec->space_id_ = H5Scopy(space_id);
+  ec->dcpl_id_ = H5Pcopy(dcpl_id);
+  ec->type_size_ = H5Tget_size(type_id);
+  if (ec->type_id_ < 0 || ec->space_id_ < 0 || ec->dcpl_id_ < 0 || ec->type_size_ == 0 || nelmts < 0) {
+    H5VL_replicate_vol_ec_free(ec);
+    return nullptr;
+  }
+  ec->nelmts_ = (hsize_t)nelmts;
+  ec->unit_elmts_ = std::max<size_t>(1, o->ec_unit_ / ec->type_size_);
+  stripe_elmts = ec->unit_elmts_ * o->ec_data_;
+
+  /* Shard units follow the header and the encoded metadata */
+  H5Tencode(ec->type_id_, nullptr, &type_size);
+  H5Sencode2(ec->space_id_, nullptr, &space_size, H5P_DEFAULT);
+  H5Pencode2(ec->dcpl_id_, nullptr, &dcpl_size, H5P_DEFAULT);
+  meta_size = sizeof(H5VL_replicate_vol_ec_header_t) + type_size + space_size + dcpl_size;
+  ec->data_off_ = (meta_size + H5VL_REPLICATE_VOL_EC_ALIGN - 1) / H5VL_REPLICATE_VOL_EC_ALIGN *
+                  H5VL_REPLICATE_VOL_EC_ALIGN;
+  ec->extent_ = ec->data_off_ +
+                ((ec->nelmts_ + stripe_elmts - 1) / stripe_elmts) * ec->unit_elmts_ * ec->type_size_;
+  return ec;
+} /* end H5VL_replicate_vol_ec_new() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_replicate_vol_ec_free
+ *
+ * Purpose:     Release an erasure-coded dataset layout.
+ *
+ *-------------------------------------------------------------------------
+ */
+static void
+H5VL_replicate_vol_ec_free(H5VL_replicate_vol_ec_t *ec)
+{
+  if (ec == nullptr)
+    return;
+  if (ec->type_id_ >= 0)
+    H5Tclose(ec->type_id_);
+  if (ec->space_id_ >= 0)
+    H5Sclose(ec->space_id_);
+  if (ec->dcpl_id_ >= 0)
+    H5Pclose(ec->dcpl_id_);
+  delete ec;
+} /* end H5VL_replicate_vol_ec_free() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_replicate_vol_ec_under_io
+ *
+ * Purpose:     Read or write a byte range of the under dataset holding
+ *              one shard. With \a req, the under VOL may hand back a
+ *              request token instead of finishing; the two dataspaces
+ *              used are then returned in \a spaces for the caller to
+ *              close once the request is done.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_replicate_vol_ec_under_io(H5VL_replicate_vol_t *o, size_t shard, uint64_t off, size_t size, void *buf,
+                               bool write, hid_t *spaces, void **req)
+{
+  hsize_t extent = o->ec_->extent_, start = off, count = size;
+  hid_t type_id = H5T_NATIVE_UINT8;
+  hid_t file_space_id, mem_space_id;
+  void *under = o->next_vol_info_[shard];
+  herr_t ret_value;
+
+  if (size == 0)
+    return 0;
+  file_space_id = H5Screate_simple(1, &extent, nullptr);
+  mem_space_id = H5Screate_simple(1, &count, nullptr);
+  H5Sselect_hyperslab(file_space_id, H5S_SELECT_SET, &start, nullptr, &count, nullptr);
+  if (write)
+    ret_value = H5VLdataset_write(1, &under, o->next_vol_id_[shard], &type_id, &mem_space_id, &file_space_id,
+                                  H5P_DATASET_XFER_DEFAULT, (const void **)&buf, req);
+  else
+    ret_value = H5VLdataset_read(1, &under, o->next_vol_id_[shard], &type_id, &mem_space_id, &file_space_id,
+                                 H5P_DATASET_XFER_DEFAULT, &buf, req);
+  if (spaces) {
+    spaces[0] = file_space_id;
+    spaces[1] = mem_space_id;
+  } else {
+    H5Sclose(file_space_id);
+    H5Sclose(mem_space_id);
+  }
+  return ret_value;
+} /* end H5VL_replicate_vol_ec_under_io() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_replicate_vol_ec_header_write
+ *
+ * Purpose:     Encode the dataset metadata and store it, with a header
+ *              naming the shard, at the start of every under dataset.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_replicate_vol_ec_header_write(H5VL_replicate_vol_t *o)
+{
+  H5VL_replicate_vol_ec_t *ec = o->ec_;
+  H5VL_replicate_vol_ec_header_t header;
+  std::vector<char> rec(sizeof(header));
+  size_t type_size = 0, space_size = 0, dcpl_size = 0;
+
+  H5Tencode(ec->type_id_, nullptr, &type_size);
+  H5Sencode2(ec->space_id_, nullptr, &space_size, H5P_DEFAULT);
+  H5Pencode2(ec->dcpl_id_, nullptr, &dcpl_size, H5P_DEFAULT);
+  rec.resize(sizeof(header) + type_size + space_size + dcpl_size);
+  if (rec.size() > ec->data_off_ || H5Tencode(ec->type_id_, rec.data() + sizeof(header), &type_size) < 0 ||
+      H5Sencode2(ec->space_id_, rec.data() + sizeof(header) + type_size, &space_size, H5P_DEFAULT) < 0 ||
+      H5Pencode2(ec->dcpl_id_, rec.data() + sizeof(header) + type_size + space_size, &dcpl_size,
+                 H5P_DEFAULT) < 0)
+    return -1;
+
+  header.magic_ = H5VL_REPLICATE_VOL_EC_MAGIC;
+  header.version_ = H5VL_REPLICATE_VOL_EC_VERSION;
+  header.data_ = (uint32_t)o->ec_data_;
+  header.parity_ = (uint32_t)o->ec_parity_;
+  header.type_size_ = (uint32_t)type_size;
+  header.space_size_ = (uint32_t)space_size;
+  header.dcpl_size_ = (uint32_t)dcpl_size;
+  header.unit_elmts_ = ec->unit_elmts_;
+  header.data_off_ = ec->data_off_;
+  for (size_t r = 0; r < o->next_vol_id_.size(); r++) {
+    header.shard_ = (uint32_t)r;
+    memcpy(rec.data(), &header, sizeof(header));
+    if (H5VL_replicate_vol_ec_under_io(o, r, 0, rec.size(), rec.data(), true, nullptr, nullptr) < 0)
+      return -1;
+  }
+  return 0;
+} /* end H5VL_replicate_vol_ec_header_write() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_replicate_vol_ec_load
+ *
+ * Purpose:     Load the layout of an opened erasure-coded dataset from
+ *              the first under dataset with a readable header.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_replicate_vol_ec_load(H5VL_replicate_vol_t *o)
+{
+  H5VL_replicate_vol_ec_t *ec = o->ec_;
+
+  for (size_t r = 0; r < o->next_vol_id_.size(); r++) {
+    H5VL_dataset_get_args_t args;
+    H5VL_replicate_vol_ec_header_t header;
+    std::vector<char> rec;
+    hsize_t extent;
+
+    args.op_type = H5VL_DATASET_GET_SPACE;
+    if (H5VLdataset_get(o->next_vol_info_[r], o->next_vol_id_[r], &args, H5P_DATASET_XFER_DEFAULT, nullptr) < 0)
+      continue;
+    H5Sget_simple_extent_dims(args.args.get_space.space_id, &extent, nullptr);
+    H5Sclose(args.args.get_space.space_id);
+    if (extent < sizeof(header))
+      continue;
+    ec->extent_ = extent;
+    if (H5VL_replicate_vol_ec_under_io(o, r, 0, sizeof(header), &header, false, nullptr, nullptr) < 0)
+      continue;
+    if (header.magic_ != H5VL_REPLICATE_VOL_EC_MAGIC || header.version_ != H5VL_REPLICATE_VOL_EC_VERSION ||
+        header.shard_ != r || header.unit_elmts_ == 0)
+      continue;
+    if (header.data_ != o->ec_data_ || header.parity_ != o->ec_parity_)
+      return -1;
+    rec.resize((size_t)header.type_size_ + header.space_size_ + header.dcpl_size_);
+    if (sizeof(header) + rec.size() > header.data_off_ ||
+        H5VL_replicate_vol_ec_under_io(o, r, sizeof(header), rec.size(), rec.data(), false, nullptr, nullptr) < 0)
+      continue;
+    ec->type_id_ = H5Tdecode(rec.data());
+    ec->space_id_ = H5Sdecode(rec.data() + header.type_size_);
+    ec->dcpl_id_ = H5Pdecode(rec.data() + header.type_size_ + header.space_size_);
+    if (ec->type_id_ < 0 || ec->space_id_ < 0 || ec->dcpl_id_ < 0)
+      return -1;
+    ec->type_size_ = H5Tget_size(ec->type_id_);
+    ec->nelmts_ = (hsize_t)H5Sget_simple_extent_npoints(ec->space_id_);
+    ec->unit_elmts_ = header.unit_elmts_;
+    ec->data_off_ = header.data_off_;
+    return 0;
+  }
+  return -1;
+} /* end H5VL_replicate_vol_ec_load() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_replicate_vol_ec_slices
+ *
+ * Purpose:     Run fn(off, len) over byte range [0, n) cut into slices,
+ *              the first on this thread and the rest on the worker pool,
+ *              and return once all are done. fn must only touch memory.
+ *
+ *-------------------------------------------------------------------------
+ */
+static void
+H5VL_replicate_vol_ec_slices(size_t n, const std::function<void(size_t, size_t)> &fn)
+{
+  h5::ThreadPool *pool = H5VL_replicate_vol_pool_g;
+  size_t nslices = pool ? std::min(pool->Size() + 1, n / H5VL_REPLICATE_VOL_EC_SLICE) : 1;
+  size_t slice;
+  std::vector<std::future<void>> done;
+
+  if (nslices <= 1) {
+    fn(0, n);
+    return;
+  }
+  slice = (n + nslices - 1) / nslices;
+  for (size_t off = slice; off < n; off += slice)
+    done.emplace_back(pool->Submit([&fn, off, slice, n]() { fn(off, std::min(slice, n - off)); }));
+  fn(0, slice);
+  for (std::future<void> &fut : done)
+    fut.wait();
+} /* end H5VL_replicate_vol_ec_slices() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_replicate_vol_ec_io
+ *
+ * Purpose:     Read or write stripes [s0, s0 + n) of the listed shards,
+ *              one under VOL call per shard. All calls are issued from
+ *              this thread with request tokens before any is waited on,
+ *              so shards behind asynchronous under VOLs move
+ *              concurrently. bufs[r] holds the n units of shard r back
+ *              to back. Failures mark the replica unhealthy; successful
+ *              reads feed its averages.
+ *
+ *-------------------------------------------------------------------------
+ */
+static void
+H5VL_replicate_vol_ec_io(H5VL_replicate_vol_t *o, const std::vector<size_t> &shards, size_t s0, size_t n,
+                         std::vector<std::vector<char>> &bufs, bool write, std::vector<herr_t> &status)
+{
+  H5VL_replicate_vol_state_t *state = o->state_.get();
+  size_t unit = o->ec_->unit_elmts_ * o->ec_->type_size_;
+  uint64_t off = o->ec_->data_off_ + (uint64_t)s0 * unit;
+  std::vector<void *> reqs(shards.size(), nullptr);
+  std::vector<hid_t> spaces(2 * shards.size(), H5I_INVALID_HID);
+  auto t0 = std::chrono::steady_clock::now();
+
+  for (size_t i = 0; i < shards.size(); i++)
+    status[shards[i]] = H5VL_replicate_vol_ec_under_io(o, shards[i], off, n * unit, bufs[shards[i]].data(), write,
+                                                       &spaces[2 * i], &reqs[i]);
+  for (size_t i = 0; i < shards.size(); i++) {
+    size_t r = shards[i];
+    status[r] = H5VL_replicate_vol_wait(reqs[i], o->next_vol_id_[r], status[r]);
+    if (status[r] >= 0 && !write)
+      H5VL_replicate_vol_observe(state, r, n * unit,
+                                 std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+  }
+  for (hid_t space_id : spaces) {
+    if (space_id >= 0)
+      H5Sclose(space_id);
+  }
+
+  std::unique_lock<std::mutex> lock(state->lock_);
+  for (size_t r : shards) {
+    H5VL_replicate_vol_status_t &health = state->status_[r];
+    if (status[r] < 0) {
+      health.healthy_ = false;
+      if (write)
+        ++health.failed_;
+    } else if (write) {
+      health.healthy_ = true;
+    }
+  }
+} /* end H5VL_replicate_vol_ec_io() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_replicate_vol_ec_read_stripes
+ *
+ * Purpose:     Fill the data shards flagged in \a need for stripes
+ *              [s0, s0 + n). They are read directly from healthy under
+ *              VOLs; if any is unavailable, enough other shards are read
+ *              to have k in total and the missing ones are rebuilt.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1 (fewer than k shards readable)
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_replicate_vol_ec_read_stripes(H5VL_replicate_vol_t *o, size_t s0, size_t n, const std::vector<bool> &need,
+                                   std::vector<std::vector<char>> &bufs)
+{
+  H5VL_replicate_vol_state_t *state = o->state_.get();
+  size_t k = o->ec_data_, nshards = o->next_vol_id_.size();
+  size_t len = n * o->ec_->unit_elmts_ * o->ec_->type_size_;
+  std::vector<herr_t> status(nshards, -1);
+  std::vector<bool> tried(nshards, false), healthy(nshards);
+  std::vector<size_t> batch;
+  size_t have = 0;
+  bool missing = false;
+
+  {
+    std::unique_lock<std::mutex> lock(state->lock_);
+    for (size_t r = 0; r < nshards; r++)
+      healthy[r] = state->status_[r].healthy_;
+  }
+
+  /* Needed data shards from healthy under VOLs */
+  for (size_t j = 0; j < k; j++) {
+    if (!need[j])
+      continue;
+    if (healthy[j]) {
+      batch.push_back(j);
+      tried[j] = true;
+    } else {
+      missing = true;
+    }
+  }
+  H5VL_replicate_vol_ec_io(o, batch, s0, n, bufs, false, status);
+  for (size_t r : batch) {
+    if (status[r] >= 0)
+      ++have;
+    else
+      missing = true;
+  }
+  if (!missing)
+    return 0;
+
+  /* Degraded: top up to k shards, healthy ones first */
+  while (have < k) {
+    batch.clear();
+    for (int pass = 0; pass < 2 && have + batch.size() < k; pass++) {
+      for (size_t r = 0; r < nshards && have + batch.size() < k; r++) {
+        if (tried[r] || healthy[r] != (pass == 0))
+          continue;
+        batch.push_back(r);
+        tried[r] = true;
+      }
+    }
+    if (batch.empty())
+      return -1;
+    H5VL_replicate_vol_ec_io(o, batch, s0, n, bufs, false, status);
+    for (size_t r : batch) {
+      if (status[r] >= 0)
+        ++have;
+    }
+  }
+
+  /* Rebuild the missing data shards, a slice of the stripes per worker */
+  h5::ReedSolomon rs(k, o->ec_parity_);
+  std::atomic<bool> decoded(true);
+  H5VL_replicate_vol_ec_slices(len, [&](size_t off, size_t size) {
+    std::vector<const uint8_t *> shards(nshards, nullptr), out;
+    std::vector<std::vector<uint8_t>> scratch;
+    for (size_t r = 0; r < nshards; r++) {
+      if (status[r] >= 0)
+        shards[r] = (const uint8_t *)bufs[r].data() + off;
+    }
+    if (!rs.Decode(shards, size, out, scratch)) {
+      decoded = false;
+      return;
+    }
+    for (size_t j = 0; j < k; j++) {
+      if (status[j] < 0)
+        memcpy(bufs[j].data() + off, out[j], size);
+    }
+  });
+  return decoded ? 0 : -1;
+} /* end H5VL_replicate_vol_ec_read_stripes() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_replicate_vol_ec_read
+ *
+ * Purpose:     Read a selection of an erasure-coded dataset, a batch of
+ *              consecutive stripes at a time, reading only the data
+ *              shards the selection touches unless one must be rebuilt.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_replicate_vol_ec_read(H5VL_replicate_vol_t *o, hid_t mem_type_id, hid_t mem_space_id, hid_t file_space_id,
+                           void *buf)
+{
+  H5VL_replicate_vol_ec_t *ec = o->ec_;
+  size_t k = o->ec_data_, type_size = ec->type_size_, unit_elmts = ec->unit_elmts_;
+  size_t unit = unit_elmts * type_size;
+  size_t max_stripes = std::max<size_t>(1, H5VL_REPLICATE_VOL_EC_BATCH / (k * unit));
+  bool convert = H5Tequal(mem_type_id, ec->type_id_) <= 0;
+  std::vector<h5::SelPair> pairs, staged;
+  std::map<size_t, std::vector<h5::SelPair>> units;
+  std::vector<std::vector<char>> bufs(o->next_vol_id_.size());
+  std::vector<char> packed;
+  char *dst = (char *)buf;
+  hsize_t npoints = 0;
+
+  h5::ResolveSpaces(ec->space_id_, file_space_id, mem_space_id);
+  if (h5::PairSelections(file_space_id, mem_space_id, pairs) < 0)
+    return -1;
+
+  /* A conversion needs the selection staged densely in the file datatype */
+  if (convert) {
+    staged = pairs;
+    for (h5::SelPair &pair : staged) {
+      pair.mem_off_ = npoints;
+      npoints += pair.len_;
+    }
+    packed.resize(npoints * std::max(type_size, H5Tget_size(mem_type_id)));
+    dst = packed.data();
+  }
+  h5::SplitByChunk(convert ? staged : pairs, unit_elmts, units);
+
+  auto it = units.begin();
+  while (it != units.end()) {
+    size_t s0 = it->first / k, n;
+    std::vector<bool> need(k, false);
+    auto end = it;
+    for (; end != units.end() && end->first / k < s0 + max_stripes; ++end)
+      need[end->first % k] = true;
+    n = (std::prev(end)->first / k) - s0 + 1;
+    for (size_t j = 0; j < bufs.size(); j++)
+      bufs[j].resize(n * unit);
+    if (H5VL_replicate_vol_ec_read_stripes(o, s0, n, need, bufs) < 0)
+      return -1;
+    for (; it != end; ++it) {
+      size_t u = it->first, s = u / k, j = u % k;
+      for (const h5::SelPair &piece : it->second)
+        memcpy(dst + piece.mem_off_ * type_size,
+               bufs[j].data() + ((s - s0) * unit_elmts + (piece.file_off_ - u * unit_elmts)) * type_size,
+               piece.len_ * type_size);
+    }
+  }
+
+  if (convert) {
+    if (H5Tconvert(ec->type_id_, mem_type_id, npoints, packed.data(), nullptr, H5P_DEFAULT) < 0)
+      return -1;
+    h5::UnpackPairs(packed.data(), pairs, H5Tget_size(mem_type_id), buf);
+  }
+  return 0;
+} /* end H5VL_replicate_vol_ec_read() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_replicate_vol_ec_write
+ *
+ * Purpose:     Write a selection of an erasure-coded dataset. Each batch
+ *              of consecutive stripes is assembled (reading the old data
+ *              only when a stripe is partially overwritten), its parity
+ *              is computed, and all k + m shards are written. The write
+ *              fails unless every shard landed.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_replicate_vol_ec_write(H5VL_replicate_vol_t *o, hid_t mem_type_id, hid_t mem_space_id,
+                            hid_t file_space_id, const void *buf)
+{
+  H5VL_replicate_vol_ec_t *ec = o->ec_;
+  size_t k = o->ec_data_, m = o->ec_parity_, type_size = ec->type_size_, unit_elmts = ec->unit_elmts_;
+  size_t unit = unit_elmts * type_size, stripe_elmts = k * unit_elmts;
+  size_t max_stripes = std::max<size_t>(1, H5VL_REPLICATE_VOL_EC_BATCH / (k * unit));
+  h5::ReedSolomon rs(k, m);
+  std::vector<h5::SelPair> pairs;
+  std::map<size_t, std::vector<h5::SelPair>> units;
+  std::vector<std::vector<char>> bufs(k + m);
+  std::vector<size_t> all(k + m);
+  std::vector<herr_t> status(k + m);
+  std::vector<char> packed;
+  const char *src = (const char *)buf;
+
+  h5::ResolveSpaces(ec->space_id_, file_space_id, mem_space_id);
+  if (h5::PairSelections(file_space_id, mem_space_id, pairs) < 0)
+    return -1;
+
+  /* Convert to the file datatype if needed */
+  if (H5Tequal(mem_type_id, ec->type_id_) <= 0) {
+    size_t mem_type_size = H5Tget_size(mem_type_id);
+    hsize_t npoints = 0;
+    for (h5::SelPair &pair : pairs)
+      npoints += pair.len_;
+    packed.resize(npoints * std::max(type_size, mem_type_size));
+    h5::PackPairs(buf, pairs, mem_type_size, packed.data());
+    if (H5Tconvert(mem_type_id, ec->type_id_, npoints, packed.data(), nullptr, H5P_DEFAULT) < 0)
+      return -1;
+    src = packed.data();
+  }
+  h5::SplitByChunk(pairs, unit_elmts, units);
+  for (size_t r = 0; r < k + m; r++)
+    all[r] = r;
+
+  auto it = units.begin();
+  while (it != units.end()) {
+    size_t s0 = it->first / k, n;
+    std::map<size_t, hsize_t> selected;
+    bool partial = false;
+    auto end = it;
+    for (; end != units.end() && end->first / k < s0 + max_stripes; ++end) {
+      for (const h5::SelPair &piece : end->second)
+        selected[end->first / k] += piece.len_;
+    }
+    n = (std::prev(end)->first / k) - s0 + 1;
+    for (size_t s = s0; s < s0 + n && !partial; s++) {
+      hsize_t valid = std::min<hsize_t>(stripe_elmts, ec->nelmts_ - (hsize_t)s * stripe_elmts);
+      partial = selected[s] != valid;
+    }
+
+    /* Old contents of partially written stripes */
+    for (size_t r = 0; r < k + m; r++)
+      bufs[r].assign(n * unit, 0);
+    if (partial && H5VL_replicate_vol_ec_read_stripes(o, s0, n, std::vector<bool>(k, true), bufs) < 0)
+      return -1;
+
+    /* New data, then parity */
+    for (; it != end; ++it) {
+      size_t u = it->first, s = u / k, j = u % k;
+      for (const h5::SelPair &piece : it->second)
+        memcpy(bufs[j].data() + ((s - s0) * unit_elmts + (piece.file_off_ - u * unit_elmts)) * type_size,
+               src + piece.mem_off_ * type_size, piece.len_ * type_size);
+    }
+    H5VL_replicate_vol_ec_slices(n * unit, [&](size_t off, size_t size) {
+      std::vector<const uint8_t *> data(k);
+      std::vector<uint8_t *> parity(m);
+      for (size_t j = 0; j < k; j++)
+        data[j] = (const uint8_t *)bufs[j].data() + off;
+      for (size_t p = 0; p < m; p++)
+        parity[p] = (uint8_t *)bufs[k + p].data() + off;
+      rs.Encode(data.data(), parity.data(), size);
+    });
+
+    H5VL_replicate_vol_ec_io(o, all, s0, n, bufs, true, status);
+    for (herr_t ret : status) {
+      if (ret < 0)
+        return -1;
+    }
+  }
+  return 0;
+} /* end H5VL_replicate_vol_ec_write() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_replicate_vol_get_status
+ *
+ * Purpose:     Report the health of each replica behind a file or object
+ *              opened through this connector. On input *nreplicas is the
+ *              capacity of \a status; on output, the number of replicas.
+ *              The request travels to the connector as an optional
+ *              operation on the object's file, so it reaches this
+ *              connector's object whatever sits above it in the stack.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1 (not a replicate_vol file, or the
+ *                          connector was never loaded)
+ *
+ *-------------------------------------------------------------------------
+ */
+herr_t
+H5VL_replicate_vol_get_status(hid_t obj_id, size_t *nreplicas, H5VL_replicate_vol_status_t *status)
+{
+  H5VL_replicate_vol_get_status_args_t status_args = {nreplicas, status};
+  H5VL_optional_args_t args;
+  hid_t file_id;
+  herr_t ret_value;
+
+  if (H5VLfind_opt_operation(H5VL_SUBCLS_FILE, H5VL_REPLICATE_VOL_GET_STATUS_OP, &args.op_type) < 0)
+    return -1;
+  args.args = &status_args;
+  if ((file_id = H5Iget_file_id(obj_id)) < 0)
+    return -1;
+  ret_value = H5VLfile_optional_op(file_id, &args, H5P_DATASET_XFER_DEFAULT, H5ES_NONE);
+  H5Fclose(file_id);
+  return ret_value;
+} /* end H5VL_replicate_vol_get_status() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5VL_replicate_vol_status
+ *
+ * Purpose:     Fill in the get_status operation for the file \a o.
+ *
+ * Return:      Success:    0
+ *              Failure:    -1
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+H5VL_replicate_vol_status(H5VL_replicate_vol_t *o, size_t *nreplicas, H5VL_replicate_vol_status_t *status)
+{
+  H5VL_replicate_vol_state_t *state;
+  auto now = std::chrono::steady_clock::now();
+
+  if (o->state_ == nullptr)
+    return -1;
+  state = o->state_.get();
+  std::unique_lock<std::mutex> lock(state->lock_);
+  for (size_t r = 0; r < state->status_.size() && r < *nreplicas; r++) {
+    status[r] = state->status_[r];
+    status[r].pending_ = 0;
+    status[r].lag_ = 0;
+    for (auto &w : state->pending_) {
+      if (w->done_[r])
+        continue;
+      ++status[r].pending_;
+      status[r].lag_ = std::max(status[r].lag_, std::chrono::duration<double>(now - w->start_).count());
+    }
+  }
+  *nreplicas = state->status_.size();
+  return 0;
+} /* end H5VL_replicate_vol_status() */
+
 /*-------------------------------------------------------------------------
  * Function:    H5VL_replicate_vol_register
  *
@@ -405,6 +1817,11 @@ H5VL_replicate_vol_init(hid_t vipl_id)
   /* Shut compiler up about unused parameter */
   (void)vipl_id;
 
+  /* Operation behind H5VL_replicate_vol_get_status */
+  if (H5VLregister_opt_operation(H5VL_SUBCLS_FILE, H5VL_REPLICATE_VOL_GET_STATUS_OP,
+                                 &H5VL_replicate_vol_get_status_op_g) < 0)
+    return -1;
+
   return 0;
 } /* end H5VL_replicate_vol_init() */
 
@@ -431,6 +1848,12 @@ H5VL_replicate_vol_term(void)
   /* Reset VOL ID */
   H5VL_REPLICATE_VOL_g = H5I_INVALID_HID;
 
+  H5VLunregister_opt_operation(H5VL_SUBCLS_FILE, H5VL_REPLICATE_VOL_GET_STATUS_OP);
+  H5VL_replicate_vol_get_status_op_g = -1;
+
+  delete H5VL_replicate_vol_pool_g;
+  H5VL_replicate_vol_pool_g = nullptr;
+
   return 0;
 } /* end H5VL_replicate_vol_term() */
 
@@ -506,6 +1929,12 @@ H5VL_replicate_vol_to_str(const void *_info, char **str)
  * Function:    H5VL_replicate_vol_str_to_info
  *
  * Purpose:     Deserialize a string into an info object for this connector.
+ *              Replicas only write concurrently, and a quorum below the
+ *              replica count only returns early, when the under VOLs
+ *              run writes asynchronously (advertise H5VL_CAP_FLAG_ASYNC,
+ *              e.g., the async VOL). Synchronous under VOLs such as
+ *              native finish each write inside the call, so replicas
+ *              are written one after another; a warning says so once.
  *
  * Return:      Success:    0
  *              Failure:    -1
@@ -515,14 +1944,70 @@ H5VL_replicate_vol_to_str(const void *_info, char **str)
 static herr_t
 H5VL_replicate_vol_str_to_info(const char *str, void **_info)
 {
-  H5VL_replicate_vol_t *info = (H5VL_replicate_vol_t*)calloc(sizeof(H5VL_replicate_vol_t), 1);
+  H5VL_replicate_vol_t *info = new H5VL_replicate_vol_t();
+  std::string params;
+  std::vector<std::string> targets;
+
+  /* One under-VOL stack per replica: "params;stack0|stack1|..." */
+  h5::ParseConn::SplitTargets(str, params, targets);
+  for (std::string &target : targets) {
+    h5::ParseConn parser;
+    void *next_vol_info = nullptr;
+    parser.parse(";" + target);
+    std::string next_vol_name = parser.GetNextVolName();
+    std::string next_vol_params = parser.GetNextVolParams();
+    hid_t next_vol_id = H5VLregister_connector_by_name(next_vol_name.c_str(), H5P_DEFAULT);
+    if (next_vol_id < 0) {
+      delete info;
+      return -1;
+    }
+    if (next_vol_params.size()) {
+      H5VLconnector_str_to_info(next_vol_params.c_str(), next_vol_id, &next_vol_info);
+    }
+    info->next_vol_id_.push_back(next_vol_id);
+    info->next_vol_info_.push_back(next_vol_info);
+  }
+  if (info->next_vol_id_.empty()) {
+    delete info;
+    return -1;
+  }
+
+  /* By default one coding worker per shard beyond the first, which this thread codes */
   h5::ParseConn parser;
-  parser.parse(str);
-  std::string next_vol_name = parser.GetNextVolName();
-  std::string next_vol_params = parser.GetNextVolParams();
-  info->next_vol_id_[0] = H5VLregister_connector_by_name(next_vol_name.c_str(), H5P_DEFAULT);
-  if (next_vol_params.size()) {
-    H5VLconnector_str_to_info(next_vol_params.c_str(), info->next_vol_id_[0], (void **) &info->next_vol_info_[0]);
+  parser.parse(params);
+  info->nthreads_ = h5::ParseSize(parser.GetParam("threads", std::to_string(info->next_vol_id_.size() - 1)));
+  info->quorum_ = h5::ParseSize(parser.GetParam("quorum", std::to_string(info->next_vol_id_.size())));
+  info->split_size_ = h5::ParseSize(parser.GetParam("read_split", "8m"));
+  if (info->quorum_ == 0 || info->quorum_ > info->next_vol_id_.size()) {
+    delete info;
+    return -1;
+  }
+
+  /* Erasure coding: ec_data data + ec_parity parity shards, one per under VOL */
+  info->ec_data_ = h5::ParseSize(parser.GetParam("ec_data", "0"));
+  info->ec_parity_ = h5::ParseSize(parser.GetParam("ec_parity", "0"));
+  info->ec_unit_ = h5::ParseSize(parser.GetParam("ec_unit", "64k"));
+  info->ec_ = nullptr;
+  if (info->ec_data_ > 0 && (info->ec_parity_ == 0 || info->ec_unit_ == 0 || info->next_vol_id_.size() > 256 ||
+                             info->ec_data_ + info->ec_parity_ != info->next_vol_id_.size())) {
+    delete info;
+    return -1;
+  }
+  /* Replicas only overlap behind asynchronous under VOLs */
+  if (info->next_vol_id_.size() > 1 && info->ec_data_ == 0) {
+    static bool warned = false;
+    uint64_t async = H5VL_CAP_FLAG_ASYNC;
+    for (size_t r = 0; r < info->next_vol_id_.size(); r++) {
+      uint64_t cap_flags = 0;
+      H5VLintrospect_get_cap_flags(info->next_vol_info_[r], info->next_vol_id_[r], &cap_flags);
+      async &= cap_flags;
+    }
+    if (!async && !warned) {
+      warned = true;
+      fprintf(stderr, "replicate_vol: an under VOL is synchronous, so the %zu replicas are written one after "
+                      "another%s\n", info->next_vol_id_.size(),
+              info->quorum_ < info->next_vol_id_.size() ? " and quorum writes wait for all of them" : "");
+    }
   }
 
   /* Set return value */
@@ -768,15 +2253,40 @@ H5VL_replicate_vol_dataset_create(void *obj, const H5VL_loc_params_t *loc_params
                                   hid_t dxpl_id, void **req)
 {
   H5VL_replicate_vol_t *o = (H5VL_replicate_vol_t *)obj;
-  H5VL_replicate_vol_t *new_obj = new H5VL_replicate_vol_t(*o);
-  if (o->next_vol_info_[0] != nullptr) {
-    new_obj->next_vol_info_[0] = H5VLdataset_create(o->next_vol_info_[0], loc_params,
-                                                    o->next_vol_id_[0], name, lcpl_id, type_id, space_id,
-                                                    dcpl_id, dapl_id, dxpl_id, req);
-  } else {
-    new_obj->next_vol_info_[0] = H5VLdataset_create((void*)32, loc_params,
-                                                    o->next_vol_id_[0], name, lcpl_id, type_id, space_id,
-                                                    dcpl_id, dapl_id, dxpl_id, req);
+  H5VL_replicate_vol_t *new_obj = H5VL_replicate_vol_new_obj(o);
+  hid_t under_type_id = type_id, under_space_id = space_id, under_dcpl_id = dcpl_id;
+  size_t i;
+
+  /* Erasure-coded datasets store one byte stream of shards per under VOL */
+  if (o->ec_data_ > 0) {
+    new_obj->ec_ = H5VL_replicate_vol_ec_new(o, type_id, space_id, dcpl_id);
+    if (new_obj->ec_ == nullptr) {
+      delete new_obj;
+      return nullptr;
+    }
+    hsize_t extent = new_obj->ec_->extent_;
+    under_type_id = H5T_NATIVE_UINT8;
+    under_space_id = H5Screate_simple(1, &extent, nullptr);
+    under_dcpl_id = H5P_DATASET_CREATE_DEFAULT;
+  }
+
+  /* Only replica 0 may complete asynchronously; the others are synchronous */
+  for (i = 0; i < o->next_vol_id_.size(); i++) {
+    new_obj->next_vol_info_[i] = H5VLdataset_create(o->next_vol_info_[i], loc_params, o->next_vol_id_[i], name,
+                                                    lcpl_id, under_type_id, under_space_id, under_dcpl_id,
+                                                    dapl_id, dxpl_id,
+                                                    i == 0 && new_obj->ec_ == nullptr ? req : nullptr);
+    if (new_obj->next_vol_info_[i] == nullptr)
+      break;
+  }
+  if (under_space_id != space_id)
+    H5Sclose(under_space_id);
+  if (i < o->next_vol_id_.size() || (new_obj->ec_ && H5VL_replicate_vol_ec_header_write(new_obj) < 0)) {
+    while (i-- > 0)
+      H5VLdataset_close(new_obj->next_vol_info_[i], new_obj->next_vol_id_[i], dxpl_id, nullptr);
+    H5VL_replicate_vol_ec_free(new_obj->ec_);
+    delete new_obj;
+    return nullptr;
   }
   return new_obj;
 } /* end H5VL_replicate_vol_dataset_create() */
@@ -795,7 +2305,26 @@ static void *
 H5VL_replicate_vol_dataset_open(void *obj, const H5VL_loc_params_t *loc_params, const char *name,
                                 hid_t dapl_id, hid_t dxpl_id, void **req)
 {
-  return 0;
+  H5VL_replicate_vol_t *o = (H5VL_replicate_vol_t *)obj;
+  H5VL_replicate_vol_t *new_obj = H5VL_replicate_vol_new_obj(o);
+  size_t i;
+
+  for (i = 0; i < o->next_vol_id_.size(); i++) {
+    new_obj->next_vol_info_[i] = H5VLdataset_open(o->next_vol_info_[i], loc_params, o->next_vol_id_[i], name,
+                                                  dapl_id, dxpl_id, i == 0 && o->ec_data_ == 0 ? req : nullptr);
+    if (new_obj->next_vol_info_[i] == nullptr)
+      break;
+  }
+  if (i == o->next_vol_id_.size() && o->ec_data_ > 0)
+    new_obj->ec_ = new H5VL_replicate_vol_ec_t{H5I_INVALID_HID, H5I_INVALID_HID, H5I_INVALID_HID, 0, 0, 0, 0, 0};
+  if (i < o->next_vol_id_.size() || (new_obj->ec_ && H5VL_replicate_vol_ec_load(new_obj) < 0)) {
+    while (i-- > 0)
+      H5VLdataset_close(new_obj->next_vol_info_[i], new_obj->next_vol_id_[i], dxpl_id, nullptr);
+    H5VL_replicate_vol_ec_free(new_obj->ec_);
+    delete new_obj;
+    return nullptr;
+  }
+  return new_obj;
 } /* end H5VL_replicate_vol_dataset_open() */
 
 /*-------------------------------------------------------------------------
@@ -812,22 +2341,86 @@ static herr_t
 H5VL_replicate_vol_dataset_read(size_t count, void *dset[], hid_t mem_type_id[], hid_t mem_space_id[],
                                 hid_t file_space_id[], hid_t plist_id, void *buf[], void **req)
 {
-  std::vector<H5VL_replicate_vol_t*> obj(count);
-  size_t i;                /* Local index variable */
+  H5VL_replicate_vol_t *o = (H5VL_replicate_vol_t *)dset[0];
+  H5VL_replicate_vol_state_t *state = o->state_.get();
+  h5::SmallArray<void *, 8> obj(count > 1 ? count : 0);
+  std::vector<size_t> order;
+  size_t i, replica;       /* Local index variables */
+  size_t bytes = 0;
   herr_t ret_value;
 
-  /* Allocate obj array if necessary */
-  for (i = 0; i < count; i++) {
-    /* Get the object */
-    obj[i] = (H5VL_replicate_vol_t*)((H5VL_replicate_vol_t*)dset[i])->next_vol_info_;
-
-    /* Make sure the class matches */
-    if (((H5VL_replicate_vol_t*) dset[i])->next_vol_id_[0] != ((H5VL_replicate_vol_t*) dset[0])->next_vol_id_[0])
+  /* Make sure all datasets share the replica set */
+  for (i = 1; i < count; i++) {
+    if (((H5VL_replicate_vol_t*) dset[i])->next_vol_id_ != o->next_vol_id_)
       return -1;
   }
+  if (o->ec_) {
+    for (i = 0; i < count; i++) {
+      if (H5VL_replicate_vol_ec_read((H5VL_replicate_vol_t *)dset[i], mem_type_id[i], mem_space_id[i],
+                                     file_space_id[i], buf[i]) < 0)
+        return -1;
+    }
+    return 0;
+  }
+  if (state == nullptr || o->next_vol_id_.size() == 1)
+    return H5VLdataset_read(count, H5VL_replicate_vol_unwrap(count, dset, 0, obj.data()), o->next_vol_id_[0],
+                            mem_type_id, mem_space_id, file_space_id, plist_id, buf, req);
+
+  /* Finish background writes that completed, so their replicas count */
+  H5VL_replicate_vol_progress(state, 0);
+
+  /* Size the request */
+  for (i = 0; i < count; i++) {
+    hid_t space_id = file_space_id[i] != H5S_ALL ? file_space_id[i] : mem_space_id[i];
+    hssize_t npoints;
+    if (space_id == H5S_ALL) {
+      H5VL_dataset_get_args_t args;
+      args.op_type = H5VL_DATASET_GET_SPACE;
+      if (H5VLdataset_get(((H5VL_replicate_vol_t*)dset[i])->next_vol_info_[0], o->next_vol_id_[0], &args,
+                          H5P_DATASET_XFER_DEFAULT, nullptr) < 0)
+        return -1;
+      npoints = H5Sget_select_npoints(args.args.get_space.space_id);
+      H5Sclose(args.args.get_space.space_id);
+    } else {
+      npoints = H5Sget_select_npoints(space_id);
+    }
+    bytes += npoints > 0 ? (size_t)npoints * H5Tget_size(mem_type_id[i]) : 0;
+  }
+  H5VL_replicate_vol_rank(state, bytes, order);
+
+  /* Large single-dataset hyperslab reads are spread over the replicas */
+  if (count == 1 && order.size() > 1 && o->split_size_ > 0 && bytes >= o->split_size_ && req == nullptr) {
+    hid_t dset_space_id = H5I_INVALID_HID, mem_space = mem_space_id[0], file_space = file_space_id[0];
+    H5S_sel_type sel_type;
+    if (file_space == H5S_ALL) {
+      H5VL_dataset_get_args_t args;
+      args.op_type = H5VL_DATASET_GET_SPACE;
+      if (H5VLdataset_get(o->next_vol_info_[0], o->next_vol_id_[0], &args, H5P_DATASET_XFER_DEFAULT, nullptr) < 0)
+        return -1;
+      dset_space_id = args.args.get_space.space_id;
+    }
+    h5::ResolveSpaces(dset_space_id, file_space, mem_space);
+    sel_type = H5Sget_select_type(file_space);
+    if ((sel_type == H5S_SEL_HYPERSLABS || sel_type == H5S_SEL_ALL) && H5Sget_simple_extent_ndims(file_space) > 0) {
+      ret_value = H5VL_replicate_vol_split_read(o, mem_type_id[0], mem_space, file_space, plist_id, buf[0], order);
+      if (dset_space_id >= 0)
+        H5Sclose(dset_space_id);
+      return ret_value;
+    }
+    if (dset_space_id >= 0)
+      H5Sclose(dset_space_id);
+  }
 
-  ret_value = H5VLdataset_read(count, (void**)obj.data(), ((H5VL_replicate_vol_t*)dset[0])->next_vol_id_[0], mem_type_id,
-                               mem_space_id, file_space_id, plist_id, buf, req);
+  /* Otherwise read everything from the fastest current replica */
+  replica = order[0];
+  H5VL_replicate_vol_strand(state, replica, H5ES_WAIT_FOREVER);
+  auto t0 = std::chrono::steady_clock::now();
+  ret_value = H5VLdataset_read(count, H5VL_replicate_vol_unwrap(count, dset, replica, obj.data()),
+                               o->next_vol_id_[replica], mem_type_id, mem_space_id, file_space_id, plist_id,
+                               buf, req);
+  if (ret_value >= 0 && req == nullptr)
+    H5VL_replicate_vol_observe(state, replica, bytes,
+                               std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
 
   return ret_value;
 } /* end H5VL_replicate_vol_dataset_read() */
@@ -846,24 +2439,86 @@ static herr_t
 H5VL_replicate_vol_dataset_write(size_t count, void *dset[], hid_t mem_type_id[], hid_t mem_space_id[],
                                  hid_t file_space_id[], hid_t plist_id, const void *buf[], void **req)
 {
-  std::vector<H5VL_replicate_vol_t*> obj(count);
-  size_t i;                /* Local index variable */
-  herr_t ret_value;
-
-  /* Allocate obj array if necessary */
-  for (i = 0; i < count; i++) {
-    /* Get the object */
-    obj[i] = (H5VL_replicate_vol_t*)((H5VL_replicate_vol_t*)dset[i])->next_vol_info_;
-
-    /* Make sure the class matches */
-    if (((H5VL_replicate_vol_t*) dset[i])->next_vol_id_ != ((H5VL_replicate_vol_t*) dset[0])->next_vol_id_)
+  H5VL_replicate_vol_t *o = (H5VL_replicate_vol_t *)dset[0];
+  H5VL_replicate_vol_state_t *state = o->state_.get();
+  size_t nreplicas = o->next_vol_id_.size();
+  std::shared_ptr<H5VL_replicate_vol_write_t> w;
+  h5::SmallArray<void *, 8> obj(count > 1 ? count : 0);
+  herr_t status;
+  size_t i, r;             /* Local index variables */
+
+  /* Make sure all datasets share the replica set */
+  for (i = 1; i < count; i++) {
+    if (((H5VL_replicate_vol_t*) dset[i])->next_vol_id_ != o->next_vol_id_)
       return -1;
   }
+  if (o->ec_) {
+    for (i = 0; i < count; i++) {
+      if (H5VL_replicate_vol_ec_write((H5VL_replicate_vol_t *)dset[i], mem_type_id[i], mem_space_id[i],
+                                      file_space_id[i], buf[i]) < 0)
+        return -1;
+    }
+    return 0;
+  }
 
-  ret_value = H5VLdataset_write(count, (void**)obj.data(), ((H5VL_replicate_vol_t*)dset[0])->next_vol_id_[0], mem_type_id,
-                                mem_space_id, file_space_id, plist_id, buf, req);
+  /* A single replica has nothing to track: hand the caller's arrays on */
+  if (state == nullptr || nreplicas == 1) {
+    status = H5VLdataset_write(count, H5VL_replicate_vol_unwrap(count, dset, 0, obj.data()), o->next_vol_id_[0],
+                               mem_type_id, mem_space_id, file_space_id, plist_id, buf, req);
+    if (state != nullptr) {
+      std::unique_lock<std::mutex> lock(state->lock_);
+      if (status < 0)
+        ++state->status_[0].failed_;
+      state->status_[0].healthy_ = status >= 0;
+    }
+    return status;
+  }
+  H5VL_replicate_vol_progress(state, 0);
+  H5VL_replicate_vol_reap(state);
+
+  /* Issue every replica from this thread, which holds the library lock;
+   * replicas write from a private copy of the data when they may outlive
+   * this call */
+  w = H5VL_replicate_vol_write_new(o, count, dset, mem_type_id, mem_space_id, file_space_id, plist_id, buf,
+                                   o->quorum_ < nreplicas);
+  if (w == nullptr)
+    return -1;
+  {
+    std::unique_lock<std::mutex> lock(state->lock_);
+    w->seq_ = ++state->seq_;
+    state->pending_.push_back(w);
+  }
+  for (r = 0; r < nreplicas; r++) {
+    state->queue_[r].push_back(w);
+    H5VL_replicate_vol_strand(state, r, 0);
+  }
 
-  return ret_value;
+  /* Return once a quorum acknowledged, whichever replicas those are, or
+   * once a quorum became impossible; without copies, every replica must
+   * finish first. Completion callbacks wake this thread; it issues each
+   * replica's next queued write and checks tokens that take no callback. */
+  while (true) {
+    uint64_t done;
+    {
+      std::unique_lock<std::mutex> lock(state->lock_);
+      if (w->owned_ ? w->acked_ >= o->quorum_ || w->failed_ > nreplicas - o->quorum_
+                    : w->acked_ + w->failed_ == nreplicas)
+        break;
+      done = state->done_;
+    }
+    H5VL_replicate_vol_progress(state, 0);
+    bool polled = false;
+    for (r = 0; r < nreplicas; r++)
+      polled = polled || (!state->queue_[r].empty() && state->queue_[r].front()->req_[r] != nullptr);
+    std::unique_lock<std::mutex> lock(state->lock_);
+    if (polled)
+      state->done_cv_.wait_for(lock, std::chrono::milliseconds(H5VL_REPLICATE_VOL_POLL_MS),
+                               [&]() { return state->done_ != done; });
+    else
+      state->done_cv_.wait(lock, [&]() { return state->done_ != done; });
+  }
+  std::unique_lock<std::mutex> lock(state->lock_);
+  return w->acked_ >= o->quorum_ ? 0 : -1;
 } /* end H5VL_replicate_vol_dataset_write() */
 
 /*-------------------------------------------------------------------------
@@ -879,7 +2534,25 @@ H5VL_replicate_vol_dataset_write(size_t count, void *dset[], hid_t mem_type_id[]
 static herr_t
 H5VL_replicate_vol_dataset_get(void *dset, H5VL_dataset_get_args_t *args, hid_t dxpl_id, void **req)
 {
-  return 0;
+  H5VL_replicate_vol_t *o = (H5VL_replicate_vol_t *)dset;
+
+  /* Erasure-coded datasets report the logical dataset, not the shards */
+  if (o->ec_) {
+    switch (args->op_type) {
+      case H5VL_DATASET_GET_SPACE:
+        args->args.get_space.space_id = H5Scopy(o->ec_->space_id_);
+        return 0;
+      case H5VL_DATASET_GET_TYPE:
+        args->args.get_type.type_id = H5Tcopy(o->ec_->type_id_);
+        return 0;
+      case H5VL_DATASET_GET_DCPL:
+        args->args.get_dcpl.dcpl_id = H5Pcopy(o->ec_->dcpl_id_);
+        return 0;
+      default:
+        break;
+    }
+  }
+  return H5VLdataset_get(o->next_vol_info_[0], o->next_vol_id_[0], args, dxpl_id, req);
 } /* end H5VL_replicate_vol_dataset_get() */
 
 /*-------------------------------------------------------------------------
@@ -895,7 +2568,20 @@ H5VL_replicate_vol_dataset_get(void *dset, H5VL_dataset_get_args_t *args, hid_t
 static herr_t
 H5VL_replicate_vol_dataset_specific(void *obj, H5VL_dataset_specific_args_t *args, hid_t dxpl_id, void **req)
 {
-  return 0;
+  H5VL_replicate_vol_t *o = (H5VL_replicate_vol_t *)obj;
+  herr_t ret_value = 0;
+
+  /* Extent changes, flushes and refreshes apply to every replica, after
+   * any background writes landed. Shards are laid out for a fixed extent. */
+  if (o->ec_ && args->op_type == H5VL_DATASET_SET_EXTENT)
+    return -1;
+  H5VL_replicate_vol_drain(o);
+  for (size_t i = 0; i < o->next_vol_id_.size(); i++) {
+    if (H5VLdataset_specific(o->next_vol_info_[i], o->next_vol_id_[i], args, dxpl_id,
+                             i == 0 ? req : nullptr) < 0)
+      ret_value = -1;
+  }
+  return ret_value;
 } /* end H5VL_replicate_vol_dataset_specific() */
 
 /*-------------------------------------------------------------------------
@@ -927,7 +2613,18 @@ H5VL_replicate_vol_dataset_optional(void *obj, H5VL_optional_args_t *args, hid_t
 static herr_t
 H5VL_replicate_vol_dataset_close(void *dset, hid_t dxpl_id, void **req)
 {
-  return 0;
+  H5VL_replicate_vol_t *o = (H5VL_replicate_vol_t *)dset;
+  herr_t ret_value = 0;
+
+  /* Background writes may still use the under datasets */
+  H5VL_replicate_vol_drain(o);
+  for (size_t i = 0; i < o->next_vol_id_.size(); i++) {
+    if (H5VLdataset_close(o->next_vol_info_[i], o->next_vol_id_[i], dxpl_id, i == 0 ? req : nullptr) < 0)
+      ret_value = -1;
+  }
+  H5VL_replicate_vol_ec_free(o->ec_);
+  delete o;
+  return ret_value;
 } /* end H5VL_replicate_vol_dataset_close() */
 
 /*-------------------------------------------------------------------------
@@ -1043,13 +2740,32 @@ static void *
 H5VL_replicate_vol_file_create(const char *name, unsigned flags, hid_t fcpl_id, hid_t fapl_id, hid_t dxpl_id,
                                void **req)
 {
-  H5VL_replicate_vol_t *file = new H5VL_replicate_vol_t(), *info;
+  H5VL_replicate_vol_t *info, *file;
+  size_t i;
+
   H5Pget_vol_info(fapl_id, (void **)&info);
-  (*file) = (*info);
-  hid_t under_fapl_id = H5Pcopy(fapl_id);
-  H5Pset_vol(under_fapl_id, info->next_vol_id_[0], info->next_vol_info_[0]);
-  H5VLfile_create(name, flags, fcpl_id, under_fapl_id, dxpl_id, req);
-  H5Pclose(under_fapl_id);
+  file = H5VL_replicate_vol_new_obj(info);
+  for (i = 0; i < info->next_vol_id_.size(); i++) {
+    std::string replica_name = H5VL_replicate_vol_replica_name(name, i);
+    hid_t under_fapl_id = H5Pcopy(fapl_id);
+    H5Pset_vol(under_fapl_id, info->next_vol_id_[i], info->next_vol_info_[i]);
+    file->next_vol_info_[i] = H5VLfile_create(replica_name.c_str(), flags, fcpl_id, under_fapl_id, dxpl_id,
+                                              i == 0 ? req : nullptr);
+    H5Pclose(under_fapl_id);
+    if (file->next_vol_info_[i] == nullptr)
+      break;
+  }
+  if (i < info->next_vol_id_.size()) {
+    while (i-- > 0)
+      H5VLfile_close(file->next_vol_info_[i], file->next_vol_id_[i], dxpl_id, nullptr);
+    delete file;
+    return nullptr;
+  }
+  file->state_ = std::make_shared<H5VL_replicate_vol_state_t>();
+  file->state_->status_.assign(file->next_vol_id_.size(), H5VL_replicate_vol_status_t{true, 0, 0, 0, 0, 0});
+  file->state_->queue_.resize(file->next_vol_id_.size());
+  if (H5VL_replicate_vol_pool_g == nullptr && info->nthreads_ > 0)
+    H5VL_replicate_vol_pool_g = new h5::ThreadPool(info->nthreads_);
   return file;
 } /* end H5VL_replicate_vol_file_create() */
 
@@ -1066,7 +2782,33 @@ H5VL_replicate_vol_file_create(const char *name, unsigned flags, hid_t fcpl_id,
 static void *
 H5VL_replicate_vol_file_open(const char *name, unsigned flags, hid_t fapl_id, hid_t dxpl_id, void **req)
 {
-  return 0;
+  H5VL_replicate_vol_t *info, *file;
+  size_t i;
+
+  H5Pget_vol_info(fapl_id, (void **)&info);
+  file = H5VL_replicate_vol_new_obj(info);
+  for (i = 0; i < info->next_vol_id_.size(); i++) {
+    std::string replica_name = H5VL_replicate_vol_replica_name(name, i);
+    hid_t under_fapl_id = H5Pcopy(fapl_id);
+    H5Pset_vol(under_fapl_id, info->next_vol_id_[i], info->next_vol_info_[i]);
+    file->next_vol_info_[i] = H5VLfile_open(replica_name.c_str(), flags, under_fapl_id, dxpl_id,
+                                            i == 0 ? req : nullptr);
+    H5Pclose(under_fapl_id);
+    if (file->next_vol_info_[i] == nullptr)
+      break;
+  }
+  if (i < info->next_vol_id_.size()) {
+    while (i-- > 0)
+      H5VLfile_close(file->next_vol_info_[i], file->next_vol_id_[i], dxpl_id, nullptr);
+    delete file;
+    return nullptr;
+  }
+  file->state_ = std::make_shared<H5VL_replicate_vol_state_t>();
+  file->state_->status_.assign(file->next_vol_id_.size(), H5VL_replicate_vol_status_t{true, 0, 0, 0, 0, 0});
+  file->state_->queue_.resize(file->next_vol_id_.size());
+  if (H5VL_replicate_vol_pool_g == nullptr && info->nthreads_ > 0)
+    H5VL_replicate_vol_pool_g = new h5::ThreadPool(info->nthreads_);
+  return file;
 } /* end H5VL_replicate_vol_file_open() */
 
 /*-------------------------------------------------------------------------
@@ -1098,7 +2840,18 @@ H5VL_replicate_vol_file_get(void *file, H5VL_file_get_args_t *args, hid_t dxpl_i
 static herr_t
 H5VL_replicate_vol_file_specific(void *file, H5VL_file_specific_args_t *args, hid_t dxpl_id, void **req)
 {
-  return 0;
+  H5VL_replicate_vol_t *o = (H5VL_replicate_vol_t *)file;
+  herr_t ret_value = 0;
+
+  /* Operations without a file object (is_accessible, delete) are not replicated */
+  if (o == nullptr)
+    return -1;
+  H5VL_replicate_vol_drain(o);
+  for (size_t i = 0; i < o->next_vol_id_.size(); i++) {
+    if (H5VLfile_specific(o->next_vol_info_[i], o->next_vol_id_[i], args, dxpl_id, i == 0 ? req : nullptr) < 0)
+      ret_value = -1;
+  }
+  return ret_value;
 } /* end H5VL_replicate_vol_file_specific() */
 
 /*-------------------------------------------------------------------------
@@ -1114,6 +2867,10 @@ H5VL_replicate_vol_file_specific(void *file, H5VL_file_specific_args_t *args, hi
 static herr_t
 H5VL_replicate_vol_file_optional(void *file, H5VL_optional_args_t *args, hid_t dxpl_id, void **req)
 {
+  if (args->op_type == H5VL_replicate_vol_get_status_op_g) {
+    H5VL_replicate_vol_get_status_args_t *status_args = (H5VL_replicate_vol_get_status_args_t *)args->args;
+    return H5VL_replicate_vol_status((H5VL_replicate_vol_t *)file, status_args->nreplicas_, status_args->status_);
+  }
   return 0;
 } /* end H5VL_replicate_vol_file_optional() */
 
@@ -1130,7 +2887,16 @@ H5VL_replicate_vol_file_optional(void *file, H5VL_optional_args_t *args, hid_t d
 static herr_t
 H5VL_replicate_vol_file_close(void *file, hid_t dxpl_id, void **req)
 {
-  return 0;
+  H5VL_replicate_vol_t *o = (H5VL_replicate_vol_t *)file;
+  herr_t ret_value = 0;
+
+  H5VL_replicate_vol_drain(o);
+  for (size_t i = 0; i < o->next_vol_id_.size(); i++) {
+    if (H5VLfile_close(o->next_vol_info_[i], o->next_vol_id_[i], dxpl_id, i == 0 ? req : nullptr) < 0)
+      ret_value = -1;
+  }
+  delete o;
+  return ret_value;
 } /* end H5VL_replicate_vol_file_close() */
 
 /*-------------------------------------------------------------------------
@@ -1147,7 +2913,23 @@ static void *
 H5VL_replicate_vol_group_create(void *obj, const H5VL_loc_params_t *loc_params, const char *name,
                                 hid_t lcpl_id, hid_t gcpl_id, hid_t gapl_id, hid_t dxpl_id, void **req)
 {
-  return 0;
+  H5VL_replicate_vol_t *o = (H5VL_replicate_vol_t *)obj;
+  H5VL_replicate_vol_t *new_obj = H5VL_replicate_vol_new_obj(o);
+  size_t i;
+
+  for (i = 0; i < o->next_vol_id_.size(); i++) {
+    new_obj->next_vol_info_[i] = H5VLgroup_create(o->next_vol_info_[i], loc_params, o->next_vol_id_[i], name,
+                                                  lcpl_id, gcpl_id, gapl_id, dxpl_id, i == 0 ? req : nullptr);
+    if (new_obj->next_vol_info_[i] == nullptr)
+      break;
+  }
+  if (i < o->next_vol_id_.size()) {
+    while (i-- > 0)
+      H5VLgroup_close(new_obj->next_vol_info_[i], new_obj->next_vol_id_[i], dxpl_id, nullptr);
+    delete new_obj;
+    return nullptr;
+  }
+  return new_obj;
 } /* end H5VL_replicate_vol_group_create() */
 
 /*-------------------------------------------------------------------------
@@ -1164,7 +2946,23 @@ static void *
 H5VL_replicate_vol_group_open(void *obj, const H5VL_loc_params_t *loc_params, const char *name, hid_t gapl_id,
                               hid_t dxpl_id, void **req)
 {
-  return 0;
+  H5VL_replicate_vol_t *o = (H5VL_replicate_vol_t *)obj;
+  H5VL_replicate_vol_t *new_obj = H5VL_replicate_vol_new_obj(o);
+  size_t i;
+
+  for (i = 0; i < o->next_vol_id_.size(); i++) {
+    new_obj->next_vol_info_[i] = H5VLgroup_open(o->next_vol_info_[i], loc_params, o->next_vol_id_[i], name,
+                                                gapl_id, dxpl_id, i == 0 ? req : nullptr);
+    if (new_obj->next_vol_info_[i] == nullptr)
+      break;
+  }
+  if (i < o->next_vol_id_.size()) {
+    while (i-- > 0)
+      H5VLgroup_close(new_obj->next_vol_info_[i], new_obj->next_vol_id_[i], dxpl_id, nullptr);
+    delete new_obj;
+    return nullptr;
+  }
+  return new_obj;
 } /* end H5VL_replicate_vol_group_open() */
 
 /*-------------------------------------------------------------------------
@@ -1228,7 +3026,15 @@ H5VL_replicate_vol_group_optional(void *obj, H5VL_optional_args_t *args, hid_t d
 static herr_t
 H5VL_replicate_vol_group_close(void *grp, hid_t dxpl_id, void **req)
 {
-  return 0;
+  H5VL_replicate_vol_t *o = (H5VL_replicate_vol_t *)grp;
+  herr_t ret_value = 0;
+
+  for (size_t i = 0; i < o->next_vol_id_.size(); i++) {
+    if (H5VLgroup_close(o->next_vol_info_[i], o->next_vol_id_[i], dxpl_id, i == 0 ? req : nullptr) < 0)
+      ret_value = -1;
+  }
+  delete o;
+  return ret_value;
 } /* end H5VL_replicate_vol_group_close() */
 
 /*-------------------------------------------------------------------------
@@ -1474,6 +3280,8 @@ H5VL_replicate_vol_introspect_get_cap_flags(const void *_info, uint64_t *cap_fla
 herr_t
 H5VL_replicate_vol_introspect_opt_query(void *obj, H5VL_subclass_t cls, int opt_type, uint64_t *flags)
 {
+  if (cls == H5VL_SUBCLS_FILE && opt_type == H5VL_replicate_vol_get_status_op_g)
+    *flags = H5VL_OPT_QUERY_SUPPORTED;
   return 0;
 } /* end H5VL_replicate_vol_introspect_opt_query() */
 
@@ -18,6 +18,8 @@
 #define H5VLreplicate_vol_H
 
 /* Public headers needed by this file */
+#include <memory>
+#include <vector>
 #include <H5PLpublic.h>
 #include "H5VLpublic.h" /* Virtual Object Layer                 */
 
@@ -29,10 +31,34 @@
 #define H5VL_REPLICATE_VOL_VALUE   2 /* VOL connector ID */
 #define H5VL_REPLICATE_VOL_VERSION 0
 
+/* Write tracking shared by a file and its objects (private to the connector) */
+struct H5VL_replicate_vol_state_t;
+
+/* Layout of an erasure-coded dataset (private to the connector) */
+struct H5VL_replicate_vol_ec_t;
+
+/* Health of one replica, see H5VL_replicate_vol_get_status() */
+typedef struct H5VL_replicate_vol_status_t {
+  hbool_t healthy_;     /* The last completed write succeeded */
+  uint64_t pending_;    /* Writes still running in the background */
+  uint64_t failed_;     /* Writes that failed since the file was opened */
+  double lag_;          /* Seconds the oldest pending write has been running */
+  double read_latency_;   /* EWMA of small-read latency in seconds (0 = unknown) */
+  double read_bandwidth_; /* EWMA of large-read bandwidth in bytes/s (0 = unknown) */
+} H5VL_replicate_vol_status_t;
+
 /* Pass-through VOL connector info */
 typedef struct H5VL_replicate_vol_t {
-  hid_t next_vol_id_[3];       /* VOL ID for under VOL */
-  void *next_vol_info_[3];     /* VOL info for under VOL */
+  size_t nthreads_;                    /* Erasure-coding workers */
+  size_t quorum_;                      /* Replicas a write waits for */
+  size_t split_size_;                  /* Reads at least this large are split across replicas (0 = never) */
+  size_t ec_data_;                     /* Data shards per stripe (0 = full copies) */
+  size_t ec_parity_;                   /* Parity shards per stripe */
+  size_t ec_unit_;                     /* Bytes of a stripe stored on each under VOL */
+  struct H5VL_replicate_vol_ec_t *ec_; /* Erasure-coded layout (datasets only) */
+  std::shared_ptr<struct H5VL_replicate_vol_state_t> state_;  /* Write tracking (files and their objects) */
+  std::vector<hid_t> next_vol_id_;     /* VOL ID of each replica's under VOL */
+  std::vector<void *> next_vol_info_;  /* VOL info (or object) of each replica */
 } H5VL_replicate_vol_t;
 
 #ifdef __cplusplus
@@ -40,6 +66,7 @@ extern "C" {
 #endif
 
 H5_DLL hid_t H5VL_replicate_vol_register(void);
+H5_DLL herr_t H5VL_replicate_vol_get_status(hid_t obj_id, size_t *nreplicas, H5VL_replicate_vol_status_t *status);
 H5_DLL const void* H5PLget_plugin_info(void);
 H5_DLL H5PL_type_t H5PLget_plugin_type(void);
 
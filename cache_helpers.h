@@ -0,0 +1,205 @@
+//
+// Adaptive replacement cache used by pfs_vol's chunk cache.
+//
+
+#ifndef HDF5_VOLS__CACHE_HELPERS_H_
+#define HDF5_VOLS__CACHE_HELPERS_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <list>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace h5 {
+
+/**
+ * An adaptive replacement cache (ARC) holding up to \a capacity bytes of
+ * values of varying size. Values seen once sit in T1 and values seen
+ * again in T2; the keys of values evicted from each are remembered in the
+ * ghost lists B1 and B2. A miss on a B1 key grows the share p_ of the
+ * capacity given to T1, one on a B2 key shrinks it, so the cache adapts
+ * between recency and frequency. Sizes are counted in bytes rather than
+ * entries. Not thread-safe; values handed back by Put and EraseIf are the
+ * caller's to write back.
+ */
+template <typename K, typename V>
+class ArcCache {
+ public:
+  typedef std::pair<K, V> Evicted;
+
+ private:
+  enum { kT1 = 0, kT2 = 1, kB1 = 2, kB2 = 3 };
+
+  struct Node {
+    K key_;
+    V val_;
+    size_t size_;
+    int list_;
+  };
+
+  typedef std::list<Node> List;
+
+  size_t capacity_;
+  size_t p_ = 0;             /**< Target bytes of T1 */
+  List lists_[4];
+  size_t bytes_[4] = {0, 0, 0, 0};
+  std::map<K, typename List::iterator> index_;
+
+ public:
+  explicit ArcCache(size_t capacity) : capacity_(capacity) {}
+
+  /** Bytes the cache may hold */
+  size_t Capacity() const { return capacity_; }
+
+  /** Bytes it holds */
+  size_t Size() const { return bytes_[kT1] + bytes_[kT2]; }
+
+  /** Whether \a key is cached, without counting as a use */
+  bool Contains(const K &key) const {
+    auto it = index_.find(key);
+    return it != index_.end() && it->second->list_ <= kT2;
+  }
+
+  /** The value of \a key, moved to the front of T2, or nullptr on a miss */
+  V *Get(const K &key) {
+    auto it = index_.find(key);
+    if (it == index_.end() || it->second->list_ >= kB1) {
+      return nullptr;
+    }
+    Move(it->second, kT2);
+    return &it->second->val_;
+  }
+
+  /**
+   * Insert \a val of \a size bytes for \a key after a miss, adapting p_
+   * if the key is a ghost. Values evicted to make room are appended to
+   * \a evicted. Returns the cached value, or nullptr if \a size exceeds
+   * the capacity (\a val is then left alone).
+   */
+  V *Put(const K &key, V &&val, size_t size, std::vector<Evicted> &evicted) {
+    auto it = index_.find(key);
+    int dest = kT1;
+    if (size > capacity_) {
+      return nullptr;
+    }
+    if (it != index_.end() && it->second->list_ == kB1) {
+      size_t ratio = std::max<size_t>(bytes_[kB2] / std::max<size_t>(bytes_[kB1], 1), 1);
+      p_ = std::min(capacity_, p_ + ratio * size);
+      Drop(it->second);
+      Replace(size, false, evicted);
+      dest = kT2;
+    } else if (it != index_.end() && it->second->list_ == kB2) {
+      size_t ratio = std::max<size_t>(bytes_[kB1] / std::max<size_t>(bytes_[kB2], 1), 1);
+      p_ = p_ > ratio * size ? p_ - ratio * size : 0;
+      Drop(it->second);
+      Replace(size, true, evicted);
+      dest = kT2;
+    } else {
+      Replace(size, false, evicted);
+    }
+    lists_[dest].push_front(Node{key, std::move(val), size, dest});
+    bytes_[dest] += size;
+    index_[key] = lists_[dest].begin();
+    Trim();
+    return &lists_[dest].front().val_;
+  }
+
+  /** Forget \a key, cached or ghost, dropping its value */
+  void Erase(const K &key) {
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      Drop(it->second);
+    }
+  }
+
+  /**
+   * Take back \a val of \a size bytes that Put just evicted for \a key,
+   * e.g. because it could not be written back, as the least recently
+   * used value of T1. Nothing is evicted for it; the caller makes room
+   * first, typically by erasing what it had put.
+   */
+  void Restore(const K &key, V &&val, size_t size) {
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      Drop(it->second);
+    }
+    lists_[kT1].push_back(Node{key, std::move(val), size, kT1});
+    bytes_[kT1] += size;
+    index_[key] = std::prev(lists_[kT1].end());
+  }
+
+  /** Call \a fn(key, value) on every cached value */
+  template <typename F>
+  void ForEach(F fn) {
+    for (int l = kT1; l <= kT2; ++l) {
+      for (Node &node : lists_[l]) {
+        fn(node.key_, node.val_);
+      }
+    }
+  }
+
+  /**
+   * Remove every key matching \a pred, cached or ghost. Cached values
+   * are appended to \a evicted.
+   */
+  template <typename P>
+  void EraseIf(P pred, std::vector<Evicted> &evicted) {
+    for (int l = kT1; l <= kB2; ++l) {
+      for (auto it = lists_[l].begin(); it != lists_[l].end();) {
+        auto next = std::next(it);
+        if (pred(it->key_)) {
+          if (l <= kT2) {
+            evicted.emplace_back(it->key_, std::move(it->val_));
+          }
+          Drop(it);
+        }
+        it = next;
+      }
+    }
+  }
+
+ private:
+  /** Move a node to the front of list \a dest */
+  void Move(typename List::iterator it, int dest) {
+    bytes_[it->list_] -= it->size_;
+    bytes_[dest] += it->size_;
+    lists_[dest].splice(lists_[dest].begin(), lists_[it->list_], it);
+    it->list_ = dest;
+  }
+
+  /** Forget a node entirely */
+  void Drop(typename List::iterator it) {
+    bytes_[it->list_] -= it->size_;
+    index_.erase(it->key_);
+    lists_[it->list_].erase(it);
+  }
+
+  /** Evict from T1 or T2 to their ghost lists until \a size more bytes fit */
+  void Replace(size_t size, bool in_b2, std::vector<Evicted> &evicted) {
+    while (Size() + size > capacity_ && Size() > 0) {
+      bool from_t1 = bytes_[kT1] > 0 && (bytes_[kT1] > p_ || (in_b2 && bytes_[kT1] >= p_) || bytes_[kT2] == 0);
+      int src = from_t1 ? kT1 : kT2;
+      auto victim = std::prev(lists_[src].end());
+      evicted.emplace_back(victim->key_, std::move(victim->val_));
+      victim->val_ = V();
+      Move(victim, from_t1 ? kB1 : kB2);
+    }
+  }
+
+  /** Keep T1 + B1 within the capacity and all lists within twice it */
+  void Trim() {
+    while (bytes_[kT1] + bytes_[kB1] > capacity_ && !lists_[kB1].empty()) {
+      Drop(std::prev(lists_[kB1].end()));
+    }
+    while (Size() + bytes_[kB1] + bytes_[kB2] > 2 * capacity_ && !lists_[kB2].empty()) {
+      Drop(std::prev(lists_[kB2].end()));
+    }
+  }
+};
+
+}
+
+#endif //HDF5_VOLS__CACHE_HELPERS_H_
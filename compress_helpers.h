@@ -0,0 +1,699 @@
+//
+// Chunk codecs used by compress_vol.
+//
+
+#ifndef HDF5_VOLS__COMPRESS_HELPERS_H_
+#define HDF5_VOLS__COMPRESS_HELPERS_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#ifdef __SSE4_2__
+#include <nmmintrin.h>
+#endif
+#ifdef HDF5_VOLS_ENABLE_LZ4
+#include <lz4.h>
+#endif
+#ifdef HDF5_VOLS_ENABLE_ZSTD
+#include <zstd.h>
+#endif
+#include "shuffle_helpers.h"
+
+namespace h5 {
+
+/**
+ * Codecs understood by compress_vol. The values are persisted in every
+ * chunk header, so never renumber them.
+ */
+enum CompressMethod : int {
+  kCompressNone = 0,   /**< Store the chunk as-is */
+  kCompressRle = 1,    /**< Built-in run-length encoding */
+  kCompressLz4 = 2,    /**< LZ4 block format (fast) */
+  kCompressZstd = 3,   /**< Zstandard (strong) */
+  kCompressLossy = 4,  /**< Error-bounded float quantization (see compress_lossy) */
+  kCompressAuto = 255, /**< Choose per chunk (never persisted) */
+};
+
+/** Thresholds for per-chunk codec selection (kCompressAuto) */
+struct AdaptivePolicy {
+  int fast_;            /**< Codec for chunks that compress easily */
+  int strong_;          /**< Codec for the remaining compressible chunks */
+  double raw_entropy_;  /**< Bits per byte at or above which a chunk is stored raw */
+  double fast_ratio_;   /**< Trial ratio at or below which the fast codec suffices */
+  size_t sample_size_;  /**< Bytes of each chunk that are sampled */
+};
+
+/** Header prepended to every compressed chunk */
+struct ChunkHeader {
+  uint8_t codec_;          /**< CompressMethod used for the payload */
+  uint8_t elmt_size_;      /**< Element size the shuffle filter used */
+  uint8_t shuffle_;        /**< ShuffleFilter applied before the codec */
+  uint8_t reserved_;       /**< Must be zero */
+  uint32_t payload_size_;  /**< Bytes following the header */
+  uint32_t raw_size_;      /**< Bytes after decompression */
+};
+
+/** Abstract chunk codec */
+class Codec {
+ public:
+  virtual ~Codec() = default;
+
+  /** Worst-case compressed size of \a size input bytes */
+  virtual size_t Bound(size_t size) = 0;
+
+  /** Compress \a in into \a out. Returns the compressed size, or 0 if it did not fit */
+  virtual size_t Compress(const char *in, size_t size, char *out, size_t cap) = 0;
+
+  /** Decompress exactly \a raw_size bytes into \a out. Returns false on corrupt input */
+  virtual bool Decompress(const char *in, size_t size, char *out, size_t raw_size) = 0;
+};
+
+/**
+ * PackBits-style run-length encoding. A control byte c < 128 is followed
+ * by c + 1 literal bytes; c >= 128 repeats the next byte (c - 125) times.
+ */
+class RleCodec : public Codec {
+ public:
+  static const size_t kMaxLiteral = 128;
+  static const size_t kMinRun = 3;
+  static const size_t kMaxRun = 130;
+
+ public:
+  size_t Bound(size_t size) override {
+    return size + size / kMaxLiteral + 2;
+  }
+
+  size_t Compress(const char *in, size_t size, char *out, size_t cap) override {
+    size_t i = 0, o = 0;
+    while (i < size) {
+      size_t run = 1;
+      while (i + run < size && run < kMaxRun && in[i + run] == in[i]) {
+        ++run;
+      }
+      if (run >= kMinRun) {
+        if (o + 2 > cap) { return 0; }
+        out[o++] = (char)(128 + run - kMinRun);
+        out[o++] = in[i];
+        i += run;
+        continue;
+      }
+      size_t start = i, lit = 0;
+      while (i < size && lit < kMaxLiteral) {
+        if (i + 2 < size && in[i] == in[i + 1] && in[i] == in[i + 2]) {
+          break;
+        }
+        ++i; ++lit;
+      }
+      if (o + 1 + lit > cap) { return 0; }
+      out[o++] = (char)(lit - 1);
+      memcpy(out + o, in + start, lit);
+      o += lit;
+    }
+    return o;
+  }
+
+  bool Decompress(const char *in, size_t size, char *out, size_t raw_size) override {
+    size_t i = 0, o = 0;
+    while (i < size) {
+      uint8_t c = (uint8_t)in[i++];
+      if (c < 128) {
+        size_t lit = (size_t)c + 1;
+        if (i + lit > size || o + lit > raw_size) { return false; }
+        memcpy(out + o, in + i, lit);
+        i += lit; o += lit;
+      } else {
+        size_t run = (size_t)c - 128 + kMinRun;
+        if (i >= size || o + run > raw_size) { return false; }
+        memset(out + o, in[i++], run);
+        o += run;
+      }
+    }
+    return o == raw_size;
+  }
+};
+
+#ifdef HDF5_VOLS_ENABLE_LZ4
+/** LZ4 block codec */
+class Lz4Codec : public Codec {
+ public:
+  size_t Bound(size_t size) override {
+    return (size_t)LZ4_compressBound((int)size);
+  }
+
+  size_t Compress(const char *in, size_t size, char *out, size_t cap) override {
+    int ret = LZ4_compress_default(in, out, (int)size, (int)cap);
+    return ret > 0 ? (size_t)ret : 0;
+  }
+
+  bool Decompress(const char *in, size_t size, char *out, size_t raw_size) override {
+    int ret = LZ4_decompress_safe(in, out, (int)size, (int)raw_size);
+    return ret >= 0 && (size_t)ret == raw_size;
+  }
+};
+#endif
+
+#ifdef HDF5_VOLS_ENABLE_ZSTD
+/** Zstandard codec */
+class ZstdCodec : public Codec {
+ public:
+  static const int kLevel = 3;
+
+ public:
+  size_t Bound(size_t size) override {
+    return ZSTD_compressBound(size);
+  }
+
+  size_t Compress(const char *in, size_t size, char *out, size_t cap) override {
+    size_t ret = ZSTD_compress(out, cap, in, size, kLevel);
+    return ZSTD_isError(ret) ? 0 : ret;
+  }
+
+  bool Decompress(const char *in, size_t size, char *out, size_t raw_size) override {
+    size_t ret = ZSTD_decompress(out, raw_size, in, size);
+    return !ZSTD_isError(ret) && ret == raw_size;
+  }
+};
+#endif
+
+/**
+ * Get the codec for a method, or nullptr if the method is kCompressNone
+ * or was not compiled in.
+ */
+inline Codec* GetCodec(int method) {
+  static RleCodec rle;
+#ifdef HDF5_VOLS_ENABLE_LZ4
+  static Lz4Codec lz4;
+#endif
+#ifdef HDF5_VOLS_ENABLE_ZSTD
+  static ZstdCodec zstd;
+#endif
+  switch (method) {
+    case kCompressRle: return &rle;
+#ifdef HDF5_VOLS_ENABLE_LZ4
+    case kCompressLz4: return &lz4;
+#endif
+#ifdef HDF5_VOLS_ENABLE_ZSTD
+    case kCompressZstd: return &zstd;
+#endif
+    default: return nullptr;
+  }
+}
+
+/** Map a method that was not compiled in to the built-in fallback */
+inline int ResolveMethod(int method) {
+  if (method == kCompressNone || GetCodec(method)) {
+    return method;
+  }
+  return kCompressRle;
+}
+
+/** Parse a method name from the connector string */
+inline int ParseMethod(const std::string &name) {
+  if (name == "none") { return kCompressNone; }
+  if (name == "rle") { return kCompressRle; }
+  if (name == "lz4") { return kCompressLz4; }
+  if (name == "zstd") { return kCompressZstd; }
+  if (name == "auto") { return kCompressAuto; }
+  if (name == "lossy") { return kCompressLossy; }
+  return -1;
+}
+
+/** How the error bound of kCompressLossy is interpreted */
+enum ErrorMode : int {
+  kErrorAbs = 0,   /**< |x - x'| <= bound */
+  kErrorRel = 1,   /**< |x - x'| <= bound * (max - min) of the chunk */
+};
+
+/** Parse an error-bound mode from the connector string */
+inline int ParseErrorMode(const std::string &name) {
+  if (name == "abs") { return kErrorAbs; }
+  if (name == "rel") { return kErrorRel; }
+  return -1;
+}
+
+/**
+ * Pick the codec for one chunk. Up to \a sample_size_ bytes are gathered
+ * from windows spread across the chunk. Their order-0 entropy rules out
+ * noise cheaply; otherwise a trial run of the fast codec on the sample
+ * decides whether the strong codec is worth its cost.
+ */
+inline int SelectMethod(const char *in, size_t size, const AdaptivePolicy &policy) {
+  static const size_t kWindows = 8;
+  static thread_local std::vector<char> sample, trial;
+  size_t hist[256] = {0};
+  size_t nsample = std::min(size, policy.sample_size_);
+  if (nsample == 0) {
+    return kCompressNone;
+  }
+
+  /* Gather evenly spaced windows so the sample covers the whole chunk */
+  sample.resize(nsample);
+  size_t win = (nsample + kWindows - 1) / kWindows;
+  for (size_t off = 0; off < nsample; off += win) {
+    size_t len = std::min(win, nsample - off);
+    size_t src = (size - len) * off / nsample;
+    memcpy(sample.data() + off, in + src, len);
+  }
+
+  /* Order-0 entropy in bits per byte */
+  for (size_t i = 0; i < nsample; ++i) {
+    ++hist[(uint8_t)sample[i]];
+  }
+  double entropy = 0;
+  for (size_t count : hist) {
+    if (count) {
+      double p = (double)count / nsample;
+      entropy -= p * std::log2(p);
+    }
+  }
+  if (entropy >= policy.raw_entropy_) {
+    return kCompressNone;
+  }
+
+  /* Trial-compress the sample with the fast codec */
+  int fast = ResolveMethod(policy.fast_);
+  Codec *codec = GetCodec(fast);
+  if (!codec) {
+    return fast;
+  }
+  trial.resize(codec->Bound(nsample));
+  size_t csize = codec->Compress(sample.data(), nsample, trial.data(), trial.size());
+  if (csize > 0 && (double)csize <= policy.fast_ratio_ * nsample) {
+    return fast;
+  }
+  return ResolveMethod(policy.strong_);
+}
+
+/** CRC-32C (Castagnoli), hardware-accelerated when SSE4.2 is available */
+inline uint32_t Crc32c(const void *data, size_t size) {
+  const uint8_t *p = (const uint8_t*)data;
+  uint32_t crc = 0xFFFFFFFF;
+#ifdef __SSE4_2__
+  uint64_t crc64 = crc;
+  for (; size >= 8; size -= 8, p += 8) {
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));
+    crc64 = _mm_crc32_u64(crc64, word);
+  }
+  crc = (uint32_t)crc64;
+  for (; size; --size, ++p) {
+    crc = _mm_crc32_u8(crc, *p);
+  }
+#else
+  static const struct Table {
+    uint32_t t_[256];
+    Table() {
+      for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; ++k) {
+          c = (c & 1) ? (c >> 1) ^ 0x82F63B78 : c >> 1;
+        }
+        t_[i] = c;
+      }
+    }
+  } table;
+  for (; size; --size, ++p) {
+    crc = table.t_[(crc ^ *p) & 0xFF] ^ (crc >> 8);
+  }
+#endif
+  return crc ^ 0xFFFFFFFF;
+}
+
+/** Append an unsigned LEB128 varint */
+inline void PutVarint(std::vector<char> &out, uint64_t val) {
+  while (val >= 0x80) {
+    out.push_back((char)(val | 0x80));
+    val >>= 7;
+  }
+  out.push_back((char)val);
+}
+
+/** Decode an unsigned LEB128 varint, advancing \a p. Returns false if truncated. */
+inline bool GetVarint(const char *&p, const char *end, uint64_t &val) {
+  val = 0;
+  for (int shift = 0; p < end && shift < 64; shift += 7) {
+    uint8_t byte = (uint8_t)*p++;
+    val |= (uint64_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/** Map signed deltas onto small unsigned varints */
+inline uint64_t ZigZag(int64_t val) {
+  return ((uint64_t)val << 1) ^ (uint64_t)(val >> 63);
+}
+
+inline int64_t UnZigZag(uint64_t val) {
+  return (int64_t)(val >> 1) ^ -(int64_t)(val & 1);
+}
+
+/** Append a little-endian fixed-width integer */
+template<typename T>
+inline void PutFixed(std::vector<char> &out, T val) {
+  size_t off = out.size();
+  out.resize(off + sizeof(T));
+  memcpy(out.data() + off, &val, sizeof(T));
+}
+
+/** Decode a fixed-width integer, advancing \a p. Returns false if truncated. */
+template<typename T>
+inline bool GetFixed(const char *&p, const char *end, T &val) {
+  if (end - p < (ptrdiff_t)sizeof(T)) {
+    return false;
+  }
+  memcpy(&val, p, sizeof(T));
+  p += sizeof(T);
+  return true;
+}
+
+/**
+ * Compress one chunk into a self-describing frame (ChunkHeader + payload).
+ * The \a shuffle pre-filter runs first with the datatype size
+ * \a elmt_size as its stride. Chunks that do not shrink are stored raw
+ * so reads never pay for a useless decode. \a policy is only consulted
+ * for kCompressAuto.
+ */
+inline void compress(int method, int shuffle, const void *input, size_t size, size_t elmt_size,
+                     std::vector<char> &output, const AdaptivePolicy *policy = nullptr) {
+  static thread_local std::vector<char> shuffled;
+  const char *in = (const char*)input;
+  ChunkHeader hdr{};
+  hdr.raw_size_ = (uint32_t)size;
+  if (shuffle == kShuffleAuto) {
+    shuffle = elmt_size > 1 ? kShuffleByte : kShuffleNone;
+  }
+  if (elmt_size == 0 || elmt_size > UINT8_MAX || (shuffle == kShuffleByte && elmt_size == 1)) {
+    shuffle = kShuffleNone;
+  }
+  if (shuffle != kShuffleNone) {
+    shuffled.resize(size);
+    if (shuffle == kShuffleBit) {
+      BitShuffle(in, shuffled.data(), size, elmt_size);
+    } else {
+      ByteShuffle(in, shuffled.data(), size, elmt_size);
+    }
+    in = shuffled.data();
+  }
+  if (method == kCompressAuto) {
+    method = policy ? SelectMethod(in, size, *policy) : kCompressRle;
+  }
+  if (method == kCompressLossy) {
+    /* Data that cannot be quantized is compressed losslessly */
+    method = kCompressZstd;
+  }
+  method = ResolveMethod(method);
+  Codec *codec = GetCodec(method);
+  if (codec) {
+    output.resize(sizeof(ChunkHeader) + codec->Bound(size));
+    size_t payload = codec->Compress(in, size, output.data() + sizeof(ChunkHeader),
+                                     output.size() - sizeof(ChunkHeader));
+    if (payload > 0 && payload < size) {
+      hdr.codec_ = (uint8_t)method;
+      hdr.shuffle_ = (uint8_t)shuffle;
+      hdr.elmt_size_ = (uint8_t)elmt_size;
+      hdr.payload_size_ = (uint32_t)payload;
+      output.resize(sizeof(ChunkHeader) + payload);
+      memcpy(output.data(), &hdr, sizeof(ChunkHeader));
+      return;
+    }
+  }
+  hdr.codec_ = kCompressNone;
+  hdr.shuffle_ = kShuffleNone;
+  hdr.elmt_size_ = 1;
+  hdr.payload_size_ = (uint32_t)size;
+  output.resize(sizeof(ChunkHeader) + size);
+  memcpy(output.data(), &hdr, sizeof(ChunkHeader));
+  memcpy(output.data() + sizeof(ChunkHeader), input, size);
+}
+
+/** Prefix of a kCompressLossy payload, followed by a nested lossless frame */
+struct LossyHeader {
+  double bound_;        /**< Requested bound, interpreted per mode_ */
+  double abs_bound_;    /**< Absolute bound this chunk was encoded with */
+  uint32_t nelmts_;     /**< Number of values */
+  uint32_t codes_size_; /**< Bytes of quantization codes; outliers follow */
+  uint8_t mode_;        /**< ErrorMode */
+  uint8_t reserved_[7]; /**< Must be zero */
+};
+
+/** Quantization codes larger than this are stored as outliers */
+static const double kMaxQuant = (double)(1 << 30);
+
+/**
+ * Reconstruct a value from its prediction and quantization code. The
+ * encoder and decoder must round identically, so this uses an explicit
+ * fma rather than leave contraction up to the compiler.
+ */
+template<typename T>
+inline T Dequantize(T pred, double q, double step) {
+  return (T)std::fma(q, step, (double)pred);
+}
+
+/**
+ * Quantize values against a 1-D Lorenzo prediction (the previous
+ * reconstructed value). Each value becomes varint(zigzag(q) + 1); values
+ * that cannot be reconstructed within \a eb become a 0 code and are
+ * stored verbatim after the codes.
+ */
+template<typename T>
+inline size_t Quantize(const T *in, size_t nelmts, double eb, std::vector<char> &stream) {
+  static thread_local std::vector<char> outliers;
+  double step = 2 * eb;
+  T pred = 0;
+  outliers.clear();
+  for (size_t i = 0; i < nelmts; ++i) {
+    T x = in[i];
+    if (std::isfinite(x)) {
+      double q = std::nearbyint(((double)x - (double)pred) / step);
+      if (std::fabs(q) < kMaxQuant) {
+        T r = Dequantize(pred, q, step);
+        if (std::fabs((double)x - (double)r) <= eb) {
+          PutVarint(stream, ZigZag((int64_t)q) + 1);
+          pred = r;
+          continue;
+        }
+      }
+    }
+    stream.push_back(0);
+    PutFixed<T>(outliers, x);
+    pred = x;
+  }
+  size_t codes_size = stream.size();
+  stream.insert(stream.end(), outliers.begin(), outliers.end());
+  return codes_size;
+}
+
+/** Inverse of Quantize. Returns false if the stream is corrupt. */
+template<typename T>
+inline bool Unquantize(const char *codes, size_t codes_size, const char *outliers, const char *end,
+                       size_t nelmts, double eb, T *out) {
+  const char *codes_end = codes + codes_size;
+  double step = 2 * eb;
+  T pred = 0;
+  for (size_t i = 0; i < nelmts; ++i) {
+    uint64_t sym;
+    if (!GetVarint(codes, codes_end, sym)) {
+      return false;
+    }
+    if (sym == 0) {
+      if (!GetFixed(outliers, end, pred)) {
+        return false;
+      }
+    } else {
+      pred = Dequantize(pred, (double)UnZigZag(sym - 1), step);
+    }
+    memcpy(out + i, &pred, sizeof(T));
+  }
+  return true;
+}
+
+/** Absolute bound for a chunk, or 0 if the chunk cannot use one */
+template<typename T>
+inline double AbsBound(const T *in, size_t nelmts, int mode, double bound) {
+  if (mode == kErrorAbs) {
+    return bound;
+  }
+  double lo = INFINITY, hi = -INFINITY;
+  for (size_t i = 0; i < nelmts; ++i) {
+    if (std::isfinite(in[i])) {
+      lo = std::min(lo, (double)in[i]);
+      hi = std::max(hi, (double)in[i]);
+    }
+  }
+  return hi > lo ? bound * (hi - lo) : 0;
+}
+
+/**
+ * Compress a chunk of native float (\a elmt_size 4) or double (8)
+ * values within an error bound. The quantization codes and outliers are
+ * entropy coded by the strong lossless codec. Chunks that get no bound
+ * (e.g., constant under kErrorRel) or do not shrink are compressed
+ * losslessly instead.
+ */
+inline void compress_lossy(int mode, double bound, const void *input, size_t size, size_t elmt_size,
+                           std::vector<char> &output) {
+  static thread_local std::vector<char> stream, nested;
+  size_t nelmts = size / elmt_size;
+  LossyHeader lh{};
+  ChunkHeader hdr{};
+  if ((elmt_size != sizeof(float) && elmt_size != sizeof(double)) || size % elmt_size || size > UINT32_MAX) {
+    compress(kCompressLossy, kShuffleAuto, input, size, elmt_size, output);
+    return;
+  }
+  lh.abs_bound_ = elmt_size == sizeof(float) ? AbsBound((const float*)input, nelmts, mode, bound)
+                                             : AbsBound((const double*)input, nelmts, mode, bound);
+  if (!(lh.abs_bound_ > 0) || !std::isfinite(lh.abs_bound_)) {
+    compress(kCompressLossy, kShuffleAuto, input, size, elmt_size, output);
+    return;
+  }
+  stream.clear();
+  lh.codes_size_ = (uint32_t)(elmt_size == sizeof(float)
+      ? Quantize((const float*)input, nelmts, lh.abs_bound_, stream)
+      : Quantize((const double*)input, nelmts, lh.abs_bound_, stream));
+  lh.bound_ = bound;
+  lh.nelmts_ = (uint32_t)nelmts;
+  lh.mode_ = (uint8_t)mode;
+  compress(kCompressZstd, kShuffleNone, stream.data(), stream.size(), 1, nested);
+  if (sizeof(LossyHeader) + nested.size() >= size) {
+    compress(kCompressLossy, kShuffleAuto, input, size, elmt_size, output);
+    return;
+  }
+  hdr.codec_ = kCompressLossy;
+  hdr.elmt_size_ = (uint8_t)elmt_size;
+  hdr.payload_size_ = (uint32_t)(sizeof(LossyHeader) + nested.size());
+  hdr.raw_size_ = (uint32_t)size;
+  output.resize(sizeof(ChunkHeader) + hdr.payload_size_);
+  memcpy(output.data(), &hdr, sizeof(ChunkHeader));
+  memcpy(output.data() + sizeof(ChunkHeader), &lh, sizeof(LossyHeader));
+  memcpy(output.data() + sizeof(ChunkHeader) + sizeof(LossyHeader), nested.data(), nested.size());
+}
+
+/**
+ * Check that a frame honors a reader's error bound. Lossless frames
+ * always do. Under kErrorRel the frame must have been written with a
+ * relative bound no looser than \a bound; under kErrorAbs its absolute
+ * bound is compared. A \a bound of 0 means the reader did not opt into
+ * lossy data, so every lossy frame is refused.
+ */
+inline bool WithinBound(const void *input, size_t size, int mode, double bound) {
+  ChunkHeader hdr;
+  LossyHeader lh;
+  if (size < sizeof(ChunkHeader)) { return true; }
+  memcpy(&hdr, input, sizeof(ChunkHeader));
+  if (hdr.codec_ != kCompressLossy) { return true; }
+  if (bound <= 0 || size < sizeof(ChunkHeader) + sizeof(LossyHeader)) { return false; }
+  memcpy(&lh, (const char*)input + sizeof(ChunkHeader), sizeof(LossyHeader));
+  if (mode == kErrorRel) {
+    return lh.mode_ == kErrorRel && lh.bound_ <= bound;
+  }
+  return lh.abs_bound_ <= bound;
+}
+
+/**
+ * The bound a lossy frame was written with: its ErrorMode, the bound as
+ * requested and the absolute bound it amounts to. Returns false for
+ * lossless or truncated frames.
+ */
+inline bool FrameBound(const void *input, size_t size, int *mode, double *bound, double *abs_bound) {
+  ChunkHeader hdr;
+  LossyHeader lh;
+  if (size < sizeof(ChunkHeader) + sizeof(LossyHeader)) { return false; }
+  memcpy(&hdr, input, sizeof(ChunkHeader));
+  if (hdr.codec_ != kCompressLossy) { return false; }
+  memcpy(&lh, (const char*)input + sizeof(ChunkHeader), sizeof(LossyHeader));
+  *mode = lh.mode_;
+  *bound = lh.bound_;
+  *abs_bound = lh.abs_bound_;
+  return true;
+}
+
+/**
+ * If a frame was stored raw, return its payload so readers can copy out
+ * of it directly. Returns nullptr for frames that need decoding.
+ */
+inline const char* RawPayload(const void *input, size_t size) {
+  ChunkHeader hdr;
+  if (size < sizeof(ChunkHeader)) { return nullptr; }
+  memcpy(&hdr, input, sizeof(ChunkHeader));
+  if (hdr.codec_ != kCompressNone || hdr.payload_size_ != hdr.raw_size_ ||
+      sizeof(ChunkHeader) + hdr.payload_size_ > size) {
+    return nullptr;
+  }
+  return (const char*)input + sizeof(ChunkHeader);
+}
+
+inline bool decompress_lossy(const ChunkHeader &hdr, const char *payload, std::vector<char> &output);
+
+/**
+ * Decompress a frame produced by compress() or compress_lossy(). \a output is resized to the
+ * raw chunk size. Returns false if the frame is truncated or corrupt.
+ */
+inline bool decompress(const void *input, size_t size, std::vector<char> &output) {
+  static thread_local std::vector<char> shuffled;
+  ChunkHeader hdr;
+  if (size < sizeof(ChunkHeader)) { return false; }
+  memcpy(&hdr, input, sizeof(ChunkHeader));
+  if (sizeof(ChunkHeader) + hdr.payload_size_ > size) { return false; }
+  const char *payload = (const char*)input + sizeof(ChunkHeader);
+  output.resize(hdr.raw_size_);
+  if (hdr.codec_ == kCompressNone) {
+    if (hdr.payload_size_ != hdr.raw_size_) { return false; }
+    memcpy(output.data(), payload, hdr.raw_size_);
+    return true;
+  }
+  if (hdr.codec_ == kCompressLossy) {
+    return decompress_lossy(hdr, payload, output);
+  }
+  Codec *codec = GetCodec(hdr.codec_);
+  if (!codec || hdr.elmt_size_ == 0) { return false; }
+  char *out = output.data();
+  if (hdr.shuffle_ != kShuffleNone) {
+    shuffled.resize(hdr.raw_size_);
+    out = shuffled.data();
+  }
+  if (!codec->Decompress(payload, hdr.payload_size_, out, hdr.raw_size_)) {
+    return false;
+  }
+  switch (hdr.shuffle_) {
+    case kShuffleNone: break;
+    case kShuffleByte: ByteUnshuffle(out, output.data(), hdr.raw_size_, hdr.elmt_size_); break;
+    case kShuffleBit: BitUnshuffle(out, output.data(), hdr.raw_size_, hdr.elmt_size_); break;
+    default: return false;
+  }
+  return true;
+}
+
+/** Decode the payload of a kCompressLossy frame into \a output */
+inline bool decompress_lossy(const ChunkHeader &hdr, const char *payload, std::vector<char> &output) {
+  static thread_local std::vector<char> stream;
+  LossyHeader lh;
+  if (hdr.payload_size_ < sizeof(LossyHeader)) { return false; }
+  memcpy(&lh, payload, sizeof(LossyHeader));
+  if ((size_t)lh.nelmts_ * hdr.elmt_size_ != hdr.raw_size_ ||
+      !decompress(payload + sizeof(LossyHeader), hdr.payload_size_ - sizeof(LossyHeader), stream) ||
+      lh.codes_size_ > stream.size()) {
+    return false;
+  }
+  const char *codes = stream.data(), *end = codes + stream.size();
+  switch (hdr.elmt_size_) {
+    case sizeof(float):
+      return Unquantize(codes, lh.codes_size_, codes + lh.codes_size_, end, lh.nelmts_, lh.abs_bound_,
+                        (float*)output.data());
+    case sizeof(double):
+      return Unquantize(codes, lh.codes_size_, codes + lh.codes_size_, end, lh.nelmts_, lh.abs_bound_,
+                        (double*)output.data());
+    default:
+      return false;
+  }
+}
+
+}
+
+#endif //HDF5_VOLS__COMPRESS_HELPERS_H_
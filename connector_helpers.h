@@ -5,7 +5,15 @@
 #ifndef HDF5_VOLS__CONNECTOR_HELPERS_H_
 #define HDF5_VOLS__CONNECTOR_HELPERS_H_
 
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 #include <list>
 #include <sstream>
@@ -42,10 +50,51 @@ class ParseConn {
     return "";
   }
 
+  /** Get a "key=value" parameter of this VOL (the first group) */
+  std::string GetParam(const std::string &key, const std::string &dflt = "") {
+    if (tree_.empty()) {
+      return dflt;
+    }
+    for (std::string &param : tree_.front()) {
+      size_t eq = param.find('=');
+      if (eq != std::string::npos && param.compare(0, eq, key) == 0 && eq == key.size()) {
+        return param.substr(eq + 1);
+      }
+    }
+    return dflt;
+  }
+
+  /**
+   * Split a connector string of the form "params;stack0|stack1|..." into
+   * this VOL's params and one "vol:params;vol:params;..." string per
+   * target. Used by connectors that fan out to several under VOLs.
+   */
+  static void SplitTargets(const std::string &str, std::string &params,
+                           std::vector<std::string> &targets) {
+    size_t semi = str.find(';');
+    params = str.substr(0, semi);
+    if (semi == std::string::npos) {
+      return;
+    }
+    std::stringstream ss(str.substr(semi + 1));
+    std::string target;
+    while (std::getline(ss, target, '|')) {
+      if (!target.empty()) {
+        targets.push_back(target);
+      }
+    }
+  }
+
   std::string GetNextVolParams() {
     std::stringstream ss;
+    if (tree_.size() < 2) {
+      return "";
+    }
+    for (size_t i = 1; i < tree_[1].size(); ++i) {
+      ss << tree_[1][i] << (i + 1 < tree_[1].size() ? ":" : "");
+    }
     if (tree_[1].size() >= 2) {
-      ss << tree_[1][1] << ";";
+      ss << ";";
     }
     for (size_t i = 2; i < tree_.size(); ++i) {
       for (std::string &name_param : tree_[i]) {
@@ -57,12 +106,111 @@ class ParseConn {
   }
 };
 
-inline void compress(void *input, size_t size, void **output) {
-  (void) input; (void) size; (void) output;
-}
+/** Fixed-size pool of worker threads draining a FIFO of tasks */
+class ThreadPool {
+ public:
+  std::vector<std::thread> workers_;
+  std::deque<std::function<void()>> tasks_;
+  std::mutex lock_;
+  std::condition_variable cv_;
+  bool stop_ = false;
+
+ public:
+  explicit ThreadPool(size_t nthreads) {
+    for (size_t i = 0; i < nthreads; ++i) {
+      workers_.emplace_back([this]() { Run(); });
+    }
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> guard(lock_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    for (std::thread &worker : workers_) {
+      worker.join();
+    }
+  }
 
-inline void decompress(void *input, size_t size, void **output) {
-  (void) input; (void) size; (void) output;
+  size_t Size() const {
+    return workers_.size();
+  }
+
+  /** Queue a task. The future becomes ready once the task has run. */
+  template<typename F>
+  std::future<void> Submit(F &&fn) {
+    auto task = std::make_shared<std::packaged_task<void()>>(std::forward<F>(fn));
+    std::future<void> done = task->get_future();
+    {
+      std::lock_guard<std::mutex> guard(lock_);
+      tasks_.emplace_back([task]() { (*task)(); });
+    }
+    cv_.notify_one();
+    return done;
+  }
+
+ private:
+  void Run() {
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> guard(lock_);
+        cv_.wait(guard, [this]() { return stop_ || !tasks_.empty(); });
+        if (tasks_.empty()) {
+          return;
+        }
+        task = std::move(tasks_.front());
+        tasks_.pop_front();
+      }
+      task();
+    }
+  }
+};
+
+/**
+ * Array of \a n entries held inline when n <= N, so the common small
+ * multi-dataset calls unwrap their objects without touching the heap.
+ */
+template<typename T, size_t N>
+class SmallArray {
+ public:
+  T local_[N];
+  std::unique_ptr<T[]> heap_;
+  T *data_;
+
+ public:
+  explicit SmallArray(size_t n) : data_(local_) {
+    if (n > N) {
+      heap_.reset(new T[n]);
+      data_ = heap_.get();
+    }
+  }
+
+  SmallArray(const SmallArray &) = delete;
+  SmallArray &operator=(const SmallArray &) = delete;
+
+  T *data() {
+    return data_;
+  }
+
+  T &operator[](size_t i) {
+    return data_[i];
+  }
+};
+
+/** Parse a byte count with an optional k/m/g suffix (e.g., "4m"). Returns 0 if malformed. */
+inline size_t ParseSize(const std::string &str) {
+  char *end;
+  size_t size = strtoull(str.c_str(), &end, 10);
+  switch (*end) {
+    case '\0': break;
+    case 'k': case 'K': size <<= 10; break;
+    case 'm': case 'M': size <<= 20; break;
+    case 'g': case 'G': size <<= 30; break;
+    default: return 0;
+  }
+  return size;
 }
 
 }
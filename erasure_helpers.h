@@ -0,0 +1,216 @@
+//
+// Reed-Solomon erasure coding over GF(2^8) used by replicate_vol.
+//
+
+#ifndef HDF5_VOLS__ERASURE_HELPERS_H_
+#define HDF5_VOLS__ERASURE_HELPERS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace h5 {
+
+/** Arithmetic in GF(2^8) with the polynomial x^8 + x^4 + x^3 + x^2 + 1 */
+class Gf256 {
+ public:
+  uint8_t exp_[512];   /**< exp_[i] = g^i, doubled to skip a modulo */
+  uint8_t log_[256];   /**< log_[x] for x != 0 */
+
+ public:
+  Gf256() {
+    unsigned x = 1;
+    for (int i = 0; i < 255; ++i) {
+      exp_[i] = exp_[i + 255] = (uint8_t)x;
+      log_[x] = (uint8_t)i;
+      x <<= 1;
+      if (x & 0x100) { x ^= 0x11d; }
+    }
+    exp_[510] = exp_[511] = exp_[0];
+    log_[0] = 0;
+  }
+
+  /** The shared instance */
+  static const Gf256& Get() {
+    static const Gf256 gf;
+    return gf;
+  }
+
+  uint8_t Mul(uint8_t a, uint8_t b) const {
+    if (a == 0 || b == 0) { return 0; }
+    return exp_[log_[a] + log_[b]];
+  }
+
+  uint8_t Inv(uint8_t a) const {
+    return exp_[255 - log_[a]];
+  }
+};
+
+/** dst ^= c * src over \a n bytes */
+inline void GfMulAdd(uint8_t c, const uint8_t *src, uint8_t *dst, size_t n) {
+  const Gf256 &gf = Gf256::Get();
+  size_t i = 0;
+  if (c == 0) {
+    return;
+  }
+#if defined(__SSSE3__)
+  /* Split each byte into nibbles and look both up with PSHUFB */
+  alignas(16) uint8_t lo[16], hi[16];
+  for (int x = 0; x < 16; ++x) {
+    lo[x] = gf.Mul(c, (uint8_t)x);
+    hi[x] = gf.Mul(c, (uint8_t)(x << 4));
+  }
+  const __m128i tlo = _mm_load_si128((const __m128i*)lo);
+  const __m128i thi = _mm_load_si128((const __m128i*)hi);
+  const __m128i mask = _mm_set1_epi8(0x0f);
+#if defined(__AVX2__)
+  const __m256i tlo2 = _mm256_broadcastsi128_si256(tlo);
+  const __m256i thi2 = _mm256_broadcastsi128_si256(thi);
+  const __m256i mask2 = _mm256_set1_epi8(0x0f);
+  for (; i + 32 <= n; i += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)(src + i));
+    __m256i p = _mm256_xor_si256(_mm256_shuffle_epi8(tlo2, _mm256_and_si256(v, mask2)),
+                                 _mm256_shuffle_epi8(thi2, _mm256_and_si256(_mm256_srli_epi64(v, 4), mask2)));
+    __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+    _mm256_storeu_si256((__m256i*)(dst + i), _mm256_xor_si256(d, p));
+  }
+#endif
+  for (; i + 16 <= n; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+    __m128i p = _mm_xor_si128(_mm_shuffle_epi8(tlo, _mm_and_si128(v, mask)),
+                              _mm_shuffle_epi8(thi, _mm_and_si128(_mm_srli_epi64(v, 4), mask)));
+    __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+    _mm_storeu_si128((__m128i*)(dst + i), _mm_xor_si128(d, p));
+  }
+#endif
+  if (i < n) {
+    uint8_t lc = gf.log_[c];
+    for (; i < n; ++i) {
+      if (src[i]) {
+        dst[i] ^= gf.exp_[lc + gf.log_[src[i]]];
+      }
+    }
+  }
+}
+
+/**
+ * Systematic Reed-Solomon code with \a k data and \a m parity shards.
+ * The parity rows form a Cauchy matrix, so any k of the k + m shards
+ * recover the data.
+ */
+class ReedSolomon {
+ public:
+  size_t k_, m_;
+  std::vector<uint8_t> parity_;   /**< m x k coefficient matrix */
+
+ public:
+  ReedSolomon(size_t k, size_t m) : k_(k), m_(m), parity_(k * m) {
+    const Gf256 &gf = Gf256::Get();
+    for (size_t p = 0; p < m; ++p) {
+      for (size_t j = 0; j < k; ++j) {
+        parity_[p * k + j] = gf.Inv((uint8_t)((k + p) ^ j));
+      }
+    }
+  }
+
+  /** Row \a i of the (k + m) x k generator matrix */
+  void GetRow(size_t i, uint8_t *row) const {
+    if (i < k_) {
+      memset(row, 0, k_);
+      row[i] = 1;
+    } else {
+      memcpy(row, &parity_[(i - k_) * k_], k_);
+    }
+  }
+
+  /** Compute the m parity shards of \a n bytes from the k data shards */
+  void Encode(const uint8_t *const *data, uint8_t *const *parity, size_t n) const {
+    for (size_t p = 0; p < m_; ++p) {
+      memset(parity[p], 0, n);
+      for (size_t j = 0; j < k_; ++j) {
+        GfMulAdd(parity_[p * k_ + j], data[j], parity[p], n);
+      }
+    }
+  }
+
+  /**
+   * Rebuild the missing data shards. \a shards holds k + m pointers, with
+   * nullptr for shards that were not read; at least k must be present.
+   * \a out receives k data shard pointers (present data shards point
+   * into \a shards, rebuilt ones into \a scratch).
+   */
+  bool Decode(const std::vector<const uint8_t*> &shards, size_t n, std::vector<const uint8_t*> &out,
+              std::vector<std::vector<uint8_t>> &scratch) const {
+    const Gf256 &gf = Gf256::Get();
+    std::vector<size_t> rows;
+    bool missing = false;
+    out.assign(k_, nullptr);
+    for (size_t j = 0; j < k_; ++j) {
+      out[j] = shards[j];
+      missing = missing || shards[j] == nullptr;
+    }
+    if (!missing) {
+      return true;
+    }
+    for (size_t i = 0; i < k_ + m_ && rows.size() < k_; ++i) {
+      if (shards[i]) { rows.push_back(i); }
+    }
+    if (rows.size() < k_) {
+      return false;
+    }
+
+    /* Invert the k x k matrix of the surviving rows (Gauss-Jordan) */
+    std::vector<uint8_t> a(k_ * k_), inv(k_ * k_, 0);
+    for (size_t r = 0; r < k_; ++r) {
+      GetRow(rows[r], &a[r * k_]);
+      inv[r * k_ + r] = 1;
+    }
+    for (size_t c = 0; c < k_; ++c) {
+      size_t piv = c;
+      while (piv < k_ && a[piv * k_ + c] == 0) { ++piv; }
+      if (piv == k_) { return false; }
+      if (piv != c) {
+        for (size_t x = 0; x < k_; ++x) {
+          std::swap(a[piv * k_ + x], a[c * k_ + x]);
+          std::swap(inv[piv * k_ + x], inv[c * k_ + x]);
+        }
+      }
+      uint8_t s = gf.Inv(a[c * k_ + c]);
+      for (size_t x = 0; x < k_; ++x) {
+        a[c * k_ + x] = gf.Mul(a[c * k_ + x], s);
+        inv[c * k_ + x] = gf.Mul(inv[c * k_ + x], s);
+      }
+      for (size_t r = 0; r < k_; ++r) {
+        uint8_t f = a[r * k_ + c];
+        if (r == c || f == 0) { continue; }
+        for (size_t x = 0; x < k_; ++x) {
+          a[r * k_ + x] ^= gf.Mul(f, a[c * k_ + x]);
+          inv[r * k_ + x] ^= gf.Mul(f, inv[c * k_ + x]);
+        }
+      }
+    }
+
+    /* Data shard j = row j of the inverse times the surviving shards */
+    scratch.resize(k_);
+    for (size_t j = 0; j < k_; ++j) {
+      if (shards[j]) { continue; }
+      scratch[j].assign(n, 0);
+      for (size_t r = 0; r < k_; ++r) {
+        GfMulAdd(inv[j * k_ + r], shards[rows[r]], scratch[j].data(), n);
+      }
+      out[j] = scratch[j].data();
+    }
+    return true;
+  }
+};
+
+}
+
+#endif //HDF5_VOLS__ERASURE_HELPERS_H_
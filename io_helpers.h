@@ -0,0 +1,614 @@
+//
+// Positioned file I/O used by pfs_vol.
+//
+
+#ifndef HDF5_VOLS__IO_HELPERS_H_
+#define HDF5_VOLS__IO_HELPERS_H_
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <sys/types.h>
+#ifdef HDF5_VOLS_ENABLE_LIBAIO
+#include <libaio.h>
+#endif
+#ifdef HDF5_VOLS_ENABLE_URING
+#include <liburing.h>
+#endif
+#ifdef HDF5_VOLS_ENABLE_LUSTRE
+#include <lustre/lustreapi.h>
+#endif
+
+namespace h5 {
+
+/** One positioned read or write */
+struct IoOp {
+  int fd_;          /**< File descriptor */
+  bool write_;      /**< Write (true) or read (false) */
+  void *buf_;       /**< Source or destination */
+  size_t size_;     /**< Bytes to transfer */
+  uint64_t off_;    /**< File offset */
+  ssize_t ret_;     /**< Bytes transferred, or -errno */
+  int dfd_ = -1;    /**< O_DIRECT descriptor of the same file, or -1 */
+};
+
+/** I/O engines */
+enum IoEngineKind : int {
+  kIoPosix = 0,   /**< Synchronous pread/pwrite */
+  kIoAio = 1,     /**< Linux native AIO (libaio) with O_DIRECT */
+  kIoUring = 2,   /**< io_uring (liburing) with registered buffers and files */
+};
+
+inline int ParseIoEngine(const std::string &name) {
+  if (name == "posix") { return kIoPosix; }
+#ifdef HDF5_VOLS_ENABLE_LIBAIO
+  if (name == "aio") { return kIoAio; }
+#endif
+#ifdef HDF5_VOLS_ENABLE_URING
+  if (name == "uring") { return kIoUring; }
+#endif
+  return -1;
+}
+
+/**
+ * Runs batches of positioned I/O. Reads past the end of a file yield
+ * zeros, so never-written regions of sparse files read back as 0.
+ */
+class IoEngine {
+ public:
+  virtual ~IoEngine() = default;
+
+  /** Run \a n operations to completion. Returns 0 if every one succeeded. */
+  virtual int Submit(IoOp *ops, size_t n) = 0;
+
+  /**
+   * Alignment of O_DIRECT transfers, or 0 if the engine does not use
+   * O_DIRECT. Callers that get a nonzero value should open files a second
+   * time with O_DIRECT (IoOp::dfd_) and keep separately written regions
+   * on distinct aligned blocks.
+   */
+  virtual size_t Alignment() const { return 0; }
+
+  /** Forget \a fd; called before a descriptor used with the engine is closed */
+  virtual void Release(int /*fd*/) {}
+};
+
+/** Synchronous pread/pwrite */
+class PosixIoEngine : public IoEngine {
+ public:
+  int Submit(IoOp *ops, size_t n) override {
+    int ret = 0;
+    for (size_t i = 0; i < n; ++i) {
+      if (Run(ops[i]) < 0) {
+        ret = -1;
+      }
+    }
+    return ret;
+  }
+
+  /** Transfer all of \a op, retrying short transfers */
+  static ssize_t Run(IoOp &op) {
+    size_t done = 0;
+    char *buf = (char*)op.buf_;
+    while (done < op.size_) {
+      ssize_t ret = op.write_ ? pwrite(op.fd_, buf + done, op.size_ - done, op.off_ + done)
+                              : pread(op.fd_, buf + done, op.size_ - done, op.off_ + done);
+      if (ret < 0 && errno == EINTR) {
+        continue;
+      }
+      if (ret < 0) {
+        op.ret_ = -errno;
+        return op.ret_;
+      }
+      if (ret == 0) {
+        if (op.write_) {
+          op.ret_ = -EIO;
+          return op.ret_;
+        }
+        memset(buf + done, 0, op.size_ - done);
+        break;
+      }
+      done += ret;
+    }
+    op.ret_ = (ssize_t)op.size_;
+    return op.ret_;
+  }
+};
+
+
+#ifdef HDF5_VOLS_ENABLE_LIBAIO
+/**
+ * Linux native AIO keeping up to \a depth operations in flight. Aligned
+ * operations go straight to the O_DIRECT descriptor. Unaligned reads go
+ * through an aligned bounce buffer; unaligned writes would need a
+ * read-modify-write of the edge blocks, so they use buffered pwrite on
+ * fd_ instead. Operations without an O_DIRECT descriptor are submitted
+ * on fd_ as they are. Each Submit borrows a kernel context of its own,
+ * so batches from several threads are in flight together.
+ */
+class AioIoEngine : public IoEngine {
+ public:
+  static const size_t kAlign = 4096;
+
+  /** One submitted operation */
+  struct Slot {
+    IoOp *op_;
+    struct iocb cb_;
+    char *bounce_ = nullptr;   /**< Aligned staging, or nullptr */
+    uint64_t bounce_off_ = 0;  /**< File offset of bounce_ */
+  };
+
+  size_t depth_;
+  std::mutex lock_;                  /**< Guards idle_ and all_ */
+  std::condition_variable idle_cv_;  /**< Signaled when a context is handed back */
+  std::vector<io_context_t> idle_;   /**< Contexts not used by a batch */
+  std::vector<io_context_t> all_;    /**< Every context created */
+
+ public:
+  explicit AioIoEngine(size_t depth) : depth_(depth) {}
+
+  ~AioIoEngine() override {
+    for (io_context_t ctx : all_) {
+      io_destroy(ctx);
+    }
+  }
+
+  /** Create the first kernel context. Returns 0 on success. */
+  int Init() {
+    io_context_t ctx = 0;
+    if (io_setup((int)depth_, &ctx) < 0) {
+      return -1;
+    }
+    all_.push_back(ctx);
+    idle_.push_back(ctx);
+    return 0;
+  }
+
+  size_t Alignment() const override { return kAlign; }
+
+  int Submit(IoOp *ops, size_t n) override {
+    io_context_t ctx = Acquire();
+    int ret = Run(ctx, ops, n);
+    {
+      std::lock_guard<std::mutex> guard(lock_);
+      idle_.push_back(ctx);
+    }
+    idle_cv_.notify_one();
+    return ret;
+  }
+
+ private:
+  /**
+   * An idle context, or a new one. If the kernel refuses another (its
+   * aio-max-nr limit), wait for a batch to hand one back.
+   */
+  io_context_t Acquire() {
+    std::unique_lock<std::mutex> guard(lock_);
+    io_context_t ctx = 0;
+    if (idle_.empty()) {
+      guard.unlock();
+      if (io_setup((int)depth_, &ctx) == 0) {
+        guard.lock();
+        all_.push_back(ctx);
+        return ctx;
+      }
+      guard.lock();
+      idle_cv_.wait(guard, [this]() { return !idle_.empty(); });
+    }
+    ctx = idle_.back();
+    idle_.pop_back();
+    return ctx;
+  }
+
+  int Run(io_context_t ctx, IoOp *ops, size_t n) {
+    std::vector<Slot> slots(n);
+    std::vector<struct iocb*> batch;
+    std::vector<struct io_event> events(depth_);
+    size_t next = 0, inflight = 0;
+    int ret = 0;
+    batch.reserve(depth_);
+
+    while (next < n || inflight) {
+      /* Top the queue up to depth_ */
+      batch.clear();
+      while (next < n && inflight + batch.size() < depth_) {
+        Slot &slot = slots[next];
+        slot.op_ = &ops[next++];
+        if (!Prepare(slot)) {
+          ret |= PosixIoEngine::Run(*slot.op_) < 0 ? -1 : 0;
+          continue;
+        }
+        batch.push_back(&slot.cb_);
+      }
+      if (!batch.empty()) {
+        int nsub = io_submit(ctx, (long)batch.size(), batch.data());
+        nsub = nsub < 0 ? 0 : nsub;
+        inflight += nsub;
+        for (size_t i = nsub; i < batch.size(); ++i) {
+          ret |= Finish(*(Slot*)batch[i]->data, 0);
+        }
+      }
+
+      /* Reap whatever has completed */
+      if (inflight) {
+        int nev = io_getevents(ctx, 1, (long)inflight, events.data(), nullptr);
+        if (nev == -EINTR) {
+          continue;
+        }
+        if (nev < 0) {
+          return -1;
+        }
+        for (int i = 0; i < nev; ++i) {
+          ret |= Finish(*(Slot*)events[i].data, (long)events[i].res);
+        }
+        inflight -= nev;
+      }
+    }
+    return ret;
+  }
+
+  static bool Aligned(uint64_t x) { return x % kAlign == 0; }
+
+  /** Fill in the iocb of \a slot. Returns false to run it synchronously. */
+  bool Prepare(Slot &slot) {
+    IoOp &op = *slot.op_;
+    slot.bounce_ = nullptr;
+    if (op.dfd_ < 0) {
+      if (op.write_) {
+        io_prep_pwrite(&slot.cb_, op.fd_, op.buf_, op.size_, (long long)op.off_);
+      } else {
+        io_prep_pread(&slot.cb_, op.fd_, op.buf_, op.size_, (long long)op.off_);
+      }
+    } else if (Aligned((uintptr_t)op.buf_) && Aligned(op.off_) && Aligned(op.size_)) {
+      if (op.write_) {
+        io_prep_pwrite(&slot.cb_, op.dfd_, op.buf_, op.size_, (long long)op.off_);
+      } else {
+        io_prep_pread(&slot.cb_, op.dfd_, op.buf_, op.size_, (long long)op.off_);
+      }
+    } else if (op.write_) {
+      if (!Aligned(op.off_) || !Aligned(op.size_)) {
+        return false;
+      }
+      slot.bounce_ = (char*)aligned_alloc(kAlign, op.size_);
+      if (slot.bounce_ == nullptr) {
+        return false;
+      }
+      slot.bounce_off_ = op.off_;
+      memcpy(slot.bounce_, op.buf_, op.size_);
+      io_prep_pwrite(&slot.cb_, op.dfd_, slot.bounce_, op.size_, (long long)op.off_);
+    } else {
+      uint64_t lo = op.off_ / kAlign * kAlign;
+      uint64_t hi = (op.off_ + op.size_ + kAlign - 1) / kAlign * kAlign;
+      slot.bounce_ = (char*)aligned_alloc(kAlign, hi - lo);
+      if (slot.bounce_ == nullptr) {
+        return false;
+      }
+      slot.bounce_off_ = lo;
+      io_prep_pread(&slot.cb_, op.dfd_, slot.bounce_, hi - lo, (long long)lo);
+    }
+    slot.cb_.data = &slot;
+    return true;
+  }
+
+  /**
+   * Complete \a slot given the kernel's result \a res. Short transfers
+   * (end of file, or a partial transfer) finish synchronously.
+   */
+  static int Finish(Slot &slot, long res) {
+    IoOp &op = *slot.op_;
+    size_t done = 0;
+    int ret = 0;
+    if (res < 0) {
+      op.ret_ = res;
+      ret = -1;
+    } else {
+      /* Bytes of the operation itself the kernel transferred */
+      uint64_t end = (slot.bounce_ ? slot.bounce_off_ : op.off_) + (uint64_t)res;
+      done = end > op.off_ ? std::min<uint64_t>(end - op.off_, op.size_) : 0;
+      if (slot.bounce_ && !op.write_) {
+        memcpy(op.buf_, slot.bounce_ + (op.off_ - slot.bounce_off_), done);
+      }
+      if (done < op.size_) {
+        IoOp rest{op.fd_, op.write_, (char*)op.buf_ + done, op.size_ - done, op.off_ + done, 0};
+        ret = PosixIoEngine::Run(rest) < 0 ? -1 : 0;
+        op.ret_ = ret < 0 ? rest.ret_ : (ssize_t)op.size_;
+      } else {
+        op.ret_ = (ssize_t)op.size_;
+      }
+    }
+    free(slot.bounce_);
+    slot.bounce_ = nullptr;
+    return ret;
+  }
+};
+#endif
+
+#ifdef HDF5_VOLS_ENABLE_URING
+/**
+ * io_uring keeping up to \a depth operations in flight. Descriptors are
+ * entered in a registered file table as they are first seen. Operations
+ * of up to kSlotSize bytes are staged in registered buffers (one slot
+ * per queue entry) and use the fixed read/write opcodes; larger ones
+ * transfer straight from the caller's buffer. Each batch of SQEs is
+ * submitted with a single system call, or none at all with SQPOLL.
+ */
+class UringIoEngine : public IoEngine {
+ public:
+  static const size_t kSlotSize = 64 * 1024;
+  static const unsigned kMaxFiles = 64;
+
+  /** One submitted operation */
+  struct Slot {
+    IoOp *op_;
+    int buf_;   /**< Registered buffer index, or -1 */
+  };
+
+  struct io_uring ring_;
+  bool init_ = false;
+  size_t depth_;
+  bool sqpoll_;
+  char *bufs_ = nullptr;            /**< depth_ registered buffers of kSlotSize */
+  std::vector<int> free_bufs_;      /**< Unused buffer indices */
+  std::vector<int> files_;          /**< Registered file table, -1 for free entries */
+  std::mutex lock_;                 /**< One batch at a time per ring */
+
+ public:
+  UringIoEngine(size_t depth, bool sqpoll) : depth_(depth), sqpoll_(sqpoll) {}
+
+  ~UringIoEngine() override {
+    if (init_) {
+      io_uring_queue_exit(&ring_);
+    }
+    free(bufs_);
+  }
+
+  /** Set up the ring and register its buffers and file table. Returns 0 on success. */
+  int Init() {
+    struct io_uring_params params;
+    std::vector<struct iovec> iov(depth_);
+    memset(&params, 0, sizeof(params));
+    if (sqpoll_) {
+      params.flags |= IORING_SETUP_SQPOLL;
+      params.sq_thread_idle = 100;
+    }
+    if (io_uring_queue_init_params((unsigned)depth_, &ring_, &params) < 0) {
+      return -1;
+    }
+    init_ = true;
+    bufs_ = (char*)aligned_alloc(4096, depth_ * kSlotSize);
+    if (bufs_ == nullptr) {
+      return -1;
+    }
+    for (size_t i = 0; i < depth_; ++i) {
+      iov[i].iov_base = bufs_ + i * kSlotSize;
+      iov[i].iov_len = kSlotSize;
+      free_bufs_.push_back((int)i);
+    }
+    files_.assign(kMaxFiles, -1);
+    if (io_uring_register_buffers(&ring_, iov.data(), (unsigned)depth_) < 0 ||
+        io_uring_register_files(&ring_, files_.data(), kMaxFiles) < 0) {
+      return -1;
+    }
+    return 0;
+  }
+
+  void Release(int fd) override {
+    std::lock_guard<std::mutex> guard(lock_);
+    for (unsigned i = 0; i < kMaxFiles; ++i) {
+      if (files_[i] == fd) {
+        files_[i] = -1;
+        io_uring_register_files_update(&ring_, i, &files_[i], 1);
+      }
+    }
+  }
+
+  int Submit(IoOp *ops, size_t n) override {
+    std::lock_guard<std::mutex> guard(lock_);
+    std::vector<Slot> slots(n);
+    size_t next = 0, inflight = 0;
+    int ret = 0;
+
+    while (next < n || inflight) {
+      /* Queue SQEs up to depth_ */
+      while (next < n && inflight < depth_) {
+        struct io_uring_sqe *sqe = io_uring_get_sqe(&ring_);
+        if (sqe == nullptr) {
+          break;
+        }
+        Slot &slot = slots[next];
+        slot.op_ = &ops[next++];
+        Prepare(slot, sqe);
+        ++inflight;
+      }
+
+      /* Submit the batch and reap what has completed */
+      int rc = io_uring_submit_and_wait(&ring_, 1);
+      if (rc == -EINTR) {
+        continue;
+      }
+      if (rc < 0) {
+        return -1;
+      }
+      struct io_uring_cqe *cqe;
+      while (inflight && io_uring_peek_cqe(&ring_, &cqe) == 0) {
+        Slot &slot = *(Slot*)io_uring_cqe_get_data(cqe);
+        int res = cqe->res;
+        io_uring_cqe_seen(&ring_, cqe);
+        ret |= Finish(slot, res);
+        --inflight;
+      }
+    }
+    return ret;
+  }
+
+ private:
+  /** Registered index of \a fd, entering it if there is room; -1 if not */
+  int FileIndex(int fd) {
+    int free_idx = -1;
+    for (unsigned i = 0; i < kMaxFiles; ++i) {
+      if (files_[i] == fd) {
+        return (int)i;
+      }
+      if (files_[i] < 0 && free_idx < 0) {
+        free_idx = (int)i;
+      }
+    }
+    if (free_idx < 0 || io_uring_register_files_update(&ring_, free_idx, &fd, 1) < 0) {
+      return -1;
+    }
+    files_[free_idx] = fd;
+    return free_idx;
+  }
+
+  void Prepare(Slot &slot, struct io_uring_sqe *sqe) {
+    IoOp &op = *slot.op_;
+    int idx = FileIndex(op.fd_);
+    int fd = idx >= 0 ? idx : op.fd_;
+    slot.buf_ = -1;
+    if (op.size_ <= kSlotSize && !free_bufs_.empty()) {
+      slot.buf_ = free_bufs_.back();
+      free_bufs_.pop_back();
+      char *buf = bufs_ + slot.buf_ * kSlotSize;
+      if (op.write_) {
+        memcpy(buf, op.buf_, op.size_);
+        io_uring_prep_write_fixed(sqe, fd, buf, (unsigned)op.size_, op.off_, slot.buf_);
+      } else {
+        io_uring_prep_read_fixed(sqe, fd, buf, (unsigned)op.size_, op.off_, slot.buf_);
+      }
+    } else if (op.write_) {
+      io_uring_prep_write(sqe, fd, op.buf_, (unsigned)op.size_, op.off_);
+    } else {
+      io_uring_prep_read(sqe, fd, op.buf_, (unsigned)op.size_, op.off_);
+    }
+    if (idx >= 0) {
+      io_uring_sqe_set_flags(sqe, IOSQE_FIXED_FILE);
+    }
+    io_uring_sqe_set_data(sqe, &slot);
+  }
+
+  /** Complete \a slot given the CQE result. Short transfers finish synchronously. */
+  int Finish(Slot &slot, int res) {
+    IoOp &op = *slot.op_;
+    int ret = 0;
+    if (res < 0) {
+      op.ret_ = res;
+      ret = -1;
+    } else {
+      size_t done = std::min<size_t>((size_t)res, op.size_);
+      if (slot.buf_ >= 0 && !op.write_) {
+        memcpy(op.buf_, bufs_ + slot.buf_ * kSlotSize, done);
+      }
+      if (done < op.size_) {
+        IoOp rest{op.fd_, op.write_, (char*)op.buf_ + done, op.size_ - done, op.off_ + done, 0};
+        ret = PosixIoEngine::Run(rest) < 0 ? -1 : 0;
+        op.ret_ = ret < 0 ? rest.ret_ : (ssize_t)op.size_;
+      } else {
+        op.ret_ = (ssize_t)op.size_;
+      }
+    }
+    if (slot.buf_ >= 0) {
+      free_bufs_.push_back(slot.buf_);
+    }
+    return ret;
+  }
+};
+#endif
+
+/**
+ * Create an engine of \a kind. An engine the kernel refuses to set up
+ * (no AIO contexts left, io_uring disabled) falls back to POSIX.
+ */
+inline std::unique_ptr<IoEngine> MakeIoEngine(int kind, size_t depth, bool sqpoll) {
+  (void)kind;
+  (void)depth;
+  (void)sqpoll;
+#ifdef HDF5_VOLS_ENABLE_LIBAIO
+  if (kind == kIoAio) {
+    std::unique_ptr<AioIoEngine> aio = std::make_unique<AioIoEngine>(depth);
+    if (aio->Init() == 0) {
+      return aio;
+    }
+  }
+#endif
+#ifdef HDF5_VOLS_ENABLE_URING
+  if (kind == kIoUring) {
+    std::unique_ptr<UringIoEngine> uring = std::make_unique<UringIoEngine>(depth, sqpoll);
+    if (uring->Init() == 0) {
+      return uring;
+    }
+  }
+#endif
+  return std::make_unique<PosixIoEngine>();
+}
+
+/**
+ * Placement of equal-sized extents (e.g., chunks) in a file, by slot
+ * number in file order. Extents are padded to a multiple of \a align.
+ * With a stripe size, an extent that fits in a stripe never straddles a
+ * stripe boundary, and larger ones are padded to whole stripes, so each
+ * extent touches as few stripes (and OSTs) as possible.
+ */
+class ExtentLayout {
+ public:
+  uint64_t size_;     /**< Bytes per extent, padded */
+  uint64_t period_;   /**< Bytes after which the layout repeats */
+  uint64_t per_;      /**< Extents per period */
+
+ public:
+  ExtentLayout(uint64_t bytes, uint64_t align, uint64_t stripe) {
+    align = std::max<uint64_t>(align, 1);
+    size_ = (std::max<uint64_t>(bytes, 1) + align - 1) / align * align;
+    stripe = (stripe + align - 1) / align * align;
+    if (stripe == 0) {
+      period_ = size_;
+    } else if (size_ <= stripe) {
+      period_ = stripe;
+    } else {
+      size_ = (size_ + stripe - 1) / stripe * stripe;
+      period_ = size_;
+    }
+    per_ = period_ / size_;
+  }
+
+  /** Offset of slot \a slot */
+  uint64_t Offset(uint64_t slot) const {
+    return slot / per_ * period_ + slot % per_ * size_;
+  }
+
+  /** The first slot at or after byte \a off */
+  uint64_t FirstSlot(uint64_t off) const {
+    uint64_t rem = off % period_;
+    return off / period_ * per_ + std::min(per_, (rem + size_ - 1) / size_);
+  }
+};
+
+/**
+ * Create \a path striped over \a stripe_count OSTs of \a stripe_size
+ * bytes (0 keeps the file system's default for either). Best effort:
+ * nothing happens if the file exists, the file system is not Lustre or
+ * the build has no lustreapi, since striping only affects performance.
+ */
+inline void CreateStriped(const std::string &path, size_t stripe_size, size_t stripe_count) {
+#ifdef HDF5_VOLS_ENABLE_LUSTRE
+  if (stripe_size || stripe_count) {
+    llapi_file_create(path.c_str(), stripe_size, -1, (int)stripe_count, 0);
+  }
+#else
+  (void)path;
+  (void)stripe_size;
+  (void)stripe_count;
+#endif
+}
+
+}
+
+#endif //HDF5_VOLS__IO_HELPERS_H_
@@ -0,0 +1,366 @@
+//
+// Persistent ordered key-value store used for pfs_vol metadata.
+//
+
+#ifndef HDF5_VOLS__KV_HELPERS_H_
+#define HDF5_VOLS__KV_HELPERS_H_
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "compress_helpers.h"
+
+namespace h5 {
+
+class KvStore;
+
+/**
+ * Mutations applied to a KvStore together. A later mutation of a key
+ * replaces an earlier one, and Get reads the batch over the store, so a
+ * batch can be built by read-modify-write steps.
+ */
+class KvBatch {
+ public:
+  struct Op {
+    bool del_;           /**< Delete (true) or put (false) */
+    std::string val_;    /**< Value of a put */
+  };
+
+  std::map<std::string, Op> ops_;
+
+ public:
+  void Put(const std::string &key, const std::string &val) { ops_[key] = Op{false, val}; }
+  void Delete(const std::string &key) { ops_[key] = Op{true, std::string()}; }
+  bool Empty() const { return ops_.empty(); }
+
+  /** The value of \a key once the batch is applied to \a store, or nullptr */
+  inline const std::string *Get(const KvStore &store, const std::string &key) const;
+};
+
+/**
+ * An ordered map of byte-string keys to values, kept in memory and made
+ * persistent by a snapshot file plus a write-ahead log. Every batch is
+ * appended to the log as one checksummed record before it is applied,
+ * so a batch survives a crash whole or not at all. Appends are buffered
+ * until Sync or kWalBuffer bytes. Checkpoint writes a new snapshot
+ * beside the old one, renames it over, then empties the log; replaying
+ * a log over a snapshot that already holds it yields the same map.
+ *
+ * A store opened without \a persist applies batches in memory only, for
+ * processes that follow a single writer.
+ */
+class KvStore {
+ public:
+  static const uint32_t kSnapMagic = 0x4b534650;  /**< "PFSK" */
+  static const uint32_t kWalMagic = 0x57534650;   /**< "PFSW" */
+  static const uint32_t kVersion = 1;
+  static const size_t kWalBuffer = 64 * 1024;     /**< Log bytes buffered before a write */
+
+  typedef std::map<std::string, std::string> Map;
+
+ private:
+  std::string db_;
+  std::string wal_;
+  bool persist_ = false;
+  int wal_fd_ = -1;
+  uint64_t wal_size_ = 0;      /**< Bytes in the log file, buffer included */
+  std::vector<char> buf_;      /**< Log records not yet written */
+  Map map_;
+
+ public:
+  ~KvStore() { Close(); }
+
+  /** Whether a store was ever written at \a db and \a wal */
+  static bool Present(const std::string &db, const std::string &wal) {
+    return access(db.c_str(), F_OK) == 0 || access(wal.c_str(), F_OK) == 0;
+  }
+
+  /**
+   * Load the store kept in the snapshot \a db and the log \a wal, either
+   * of which may be missing. A torn record at the end of the log, from a
+   * crash mid-append, is dropped. Returns 0 on success.
+   */
+  int Open(const std::string &db, const std::string &wal, bool persist) {
+    std::vector<char> data;
+    const char *p, *end;
+    uint64_t valid = 0;
+
+    db_ = db;
+    wal_ = wal;
+    persist_ = persist;
+    map_.clear();
+    if (ReadFile(db, data) == 0 && LoadSnapshot(data) < 0) {
+      return -1;
+    }
+
+    /* Replay the log up to its first bad record */
+    data.clear();
+    if (ReadFile(wal, data) < 0 && errno != ENOENT) {
+      return -1;
+    }
+    p = data.data();
+    end = p + data.size();
+    while (end - p >= 12) {
+      uint32_t magic = 0, len = 0, crc = 0;
+      const char *q = p;
+      GetFixed(q, end, magic);
+      GetFixed(q, end, len);
+      GetFixed(q, end, crc);
+      if (magic != kWalMagic || (uint64_t)(end - q) < len || Crc32c(q, len) != crc || Apply(q, q + len) < 0) {
+        break;
+      }
+      p = q + len;
+      valid = p - data.data();
+    }
+    if (!persist_) {
+      return 0;
+    }
+    wal_fd_ = open(wal.c_str(), O_WRONLY | O_CREAT, 0644);
+    if (wal_fd_ < 0 || ftruncate(wal_fd_, valid) < 0) {
+      return -1;
+    }
+    wal_size_ = valid;
+    return 0;
+  }
+
+  /** Checkpoint a persistent store and release it. Returns 0 on success. */
+  int Close() {
+    int ret = 0;
+    if (wal_fd_ >= 0) {
+      ret = wal_size_ ? Checkpoint() : 0;
+      close(wal_fd_);
+      wal_fd_ = -1;
+    }
+    map_.clear();
+    return ret;
+  }
+
+  /** The value of \a key, or nullptr */
+  const std::string *Get(const std::string &key) const {
+    auto it = map_.find(key);
+    return it == map_.end() ? nullptr : &it->second;
+  }
+
+  /** The first entry not before \a key */
+  Map::const_iterator Seek(const std::string &key) const { return map_.lower_bound(key); }
+
+  Map::const_iterator Begin() const { return map_.begin(); }
+  Map::const_iterator End() const { return map_.end(); }
+
+  /** Log and apply \a batch. Returns 0 on success. */
+  int Write(const KvBatch &batch) {
+    std::vector<char> rec;
+    uint32_t crc, len;
+    if (batch.Empty()) {
+      return 0;
+    }
+    PutVarint(rec, batch.ops_.size());
+    for (auto &it : batch.ops_) {
+      rec.push_back(it.second.del_ ? 1 : 0);
+      PutVarint(rec, it.first.size());
+      rec.insert(rec.end(), it.first.begin(), it.first.end());
+      if (!it.second.del_) {
+        PutVarint(rec, it.second.val_.size());
+        rec.insert(rec.end(), it.second.val_.begin(), it.second.val_.end());
+      }
+    }
+    if (persist_) {
+      len = (uint32_t)rec.size();
+      crc = Crc32c(rec.data(), rec.size());
+      PutFixed(buf_, kWalMagic);
+      PutFixed(buf_, len);
+      PutFixed(buf_, crc);
+      buf_.insert(buf_.end(), rec.begin(), rec.end());
+      wal_size_ += 12 + rec.size();
+      if (buf_.size() >= kWalBuffer && Drain() < 0) {
+        return -1;
+      }
+    }
+    return Apply(rec.data(), rec.data() + rec.size());
+  }
+
+  /** Bytes in the log, to decide when to checkpoint */
+  uint64_t LogSize() const { return wal_size_; }
+
+  /** Make every batch written so far durable. Returns 0 on success. */
+  int Sync() {
+    if (wal_fd_ < 0) {
+      return 0;
+    }
+    return Drain() < 0 || fdatasync(wal_fd_) < 0 ? -1 : 0;
+  }
+
+  /** Write the map as a new snapshot and empty the log. Returns 0 on success. */
+  int Checkpoint() {
+    std::vector<char> out;
+    std::string tmp = db_ + ".tmp";
+    uint32_t crc;
+    int fd;
+    if (!persist_) {
+      return 0;
+    }
+    PutFixed(out, kSnapMagic);
+    PutFixed(out, kVersion);
+    PutFixed(out, (uint64_t)map_.size());
+    for (auto &it : map_) {
+      PutVarint(out, it.first.size());
+      out.insert(out.end(), it.first.begin(), it.first.end());
+      PutVarint(out, it.second.size());
+      out.insert(out.end(), it.second.begin(), it.second.end());
+    }
+    crc = Crc32c(out.data(), out.size());
+    PutFixed(out, crc);
+    fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+      return -1;
+    }
+    if (WriteAll(fd, out.data(), out.size()) < 0 || fsync(fd) < 0) {
+      close(fd);
+      return -1;
+    }
+    close(fd);
+    if (rename(tmp.c_str(), db_.c_str()) < 0) {
+      return -1;
+    }
+    buf_.clear();
+    wal_size_ = 0;
+    return ftruncate(wal_fd_, 0);
+  }
+
+ private:
+  /** Apply an encoded batch to the map */
+  int Apply(const char *p, const char *end) {
+    uint64_t count;
+    if (!GetVarint(p, end, count)) {
+      return -1;
+    }
+    for (uint64_t i = 0; i < count; ++i) {
+      uint64_t klen, vlen;
+      bool del;
+      if (p >= end) {
+        return -1;
+      }
+      del = *p++ != 0;
+      if (!GetVarint(p, end, klen) || (uint64_t)(end - p) < klen) {
+        return -1;
+      }
+      std::string key(p, klen);
+      p += klen;
+      if (del) {
+        map_.erase(key);
+        continue;
+      }
+      if (!GetVarint(p, end, vlen) || (uint64_t)(end - p) < vlen) {
+        return -1;
+      }
+      map_[key].assign(p, vlen);
+      p += vlen;
+    }
+    return 0;
+  }
+
+  int LoadSnapshot(const std::vector<char> &data) {
+    const char *p = data.data(), *end = p + data.size();
+    uint32_t magic, version, crc;
+    uint64_t count;
+    if (data.size() < 20) {
+      return -1;
+    }
+    memcpy(&crc, end - 4, 4);
+    if (Crc32c(p, data.size() - 4) != crc) {
+      return -1;
+    }
+    end -= 4;
+    if (!GetFixed(p, end, magic) || !GetFixed(p, end, version) || !GetFixed(p, end, count) ||
+        magic != kSnapMagic || version != kVersion) {
+      return -1;
+    }
+    for (uint64_t i = 0; i < count; ++i) {
+      uint64_t klen, vlen;
+      if (!GetVarint(p, end, klen) || (uint64_t)(end - p) < klen) {
+        return -1;
+      }
+      std::string key(p, klen);
+      p += klen;
+      if (!GetVarint(p, end, vlen) || (uint64_t)(end - p) < vlen) {
+        return -1;
+      }
+      map_.emplace_hint(map_.end(), std::move(key), std::string(p, vlen));
+      p += vlen;
+    }
+    return 0;
+  }
+
+  /** Write the buffered log records */
+  int Drain() {
+    if (buf_.empty()) {
+      return 0;
+    }
+    if (lseek(wal_fd_, 0, SEEK_END) < 0 || WriteAll(wal_fd_, buf_.data(), buf_.size()) < 0) {
+      return -1;
+    }
+    buf_.clear();
+    return 0;
+  }
+
+  static int WriteAll(int fd, const char *p, size_t size) {
+    while (size) {
+      ssize_t ret = write(fd, p, size);
+      if (ret < 0 && errno == EINTR) {
+        continue;
+      }
+      if (ret <= 0) {
+        return -1;
+      }
+      p += ret;
+      size -= ret;
+    }
+    return 0;
+  }
+
+  static int ReadFile(const std::string &path, std::vector<char> &data) {
+    struct stat st;
+    size_t done = 0;
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return -1;
+    }
+    if (fstat(fd, &st) < 0) {
+      close(fd);
+      return -1;
+    }
+    data.resize(st.st_size);
+    while (done < data.size()) {
+      ssize_t ret = read(fd, data.data() + done, data.size() - done);
+      if (ret < 0 && errno == EINTR) {
+        continue;
+      }
+      if (ret <= 0) {
+        break;
+      }
+      done += ret;
+    }
+    close(fd);
+    data.resize(done);
+    return 0;
+  }
+};
+
+const std::string *KvBatch::Get(const KvStore &store, const std::string &key) const {
+  auto it = ops_.find(key);
+  if (it == ops_.end()) {
+    return store.Get(key);
+  }
+  return it->second.del_ ? nullptr : &it->second.val_;
+}
+
+}
+
+#endif //HDF5_VOLS__KV_HELPERS_H_
@@ -0,0 +1,193 @@
+//
+// Dataspace selection helpers shared by the connectors.
+//
+
+#ifndef HDF5_VOLS__SELECTION_HELPERS_H_
+#define HDF5_VOLS__SELECTION_HELPERS_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <vector>
+#include "hdf5.h"
+
+namespace h5 {
+
+/** A run of contiguous elements in a linearized selection */
+struct SelSeq {
+  hsize_t off_;   /**< First element (row-major linear index) */
+  size_t len_;    /**< Number of elements */
+};
+
+/** A run of elements shared by the file and memory selections */
+struct SelPair {
+  hsize_t file_off_;  /**< Linear element index in the file dataspace */
+  hsize_t mem_off_;   /**< Linear element index in the memory buffer */
+  size_t len_;        /**< Number of elements */
+};
+
+/**
+ * Resolve H5S_ALL the way H5Dread/H5Dwrite do: an H5S_ALL file space
+ * selects the whole dataset, an H5S_ALL memory space mirrors the file
+ * selection.
+ */
+inline void ResolveSpaces(hid_t dset_space_id, hid_t &file_space_id, hid_t &mem_space_id) {
+  if (file_space_id == H5S_ALL) {
+    file_space_id = dset_space_id;
+  }
+  if (mem_space_id == H5S_ALL) {
+    mem_space_id = file_space_id;
+  }
+}
+
+/** Linearize a selection into element runs, in selection iteration order */
+inline herr_t GetSelectionSeqs(hid_t space_id, std::vector<SelSeq> &seqs) {
+  static const size_t kMaxSeq = 1024;
+  hsize_t off[kMaxSeq];
+  size_t len[kMaxSeq];
+  size_t nseq, nelmts;
+  hid_t iter_id = H5Ssel_iter_create(space_id, 1, 0);
+  if (iter_id < 0) {
+    return -1;
+  }
+  do {
+    if (H5Ssel_iter_get_seq_list(iter_id, kMaxSeq, SIZE_MAX, &nseq, &nelmts, off, len) < 0) {
+      H5Ssel_iter_close(iter_id);
+      return -1;
+    }
+    for (size_t i = 0; i < nseq; ++i) {
+      if (!seqs.empty() && seqs.back().off_ + seqs.back().len_ == off[i]) {
+        seqs.back().len_ += len[i];
+      } else {
+        seqs.push_back(SelSeq{off[i], len[i]});
+      }
+    }
+  } while (nseq == kMaxSeq);
+  H5Ssel_iter_close(iter_id);
+  return 0;
+}
+
+/**
+ * Walk the file and memory selections in lockstep, producing the runs of
+ * elements that are contiguous in both. The selections must contain the
+ * same number of elements.
+ */
+inline herr_t PairSelections(hid_t file_space_id, hid_t mem_space_id, std::vector<SelPair> &pairs) {
+  std::vector<SelSeq> fseqs, mseqs;
+  if (GetSelectionSeqs(file_space_id, fseqs) < 0) {
+    return -1;
+  }
+  if (mem_space_id == file_space_id) {
+    for (SelSeq &seq : fseqs) {
+      pairs.push_back(SelPair{seq.off_, seq.off_, seq.len_});
+    }
+    return 0;
+  }
+  if (GetSelectionSeqs(mem_space_id, mseqs) < 0) {
+    return -1;
+  }
+  size_t fi = 0, mi = 0, fdone = 0, mdone = 0;
+  while (fi < fseqs.size() && mi < mseqs.size()) {
+    size_t len = std::min(fseqs[fi].len_ - fdone, mseqs[mi].len_ - mdone);
+    pairs.push_back(SelPair{fseqs[fi].off_ + fdone, mseqs[mi].off_ + mdone, len});
+    fdone += len;
+    mdone += len;
+    if (fdone == fseqs[fi].len_) { ++fi; fdone = 0; }
+    if (mdone == mseqs[mi].len_) { ++mi; mdone = 0; }
+  }
+  if (fi != fseqs.size() || mi != mseqs.size()) {
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * Copy the memory side of each pair from \a src into the packed buffer
+ * \a dst, and rewrite the pairs so their memory offsets index \a dst.
+ */
+inline void PackPairs(const void *src, std::vector<SelPair> &pairs, size_t elmt_size, void *dst) {
+  hsize_t packed = 0;
+  for (SelPair &pair : pairs) {
+    memcpy((char*)dst + packed * elmt_size, (const char*)src + pair.mem_off_ * elmt_size,
+           pair.len_ * elmt_size);
+    pair.mem_off_ = packed;
+    packed += pair.len_;
+  }
+}
+
+/** Inverse of PackPairs: scatter a packed buffer to the memory offsets in \a pairs */
+inline void UnpackPairs(const void *src, const std::vector<SelPair> &pairs, size_t elmt_size,
+                        void *dst) {
+  hsize_t packed = 0;
+  for (const SelPair &pair : pairs) {
+    memcpy((char*)dst + pair.mem_off_ * elmt_size, (const char*)src + packed * elmt_size,
+           pair.len_ * elmt_size);
+    packed += pair.len_;
+  }
+}
+
+/**
+ * Split pairs at boundaries of fixed-size linear chunks of \a chunk_elmts
+ * elements, grouping the pieces by chunk index.
+ */
+inline void SplitByChunk(const std::vector<SelPair> &pairs, size_t chunk_elmts,
+                         std::map<size_t, std::vector<SelPair>> &chunks) {
+  for (const SelPair &pair : pairs) {
+    hsize_t foff = pair.file_off_, moff = pair.mem_off_;
+    size_t left = pair.len_;
+    while (left) {
+      size_t idx = foff / chunk_elmts;
+      size_t len = std::min<size_t>(left, (idx + 1) * chunk_elmts - foff);
+      chunks[idx].push_back(SelPair{foff, moff, len});
+      foff += len;
+      moff += len;
+      left -= len;
+    }
+  }
+}
+
+
+/**
+ * Split pairs over an n-D chunk grid. \a dims is the dataspace extent and
+ * \a chunk_dims the chunk shape. Pieces are grouped by row-major chunk
+ * index and their file offsets are rewritten to row-major element
+ * offsets inside the chunk.
+ */
+inline void SplitByChunkGrid(const std::vector<SelPair> &pairs, const std::vector<hsize_t> &dims,
+                             const std::vector<hsize_t> &chunk_dims,
+                             std::map<size_t, std::vector<SelPair>> &chunks) {
+  int rank = (int)dims.size();
+  std::vector<hsize_t> coord(rank), grid(rank);
+  for (int d = 0; d < rank; ++d) {
+    grid[d] = (dims[d] + chunk_dims[d] - 1) / chunk_dims[d];
+  }
+  for (const SelPair &pair : pairs) {
+    hsize_t foff = pair.file_off_, moff = pair.mem_off_;
+    size_t left = pair.len_;
+    while (left) {
+      hsize_t rem = foff;
+      for (int d = rank - 1; d >= 0; --d) {
+        coord[d] = rem % dims[d];
+        rem /= dims[d];
+      }
+      /* Runs stay in one chunk until a chunk edge or the end of the row */
+      hsize_t in_row = coord[rank - 1] % chunk_dims[rank - 1];
+      size_t len = std::min<hsize_t>(left, chunk_dims[rank - 1] - in_row);
+      len = std::min<hsize_t>(len, dims[rank - 1] - coord[rank - 1]);
+      size_t idx = 0;
+      hsize_t local = 0;
+      for (int d = 0; d < rank; ++d) {
+        idx = idx * grid[d] + coord[d] / chunk_dims[d];
+        local = local * chunk_dims[d] + coord[d] % chunk_dims[d];
+      }
+      chunks[idx].push_back(SelPair{local, moff, len});
+      foff += len;
+      moff += len;
+      left -= len;
+    }
+  }
+}
+}
+
+#endif //HDF5_VOLS__SELECTION_HELPERS_H_
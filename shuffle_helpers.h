@@ -0,0 +1,310 @@
+//
+// Byte- and bit-shuffle pre-filters used by compress_vol.
+//
+
+#ifndef HDF5_VOLS__SHUFFLE_HELPERS_H_
+#define HDF5_VOLS__SHUFFLE_HELPERS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace h5 {
+
+/**
+ * Pre-filters applied before the codec. The values are persisted in
+ * every chunk header, so never renumber them.
+ */
+enum ShuffleFilter : int {
+  kShuffleNone = 0,     /**< Bytes are passed to the codec unchanged */
+  kShuffleByte = 1,     /**< Gather byte k of every element into plane k */
+  kShuffleBit = 2,      /**< Byte shuffle, then split each plane into bit planes */
+  kShuffleAuto = 255,   /**< Byte shuffle for multi-byte types (never persisted) */
+};
+
+/** Parse a shuffle filter name from the connector string */
+inline int ParseShuffle(const std::string &name) {
+  if (name == "none") { return kShuffleNone; }
+  if (name == "byte") { return kShuffleByte; }
+  if (name == "bit") { return kShuffleBit; }
+  if (name == "auto") { return kShuffleAuto; }
+  return -1;
+}
+
+/**
+ * Vectorized byte shuffle of 16 elements of \a E bytes. Plane k of the
+ * output starts at \a out + k * \a stride.
+ */
+template<size_t E>
+inline void ByteShuffleBlock(const char *in, char *out, size_t stride);
+
+/** Inverse of ByteShuffleBlock */
+template<size_t E>
+inline void ByteUnshuffleBlock(const char *in, char *out, size_t stride);
+
+#ifdef __SSSE3__
+template<>
+inline void ByteShuffleBlock<2>(const char *in, char *out, size_t stride) {
+  const __m128i mask = _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15);
+  __m128i a0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)in), mask);
+  __m128i a1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)in + 1), mask);
+  _mm_storeu_si128((__m128i*)out, _mm_unpacklo_epi64(a0, a1));
+  _mm_storeu_si128((__m128i*)(out + stride), _mm_unpackhi_epi64(a0, a1));
+}
+
+template<>
+inline void ByteShuffleBlock<4>(const char *in, char *out, size_t stride) {
+  const __m128i mask = _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+  __m128i a[4], t[4];
+  for (int i = 0; i < 4; ++i) {
+    a[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)in + i), mask);
+  }
+  t[0] = _mm_unpacklo_epi32(a[0], a[1]);
+  t[1] = _mm_unpackhi_epi32(a[0], a[1]);
+  t[2] = _mm_unpacklo_epi32(a[2], a[3]);
+  t[3] = _mm_unpackhi_epi32(a[2], a[3]);
+  _mm_storeu_si128((__m128i*)out, _mm_unpacklo_epi64(t[0], t[2]));
+  _mm_storeu_si128((__m128i*)(out + stride), _mm_unpackhi_epi64(t[0], t[2]));
+  _mm_storeu_si128((__m128i*)(out + 2 * stride), _mm_unpacklo_epi64(t[1], t[3]));
+  _mm_storeu_si128((__m128i*)(out + 3 * stride), _mm_unpackhi_epi64(t[1], t[3]));
+}
+
+template<>
+inline void ByteShuffleBlock<8>(const char *in, char *out, size_t stride) {
+  const __m128i mask = _mm_setr_epi8(0, 8, 1, 9, 2, 10, 3, 11, 4, 12, 5, 13, 6, 14, 7, 15);
+  __m128i a[8], t[8];
+  for (int i = 0; i < 8; ++i) {
+    a[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)in + i), mask);
+  }
+  /* 8x8 transpose of 16-bit words; word k of a[i] is byte k of elements 2i, 2i+1 */
+  for (int i = 0; i < 4; ++i) {
+    t[2 * i] = _mm_unpacklo_epi16(a[2 * i], a[2 * i + 1]);
+    t[2 * i + 1] = _mm_unpackhi_epi16(a[2 * i], a[2 * i + 1]);
+  }
+  a[0] = _mm_unpacklo_epi32(t[0], t[2]);
+  a[1] = _mm_unpackhi_epi32(t[0], t[2]);
+  a[2] = _mm_unpacklo_epi32(t[1], t[3]);
+  a[3] = _mm_unpackhi_epi32(t[1], t[3]);
+  a[4] = _mm_unpacklo_epi32(t[4], t[6]);
+  a[5] = _mm_unpackhi_epi32(t[4], t[6]);
+  a[6] = _mm_unpacklo_epi32(t[5], t[7]);
+  a[7] = _mm_unpackhi_epi32(t[5], t[7]);
+  for (int k = 0; k < 4; ++k) {
+    _mm_storeu_si128((__m128i*)(out + 2 * k * stride), _mm_unpacklo_epi64(a[k], a[k + 4]));
+    _mm_storeu_si128((__m128i*)(out + (2 * k + 1) * stride), _mm_unpackhi_epi64(a[k], a[k + 4]));
+  }
+}
+#endif
+
+#ifdef __SSE2__
+template<>
+inline void ByteUnshuffleBlock<2>(const char *in, char *out, size_t stride) {
+  __m128i p0 = _mm_loadu_si128((const __m128i*)in);
+  __m128i p1 = _mm_loadu_si128((const __m128i*)(in + stride));
+  _mm_storeu_si128((__m128i*)out, _mm_unpacklo_epi8(p0, p1));
+  _mm_storeu_si128((__m128i*)out + 1, _mm_unpackhi_epi8(p0, p1));
+}
+
+template<>
+inline void ByteUnshuffleBlock<4>(const char *in, char *out, size_t stride) {
+  __m128i p[4], b[4];
+  for (int k = 0; k < 4; ++k) {
+    p[k] = _mm_loadu_si128((const __m128i*)(in + k * stride));
+  }
+  b[0] = _mm_unpacklo_epi8(p[0], p[1]);
+  b[1] = _mm_unpackhi_epi8(p[0], p[1]);
+  b[2] = _mm_unpacklo_epi8(p[2], p[3]);
+  b[3] = _mm_unpackhi_epi8(p[2], p[3]);
+  _mm_storeu_si128((__m128i*)out, _mm_unpacklo_epi16(b[0], b[2]));
+  _mm_storeu_si128((__m128i*)out + 1, _mm_unpackhi_epi16(b[0], b[2]));
+  _mm_storeu_si128((__m128i*)out + 2, _mm_unpacklo_epi16(b[1], b[3]));
+  _mm_storeu_si128((__m128i*)out + 3, _mm_unpackhi_epi16(b[1], b[3]));
+}
+
+template<>
+inline void ByteUnshuffleBlock<8>(const char *in, char *out, size_t stride) {
+  __m128i p[8], b[8], c[8];
+  for (int k = 0; k < 8; ++k) {
+    p[k] = _mm_loadu_si128((const __m128i*)(in + k * stride));
+  }
+  for (int k = 0; k < 4; ++k) {
+    b[2 * k] = _mm_unpacklo_epi8(p[2 * k], p[2 * k + 1]);
+    b[2 * k + 1] = _mm_unpackhi_epi8(p[2 * k], p[2 * k + 1]);
+  }
+  /* c[0..3]: bytes 0-3 of elements 0-15; c[4..7]: bytes 4-7 */
+  for (int h = 0; h < 2; ++h) {
+    c[4 * h] = _mm_unpacklo_epi16(b[4 * h], b[4 * h + 2]);
+    c[4 * h + 1] = _mm_unpackhi_epi16(b[4 * h], b[4 * h + 2]);
+    c[4 * h + 2] = _mm_unpacklo_epi16(b[4 * h + 1], b[4 * h + 3]);
+    c[4 * h + 3] = _mm_unpackhi_epi16(b[4 * h + 1], b[4 * h + 3]);
+  }
+  for (int k = 0; k < 4; ++k) {
+    _mm_storeu_si128((__m128i*)out + 2 * k, _mm_unpacklo_epi32(c[k], c[k + 4]));
+    _mm_storeu_si128((__m128i*)out + 2 * k + 1, _mm_unpackhi_epi32(c[k], c[k + 4]));
+  }
+}
+#endif
+
+/** Shuffle with a vector kernel for whole blocks of 16 elements */
+template<size_t E>
+inline size_t ByteShuffleBlocks(const char *in, char *out, size_t nelmts) {
+  size_t e = 0;
+#ifdef __SSSE3__
+  for (; e + 16 <= nelmts; e += 16) {
+    ByteShuffleBlock<E>(in + e * E, out + e, nelmts);
+  }
+#else
+  (void)in;
+  (void)out;
+  (void)nelmts;
+#endif
+  return e;
+}
+
+/** Unshuffle with a vector kernel for whole blocks of 16 elements */
+template<size_t E>
+inline size_t ByteUnshuffleBlocks(const char *in, char *out, size_t nelmts) {
+  size_t e = 0;
+#ifdef __SSE2__
+  for (; e + 16 <= nelmts; e += 16) {
+    ByteUnshuffleBlock<E>(in + e, out + e * E, nelmts);
+  }
+#else
+  (void)in;
+  (void)out;
+  (void)nelmts;
+#endif
+  return e;
+}
+
+/** Byte-shuffle: gather byte k of every element into plane k */
+inline void ByteShuffle(const char *in, char *out, size_t size, size_t elmt_size) {
+  size_t nelmts = size / elmt_size;
+  size_t e = 0;
+  switch (elmt_size) {
+    case 2: e = ByteShuffleBlocks<2>(in, out, nelmts); break;
+    case 4: e = ByteShuffleBlocks<4>(in, out, nelmts); break;
+    case 8: e = ByteShuffleBlocks<8>(in, out, nelmts); break;
+    default: break;
+  }
+  for (; e < nelmts; ++e) {
+    for (size_t k = 0; k < elmt_size; ++k) {
+      out[k * nelmts + e] = in[e * elmt_size + k];
+    }
+  }
+  /* Trailing bytes that do not form a whole element are copied as-is */
+  memcpy(out + nelmts * elmt_size, in + nelmts * elmt_size, size - nelmts * elmt_size);
+}
+
+/** Inverse of ByteShuffle */
+inline void ByteUnshuffle(const char *in, char *out, size_t size, size_t elmt_size) {
+  size_t nelmts = size / elmt_size;
+  size_t e = 0;
+  switch (elmt_size) {
+    case 2: e = ByteUnshuffleBlocks<2>(in, out, nelmts); break;
+    case 4: e = ByteUnshuffleBlocks<4>(in, out, nelmts); break;
+    case 8: e = ByteUnshuffleBlocks<8>(in, out, nelmts); break;
+    default: break;
+  }
+  for (; e < nelmts; ++e) {
+    for (size_t k = 0; k < elmt_size; ++k) {
+      out[e * elmt_size + k] = in[k * nelmts + e];
+    }
+  }
+  memcpy(out + nelmts * elmt_size, in + nelmts * elmt_size, size - nelmts * elmt_size);
+}
+
+/**
+ * Split \a n bytes (a multiple of 8) into 8 bit planes of n / 8 bytes.
+ * Bit i of plane t is bit 7 - t of byte i.
+ */
+inline void BitTranspose(const uint8_t *in, uint8_t *out, size_t n) {
+  size_t nb = n / 8, i = 0;
+#ifdef __AVX2__
+  for (; i + 32 <= n; i += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)(in + i));
+    for (size_t t = 0; t < 8; ++t) {
+      uint32_t bits = (uint32_t)_mm256_movemask_epi8(v);
+      memcpy(out + t * nb + i / 8, &bits, sizeof(bits));
+      v = _mm256_slli_epi16(v, 1);
+    }
+  }
+#endif
+#ifdef __SSE2__
+  for (; i + 16 <= n; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(in + i));
+    for (size_t t = 0; t < 8; ++t) {
+      uint16_t bits = (uint16_t)_mm_movemask_epi8(v);
+      memcpy(out + t * nb + i / 8, &bits, sizeof(bits));
+      v = _mm_slli_epi16(v, 1);
+    }
+  }
+#endif
+  for (; i < n; i += 8) {
+    uint64_t x;
+    memcpy(&x, in + i, sizeof(x));
+    for (size_t t = 0; t < 8; ++t) {
+      out[t * nb + i / 8] = (uint8_t)((((x >> (7 - t)) & 0x0101010101010101ULL) * 0x0102040810204080ULL) >> 56);
+    }
+  }
+}
+
+/** Inverse of BitTranspose */
+inline void BitUntranspose(const uint8_t *in, uint8_t *out, size_t n) {
+  size_t nb = n / 8;
+  for (size_t g = 0; g < nb; ++g) {
+    uint64_t x = 0;
+    for (size_t t = 0; t < 8; ++t) {
+      /* Spread the 8 bits of the plane byte to bit 0 of 8 bytes */
+      uint64_t m = in[t * nb + g];
+      uint64_t spread = __builtin_bswap64(((m * 0x8040201008040201ULL) & 0x8080808080808080ULL) >> 7);
+      x |= spread << (7 - t);
+    }
+    memcpy(out + g * 8, &x, sizeof(x));
+  }
+}
+
+/**
+ * Bit-shuffle: byte-shuffle, then split each byte plane into bit planes.
+ * Only whole groups of 8 elements are transposed; the remaining bytes
+ * are copied as-is.
+ */
+inline void BitShuffle(const char *in, char *out, size_t size, size_t elmt_size) {
+  static thread_local std::vector<char> planes;
+  size_t nelmts = (size / elmt_size) & ~(size_t)7;
+  size_t nbytes = nelmts * elmt_size;
+  planes.resize(nbytes);
+  ByteShuffle(in, planes.data(), nbytes, elmt_size);
+  for (size_t k = 0; k < elmt_size; ++k) {
+    BitTranspose((const uint8_t*)planes.data() + k * nelmts, (uint8_t*)out + k * nelmts, nelmts);
+  }
+  memcpy(out + nbytes, in + nbytes, size - nbytes);
+}
+
+/** Inverse of BitShuffle */
+inline void BitUnshuffle(const char *in, char *out, size_t size, size_t elmt_size) {
+  static thread_local std::vector<char> planes;
+  size_t nelmts = (size / elmt_size) & ~(size_t)7;
+  size_t nbytes = nelmts * elmt_size;
+  planes.resize(nbytes);
+  for (size_t k = 0; k < elmt_size; ++k) {
+    BitUntranspose((const uint8_t*)in + k * nelmts, (uint8_t*)planes.data() + k * nelmts, nelmts);
+  }
+  ByteUnshuffle(planes.data(), out, nbytes, elmt_size);
+  memcpy(out + nbytes, in + nbytes, size - nbytes);
+}
+
+}
+
+#endif //HDF5_VOLS__SHUFFLE_HELPERS_H_
@@ -0,0 +1,507 @@
+//
+// Node-wide write staging in POSIX shared memory used by pfs_vol.
+//
+
+#ifndef HDF5_VOLS__STAGE_HELPERS_H_
+#define HDF5_VOLS__STAGE_HELPERS_H_
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace h5 {
+
+/** FNV-1a hash of \a str, the same in every process */
+inline uint64_t StableHash(const std::string &str) {
+  uint64_t h = 14695981039346656037ULL;
+  for (unsigned char c : str) {
+    h = (h ^ c) * 1099511628211ULL;
+  }
+  return h;
+}
+
+/**
+ * Equal-sized blocks in a POSIX shared memory segment, shared by every
+ * process on the node that attaches the same name. A block stages an
+ * image of one chunk, keyed by (dataset, chunk index, location in its
+ * file), so that any attached process can write it back. Processes that
+ * allocated the same chunk at different locations get a block each; a
+ * new block starts from the latest image of the chunk on the node.
+ * Blocks are found through a hash table over (dataset, chunk). Dirty
+ * blocks stay until written back, or until write-back failed kRetries
+ * times, when they are dropped and the dataset's next Flush() fails.
+ * Clean ones are reused in clock order. Datasets are registered by
+ * path, and their table entry is reused once no process holds it and no
+ * block refers to it.
+ *
+ * Locks are process-shared and robust, so a process dying while holding
+ * one does not wedge the node; HermesShm's mutexes are spin locks that
+ * stay held when their owner dies, hence plain pthreads. The table lock
+ * is always taken before block locks, and more than one block lock is
+ * only taken while holding it.
+ */
+class StagePool {
+ public:
+  static const uint32_t kMagic = 0x50475453;  /**< "STGP" */
+  static const size_t kDsets = 64;            /**< Datasets staged at once */
+  static const size_t kPath = 4096;           /**< Bytes of a dataset path */
+  static const uint32_t kRetries = 8;         /**< Failed write-backs before a block is dropped */
+  static const uint32_t kNone = UINT32_MAX;   /**< End of a hash chain */
+  enum { kFree = 0, kClean = 1, kDirty = 2 };
+
+  /** A dataset with staged chunks */
+  struct Dset {
+    int32_t refs_;              /**< Processes holding the entry */
+    int32_t used_;              /**< Blocks not free that refer to it */
+    int32_t failed_;            /**< A block of it was dropped since the last Flush() of it */
+    char path_[kPath];          /**< Canonical path of the dataset, "" if unused */
+  };
+
+  /** The state of a block */
+  struct Slot {
+    pthread_mutex_t lock_;      /**< Guards the block's data */
+    uint32_t state_;            /**< kFree, kClean or kDirty */
+    uint32_t dset_;             /**< Index in Header::dsets_ */
+    uint64_t chunk_;            /**< Chunk index */
+    uint64_t loc_;              /**< Location of the chunk, as the caller defines it */
+    uint64_t size_;             /**< Bytes of the chunk */
+    uint64_t tick_;             /**< Last write or read */
+    uint32_t bucket_;           /**< Hash chain holding it, kNone if none */
+    uint32_t next_;             /**< Next in the hash chain */
+    uint32_t ref_;              /**< Used since the clock hand last passed */
+    uint32_t fails_;            /**< Failed write-backs in a row */
+  };
+
+  /** Start of the segment; the slots, the hash chains and then the blocks follow */
+  struct Header {
+    uint32_t magic_;            /**< kMagic once the segment is set up */
+    uint32_t nslots_;           /**< Blocks in the pool */
+    uint32_t nbuckets_;         /**< Hash chains, a power of two */
+    uint32_t hand_;             /**< Clock hand over the slots */
+    uint64_t block_;            /**< Bytes per block */
+    uint64_t data_off_;         /**< Segment offset of the first block */
+    uint64_t tick_;             /**< Use counter */
+    int32_t attached_;          /**< Processes attached */
+    pthread_mutex_t lock_;      /**< Guards the slot and dataset tables */
+    Dset dsets_[kDsets];
+  };
+
+ public:
+  std::string name_;
+  char *base_ = nullptr;
+  size_t size_ = 0;
+  Header *hdr_ = nullptr;
+  Slot *slots_ = nullptr;
+  uint32_t *buckets_ = nullptr;
+
+ public:
+  ~StagePool() { Detach(); }
+
+  /**
+   * Attach the segment \a name, creating it with about \a size bytes of
+   * \a block-byte blocks if no process on the node has. An existing
+   * segment keeps its own geometry. Returns 0 on success.
+   */
+  int Attach(const std::string &name, size_t size, size_t block) {
+    bool creator = true;
+    struct stat st;
+    int fd;
+
+    block = (block + 4095) / 4096 * 4096;
+    name_ = name;
+    fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0 && errno == EEXIST) {
+      creator = false;
+      fd = shm_open(name.c_str(), O_RDWR, 0600);
+    }
+    if (fd < 0) {
+      return -1;
+    }
+    if (creator) {
+      size_t nslots = std::max<size_t>(size / block, 1);
+      size_ = DataOffset(nslots) + nslots * block;
+      if (ftruncate(fd, size_) < 0) {
+        close(fd);
+        shm_unlink(name.c_str());
+        return -1;
+      }
+    } else {
+      /* Wait for the creator to size the segment */
+      for (int i = 0; i < 5000; ++i) {
+        if (fstat(fd, &st) < 0 || st.st_size > 0) {
+          break;
+        }
+        usleep(1000);
+      }
+      if (fstat(fd, &st) < 0 || st.st_size == 0) {
+        close(fd);
+        return -1;
+      }
+      size_ = st.st_size;
+    }
+    void *base = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+      return -1;
+    }
+    base_ = (char *)base;
+    hdr_ = (Header *)base_;
+    slots_ = (Slot *)(base_ + sizeof(Header));
+
+    if (creator) {
+      pthread_mutexattr_t attr;
+      pthread_mutexattr_init(&attr);
+      pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+      pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+      hdr_->nslots_ = (uint32_t)std::max<size_t>(size / block, 1);
+      hdr_->nbuckets_ = Buckets(hdr_->nslots_);
+      hdr_->block_ = block;
+      hdr_->data_off_ = DataOffset(hdr_->nslots_);
+      buckets_ = (uint32_t *)(slots_ + hdr_->nslots_);
+      pthread_mutex_init(&hdr_->lock_, &attr);
+      for (uint32_t i = 0; i < hdr_->nslots_; ++i) {
+        pthread_mutex_init(&slots_[i].lock_, &attr);
+        slots_[i].bucket_ = kNone;
+      }
+      for (uint32_t i = 0; i < hdr_->nbuckets_; ++i) {
+        buckets_[i] = kNone;
+      }
+      pthread_mutexattr_destroy(&attr);
+      __atomic_store_n(&hdr_->magic_, kMagic, __ATOMIC_RELEASE);
+    } else {
+      for (int i = 0; i < 5000 && __atomic_load_n(&hdr_->magic_, __ATOMIC_ACQUIRE) != kMagic; ++i) {
+        usleep(1000);
+      }
+      if (__atomic_load_n(&hdr_->magic_, __ATOMIC_ACQUIRE) != kMagic) {
+        munmap(base_, size_);
+        base_ = nullptr;
+        return -1;
+      }
+      buckets_ = (uint32_t *)(slots_ + hdr_->nslots_);
+    }
+    Lock(&hdr_->lock_);
+    hdr_->attached_++;
+    Unlock(&hdr_->lock_);
+    return 0;
+  }
+
+  /** Detach; the last process to detach removes the segment */
+  void Detach() {
+    bool last;
+    if (base_ == nullptr) {
+      return;
+    }
+    Lock(&hdr_->lock_);
+    last = --hdr_->attached_ == 0;
+    Unlock(&hdr_->lock_);
+    munmap(base_, size_);
+    base_ = nullptr;
+    if (last) {
+      shm_unlink(name_.c_str());
+    }
+  }
+
+  /** Bytes per block; larger chunks cannot be staged */
+  size_t BlockSize() const { return hdr_->block_; }
+
+  /**
+   * Hold the entry of dataset \a path, registering it. Returns its index,
+   * or -1 if the table is full.
+   */
+  int Dataset(const std::string &path) {
+    int idx = -1;
+    if (path.size() >= kPath) {
+      return -1;
+    }
+    Lock(&hdr_->lock_);
+    for (size_t i = 0; i < kDsets; ++i) {
+      if (strcmp(hdr_->dsets_[i].path_, path.c_str()) == 0) {
+        idx = (int)i;
+        break;
+      }
+      if (idx < 0 && hdr_->dsets_[i].path_[0] == '\0') {
+        idx = (int)i;
+      }
+    }
+    if (idx >= 0) {
+      if (hdr_->dsets_[idx].path_[0] == '\0') {
+        memcpy(hdr_->dsets_[idx].path_, path.c_str(), path.size() + 1);
+        hdr_->dsets_[idx].refs_ = 0;
+        hdr_->dsets_[idx].failed_ = 0;
+      }
+      hdr_->dsets_[idx].refs_++;
+    }
+    Unlock(&hdr_->lock_);
+    return idx;
+  }
+
+  /** Forget the clean chunks of dataset \a dset, then drop this process's hold on it */
+  void Release(int dset) {
+    Forget(dset);
+    Lock(&hdr_->lock_);
+    if (--hdr_->dsets_[dset].refs_ <= 0 && __atomic_load_n(&hdr_->dsets_[dset].used_, __ATOMIC_RELAXED) == 0) {
+      hdr_->dsets_[dset].path_[0] = '\0';
+    }
+    Unlock(&hdr_->lock_);
+  }
+
+  /**
+   * Stage a write to chunk \a chunk of dataset \a dset, stored at \a loc.
+   * A chunk not yet resident at \a loc gets a block holding the latest
+   * image of the chunk on the node, or that \a init fills with its
+   * current contents if there is none; \a apply then updates the image.
+   * Returns 0 once staged, 1 if the chunk does not fit or no block is
+   * free (the caller writes it itself) and -1 if \a init failed.
+   */
+  int Write(int dset, uint64_t chunk, uint64_t loc, size_t size, const std::function<int(char *)> &init,
+            const std::function<void(char *)> &apply) {
+    Slot *s;
+    Slot *src = nullptr;
+    bool rekey = false;
+    bool fresh;
+    if (size > hdr_->block_) {
+      return 1;
+    }
+    Lock(&hdr_->lock_);
+    s = Find(dset, chunk, loc);
+    if (s == nullptr) {
+      s = Victim();
+      rekey = true;
+    }
+    if (s == nullptr) {
+      Unlock(&hdr_->lock_);
+      return 1;
+    }
+    Lock(&s->lock_);
+    /* A block found may have been freed by a writer whose init failed */
+    fresh = rekey || s->state_ == kFree;
+    if (rekey) {
+      SetState(s, kFree);
+      Unlink(s);
+      s->dset_ = (uint32_t)dset;
+      s->chunk_ = chunk;
+      s->loc_ = loc;
+      s->size_ = size;
+      Link(s);
+    }
+    if (fresh) {
+      s->fails_ = 0;
+      src = Latest(dset, chunk, s);
+      if (src != nullptr) {
+        Lock(&src->lock_);
+      }
+    }
+    SetState(s, kDirty);
+    s->ref_ = 1;
+    s->tick_ = ++hdr_->tick_;
+    Unlock(&hdr_->lock_);
+    if (src != nullptr) {
+      memcpy(Block(s), Block(src), size);
+      Unlock(&src->lock_);
+    } else if (fresh && init(Block(s)) < 0) {
+      SetState(s, kFree);
+      Unlock(&s->lock_);
+      return -1;
+    }
+    apply(Block(s));
+    Unlock(&s->lock_);
+    return 0;
+  }
+
+  /**
+   * Pass the latest image of a resident chunk, whatever its location, to
+   * \a apply. Returns false if it is not resident.
+   */
+  bool Read(int dset, uint64_t chunk, const std::function<void(const char *)> &apply) {
+    Slot *s;
+    Lock(&hdr_->lock_);
+    s = Latest(dset, chunk, nullptr);
+    if (s == nullptr) {
+      Unlock(&hdr_->lock_);
+      return false;
+    }
+    Lock(&s->lock_);
+    s->ref_ = 1;
+    s->tick_ = ++hdr_->tick_;
+    Unlock(&hdr_->lock_);
+    apply(Block(s));
+    Unlock(&s->lock_);
+    return true;
+  }
+
+  /**
+   * Write back the dirty chunks of dataset \a dset (all datasets if -1)
+   * through \a writer(dataset path, loc, data, size), which returns 0 on
+   * success. Written chunks stay resident as clean; a chunk failing
+   * kRetries times in a row is dropped. Returns 0 if every write-back
+   * succeeded and, for a single dataset, none of its chunks was dropped
+   * since it was last flushed.
+   */
+  int Flush(int dset, const std::function<int(const char *, uint64_t, const char *, size_t)> &writer) {
+    int ret = 0;
+    if (dset >= 0 && __atomic_exchange_n(&hdr_->dsets_[dset].failed_, 0, __ATOMIC_RELAXED)) {
+      ret = -1;
+    }
+    for (uint32_t i = 0; i < hdr_->nslots_; ++i) {
+      Slot *s = &slots_[i];
+      if (__atomic_load_n(&s->state_, __ATOMIC_RELAXED) != kDirty) {
+        continue;
+      }
+      Lock(&hdr_->lock_);
+      Lock(&s->lock_);
+      Unlock(&hdr_->lock_);
+      if (s->state_ == kDirty && (dset < 0 || s->dset_ == (uint32_t)dset)) {
+        if (writer(hdr_->dsets_[s->dset_].path_, s->loc_, Block(s), s->size_) < 0) {
+          ret = -1;
+          if (++s->fails_ >= kRetries) {
+            __atomic_store_n(&hdr_->dsets_[s->dset_].failed_, 1, __ATOMIC_RELAXED);
+            SetState(s, kFree);
+          }
+        } else {
+          s->fails_ = 0;
+          SetState(s, kClean);
+        }
+      }
+      Unlock(&s->lock_);
+    }
+    return ret;
+  }
+
+  /**
+   * Forget the clean chunks of dataset \a dset, e.g. once its chunk grid
+   * changed. Dirty ones still belong to their writers.
+   */
+  void Forget(int dset) {
+    Lock(&hdr_->lock_);
+    for (uint32_t i = 0; i < hdr_->nslots_; ++i) {
+      Slot *s = &slots_[i];
+      Lock(&s->lock_);
+      if (s->state_ == kClean && s->dset_ == (uint32_t)dset) {
+        SetState(s, kFree);
+      }
+      Unlock(&s->lock_);
+    }
+    Unlock(&hdr_->lock_);
+  }
+
+ private:
+  static void Lock(pthread_mutex_t *lock) {
+    if (pthread_mutex_lock(lock) == EOWNERDEAD) {
+      pthread_mutex_consistent(lock);
+    }
+  }
+
+  static void Unlock(pthread_mutex_t *lock) {
+    pthread_mutex_unlock(lock);
+  }
+
+  char *Block(const Slot *s) const {
+    return base_ + hdr_->data_off_ + (size_t)(s - slots_) * hdr_->block_;
+  }
+
+  /** Hash chains for \a nslots blocks: a power of two, at least \a nslots */
+  static uint32_t Buckets(size_t nslots) {
+    uint32_t n = 1;
+    while (n < nslots) {
+      n <<= 1;
+    }
+    return n;
+  }
+
+  /** Segment offset of the first block for \a nslots blocks */
+  static size_t DataOffset(size_t nslots) {
+    return (sizeof(Header) + nslots * sizeof(Slot) + Buckets(nslots) * sizeof(uint32_t) + 4095) / 4096 * 4096;
+  }
+
+  /** Hash chain of chunk \a chunk of dataset \a dset */
+  uint32_t Bucket(uint32_t dset, uint64_t chunk) const {
+    uint64_t h = (chunk ^ ((uint64_t)dset << 48)) * 0x9E3779B97F4A7C15ULL;
+    return (uint32_t)(h >> 32) & (hdr_->nbuckets_ - 1);
+  }
+
+  /** Set the state of a block, counting the blocks in use per dataset; its lock is held */
+  void SetState(Slot *s, uint32_t state) {
+    uint32_t old = __atomic_load_n(&s->state_, __ATOMIC_RELAXED);
+    if ((old == kFree) != (state == kFree)) {
+      __atomic_add_fetch(&hdr_->dsets_[s->dset_].used_, state == kFree ? -1 : 1, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&s->state_, state, __ATOMIC_RELAXED);
+  }
+
+  /** Put a block on the hash chain of its key; the table lock is held */
+  void Link(Slot *s) {
+    s->bucket_ = Bucket(s->dset_, s->chunk_);
+    s->next_ = buckets_[s->bucket_];
+    buckets_[s->bucket_] = (uint32_t)(s - slots_);
+  }
+
+  /** Take a block off its hash chain, if any; the table lock is held */
+  void Unlink(Slot *s) {
+    uint32_t idx = (uint32_t)(s - slots_);
+    uint32_t *link;
+    if (s->bucket_ == kNone) {
+      return;
+    }
+    for (link = &buckets_[s->bucket_]; *link != idx; link = &slots_[*link].next_) {
+    }
+    *link = s->next_;
+    s->bucket_ = kNone;
+  }
+
+  /** The block holding a chunk at \a loc; the table lock is held */
+  Slot *Find(int dset, uint64_t chunk, uint64_t loc) {
+    for (uint32_t i = buckets_[Bucket((uint32_t)dset, chunk)]; i != kNone; i = slots_[i].next_) {
+      Slot *s = &slots_[i];
+      if (__atomic_load_n(&s->state_, __ATOMIC_RELAXED) != kFree && s->dset_ == (uint32_t)dset &&
+          s->chunk_ == chunk && s->loc_ == loc) {
+        return s;
+      }
+    }
+    return nullptr;
+  }
+
+  /** The most recently used block holding a chunk, other than \a skip; the table lock is held */
+  Slot *Latest(int dset, uint64_t chunk, const Slot *skip) {
+    Slot *latest = nullptr;
+    for (uint32_t i = buckets_[Bucket((uint32_t)dset, chunk)]; i != kNone; i = slots_[i].next_) {
+      Slot *s = &slots_[i];
+      if (s != skip && __atomic_load_n(&s->state_, __ATOMIC_RELAXED) != kFree && s->dset_ == (uint32_t)dset &&
+          s->chunk_ == chunk && (latest == nullptr || s->tick_ > latest->tick_)) {
+        latest = s;
+      }
+    }
+    return latest;
+  }
+
+  /**
+   * A free block, else a clean one not used since the clock hand last
+   * passed it; the table lock is held. Returns null if all are dirty.
+   */
+  Slot *Victim() {
+    for (uint32_t n = 0; n < 2 * hdr_->nslots_; ++n) {
+      Slot *s = &slots_[hdr_->hand_];
+      uint32_t state = __atomic_load_n(&s->state_, __ATOMIC_RELAXED);
+      hdr_->hand_ = (hdr_->hand_ + 1) % hdr_->nslots_;
+      if (state == kFree || (state == kClean && s->ref_ == 0)) {
+        return s;
+      }
+      if (state == kClean) {
+        s->ref_ = 0;
+      }
+    }
+    return nullptr;
+  }
+};
+
+}
+
+#endif //HDF5_VOLS__STAGE_HELPERS_H_
@@ -0,0 +1,116 @@
+/*
+ * Per-call overhead of the passthrough connectors: unwrapping the under
+ * objects of a multi-dataset call (a per-call std::vector against
+ * h5::SmallArray, and a single dataset forwarded in place), and a small
+ * H5Dwrite/H5Dread through replicate_vol and compress_vol against the
+ * native connector. Not run by ctest; run bench_connector_helpers by
+ * hand to compare, with HDF5_PLUGIN_PATH pointing at the built
+ * connectors.
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <hdf5.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "connector_helpers.h"
+
+namespace {
+
+struct Wrapped {
+  void *under_object_;
+};
+
+/** Stands in for the under VOL call, so the unwrapped array is not optimized away */
+__attribute__((noinline)) void *Forward(void **obj, size_t count) {
+  return obj[count - 1];
+}
+
+/** A fapl routing files through \a connector with the given parameters, or the native one */
+hid_t ConnectorFapl(const char *connector, const char *params) {
+  hid_t fapl = H5Pcreate(H5P_FILE_ACCESS);
+  if (connector == nullptr) {
+    return fapl;
+  }
+  hid_t vol = H5VLregister_connector_by_name(connector, H5P_DEFAULT);
+  void *info = nullptr;
+  REQUIRE(vol >= 0);
+  REQUIRE(H5VLconnector_str_to_info(params, vol, &info) >= 0);
+  REQUIRE(H5Pset_vol(fapl, vol, info) >= 0);
+  H5VLfree_connector_info(vol, info);
+  H5VLclose(vol);
+  return fapl;
+}
+
+}  // namespace
+
+TEST_CASE("Unwrap under objects", "[benchmark][connector_helpers]") {
+  for (size_t count : {1, 2, 8, 32}) {
+    std::vector<Wrapped> dsets(count);
+    for (size_t i = 0; i < count; ++i) {
+      dsets[i].under_object_ = &dsets[i];
+    }
+
+    /* What the connectors do for a single dataset: no unwrap array at all */
+    if (count == 1) {
+      BENCHMARK("Forwarded in place, 1 dataset") {
+        return Forward(&dsets[0].under_object_, 1);
+      };
+    }
+
+    BENCHMARK("std::vector, " + std::to_string(count) + " datasets") {
+      std::vector<void *> obj(count);
+      for (size_t i = 0; i < count; ++i) {
+        obj[i] = dsets[i].under_object_;
+      }
+      return Forward(obj.data(), count);
+    };
+
+    BENCHMARK("SmallArray, " + std::to_string(count) + " datasets") {
+      h5::SmallArray<void *, 8> obj(count);
+      for (size_t i = 0; i < count; ++i) {
+        obj[i] = dsets[i].under_object_;
+      }
+      return Forward(obj.data(), count);
+    };
+  }
+}
+
+TEST_CASE("Small dataset reads and writes through a connector", "[benchmark][connector_helpers]") {
+  struct Stack {
+    const char *name_, *connector_, *params_;
+  };
+  const Stack stacks[] = {{"native", nullptr, nullptr},
+                          {"replicate_vol, 1 replica", "replicate_vol", "quorum=1;native"},
+                          {"compress_vol, method=none", "compress_vol", "method=none;native"}};
+  const char *path = "bench_connector_helpers.h5";
+  hsize_t dims[1] = {4096}, start[1] = {100}, count[1] = {16};
+  std::vector<int> data(dims[0], 1), small(count[0], 2);
+
+  for (const Stack &stack : stacks) {
+    hid_t fapl = ConnectorFapl(stack.connector_, stack.params_);
+    hid_t file = H5Fcreate(path, H5F_ACC_TRUNC, H5P_DEFAULT, fapl);
+    REQUIRE(file >= 0);
+    hid_t space = H5Screate_simple(1, dims, nullptr);
+    hid_t dset = H5Dcreate2(file, "data", H5T_NATIVE_INT, space, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+    REQUIRE(dset >= 0);
+    REQUIRE(H5Dwrite(dset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, data.data()) >= 0);
+    hid_t mem = H5Screate_simple(1, count, nullptr);
+    REQUIRE(H5Sselect_hyperslab(space, H5S_SELECT_SET, start, nullptr, count, nullptr) >= 0);
+
+    /* One dataset per call: the count == 1 path of dataset_write/dataset_read */
+    BENCHMARK(std::string("H5Dwrite 16 ints, ") + stack.name_) {
+      return H5Dwrite(dset, H5T_NATIVE_INT, mem, space, H5P_DEFAULT, small.data());
+    };
+    BENCHMARK(std::string("H5Dread 16 ints, ") + stack.name_) {
+      return H5Dread(dset, H5T_NATIVE_INT, mem, space, H5P_DEFAULT, small.data());
+    };
+    H5Sclose(mem);
+    H5Sclose(space);
+    H5Dclose(dset);
+    H5Fclose(file);
+    H5Pclose(fapl);
+    remove(path);
+  }
+}
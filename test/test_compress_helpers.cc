@@ -0,0 +1,167 @@
+/*
+ * Chunk codecs, codec selection and lossy frames.
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "compress_helpers.h"
+
+namespace {
+
+/** Sample chunks: constant, smooth, short runs and noise */
+std::vector<std::vector<char>> Samples() {
+  std::vector<std::vector<char>> samples(4, std::vector<char>(64 * 1024));
+  std::mt19937 rng(42);
+  for (size_t i = 0; i < samples[0].size(); ++i) {
+    samples[1][i] = (char)(i / 256);
+    samples[2][i] = (char)(i / 3 % 7);
+    samples[3][i] = (char)rng();
+  }
+  return samples;
+}
+
+/** Whether \a frame decompresses back to \a raw */
+bool RoundTrips(const std::vector<char> &frame, const std::vector<char> &raw) {
+  std::vector<char> out;
+  return h5::decompress(frame.data(), frame.size(), out) && out == raw;
+}
+
+}  // namespace
+
+TEST_CASE("compress round-trips every method", "[compress_helpers]") {
+  int methods[] = {h5::kCompressNone, h5::kCompressRle, h5::kCompressLz4, h5::kCompressZstd};
+  for (const std::vector<char> &raw : Samples()) {
+    for (int method : methods) {
+      for (int shuffle : {(int)h5::kShuffleNone, (int)h5::kShuffleByte, (int)h5::kShuffleBit}) {
+        std::vector<char> frame;
+        h5::compress(method, shuffle, raw.data(), raw.size(), 4, frame);
+        REQUIRE(frame.size() <= sizeof(h5::ChunkHeader) + raw.size());
+        REQUIRE(RoundTrips(frame, raw));
+      }
+    }
+  }
+}
+
+TEST_CASE("compress stores incompressible chunks raw", "[compress_helpers]") {
+  std::vector<char> noise = Samples()[3], frame;
+  h5::compress(h5::kCompressRle, h5::kShuffleNone, noise.data(), noise.size(), 1, frame);
+  REQUIRE(h5::RawPayload(frame.data(), frame.size()) != nullptr);
+  REQUIRE(RoundTrips(frame, noise));
+}
+
+TEST_CASE("decompress rejects truncated frames", "[compress_helpers]") {
+  std::vector<char> raw = Samples()[2], frame, out;
+  h5::compress(h5::kCompressRle, h5::kShuffleNone, raw.data(), raw.size(), 1, frame);
+  for (size_t size : {(size_t)0, sizeof(h5::ChunkHeader) - 1, frame.size() - 1}) {
+    REQUIRE_FALSE(h5::decompress(frame.data(), size, out));
+  }
+}
+
+TEST_CASE("SelectMethod picks a codec per chunk", "[compress_helpers]") {
+  std::vector<std::vector<char>> samples = Samples();
+  h5::AdaptivePolicy policy{h5::kCompressLz4, h5::kCompressZstd, 7.5, 0.5, 16 * 1024};
+
+  /* Noise stays raw; easy data gets the fast codec */
+  REQUIRE(h5::SelectMethod(samples[3].data(), samples[3].size(), policy) == h5::kCompressNone);
+  REQUIRE(h5::SelectMethod(samples[0].data(), samples[0].size(), policy) == h5::ResolveMethod(policy.fast_));
+  REQUIRE(h5::SelectMethod(samples[0].data(), 0, policy) == h5::kCompressNone);
+
+  /* Whatever is picked, the frame round-trips */
+  for (const std::vector<char> &raw : samples) {
+    std::vector<char> frame;
+    h5::compress(h5::kCompressAuto, h5::kShuffleNone, raw.data(), raw.size(), 1, frame, &policy);
+    REQUIRE(RoundTrips(frame, raw));
+  }
+}
+
+TEST_CASE("compress_lossy honors its error bound", "[compress_helpers]") {
+  std::vector<double> in(8192);
+  for (size_t i = 0; i < in.size(); ++i) {
+    in[i] = std::sin(i * 0.01) * 100;
+  }
+  in[100] = NAN;
+  in[200] = INFINITY;
+  for (int mode : {(int)h5::kErrorAbs, (int)h5::kErrorRel}) {
+    double bound = 1e-3, abs_bound = mode == h5::kErrorAbs ? bound : bound * 200, got_bound = 0, got_abs = 0;
+    int got_mode = -1;
+    std::vector<char> frame, out;
+    h5::compress_lossy(mode, bound, in.data(), in.size() * sizeof(double), sizeof(double), frame);
+    REQUIRE(frame.size() < in.size() * sizeof(double));
+    REQUIRE(h5::FrameBound(frame.data(), frame.size(), &got_mode, &got_bound, &got_abs));
+    REQUIRE(got_mode == mode);
+    REQUIRE(got_bound == bound);
+    REQUIRE(h5::WithinBound(frame.data(), frame.size(), mode, bound));
+    REQUIRE_FALSE(h5::WithinBound(frame.data(), frame.size(), mode, bound / 10));
+    REQUIRE_FALSE(h5::WithinBound(frame.data(), frame.size(), mode, 0));
+    REQUIRE(h5::decompress(frame.data(), frame.size(), out));
+    REQUIRE(out.size() == in.size() * sizeof(double));
+    const double *rec = (const double *)out.data();
+    for (size_t i = 0; i < in.size(); ++i) {
+      if (std::isfinite(in[i])) {
+        REQUIRE(std::fabs(rec[i] - in[i]) <= abs_bound * 1.0001);
+      } else {
+        REQUIRE(std::memcmp(&rec[i], &in[i], sizeof(double)) == 0);
+      }
+    }
+  }
+}
+
+TEST_CASE("Crc32c matches the Castagnoli check value", "[compress_helpers]") {
+  REQUIRE(h5::Crc32c("123456789", 9) == 0xE3069283);
+  REQUIRE(h5::Crc32c("", 0) == 0);
+  /* A single flipped bit in an unaligned buffer with a partial word changes the checksum */
+  std::vector<char> data = Samples()[3];
+  uint32_t crc = h5::Crc32c(data.data() + 1, 1001);
+  data[500] ^= 1;
+  REQUIRE(h5::Crc32c(data.data() + 1, 1001) != crc);
+}
+
+TEST_CASE("Index varints and fixed fields round-trip", "[compress_helpers]") {
+  const uint64_t vals[] = {0, 1, 127, 128, 16383, 16384, UINT32_MAX, UINT64_MAX};
+  const int64_t deltas[] = {0, -1, 1, -64, 64, INT64_MIN, INT64_MAX};
+  std::vector<char> out;
+  for (uint64_t val : vals) {
+    h5::PutVarint(out, val);
+  }
+  for (int64_t delta : deltas) {
+    h5::PutVarint(out, h5::ZigZag(delta));
+  }
+  h5::PutFixed<uint32_t>(out, 0xDEADBEEF);
+  h5::PutFixed<double>(out, 0.25);
+
+  const char *p = out.data(), *end = out.data() + out.size();
+  for (uint64_t val : vals) {
+    uint64_t got;
+    REQUIRE(h5::GetVarint(p, end, got));
+    REQUIRE(got == val);
+  }
+  for (int64_t delta : deltas) {
+    uint64_t got;
+    REQUIRE(h5::GetVarint(p, end, got));
+    REQUIRE(h5::UnZigZag(got) == delta);
+  }
+  uint32_t word;
+  double real;
+  REQUIRE(h5::GetFixed(p, end, word));
+  REQUIRE(h5::GetFixed(p, end, real));
+  REQUIRE(word == 0xDEADBEEF);
+  REQUIRE(real == 0.25);
+  REQUIRE(p == end);
+  REQUIRE(!h5::GetFixed(p, end, word));
+}
+
+TEST_CASE("Truncated varints are rejected", "[compress_helpers]") {
+  std::vector<char> out;
+  h5::PutVarint(out, UINT64_MAX);
+  REQUIRE(out.size() == 10);
+  for (size_t len = 0; len < out.size(); ++len) {
+    const char *p = out.data();
+    uint64_t got;
+    REQUIRE(!h5::GetVarint(p, out.data() + len, got));
+  }
+  REQUIRE(h5::ZigZag(-1) == 1);
+  REQUIRE(h5::ZigZag(1) == 2);
+}
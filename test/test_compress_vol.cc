@@ -0,0 +1,282 @@
+/*
+ * Round trips through compress_vol stacked on the native connector.
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <hdf5.h>
+#include <algorithm>
+#include <cmath>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+namespace {
+
+/** A fapl routing files through compress_vol with the given parameters */
+hid_t CompressFapl(const char *params) {
+  hid_t vol = H5VLregister_connector_by_name("compress_vol", H5P_DEFAULT);
+  hid_t fapl = H5Pcreate(H5P_FILE_ACCESS);
+  void *info = nullptr;
+  REQUIRE(vol >= 0);
+  REQUIRE(H5VLconnector_str_to_info(params, vol, &info) >= 0);
+  REQUIRE(H5Pset_vol(fapl, vol, info) >= 0);
+  H5VLfree_connector_info(vol, info);
+  H5VLclose(vol);
+  return fapl;
+}
+
+}  // namespace
+
+TEST_CASE("compress_vol reopens a closed dataset", "[compress_vol]") {
+  const char *path = "test_compress_vol.h5";
+  const char *params[] = {"method=rle;native", "method=rle:shuffle=byte:chunk_size=4k;native"};
+  hsize_t dims[2] = {64, 100};
+  std::vector<int> data(dims[0] * dims[1]), out(data.size(), -1);
+
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = (int)(i / 7);
+  }
+  for (const char *param : params) {
+    hid_t fapl = CompressFapl(param);
+
+    /* Write and close */
+    hid_t file = H5Fcreate(path, H5F_ACC_TRUNC, H5P_DEFAULT, fapl);
+    REQUIRE(file >= 0);
+    hid_t space = H5Screate_simple(2, dims, nullptr);
+    hid_t dset = H5Dcreate2(file, "data", H5T_NATIVE_INT, space, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+    REQUIRE(dset >= 0);
+    REQUIRE(H5Dwrite(dset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, data.data()) >= 0);
+    REQUIRE(H5Dclose(dset) >= 0);
+    REQUIRE(H5Sclose(space) >= 0);
+    REQUIRE(H5Fclose(file) >= 0);
+
+    /* Reopen and read it back */
+    file = H5Fopen(path, H5F_ACC_RDONLY, fapl);
+    REQUIRE(file >= 0);
+    dset = H5Dopen2(file, "data", H5P_DEFAULT);
+    REQUIRE(dset >= 0);
+    space = H5Dget_space(dset);
+    hsize_t got[2] = {0, 0};
+    REQUIRE(H5Sget_simple_extent_dims(space, got, nullptr) == 2);
+    REQUIRE(got[0] == dims[0]);
+    REQUIRE(got[1] == dims[1]);
+    REQUIRE(H5Dread(dset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out.data()) >= 0);
+    REQUIRE(out == data);
+    H5Sclose(space);
+    H5Dclose(dset);
+    H5Fclose(file);
+    H5Pclose(fapl);
+  }
+  remove(path);
+}
+
+TEST_CASE("compress_vol reads and writes blocks across chunk edges", "[compress_vol]") {
+  const char *path = "test_compress_vol_block.h5";
+  hsize_t dims[3] = {20, 30, 40}, chunk[3] = {8, 8, 8};
+  hsize_t start[3] = {5, 6, 7}, count[3] = {6, 10, 12};
+  std::vector<int> data(dims[0] * dims[1] * dims[2]), block(count[0] * count[1] * count[2]);
+  std::vector<int> out(block.size(), -1), all(data.size(), -1);
+
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = (int)i;
+  }
+  for (size_t i = 0; i < block.size(); ++i) {
+    block[i] = -(int)i - 1;
+  }
+  hid_t fapl = CompressFapl("method=rle:chunk_size=4k;native");
+  hid_t file = H5Fcreate(path, H5F_ACC_TRUNC, H5P_DEFAULT, fapl);
+  REQUIRE(file >= 0);
+  hid_t space = H5Screate_simple(3, dims, nullptr);
+  hid_t dcpl = H5Pcreate(H5P_DATASET_CREATE);
+  REQUIRE(H5Pset_chunk(dcpl, 3, chunk) >= 0);
+  hid_t dset = H5Dcreate2(file, "field", H5T_NATIVE_INT, space, H5P_DEFAULT, dcpl, H5P_DEFAULT);
+  REQUIRE(dset >= 0);
+  REQUIRE(H5Dwrite(dset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, data.data()) >= 0);
+
+  /* Overwrite a block that straddles chunks, then read it back */
+  hid_t mem = H5Screate_simple(3, count, nullptr);
+  REQUIRE(H5Sselect_hyperslab(space, H5S_SELECT_SET, start, nullptr, count, nullptr) >= 0);
+  REQUIRE(H5Dwrite(dset, H5T_NATIVE_INT, mem, space, H5P_DEFAULT, block.data()) >= 0);
+  REQUIRE(H5Dread(dset, H5T_NATIVE_INT, mem, space, H5P_DEFAULT, out.data()) >= 0);
+  REQUIRE(out == block);
+  REQUIRE(H5Dclose(dset) >= 0);
+  REQUIRE(H5Fclose(file) >= 0);
+
+  /* Everything outside the block is untouched after a reopen */
+  for (hsize_t i = 0; i < count[0]; ++i) {
+    for (hsize_t j = 0; j < count[1]; ++j) {
+      for (hsize_t k = 0; k < count[2]; ++k) {
+        data[((start[0] + i) * dims[1] + start[1] + j) * dims[2] + start[2] + k] =
+            block[(i * count[1] + j) * count[2] + k];
+      }
+    }
+  }
+  file = H5Fopen(path, H5F_ACC_RDONLY, fapl);
+  REQUIRE(file >= 0);
+  dset = H5Dopen2(file, "field", H5P_DEFAULT);
+  REQUIRE(dset >= 0);
+  REQUIRE(H5Dread(dset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, all.data()) >= 0);
+  REQUIRE(all == data);
+  H5Sclose(mem);
+  H5Sclose(space);
+  H5Pclose(dcpl);
+  H5Dclose(dset);
+  H5Fclose(file);
+  H5Pclose(fapl);
+  remove(path);
+}
+
+TEST_CASE("compress_vol reuses the space of rewritten chunks", "[compress_vol]") {
+  const char *path = "test_compress_vol_reuse.h5";
+  hsize_t dims[1] = {4096};
+  std::vector<int> data(dims[0]), out(data.size(), -1);
+  hsize_t first = 0;
+
+  hid_t fapl = CompressFapl("method=rle:chunk_size=4k;native");
+  hid_t file = H5Fcreate(path, H5F_ACC_TRUNC, H5P_DEFAULT, fapl);
+  REQUIRE(file >= 0);
+  hid_t space = H5Screate_simple(1, dims, nullptr);
+  REQUIRE(H5Dcreate2(file, "data", H5T_NATIVE_INT, space, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT) >= 0);
+  H5Sclose(space);
+  H5Fclose(file);
+
+  /* Rewrite every chunk many times, closing in between */
+  for (int round = 0; round < 20; ++round) {
+    for (size_t i = 0; i < data.size(); ++i) {
+      data[i] = (int)(i / (round + 1));
+    }
+    file = H5Fopen(path, H5F_ACC_RDWR, fapl);
+    REQUIRE(file >= 0);
+    hid_t dset = H5Dopen2(file, "data", H5P_DEFAULT);
+    REQUIRE(dset >= 0);
+    REQUIRE(H5Dwrite(dset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, data.data()) >= 0);
+    REQUIRE(H5Dclose(dset) >= 0);
+    REQUIRE(H5Fclose(file) >= 0);
+
+    /* The byte stream under the dataset stays near its first size */
+    file = H5Fopen(path, H5F_ACC_RDONLY, H5P_DEFAULT);
+    REQUIRE(file >= 0);
+    dset = H5Dopen2(file, "data", H5P_DEFAULT);
+    REQUIRE(dset >= 0);
+    hsize_t bytes = 0;
+    space = H5Dget_space(dset);
+    REQUIRE(H5Sget_simple_extent_dims(space, &bytes, nullptr) == 1);
+    if (round == 0) {
+      first = bytes;
+    }
+    REQUIRE(bytes <= 3 * first);
+    H5Sclose(space);
+    H5Dclose(dset);
+    H5Fclose(file);
+  }
+
+  file = H5Fopen(path, H5F_ACC_RDONLY, fapl);
+  REQUIRE(file >= 0);
+  hid_t dset = H5Dopen2(file, "data", H5P_DEFAULT);
+  REQUIRE(dset >= 0);
+  REQUIRE(H5Dread(dset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out.data()) >= 0);
+  REQUIRE(out == data);
+  H5Dclose(dset);
+  H5Fclose(file);
+  H5Pclose(fapl);
+  remove(path);
+}
+
+TEST_CASE("compress_vol reports the bound a refused chunk was written with", "[compress_vol]") {
+  const char *path = "test_compress_vol_bound.h5";
+  hsize_t dims[1] = {4096};
+  std::vector<double> data(dims[0]), out(data.size());
+  bool reported = false;
+
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = (double)i / 7;
+  }
+  hid_t fapl = CompressFapl("method=lossy:error_bound=0.01;native");
+  hid_t file = H5Fcreate(path, H5F_ACC_TRUNC, H5P_DEFAULT, fapl);
+  REQUIRE(file >= 0);
+  hid_t space = H5Screate_simple(1, dims, nullptr);
+  hid_t dset = H5Dcreate2(file, "data", H5T_NATIVE_DOUBLE, space, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+  REQUIRE(dset >= 0);
+  REQUIRE(H5Dwrite(dset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, data.data()) >= 0);
+  H5Dclose(dset);
+  H5Sclose(space);
+  H5Fclose(file);
+  H5Pclose(fapl);
+
+  /* A reader asking for a tighter bound is refused, and told why */
+  fapl = CompressFapl("method=lossy:error_bound=0.0001;native");
+  file = H5Fopen(path, H5F_ACC_RDONLY, fapl);
+  REQUIRE(file >= 0);
+  dset = H5Dopen2(file, "data", H5P_DEFAULT);
+  REQUIRE(dset >= 0);
+  H5E_BEGIN_TRY {
+    REQUIRE(H5Dread(dset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, out.data()) < 0);
+  } H5E_END_TRY;
+  hid_t stack = H5Eget_current_stack();
+  H5Ewalk2(stack, H5E_WALK_UPWARD, [](unsigned, const H5E_error2_t *err, void *reported) -> herr_t {
+    if (err->desc && strstr(err->desc, "looser than the abs bound of 0.0001")) {
+      *(bool *)reported = true;
+    }
+    return 0;
+  }, &reported);
+  H5Eclose_stack(stack);
+  REQUIRE(reported);
+  H5Dclose(dset);
+  H5Fclose(file);
+  H5Pclose(fapl);
+  remove(path);
+}
+
+TEST_CASE("compress_vol reads lossy chunks within the reader's bound", "[compress_vol]") {
+  const char *path = "test_compress_vol_lossy.h5";
+  const char *readers[] = {"method=lossy:error_bound=0.01;native", "method=lossy:error_bound=0.1;native",
+                           "method=rle:error_bound=0.01;native"};
+  hsize_t dims[1] = {16384};
+  std::vector<double> data(dims[0]), out(data.size());
+
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = std::sin(i * 0.001) * 50;
+  }
+  hid_t fapl = CompressFapl("method=lossy:error_bound=0.01:chunk_size=16k;native");
+  hid_t file = H5Fcreate(path, H5F_ACC_TRUNC, H5P_DEFAULT, fapl);
+  REQUIRE(file >= 0);
+  hid_t space = H5Screate_simple(1, dims, nullptr);
+  hid_t dset = H5Dcreate2(file, "data", H5T_NATIVE_DOUBLE, space, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+  REQUIRE(dset >= 0);
+  REQUIRE(H5Dwrite(dset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, data.data()) >= 0);
+  H5Dclose(dset);
+  H5Sclose(space);
+  H5Fclose(file);
+  H5Pclose(fapl);
+
+  /* Readers allowing the same or a looser bound get every element within it */
+  for (const char *reader : readers) {
+    fapl = CompressFapl(reader);
+    file = H5Fopen(path, H5F_ACC_RDONLY, fapl);
+    REQUIRE(file >= 0);
+    dset = H5Dopen2(file, "data", H5P_DEFAULT);
+    REQUIRE(dset >= 0);
+    std::fill(out.begin(), out.end(), NAN);
+    REQUIRE(H5Dread(dset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, out.data()) >= 0);
+    for (size_t i = 0; i < data.size(); ++i) {
+      REQUIRE(std::fabs(out[i] - data[i]) <= 0.01 * 1.0001);
+    }
+    H5Dclose(dset);
+    H5Fclose(file);
+    H5Pclose(fapl);
+  }
+
+  /* A reader that never opted into lossy data is refused */
+  fapl = CompressFapl("method=rle;native");
+  file = H5Fopen(path, H5F_ACC_RDONLY, fapl);
+  REQUIRE(file >= 0);
+  dset = H5Dopen2(file, "data", H5P_DEFAULT);
+  REQUIRE(dset >= 0);
+  H5E_BEGIN_TRY {
+    REQUIRE(H5Dread(dset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, out.data()) < 0);
+  } H5E_END_TRY;
+  H5Dclose(dset);
+  H5Fclose(file);
+  H5Pclose(fapl);
+  remove(path);
+}
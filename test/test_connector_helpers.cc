@@ -0,0 +1,96 @@
+/*
+ * Connector string parsing, the worker pool and small arrays.
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "connector_helpers.h"
+
+TEST_CASE("ThreadPool runs every submitted task", "[connector_helpers]") {
+  h5::ThreadPool pool(4);
+  REQUIRE(pool.Size() == 4);
+  std::atomic<int> sum(0);
+  std::vector<std::future<void>> done;
+  for (int i = 1; i <= 1000; ++i) {
+    done.emplace_back(pool.Submit([&sum, i]() { sum += i; }));
+  }
+  for (std::future<void> &task : done) {
+    task.wait();
+  }
+  REQUIRE(sum == 500500);
+}
+
+TEST_CASE("ThreadPool drains queued tasks before stopping", "[connector_helpers]") {
+  std::atomic<int> count(0);
+  {
+    h5::ThreadPool pool(1);
+    for (int i = 0; i < 100; ++i) {
+      pool.Submit([&count]() { ++count; });
+    }
+  }
+  REQUIRE(count == 100);
+}
+
+TEST_CASE("ThreadPool futures carry task exceptions", "[connector_helpers]") {
+  h5::ThreadPool pool(2);
+  std::future<void> done = pool.Submit([]() { throw std::runtime_error("chunk"); });
+  REQUIRE_THROWS_AS(done.get(), std::runtime_error);
+}
+
+TEST_CASE("ParseConn reads this VOL's parameters", "[connector_helpers]") {
+  h5::ParseConn parser;
+  parser.parse("quorum=2:read_split=4m:ec=;native");
+  REQUIRE(parser.GetParam("quorum") == "2");
+  REQUIRE(parser.GetParam("read_split") == "4m");
+  REQUIRE(parser.GetParam("ec", "x") == "");
+  REQUIRE(parser.GetParam("quorum_min", "1") == "1");
+  REQUIRE(parser.GetParam("quo", "none") == "none");
+  REQUIRE(parser.GetNextVolName() == "native");
+
+  h5::ParseConn empty;
+  REQUIRE(empty.GetParam("quorum", "3") == "3");
+  REQUIRE(empty.GetNextVolName() == "");
+}
+
+TEST_CASE("SplitTargets separates the under-VOL stacks", "[connector_helpers]") {
+  std::string params;
+  std::vector<std::string> targets;
+  h5::ParseConn::SplitTargets("quorum=2;compress_vol:method=lz4;native||native", params, targets);
+  REQUIRE(params == "quorum=2");
+  REQUIRE(targets == std::vector<std::string>{"compress_vol:method=lz4;native", "native"});
+
+  /* Each target parses like a connector string whose own params are empty */
+  h5::ParseConn parser;
+  parser.parse(";" + targets[0]);
+  REQUIRE(parser.GetNextVolName() == "compress_vol");
+  REQUIRE(parser.GetNextVolParams() == "method=lz4;native:;");
+
+  params.clear();
+  targets.clear();
+  h5::ParseConn::SplitTargets("threads=4", params, targets);
+  REQUIRE(params == "threads=4");
+  REQUIRE(targets.empty());
+}
+
+TEST_CASE("ParseSize accepts binary suffixes", "[connector_helpers]") {
+  REQUIRE(h5::ParseSize("512") == 512);
+  REQUIRE(h5::ParseSize("64k") == 64 << 10);
+  REQUIRE(h5::ParseSize("8M") == 8 << 20);
+  REQUIRE(h5::ParseSize("1g") == (size_t)1 << 30);
+  REQUIRE(h5::ParseSize("4x") == 0);
+}
+
+TEST_CASE("SmallArray spills to the heap past its inline capacity", "[connector_helpers]") {
+  h5::SmallArray<int, 4> small(4), big(5), none(0);
+  REQUIRE(small.data() == small.local_);
+  REQUIRE(big.data() != big.local_);
+  REQUIRE(none.data() == none.local_);
+  for (int i = 0; i < 5; ++i) {
+    big[i] = i;
+  }
+  REQUIRE(big.data()[4] == 4);
+}
@@ -0,0 +1,90 @@
+/*
+ * GF(2^8) arithmetic and Reed-Solomon erasure coding.
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "erasure_helpers.h"
+
+TEST_CASE("Gf256 multiplies and inverts", "[erasure_helpers]") {
+  const h5::Gf256 &gf = h5::Gf256::Get();
+  for (int a = 1; a < 256; ++a) {
+    REQUIRE(gf.Mul((uint8_t)a, gf.Inv((uint8_t)a)) == 1);
+    REQUIRE(gf.Mul((uint8_t)a, 1) == a);
+    REQUIRE(gf.Mul((uint8_t)a, 0) == 0);
+  }
+  /* x * x^7 = x^8 = x^4 + x^3 + x^2 + 1 */
+  REQUIRE(gf.Mul(2, 0x80) == 0x1d);
+}
+
+TEST_CASE("GfMulAdd matches scalar multiplication at every length", "[erasure_helpers]") {
+  const h5::Gf256 &gf = h5::Gf256::Get();
+  std::mt19937 rng(3);
+  /* Lengths cover the 32- and 16-byte vector loops and the scalar tail */
+  for (size_t n : {0, 1, 15, 16, 17, 31, 32, 33, 100}) {
+    for (int c : {0, 1, 2, 0x53, 0xff}) {
+      std::vector<uint8_t> src(n), dst(n), expect(n);
+      for (size_t i = 0; i < n; ++i) {
+        src[i] = (uint8_t)rng();
+        dst[i] = expect[i] = (uint8_t)rng();
+        expect[i] ^= gf.Mul((uint8_t)c, src[i]);
+      }
+      h5::GfMulAdd((uint8_t)c, src.data(), dst.data(), n);
+      REQUIRE(dst == expect);
+    }
+  }
+}
+
+TEST_CASE("ReedSolomon recovers from any m erasures", "[erasure_helpers]") {
+  const size_t k = 4, m = 2, n = 1000;
+  h5::ReedSolomon rs(k, m);
+  std::mt19937 rng(11);
+  std::vector<std::vector<uint8_t>> shards(k + m, std::vector<uint8_t>(n));
+  std::vector<const uint8_t*> data;
+  std::vector<uint8_t*> parity;
+  for (size_t j = 0; j < k; ++j) {
+    for (uint8_t &b : shards[j]) {
+      b = (uint8_t)rng();
+    }
+    data.push_back(shards[j].data());
+  }
+  for (size_t p = 0; p < m; ++p) {
+    parity.push_back(shards[k + p].data());
+  }
+  rs.Encode(data.data(), parity.data(), n);
+
+  /* Every pattern of up to m lost shards, data or parity */
+  for (unsigned lost = 0; lost < (1u << (k + m)); ++lost) {
+    std::vector<const uint8_t*> avail(k + m);
+    size_t nlost = 0;
+    for (size_t i = 0; i < k + m; ++i) {
+      avail[i] = (lost >> i & 1) ? nullptr : shards[i].data();
+      nlost += lost >> i & 1;
+    }
+    std::vector<const uint8_t*> out;
+    std::vector<std::vector<uint8_t>> scratch;
+    bool ok = rs.Decode(avail, n, out, scratch);
+    REQUIRE(ok == (nlost <= m));
+    if (!ok) {
+      continue;
+    }
+    for (size_t j = 0; j < k; ++j) {
+      REQUIRE(std::vector<uint8_t>(out[j], out[j] + n) == shards[j]);
+    }
+  }
+}
+
+TEST_CASE("ReedSolomon with a single shard of each kind", "[erasure_helpers]") {
+  h5::ReedSolomon rs(1, 1);
+  std::vector<uint8_t> data(64, 7), parity(64);
+  const uint8_t *in = data.data();
+  uint8_t *out_parity = parity.data();
+  rs.Encode(&in, &out_parity, data.size());
+
+  std::vector<const uint8_t*> avail = {nullptr, parity.data()}, out;
+  std::vector<std::vector<uint8_t>> scratch;
+  REQUIRE(rs.Decode(avail, data.size(), out, scratch));
+  REQUIRE(std::vector<uint8_t>(out[0], out[0] + data.size()) == data);
+}
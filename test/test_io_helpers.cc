@@ -0,0 +1,172 @@
+/*
+ * Extent placement and I/O engines.
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <fcntl.h>
+#include <memory>
+#include <set>
+#include <vector>
+#include "io_helpers.h"
+
+TEST_CASE("ExtentLayout keeps extents inside stripes", "[io_helpers]") {
+  const uint64_t stripe = 4096;
+
+  /* Small extents pack into a stripe, and the next stripe starts fresh */
+  h5::ExtentLayout small(1000, 512, stripe);
+  REQUIRE(small.size_ == 1024);
+  REQUIRE(small.per_ == 4);
+  REQUIRE(small.Offset(3) == 3072);
+  REQUIRE(small.Offset(4) == 4096);
+
+  /* Extents that do not divide the stripe leave its tail unused */
+  h5::ExtentLayout odd(3000, 512, stripe);
+  REQUIRE(odd.size_ == 3072);
+  for (uint64_t slot = 0; slot < 8; ++slot) {
+    REQUIRE(odd.Offset(slot) == slot * stripe);
+  }
+
+  /* Extents larger than a stripe take whole stripes */
+  h5::ExtentLayout big(5000, 512, stripe);
+  REQUIRE(big.size_ == 2 * stripe);
+  REQUIRE(big.Offset(1) == 2 * stripe);
+
+  /* Without striping extents are contiguous */
+  h5::ExtentLayout flat(1000, 512, 0);
+  REQUIRE(flat.Offset(5) == 5 * 1024);
+
+  /* A stripe size that is not a multiple of the alignment is rounded up */
+  h5::ExtentLayout rounded(1000, 512, 1000);
+  REQUIRE(rounded.period_ == 1024);
+}
+
+TEST_CASE("ExtentLayout places every extent on as few stripes as possible", "[io_helpers]") {
+  for (uint64_t bytes : {1, 511, 512, 1000, 4096, 4097, 10000}) {
+    for (uint64_t align : {1, 512, 4096}) {
+      for (uint64_t stripe : {0, 4096, 65536}) {
+        h5::ExtentLayout layout(bytes, align, stripe);
+        uint64_t end = 0;
+        for (uint64_t slot = 0; slot < 64; ++slot) {
+          uint64_t off = layout.Offset(slot);
+          REQUIRE(off % align == 0);
+          REQUIRE(off >= end);
+          end = off + layout.size_;
+          if (stripe && layout.size_ <= stripe) {
+            REQUIRE(off / stripe == (end - 1) / stripe);
+          } else if (stripe) {
+            REQUIRE(off % stripe == 0);
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST_CASE("ExtentLayout spreads consecutive extents over the stripe count", "[io_helpers]") {
+  const uint64_t stripe = 4096, count = 4;
+
+  /* One extent per stripe: OSTs are visited in turn and wrap around */
+  h5::ExtentLayout one(3000, 512, stripe);
+  for (uint64_t slot = 0; slot < 3 * count; ++slot) {
+    REQUIRE(one.Offset(slot) / stripe % count == slot % count);
+  }
+
+  /* Two stripes per extent: each extent spans a pair of OSTs */
+  h5::ExtentLayout two(8000, 512, stripe);
+  std::set<uint64_t> osts;
+  for (uint64_t slot = 0; slot < 2 * count; ++slot) {
+    uint64_t first = two.Offset(slot) / stripe % count;
+    uint64_t last = (two.Offset(slot) + two.size_ - 1) / stripe % count;
+    REQUIRE(last == (first + 1) % count);
+    osts.insert(first);
+  }
+  REQUIRE(osts == std::set<uint64_t>{0, 2});
+}
+
+TEST_CASE("ExtentLayout finds the first slot at or after an offset", "[io_helpers]") {
+  for (uint64_t bytes : {1000, 3000, 5000}) {
+    h5::ExtentLayout layout(bytes, 512, 4096);
+    for (uint64_t off = 0; off < 64 * 1024; off += 256) {
+      uint64_t slot = layout.FirstSlot(off);
+      REQUIRE(layout.Offset(slot) >= off);
+      if (slot > 0) {
+        REQUIRE(layout.Offset(slot - 1) < off);
+      }
+    }
+  }
+}
+
+namespace {
+
+/** Write a few extents to a scratch file with \a engine, then read them and a hole past EOF back */
+void RoundTrip(h5::IoEngine &engine) {
+  char path[] = "/tmp/test_io_helpersXXXXXX";
+  int fd = mkstemp(path);
+  REQUIRE(fd >= 0);
+  unlink(path);
+
+  /* Small transfers, one larger than a uring slot, and an unaligned offset */
+  const size_t sizes[] = {100, 4096, 1 << 20, 3};
+  const uint64_t offs[] = {0, 4096, 8192, 8192 + (1 << 20) + 5};
+  std::vector<std::vector<char>> data, back;
+  std::vector<h5::IoOp> ops;
+  for (size_t i = 0; i < 4; ++i) {
+    data.emplace_back(sizes[i], (char)('a' + i));
+    ops.push_back(h5::IoOp{fd, true, data[i].data(), sizes[i], offs[i], 0});
+  }
+  REQUIRE(engine.Submit(ops.data(), ops.size()) == 0);
+
+  ops.clear();
+  for (size_t i = 0; i < 4; ++i) {
+    back.emplace_back(sizes[i] + 64, 'x');
+    ops.push_back(h5::IoOp{fd, false, back[i].data(), sizes[i], offs[i], 0});
+  }
+  /* The write never touched [100, 4096) or anything past the last extent */
+  std::vector<char> hole(512, 'x'), tail(4096, 'x');
+  ops.push_back(h5::IoOp{fd, false, hole.data(), hole.size(), 1024, 0});
+  ops.push_back(h5::IoOp{fd, false, tail.data(), tail.size(), offs[3] + 1, 0});
+  REQUIRE(engine.Submit(ops.data(), ops.size()) == 0);
+  for (size_t i = 0; i < 4; ++i) {
+    REQUIRE(ops[i].ret_ == (ssize_t)sizes[i]);
+    REQUIRE(std::vector<char>(back[i].begin(), back[i].begin() + sizes[i]) == data[i]);
+    REQUIRE(back[i][sizes[i]] == 'x');
+  }
+  REQUIRE(hole == std::vector<char>(hole.size(), 0));
+  REQUIRE(std::vector<char>(tail.begin(), tail.begin() + 2) == std::vector<char>(2, 'd'));
+  REQUIRE(std::vector<char>(tail.begin() + 2, tail.end()) == std::vector<char>(tail.size() - 2, 0));
+
+  engine.Release(fd);
+  close(fd);
+}
+
+}  // namespace
+
+TEST_CASE("PosixIoEngine round-trips and zero-fills past EOF", "[io_helpers]") {
+  h5::PosixIoEngine engine;
+  RoundTrip(engine);
+
+  /* Writes to a read-only descriptor report -errno */
+  char buf[16] = {0};
+  int fd = open("/dev/null", O_RDONLY);
+  h5::IoOp op{fd, true, buf, sizeof(buf), 0, 0};
+  REQUIRE(engine.Submit(&op, 1) == -1);
+  REQUIRE(op.ret_ == -EBADF);
+  close(fd);
+}
+
+TEST_CASE("MakeIoEngine engines round-trip", "[io_helpers]") {
+  REQUIRE(h5::ParseIoEngine("posix") == h5::kIoPosix);
+  REQUIRE(h5::ParseIoEngine("mmap") == -1);
+#ifdef HDF5_VOLS_ENABLE_LIBAIO
+  REQUIRE(h5::ParseIoEngine("aio") == h5::kIoAio);
+#endif
+#ifdef HDF5_VOLS_ENABLE_URING
+  REQUIRE(h5::ParseIoEngine("uring") == h5::kIoUring);
+#endif
+  /* Kinds this build or kernel lacks fall back to POSIX */
+  for (int kind : {h5::kIoPosix, h5::kIoAio, h5::kIoUring}) {
+    std::unique_ptr<h5::IoEngine> engine = h5::MakeIoEngine(kind, 8, false);
+    REQUIRE(engine != nullptr);
+    RoundTrip(*engine);
+  }
+}
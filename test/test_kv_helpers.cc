@@ -0,0 +1,105 @@
+/*
+ * KvStore log replay and checkpoints.
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <fstream>
+#include <iterator>
+#include <stdio.h>
+#include <string>
+#include "kv_helpers.h"
+
+namespace {
+
+const char *kDb = "test_kv_helpers.db";
+const char *kWal = "test_kv_helpers.wal";
+
+std::string Slurp(const char *path) {
+  std::ifstream in(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+void Spill(const char *path, const std::string &data) {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(data.data(), (std::streamsize)data.size());
+}
+
+}  // namespace
+
+TEST_CASE("KvStore replays its log and drops a torn tail", "[kv_helpers]") {
+  std::string synced, log;
+  remove(kDb);
+  remove(kWal);
+  {
+    h5::KvStore store;
+    h5::KvBatch first, second, third;
+    REQUIRE(store.Open(kDb, kWal, true) == 0);
+    first.Put("a", "1");
+    first.Put("b", "2");
+    second.Put("c", "3");
+    second.Delete("a");
+    REQUIRE(store.Write(first) == 0);
+    REQUIRE(store.Write(second) == 0);
+    REQUIRE(store.Sync() == 0);
+    synced = Slurp(kWal);
+    third.Put("d", "4");
+    REQUIRE(store.Write(third) == 0);
+    REQUIRE(store.Sync() == 0);
+    log = Slurp(kWal);
+    REQUIRE(log.size() > synced.size());
+  }
+
+  /* A crash in the middle of the last append leaves no snapshot and a
+   * log missing the end of its last record */
+  remove(kDb);
+  Spill(kWal, log.substr(0, log.size() - 3));
+
+  h5::KvStore store;
+  REQUIRE(store.Open(kDb, kWal, true) == 0);
+  REQUIRE(store.Get("a") == nullptr);
+  REQUIRE(store.Get("b") != nullptr);
+  REQUIRE(*store.Get("b") == "2");
+  REQUIRE(store.Get("c") != nullptr);
+  REQUIRE(*store.Get("c") == "3");
+  REQUIRE(store.Get("d") == nullptr);
+  REQUIRE(Slurp(kWal) == synced);
+
+  /* The store keeps appending after the dropped record */
+  h5::KvBatch fourth;
+  fourth.Put("e", "5");
+  REQUIRE(store.Write(fourth) == 0);
+  REQUIRE(store.Close() == 0);
+  REQUIRE(store.Open(kDb, kWal, false) == 0);
+  REQUIRE(store.Get("e") != nullptr);
+  REQUIRE(*store.Get("e") == "5");
+  REQUIRE(store.Get("d") == nullptr);
+  remove(kDb);
+  remove(kWal);
+}
+
+TEST_CASE("KvStore ignores a corrupt log record and what follows", "[kv_helpers]") {
+  std::string log;
+  remove(kDb);
+  remove(kWal);
+  {
+    h5::KvStore store;
+    h5::KvBatch first, second;
+    REQUIRE(store.Open(kDb, kWal, true) == 0);
+    first.Put("x", "1");
+    second.Put("y", "2");
+    REQUIRE(store.Write(first) == 0);
+    REQUIRE(store.Write(second) == 0);
+    REQUIRE(store.Sync() == 0);
+    log = Slurp(kWal);
+  }
+  remove(kDb);
+
+  /* Flip a byte in the payload of the first record */
+  log[12] ^= 0x40;
+  Spill(kWal, log);
+  h5::KvStore store;
+  REQUIRE(store.Open(kDb, kWal, false) == 0);
+  REQUIRE(store.Get("x") == nullptr);
+  REQUIRE(store.Get("y") == nullptr);
+  remove(kWal);
+}
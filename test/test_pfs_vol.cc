@@ -0,0 +1,643 @@
+/*
+ * Round trips through pfs_vol.
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <hdf5.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace {
+
+/** A fapl routing files through pfs_vol with the given parameters */
+hid_t PfsFapl(const char *params) {
+  hid_t vol = H5VLregister_connector_by_name("pfs_vol", H5P_DEFAULT);
+  hid_t fapl = H5Pcreate(H5P_FILE_ACCESS);
+  void *info = nullptr;
+  REQUIRE(vol >= 0);
+  REQUIRE(H5VLconnector_str_to_info(params, vol, &info) >= 0);
+  REQUIRE(H5Pset_vol(fapl, vol, info) >= 0);
+  H5VLfree_connector_info(vol, info);
+  H5VLclose(vol);
+  return fapl;
+}
+
+/** Write rows [lo, hi) of a 2-D int dataset */
+void WriteRows(hid_t dset, hsize_t lo, hsize_t hi, hsize_t ncols, const std::vector<int> &data) {
+  hid_t space = H5Dget_space(dset);
+  hsize_t start[2] = {lo, 0}, count[2] = {hi - lo, ncols};
+  hid_t mem = H5Screate_simple(2, count, nullptr);
+  REQUIRE(H5Sselect_hyperslab(space, H5S_SELECT_SET, start, nullptr, count, nullptr) >= 0);
+  REQUIRE(H5Dwrite(dset, H5T_NATIVE_INT, mem, space, H5P_DEFAULT, data.data() + lo * ncols) >= 0);
+  H5Sclose(mem);
+  H5Sclose(space);
+}
+
+/** The directory holding the chunks and meta file of the only dataset in a container */
+std::string DatasetDir(const char *path) {
+  std::vector<std::string> dirs;
+  for (const auto &entry : std::filesystem::directory_iterator(std::string(path) + "/.pfs_vol.d")) {
+    dirs.push_back(entry.path().string());
+  }
+  REQUIRE(dirs.size() == 1);
+  return dirs[0];
+}
+
+/** Blocks of a 64x64 dataset as {start, count}; they overlap, so later ones win */
+const hsize_t kBlocks[][4] = {{0, 0, 20, 20}, {10, 10, 30, 5}, {5, 3, 2, 60}, {40, 40, 24, 24}, {12, 0, 1, 64}};
+
+/**
+ * Write each of kBlocks with distinct values starting at \a base and
+ * mirror them in \a expect. With a negative \a dset only \a expect is
+ * updated.
+ */
+void WriteBlocks(hid_t dset, int base, std::vector<int> &expect) {
+  for (const hsize_t *b : kBlocks) {
+    std::vector<int> block(b[2] * b[3]);
+    for (hsize_t i = 0; i < b[2]; ++i) {
+      for (hsize_t j = 0; j < b[3]; ++j) {
+        block[i * b[3] + j] = base++;
+        expect[(b[0] + i) * 64 + b[1] + j] = block[i * b[3] + j];
+      }
+    }
+    if (dset < 0) {
+      continue;
+    }
+    hid_t space = H5Dget_space(dset);
+    hid_t mem = H5Screate_simple(2, b + 2, nullptr);
+    REQUIRE(H5Sselect_hyperslab(space, H5S_SELECT_SET, b, nullptr, b + 2, nullptr) >= 0);
+    REQUIRE(H5Dwrite(dset, H5T_NATIVE_INT, mem, space, H5P_DEFAULT, block.data()) >= 0);
+    H5Sclose(mem);
+    H5Sclose(space);
+  }
+}
+
+/** Read a whole int dataset of \a path through \a fapl */
+std::vector<int> ReadAll(const char *path, hid_t fapl, const char *name, size_t n) {
+  std::vector<int> out(n, -1);
+  hid_t file = H5Fopen(path, H5F_ACC_RDONLY, fapl);
+  REQUIRE(file >= 0);
+  hid_t dset = H5Dopen2(file, name, H5P_DEFAULT);
+  REQUIRE(dset >= 0);
+  REQUIRE(H5Dread(dset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out.data()) >= 0);
+  H5Dclose(dset);
+  H5Fclose(file);
+  return out;
+}
+
+/**
+ * Write kBlocks in rounds through \a params, check that a second handle
+ * with a plain fapl reads them from disk once H5Fflush returned, while
+ * the writer is still open, and that they survive a reopen.
+ */
+void FlushRoundTrip(const char *path, const char *params) {
+  hsize_t dims[2] = {64, 64}, chunk[2] = {16, 16};
+  std::vector<int> expect(dims[0] * dims[1], 0), out(expect.size(), -1);
+
+  hid_t fapl = PfsFapl(params);
+  hid_t plain = PfsFapl("io=posix");
+  hid_t file = H5Fcreate(path, H5F_ACC_TRUNC, H5P_DEFAULT, fapl);
+  REQUIRE(file >= 0);
+  hid_t space = H5Screate_simple(2, dims, nullptr);
+  hid_t dcpl = H5Pcreate(H5P_DATASET_CREATE);
+  REQUIRE(H5Pset_chunk(dcpl, 2, chunk) >= 0);
+  hid_t dset = H5Dcreate2(file, "data", H5T_NATIVE_INT, space, H5P_DEFAULT, dcpl, H5P_DEFAULT);
+  REQUIRE(dset >= 0);
+  for (int round = 0; round < 4; ++round) {
+    WriteBlocks(dset, round * 10000 + 1, expect);
+    REQUIRE(H5Dread(dset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out.data()) >= 0);
+    REQUIRE(out == expect);
+  }
+  REQUIRE(H5Fflush(file, H5F_SCOPE_GLOBAL) >= 0);
+  REQUIRE(ReadAll(path, plain, "data", expect.size()) == expect);
+  REQUIRE(H5Dclose(dset) >= 0);
+  REQUIRE(H5Fclose(file) >= 0);
+  REQUIRE(ReadAll(path, fapl, "data", expect.size()) == expect);
+  H5Pclose(dcpl);
+  H5Sclose(space);
+  H5Pclose(plain);
+  H5Pclose(fapl);
+  std::filesystem::remove_all(path);
+}
+
+/**
+ * Run \a body in a forked child that exits without closing anything, as
+ * a crashed writer would. True if \a body returned true.
+ */
+template <typename F>
+bool InChild(F body) {
+  pid_t pid = fork();
+  int status = 0;
+  if (pid == 0) {
+    bool ok = false;
+    try {
+      ok = body();
+    } catch (...) {
+    }
+    _exit(ok ? 0 : 1);
+  }
+  return pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+/** Names of the links in group \a name of \a loc, in name order */
+std::vector<std::string> LinkNames(hid_t loc, const char *name) {
+  std::vector<std::string> names;
+  hsize_t idx = 0;
+  hid_t group = H5Gopen2(loc, name, H5P_DEFAULT);
+  REQUIRE(group >= 0);
+  REQUIRE(H5Literate2(group, H5_INDEX_NAME, H5_ITER_INC, &idx,
+                      [](hid_t, const char *link, const H5L_info2_t *, void *data) -> herr_t {
+                        ((std::vector<std::string> *)data)->push_back(link);
+                        return 0;
+                      },
+                      &names) >= 0);
+  H5Gclose(group);
+  return names;
+}
+
+/** Names of the attributes of object \a name of \a loc, in name order */
+std::vector<std::string> AttrNames(hid_t loc, const char *name) {
+  std::vector<std::string> names;
+  hsize_t idx = 0;
+  hid_t obj = H5Oopen(loc, name, H5P_DEFAULT);
+  REQUIRE(obj >= 0);
+  REQUIRE(H5Aiterate2(obj, H5_INDEX_NAME, H5_ITER_INC, &idx,
+                      [](hid_t, const char *attr, const H5A_info_t *, void *data) -> herr_t {
+                        ((std::vector<std::string> *)data)->push_back(attr);
+                        return 0;
+                      },
+                      &names) >= 0);
+  H5Oclose(obj);
+  return names;
+}
+
+/** Read the scalar int attribute \a attr of object \a name of \a loc */
+int ReadIntAttr(hid_t loc, const char *name, const char *attr) {
+  int value = -1;
+  hid_t id = H5Aopen_by_name(loc, name, attr, H5P_DEFAULT, H5P_DEFAULT);
+  REQUIRE(id >= 0);
+  REQUIRE(H5Aread(id, H5T_NATIVE_INT, &value) >= 0);
+  H5Aclose(id);
+  return value;
+}
+
+/** Create the scalar int attribute \a attr on \a obj */
+void WriteIntAttr(hid_t obj, const char *attr, int value) {
+  hid_t space = H5Screate(H5S_SCALAR);
+  hid_t id = H5Acreate2(obj, attr, H5T_NATIVE_INT, space, H5P_DEFAULT, H5P_DEFAULT);
+  REQUIRE(id >= 0);
+  REQUIRE(H5Awrite(id, H5T_NATIVE_INT, &value) >= 0);
+  H5Aclose(id);
+  H5Sclose(space);
+}
+
+}  // namespace
+
+TEST_CASE("pfs_vol reads through a mapping of the data file", "[pfs_vol]") {
+  const char *path = "test_pfs_vol_mmap.h5";
+  hsize_t dims[2] = {256, 100}, chunk[2] = {16, 100};
+  std::vector<int> data(dims[0] * dims[1]), out(data.size(), -1), expect(data.size(), 0);
+
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = (int)i;
+  }
+  hid_t fapl = PfsFapl("mmap=1:io=posix");
+  hid_t file = H5Fcreate(path, H5F_ACC_TRUNC, H5P_DEFAULT, fapl);
+  REQUIRE(file >= 0);
+  hid_t space = H5Screate_simple(2, dims, nullptr);
+  hid_t dcpl = H5Pcreate(H5P_DATASET_CREATE);
+  H5Pset_chunk(dcpl, 2, chunk);
+  hid_t dset = H5Dcreate2(file, "data", H5T_NATIVE_INT, space, H5P_DEFAULT, dcpl, H5P_DEFAULT);
+  REQUIRE(dset >= 0);
+
+  /* Only the first half is written; the rest reads as zeros */
+  WriteRows(dset, 0, dims[0] / 2, dims[1], data);
+  std::copy(data.begin(), data.begin() + data.size() / 2, expect.begin());
+  REQUIRE(H5Dread(dset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out.data()) >= 0);
+  REQUIRE(out == expect);
+
+  /* Chunks allocated past the mapped length are picked up by a remap */
+  WriteRows(dset, dims[0] / 2, dims[0], dims[1], data);
+  REQUIRE(H5Dread(dset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out.data()) >= 0);
+  REQUIRE(out == data);
+  REQUIRE(H5Dclose(dset) >= 0);
+  REQUIRE(H5Fclose(file) >= 0);
+
+  /* Reopen read-only and read a block straddling chunk edges */
+  file = H5Fopen(path, H5F_ACC_RDONLY, fapl);
+  REQUIRE(file >= 0);
+  dset = H5Dopen2(file, "data", H5P_DEFAULT);
+  REQUIRE(dset >= 0);
+  hsize_t start[2] = {10, 3}, count[2] = {40, 50};
+  hid_t fspace = H5Dget_space(dset);
+  hid_t mem = H5Screate_simple(2, count, nullptr);
+  std::vector<int> block(count[0] * count[1], -1);
+  REQUIRE(H5Sselect_hyperslab(fspace, H5S_SELECT_SET, start, nullptr, count, nullptr) >= 0);
+  REQUIRE(H5Dread(dset, H5T_NATIVE_INT, mem, fspace, H5P_DEFAULT, block.data()) >= 0);
+  for (hsize_t i = 0; i < count[0]; ++i) {
+    for (hsize_t j = 0; j < count[1]; ++j) {
+      REQUIRE(block[i * count[1] + j] == data[(start[0] + i) * dims[1] + start[1] + j]);
+    }
+  }
+  H5Sclose(mem);
+  H5Sclose(fspace);
+  H5Dclose(dset);
+  H5Fclose(file);
+  H5Pclose(dcpl);
+  H5Sclose(space);
+  H5Pclose(fapl);
+  std::filesystem::remove_all(path);
+}
+
+TEST_CASE("pfs_vol keeps the layout and extent of a chunked dataset", "[pfs_vol]") {
+  const char *path = "test_pfs_vol_layout.h5";
+  hsize_t dims[2] = {50, 70}, max_dims[2] = {H5S_UNLIMITED, 70}, chunk[2] = {16, 32}, grown[2] = {90, 70};
+  hsize_t got[2] = {0, 0}, got_max[2] = {0, 0}, got_chunk[2] = {0, 0};
+  std::vector<int> data(grown[0] * grown[1]), out(data.size(), -1);
+
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = (int)i + 1;
+  }
+  hid_t fapl = PfsFapl("io=posix");
+  hid_t file = H5Fcreate(path, H5F_ACC_TRUNC, H5P_DEFAULT, fapl);
+  REQUIRE(file >= 0);
+  hid_t space = H5Screate_simple(2, dims, max_dims);
+  hid_t dcpl = H5Pcreate(H5P_DATASET_CREATE);
+  REQUIRE(H5Pset_chunk(dcpl, 2, chunk) >= 0);
+  hid_t dset = H5Dcreate2(file, "grid", H5T_NATIVE_INT, space, H5P_DEFAULT, dcpl, H5P_DEFAULT);
+  REQUIRE(dset >= 0);
+  WriteRows(dset, 0, dims[0], dims[1], data);
+
+  /* Grow along the unlimited dimension and fill the new rows */
+  REQUIRE(H5Dset_extent(dset, grown) >= 0);
+  WriteRows(dset, dims[0], grown[0], grown[1], data);
+  REQUIRE(H5Dclose(dset) >= 0);
+  REQUIRE(H5Fclose(file) >= 0);
+
+  /* The chunks and the meta file sit in the dataset's own directory */
+  std::string dir = DatasetDir(path);
+  REQUIRE(std::filesystem::exists(dir + "/meta"));
+  REQUIRE(std::filesystem::exists(dir + "/data"));
+
+  /* Type, extent and chunk shape come back from the meta file */
+  file = H5Fopen(path, H5F_ACC_RDWR, fapl);
+  REQUIRE(file >= 0);
+  dset = H5Dopen2(file, "grid", H5P_DEFAULT);
+  REQUIRE(dset >= 0);
+  hid_t type = H5Dget_type(dset);
+  REQUIRE(H5Tequal(type, H5T_NATIVE_INT) > 0);
+  hid_t fspace = H5Dget_space(dset);
+  REQUIRE(H5Sget_simple_extent_dims(fspace, got, got_max) == 2);
+  REQUIRE(got[0] == grown[0]);
+  REQUIRE(got[1] == grown[1]);
+  REQUIRE(got_max[0] == H5S_UNLIMITED);
+  REQUIRE(got_max[1] == max_dims[1]);
+  hid_t got_dcpl = H5Dget_create_plist(dset);
+  REQUIRE(H5Pget_layout(got_dcpl) == H5D_CHUNKED);
+  REQUIRE(H5Pget_chunk(got_dcpl, 2, got_chunk) == 2);
+  REQUIRE(got_chunk[0] == chunk[0]);
+  REQUIRE(got_chunk[1] == chunk[1]);
+  REQUIRE(H5Dread(dset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out.data()) >= 0);
+  REQUIRE(out == data);
+
+  /* Shrinking keeps the rows inside the new extent, also after a reopen */
+  REQUIRE(H5Dset_extent(dset, dims) >= 0);
+  REQUIRE(H5Dclose(dset) >= 0);
+  REQUIRE(H5Fclose(file) >= 0);
+  file = H5Fopen(path, H5F_ACC_RDONLY, fapl);
+  REQUIRE(file >= 0);
+  dset = H5Dopen2(file, "grid", H5P_DEFAULT);
+  REQUIRE(dset >= 0);
+  H5Sclose(fspace);
+  fspace = H5Dget_space(dset);
+  REQUIRE(H5Sget_simple_extent_dims(fspace, got, nullptr) == 2);
+  REQUIRE(got[0] == dims[0]);
+  out.assign(dims[0] * dims[1], -1);
+  REQUIRE(H5Dread(dset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out.data()) >= 0);
+  REQUIRE(std::equal(out.begin(), out.end(), data.begin()));
+  H5Pclose(got_dcpl);
+  H5Sclose(fspace);
+  H5Tclose(type);
+  H5Dclose(dset);
+  H5Fclose(file);
+  H5Pclose(dcpl);
+  H5Sclose(space);
+  H5Pclose(fapl);
+  std::filesystem::remove_all(path);
+}
+
+TEST_CASE("pfs_vol reads logged writes before and after compaction", "[pfs_vol]") {
+  const char *path = "test_pfs_vol_log.h5";
+  hsize_t dims[2] = {64, 64}, chunk[2] = {16, 16};
+  std::vector<int> expect(dims[0] * dims[1], 0), out(expect.size(), -1);
+
+  hid_t fapl = PfsFapl("log=1:io=posix");
+  hid_t plain = PfsFapl("io=posix");
+  hid_t file = H5Fcreate(path, H5F_ACC_TRUNC, H5P_DEFAULT, fapl);
+  REQUIRE(file >= 0);
+  hid_t space = H5Screate_simple(2, dims, nullptr);
+  hid_t dcpl = H5Pcreate(H5P_DATASET_CREATE);
+  REQUIRE(H5Pset_chunk(dcpl, 2, chunk) >= 0);
+  hid_t dset = H5Dcreate2(file, "log", H5T_NATIVE_INT, space, H5P_DEFAULT, dcpl, H5P_DEFAULT);
+  REQUIRE(dset >= 0);
+  std::string log = DatasetDir(path) + "/log.0";
+
+  /* Before compaction the writes are only in the log */
+  WriteBlocks(dset, 1, expect);
+  REQUIRE(std::filesystem::file_size(log) > 0);
+  REQUIRE(H5Dread(dset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out.data()) >= 0);
+  REQUIRE(out == expect);
+
+  /* A flush merges the log into the chunks and empties it */
+  REQUIRE(H5Dflush(dset) >= 0);
+  REQUIRE(std::filesystem::file_size(log) == 0);
+  REQUIRE(H5Dread(dset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out.data()) >= 0);
+  REQUIRE(out == expect);
+
+  /* Logged writes over compacted ones win, also after a reopen */
+  WriteBlocks(dset, 100000, expect);
+  REQUIRE(H5Dread(dset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out.data()) >= 0);
+  REQUIRE(out == expect);
+  REQUIRE(H5Dclose(dset) >= 0);
+  REQUIRE(H5Fclose(file) >= 0);
+  REQUIRE(ReadAll(path, fapl, "log", expect.size()) == expect);
+  REQUIRE(ReadAll(path, plain, "log", expect.size()) == expect);
+
+  /* A writer dying before close leaves its log to be replayed */
+  REQUIRE(InChild([&]() {
+    std::vector<int> mirror(expect);
+    hid_t f = H5Fopen(path, H5F_ACC_RDWR, fapl);
+    hid_t d = H5Dopen2(f, "log", H5P_DEFAULT);
+    WriteBlocks(d, 200000, mirror);
+    return f >= 0 && d >= 0;
+  }));
+  WriteBlocks(-1, 200000, expect);
+  REQUIRE(std::filesystem::file_size(log) > 0);
+  REQUIRE(ReadAll(path, fapl, "log", expect.size()) == expect);
+  file = H5Fopen(path, H5F_ACC_RDWR, fapl);
+  REQUIRE(file >= 0);
+  dset = H5Dopen2(file, "log", H5P_DEFAULT);
+  REQUIRE(dset >= 0);
+  REQUIRE(H5Dclose(dset) >= 0);
+  REQUIRE(H5Fclose(file) >= 0);
+  REQUIRE(std::filesystem::file_size(log) == 0);
+  REQUIRE(ReadAll(path, plain, "log", expect.size()) == expect);
+  H5Pclose(dcpl);
+  H5Sclose(space);
+  H5Pclose(plain);
+  H5Pclose(fapl);
+  std::filesystem::remove_all(path);
+}
+
+TEST_CASE("pfs_vol compacts the log in the background while writes go on", "[pfs_vol]") {
+  const char *path = "test_pfs_vol_log_compact.h5";
+  hsize_t dims[2] = {64, 64}, chunk[2] = {16, 16};
+  std::vector<int> expect(dims[0] * dims[1], 0), out(expect.size(), -1);
+
+  hid_t fapl = PfsFapl("log=1:log_compact=8k:threads=2:io=posix");
+  hid_t file = H5Fcreate(path, H5F_ACC_TRUNC, H5P_DEFAULT, fapl);
+  REQUIRE(file >= 0);
+  hid_t space = H5Screate_simple(2, dims, nullptr);
+  hid_t dcpl = H5Pcreate(H5P_DATASET_CREATE);
+  REQUIRE(H5Pset_chunk(dcpl, 2, chunk) >= 0);
+  hid_t dset = H5Dcreate2(file, "log", H5T_NATIVE_INT, space, H5P_DEFAULT, dcpl, H5P_DEFAULT);
+  REQUIRE(dset >= 0);
+  for (int round = 0; round < 20; ++round) {
+    WriteBlocks(dset, round * 10000, expect);
+    REQUIRE(H5Dread(dset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out.data()) >= 0);
+    REQUIRE(out == expect);
+  }
+  REQUIRE(H5Dclose(dset) >= 0);
+  REQUIRE(H5Fclose(file) >= 0);
+  REQUIRE(ReadAll(path, fapl, "log", expect.size()) == expect);
+  H5Pclose(dcpl);
+  H5Sclose(space);
+  H5Pclose(fapl);
+  std::filesystem::remove_all(path);
+}
+
+TEST_CASE("pfs_vol round trips a subfiled container on one rank", "[pfs_vol]") {
+  const char *path = "test_pfs_vol_subfile.h5";
+  const char *params[] = {"subfiling=rank:io=posix", "subfiling=node:io=posix",
+                          "subfiling=rank:cb_write=enable:io=posix"};
+  hsize_t dims[2] = {64, 64}, chunk[2] = {16, 16};
+
+  for (const char *param : params) {
+    std::vector<int> expect(dims[0] * dims[1], 0), out(expect.size(), -1);
+    hid_t fapl = PfsFapl(param);
+    hid_t plain = PfsFapl("io=posix");
+    hid_t file = H5Fcreate(path, H5F_ACC_TRUNC, H5P_DEFAULT, fapl);
+    REQUIRE(file >= 0);
+    hid_t space = H5Screate_simple(2, dims, nullptr);
+    hid_t dcpl = H5Pcreate(H5P_DATASET_CREATE);
+    REQUIRE(H5Pset_chunk(dcpl, 2, chunk) >= 0);
+    hid_t dset = H5Dcreate2(file, "sub", H5T_NATIVE_INT, space, H5P_DEFAULT, dcpl, H5P_DEFAULT);
+    REQUIRE(dset >= 0);
+    WriteBlocks(dset, 1, expect);
+    REQUIRE(H5Dread(dset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out.data()) >= 0);
+    REQUIRE(out == expect);
+    REQUIRE(H5Dclose(dset) >= 0);
+    REQUIRE(H5Fclose(file) >= 0);
+
+    /* A single rank writes subfile 1; the merge at close records where its chunks went */
+    REQUIRE(std::filesystem::exists(DatasetDir(path) + "/data.1"));
+    REQUIRE(ReadAll(path, fapl, "sub", expect.size()) == expect);
+    REQUIRE(ReadAll(path, plain, "sub", expect.size()) == expect);
+
+    /* Rewrites in a later session win over the chunks of the first */
+    file = H5Fopen(path, H5F_ACC_RDWR, fapl);
+    REQUIRE(file >= 0);
+    dset = H5Dopen2(file, "sub", H5P_DEFAULT);
+    REQUIRE(dset >= 0);
+    WriteBlocks(dset, 100000, expect);
+    REQUIRE(H5Dclose(dset) >= 0);
+    REQUIRE(H5Fclose(file) >= 0);
+    REQUIRE(ReadAll(path, fapl, "sub", expect.size()) == expect);
+    H5Pclose(dcpl);
+    H5Sclose(space);
+    H5Pclose(plain);
+    H5Pclose(fapl);
+    std::filesystem::remove_all(path);
+  }
+}
+
+TEST_CASE("pfs_vol writes staged chunks back on flush", "[pfs_vol]") {
+  FlushRoundTrip("test_pfs_vol_stage.h5", "stage_size=1m:stage_block=4k:io=posix");
+}
+
+TEST_CASE("pfs_vol writes cached chunks back on flush", "[pfs_vol]") {
+  /* Everything stays cached until the flush, or chunks are evicted along the way */
+  FlushRoundTrip("test_pfs_vol_cache.h5", "cache_size=1m:io=posix");
+  FlushRoundTrip("test_pfs_vol_cache.h5", "cache_size=4k:io=posix");
+}
+
+TEST_CASE("pfs_vol reads strided selections correctly while prefetching", "[pfs_vol]") {
+  const char *path = "test_pfs_vol_prefetch.h5";
+  hsize_t dims[2] = {512, 64}, chunk[2] = {8, 64};
+  hsize_t stride[2] = {2, 1}, count[2] = {4, 64};
+  std::vector<int> expect(dims[0] * dims[1]), out(count[0] * count[1]), all(expect.size());
+
+  for (size_t i = 0; i < expect.size(); ++i) {
+    expect[i] = (int)i;
+  }
+  hid_t plain = PfsFapl("io=posix");
+  hid_t file = H5Fcreate(path, H5F_ACC_TRUNC, H5P_DEFAULT, plain);
+  REQUIRE(file >= 0);
+  hid_t space = H5Screate_simple(2, dims, nullptr);
+  hid_t dcpl = H5Pcreate(H5P_DATASET_CREATE);
+  REQUIRE(H5Pset_chunk(dcpl, 2, chunk) >= 0);
+  hid_t dset = H5Dcreate2(file, "data", H5T_NATIVE_INT, space, H5P_DEFAULT, dcpl, H5P_DEFAULT);
+  REQUIRE(dset >= 0);
+  WriteRows(dset, 0, dims[0], dims[1], expect);
+  REQUIRE(H5Dclose(dset) >= 0);
+  REQUIRE(H5Fclose(file) >= 0);
+
+  /* Every other row of every third chunk: a strided pattern the prefetcher follows */
+  hid_t fapl = PfsFapl("cache_size=16k:prefetch=4:io=posix");
+  file = H5Fopen(path, H5F_ACC_RDWR, fapl);
+  REQUIRE(file >= 0);
+  dset = H5Dopen2(file, "data", H5P_DEFAULT);
+  REQUIRE(dset >= 0);
+  hid_t fspace = H5Dget_space(dset);
+  hid_t mem = H5Screate_simple(2, count, nullptr);
+  for (hsize_t k = 0; k < 21; ++k) {
+    hsize_t start[2] = {k * 3 * chunk[0], 0};
+
+    /* Rewrite a chunk ahead of the reader, which may already be prefetched */
+    if (k == 10) {
+      hsize_t row = 12 * 3 * chunk[0];
+      for (size_t i = row * dims[1]; i < (row + chunk[0]) * dims[1]; ++i) {
+        expect[i] = -(int)i;
+      }
+      WriteRows(dset, row, row + chunk[0], dims[1], expect);
+    }
+    REQUIRE(H5Sselect_hyperslab(fspace, H5S_SELECT_SET, start, stride, count, nullptr) >= 0);
+    REQUIRE(H5Dread(dset, H5T_NATIVE_INT, mem, fspace, H5P_DEFAULT, out.data()) >= 0);
+    for (hsize_t i = 0; i < count[0]; ++i) {
+      for (hsize_t j = 0; j < count[1]; ++j) {
+        REQUIRE(out[i * count[1] + j] == expect[(start[0] + i * stride[0]) * dims[1] + j]);
+      }
+    }
+  }
+  REQUIRE(H5Dread(dset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, all.data()) >= 0);
+  REQUIRE(all == expect);
+  REQUIRE(H5Dclose(dset) >= 0);
+  REQUIRE(H5Fclose(file) >= 0);
+  REQUIRE(ReadAll(path, plain, "data", expect.size()) == expect);
+  H5Sclose(mem);
+  H5Sclose(fspace);
+  H5Pclose(dcpl);
+  H5Sclose(space);
+  H5Pclose(fapl);
+  H5Pclose(plain);
+  std::filesystem::remove_all(path);
+}
+
+TEST_CASE("pfs_vol keeps groups, links and attributes", "[pfs_vol]") {
+  const char *path = "test_pfs_vol_md.h5";
+  hsize_t dims[1] = {100};
+  std::vector<int> data(dims[0]), out(data.size(), -1);
+
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = (int)i * 3;
+  }
+  hid_t fapl = PfsFapl("io=posix");
+  hid_t file = H5Fcreate(path, H5F_ACC_TRUNC, H5P_DEFAULT, fapl);
+  REQUIRE(file >= 0);
+  hid_t a = H5Gcreate2(file, "a", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+  REQUIRE(a >= 0);
+  hid_t b = H5Gcreate2(a, "b", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+  REQUIRE(b >= 0);
+  REQUIRE(H5Gclose(H5Gcreate2(file, "/c", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) >= 0);
+  hid_t space = H5Screate_simple(1, dims, nullptr);
+  hid_t dset = H5Dcreate2(b, "d", H5T_NATIVE_INT, space, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+  REQUIRE(dset >= 0);
+  REQUIRE(H5Dwrite(dset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, data.data()) >= 0);
+  REQUIRE(H5Dclose(dset) >= 0);
+  REQUIRE(H5Lcreate_soft("/a/b", file, "s", H5P_DEFAULT, H5P_DEFAULT) >= 0);
+  REQUIRE(H5Lcreate_hard(file, "/a/b/d", file, "h", H5P_DEFAULT, H5P_DEFAULT) >= 0);
+  WriteIntAttr(a, "count", 42);
+  WriteIntAttr(a, "scale", 7);
+  WriteIntAttr(b, "depth", 2);
+
+  /* Create, open and iterate in the open container */
+  REQUIRE(LinkNames(file, "/") == std::vector<std::string>{"a", "c", "h", "s"});
+  REQUIRE(LinkNames(file, "/a") == std::vector<std::string>{"b"});
+  REQUIRE(AttrNames(file, "/a") == std::vector<std::string>{"count", "scale"});
+  REQUIRE(ReadIntAttr(file, "/s", "depth") == 2);
+  REQUIRE(H5Lexists(file, "/s/d", H5P_DEFAULT) > 0);
+
+  /* Delete a group link and an attribute */
+  REQUIRE(H5Ldelete(file, "/c", H5P_DEFAULT) >= 0);
+  REQUIRE(H5Adelete(a, "scale") >= 0);
+  REQUIRE(H5Lexists(file, "/c", H5P_DEFAULT) == 0);
+  REQUIRE(H5Aexists(a, "scale") == 0);
+  H5Gclose(b);
+  H5Gclose(a);
+  REQUIRE(H5Fclose(file) >= 0);
+
+  /* All of it is back after a reopen */
+  file = H5Fopen(path, H5F_ACC_RDONLY, fapl);
+  REQUIRE(file >= 0);
+  REQUIRE(LinkNames(file, "/") == std::vector<std::string>{"a", "h", "s"});
+  REQUIRE(AttrNames(file, "/a") == std::vector<std::string>{"count"});
+  REQUIRE(ReadIntAttr(file, "/a", "count") == 42);
+  REQUIRE(ReadIntAttr(file, "/a/b", "depth") == 2);
+  H5G_info_t info;
+  REQUIRE(H5Gget_info_by_name(file, "/a/b", &info, H5P_DEFAULT) >= 0);
+  REQUIRE(info.nlinks == 1);
+  dset = H5Dopen2(file, "/h", H5P_DEFAULT);
+  REQUIRE(dset >= 0);
+  REQUIRE(H5Dread(dset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out.data()) >= 0);
+  REQUIRE(out == data);
+  H5Dclose(dset);
+  H5Fclose(file);
+  H5Sclose(space);
+  H5Pclose(fapl);
+  std::filesystem::remove_all(path);
+}
+
+TEST_CASE("pfs_vol replays the metadata log after an unclean close", "[pfs_vol]") {
+  const char *path = "test_pfs_vol_wal.h5";
+
+  hid_t fapl = PfsFapl("io=posix");
+  hid_t file = H5Fcreate(path, H5F_ACC_TRUNC, H5P_DEFAULT, fapl);
+  REQUIRE(file >= 0);
+  REQUIRE(H5Gclose(H5Gcreate2(file, "old", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) >= 0);
+  REQUIRE(H5Gclose(H5Gcreate2(file, "gone", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) >= 0);
+  REQUIRE(H5Fclose(file) >= 0);
+
+  /* A writer changes the tree, flushes and dies without closing, so only the log has the changes */
+  REQUIRE(InChild([&]() {
+    hid_t f = H5Fopen(path, H5F_ACC_RDWR, fapl);
+    if (f < 0) {
+      return false;
+    }
+    hid_t g = H5Gcreate2(f, "new", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+    if (g < 0) {
+      return false;
+    }
+    WriteIntAttr(g, "step", 17);
+    return H5Gclose(H5Gcreate2(g, "inner", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) >= 0 &&
+           H5Lcreate_soft("/new/inner", f, "alias", H5P_DEFAULT, H5P_DEFAULT) >= 0 &&
+           H5Ldelete(f, "gone", H5P_DEFAULT) >= 0 && H5Fflush(f, H5F_SCOPE_GLOBAL) >= 0;
+  }));
+  REQUIRE(std::filesystem::file_size(std::string(path) + "/.pfs_vol.wal") > 0);
+
+  /* Read-only and writable opens both replay the log */
+  for (unsigned flags : {H5F_ACC_RDONLY, H5F_ACC_RDWR, H5F_ACC_RDONLY}) {
+    file = H5Fopen(path, flags, fapl);
+    REQUIRE(file >= 0);
+    REQUIRE(LinkNames(file, "/") == std::vector<std::string>{"alias", "new", "old"});
+    REQUIRE(LinkNames(file, "/new") == std::vector<std::string>{"inner"});
+    REQUIRE(ReadIntAttr(file, "/new", "step") == 17);
+    REQUIRE(H5Lexists(file, "/alias", H5P_DEFAULT) > 0);
+    REQUIRE(H5Fclose(file) >= 0);
+  }
+  H5Pclose(fapl);
+  std::filesystem::remove_all(path);
+}
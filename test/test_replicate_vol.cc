@@ -0,0 +1,259 @@
+/*
+ * Round trips through replicate_vol over native replicas.
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <hdf5.h>
+#include <algorithm>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "H5VLreplicate_vol.h"
+
+namespace {
+
+/** A fapl routing files through replicate_vol with the given parameters */
+hid_t ReplicateFapl(const char *params) {
+  hid_t vol = H5VLregister_connector_by_name("replicate_vol", H5P_DEFAULT);
+  hid_t fapl = H5Pcreate(H5P_FILE_ACCESS);
+  void *info = nullptr;
+  REQUIRE(vol >= 0);
+  REQUIRE(H5VLconnector_str_to_info(params, vol, &info) >= 0);
+  REQUIRE(H5Pset_vol(fapl, vol, info) >= 0);
+  H5VLfree_connector_info(vol, info);
+  H5VLclose(vol);
+  return fapl;
+}
+
+/** Remove a replicated file and its replicas */
+void RemoveReplicas(const char *path, size_t nreplicas) {
+  remove(path);
+  for (size_t r = 1; r < nreplicas; ++r) {
+    remove((std::string(path) + ".r" + std::to_string(r)).c_str());
+  }
+}
+
+}  // namespace
+
+TEST_CASE("replicate_vol reports the health of every replica", "[replicate_vol]") {
+  const char *path = "test_replicate_vol_status.h5";
+  hsize_t dims[1] = {1024};
+  std::vector<int> data(dims[0], 7);
+
+  hid_t fapl = ReplicateFapl("quorum=2;native|native|native");
+  hid_t file = H5Fcreate(path, H5F_ACC_TRUNC, H5P_DEFAULT, fapl);
+  REQUIRE(file >= 0);
+  hid_t space = H5Screate_simple(1, dims, nullptr);
+  hid_t dset = H5Dcreate2(file, "data", H5T_NATIVE_INT, space, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+  REQUIRE(dset >= 0);
+  REQUIRE(H5Dwrite(dset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, data.data()) >= 0);
+  REQUIRE(H5Fflush(file, H5F_SCOPE_GLOBAL) >= 0);
+
+  /* Through the file and through an object in it */
+  for (hid_t obj : {file, dset}) {
+    H5VL_replicate_vol_status_t status[4];
+    size_t nreplicas = 4;
+    REQUIRE(H5VL_replicate_vol_get_status(obj, &nreplicas, status) >= 0);
+    REQUIRE(nreplicas == 3);
+    for (size_t r = 0; r < nreplicas; ++r) {
+      REQUIRE(status[r].healthy_);
+      REQUIRE(status[r].pending_ == 0);
+      REQUIRE(status[r].failed_ == 0);
+    }
+  }
+
+  /* A short array gets the first entries and the full count */
+  H5VL_replicate_vol_status_t first;
+  size_t nreplicas = 1;
+  REQUIRE(H5VL_replicate_vol_get_status(file, &nreplicas, &first) >= 0);
+  REQUIRE(nreplicas == 3);
+  REQUIRE(first.healthy_);
+  H5Dclose(dset);
+  H5Sclose(space);
+  H5Fclose(file);
+
+  /* A file not opened through the connector has no status */
+  file = H5Fopen(path, H5F_ACC_RDONLY, H5P_DEFAULT);
+  REQUIRE(file >= 0);
+  nreplicas = 1;
+  H5E_BEGIN_TRY {
+    REQUIRE(H5VL_replicate_vol_get_status(file, &nreplicas, &first) < 0);
+  } H5E_END_TRY;
+  H5Fclose(file);
+  H5Pclose(fapl);
+  RemoveReplicas(path, 3);
+}
+
+TEST_CASE("replicate_vol lands quorum writes on every replica", "[replicate_vol]") {
+  const char *path = "test_replicate_vol_quorum.h5";
+  hsize_t dims[2] = {64, 64};
+  std::vector<int> data(dims[0] * dims[1]), out(data.size(), -1);
+
+  for (const char *params : {"quorum=1;native|native|native", "quorum=2;native|native|native"}) {
+    hid_t fapl = ReplicateFapl(params);
+    hid_t file = H5Fcreate(path, H5F_ACC_TRUNC, H5P_DEFAULT, fapl);
+    REQUIRE(file >= 0);
+    hid_t space = H5Screate_simple(2, dims, nullptr);
+    hid_t dset = H5Dcreate2(file, "data", H5T_NATIVE_INT, space, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+    REQUIRE(dset >= 0);
+
+    /* Each write is visible to the next read, whichever replica serves it */
+    for (int round = 0; round < 4; ++round) {
+      for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = (int)i * (round + 1);
+      }
+      REQUIRE(H5Dwrite(dset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, data.data()) >= 0);
+      REQUIRE(H5Dread(dset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out.data()) >= 0);
+      REQUIRE(out == data);
+    }
+    H5Dclose(dset);
+    H5Sclose(space);
+    REQUIRE(H5Fclose(file) >= 0);
+
+    /* Closing waited for the replicas the quorum left behind */
+    for (size_t r = 0; r < 3; ++r) {
+      std::string name = r == 0 ? std::string(path) : std::string(path) + ".r" + std::to_string(r);
+      file = H5Fopen(name.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+      REQUIRE(file >= 0);
+      dset = H5Dopen2(file, "data", H5P_DEFAULT);
+      REQUIRE(dset >= 0);
+      std::fill(out.begin(), out.end(), -1);
+      REQUIRE(H5Dread(dset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out.data()) >= 0);
+      REQUIRE(out == data);
+      H5Dclose(dset);
+      H5Fclose(file);
+    }
+    H5Pclose(fapl);
+  }
+  RemoveReplicas(path, 3);
+}
+
+TEST_CASE("replicate_vol writes several datasets in one call to every replica", "[replicate_vol]") {
+  const char *path = "test_replicate_vol_multi.h5";
+  const char *names[3] = {"a", "b", "c"};
+  hsize_t dims[1] = {2048};
+  std::vector<std::vector<int>> data(3, std::vector<int>(dims[0]));
+  std::vector<int> out(dims[0]);
+  hid_t dsets[3], types[3], spaces[3];
+  const void *bufs[3];
+
+  hid_t fapl = ReplicateFapl("quorum=2;native|native|native");
+  hid_t file = H5Fcreate(path, H5F_ACC_TRUNC, H5P_DEFAULT, fapl);
+  REQUIRE(file >= 0);
+  hid_t space = H5Screate_simple(1, dims, nullptr);
+  for (size_t d = 0; d < 3; ++d) {
+    for (size_t i = 0; i < dims[0]; ++i) {
+      data[d][i] = (int)(d * dims[0] + i);
+    }
+    dsets[d] = H5Dcreate2(file, names[d], H5T_NATIVE_INT, space, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+    REQUIRE(dsets[d] >= 0);
+    types[d] = H5T_NATIVE_INT;
+    spaces[d] = H5S_ALL;
+    bufs[d] = data[d].data();
+  }
+  REQUIRE(H5Dwrite_multi(3, dsets, types, spaces, spaces, H5P_DEFAULT, bufs) >= 0);
+  for (size_t d = 0; d < 3; ++d) {
+    H5Dclose(dsets[d]);
+  }
+  H5Sclose(space);
+  REQUIRE(H5Fclose(file) >= 0);
+
+  for (size_t r = 0; r < 3; ++r) {
+    std::string name = r == 0 ? std::string(path) : std::string(path) + ".r" + std::to_string(r);
+    file = H5Fopen(name.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+    REQUIRE(file >= 0);
+    for (size_t d = 0; d < 3; ++d) {
+      hid_t dset = H5Dopen2(file, names[d], H5P_DEFAULT);
+      REQUIRE(dset >= 0);
+      REQUIRE(H5Dread(dset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out.data()) >= 0);
+      REQUIRE(out == data[d]);
+      H5Dclose(dset);
+    }
+    H5Fclose(file);
+  }
+  H5Pclose(fapl);
+  RemoveReplicas(path, 3);
+}
+
+TEST_CASE("replicate_vol splits large reads across replicas", "[replicate_vol]") {
+  const char *path = "test_replicate_vol_split.h5";
+  hsize_t dims[2] = {256, 256};
+  std::vector<int> data(dims[0] * dims[1]), out(data.size(), -1);
+
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = (int)i;
+  }
+  hid_t fapl = ReplicateFapl("read_split=4k;native|native|native");
+  hid_t file = H5Fcreate(path, H5F_ACC_TRUNC, H5P_DEFAULT, fapl);
+  REQUIRE(file >= 0);
+  hid_t space = H5Screate_simple(2, dims, nullptr);
+  hid_t dset = H5Dcreate2(file, "data", H5T_NATIVE_INT, space, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+  REQUIRE(dset >= 0);
+  REQUIRE(H5Dwrite(dset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, data.data()) >= 0);
+
+  /* The whole dataset, served in slabs by every replica */
+  REQUIRE(H5Dread(dset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out.data()) >= 0);
+  REQUIRE(out == data);
+  H5VL_replicate_vol_status_t status[3];
+  size_t nreplicas = 3;
+  REQUIRE(H5VL_replicate_vol_get_status(file, &nreplicas, status) >= 0);
+  for (size_t r = 0; r < nreplicas; ++r) {
+    REQUIRE((status[r].read_bandwidth_ > 0 || status[r].read_latency_ > 0));
+  }
+
+  /* A strided block scattered into a larger memory selection */
+  hsize_t start[2] = {3, 5}, stride[2] = {2, 3}, count[2] = {100, 60};
+  hsize_t mem_dims[2] = {count[0], count[1] + 4}, mem_start[2] = {0, 2};
+  std::vector<int> block(mem_dims[0] * mem_dims[1], -1);
+  hid_t mem = H5Screate_simple(2, mem_dims, nullptr);
+  REQUIRE(H5Sselect_hyperslab(space, H5S_SELECT_SET, start, stride, count, nullptr) >= 0);
+  REQUIRE(H5Sselect_hyperslab(mem, H5S_SELECT_SET, mem_start, nullptr, count, nullptr) >= 0);
+  REQUIRE(H5Dread(dset, H5T_NATIVE_INT, mem, space, H5P_DEFAULT, block.data()) >= 0);
+  for (hsize_t i = 0; i < count[0]; ++i) {
+    REQUIRE(block[i * mem_dims[1]] == -1);
+    for (hsize_t j = 0; j < count[1]; ++j) {
+      hsize_t row = start[0] + i * stride[0], col = start[1] + j * stride[1];
+      REQUIRE(block[i * mem_dims[1] + mem_start[1] + j] == data[row * dims[1] + col]);
+    }
+  }
+  H5Sclose(mem);
+  H5Dclose(dset);
+  H5Sclose(space);
+  H5Fclose(file);
+  H5Pclose(fapl);
+  RemoveReplicas(path, 3);
+}
+
+TEST_CASE("replicate_vol routes small reads to one current replica", "[replicate_vol]") {
+  const char *path = "test_replicate_vol_route.h5";
+  hsize_t dims[1] = {64};
+  std::vector<int> data(dims[0]), out(dims[0]);
+
+  hid_t fapl = ReplicateFapl("quorum=1;native|native");
+  hid_t file = H5Fcreate(path, H5F_ACC_TRUNC, H5P_DEFAULT, fapl);
+  REQUIRE(file >= 0);
+  hid_t space = H5Screate_simple(1, dims, nullptr);
+  hid_t dset = H5Dcreate2(file, "data", H5T_NATIVE_INT, space, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+  REQUIRE(dset >= 0);
+
+  /* Alternate writes and reads; each read sees the write before it */
+  for (int round = 0; round < 50; ++round) {
+    std::fill(data.begin(), data.end(), round);
+    REQUIRE(H5Dwrite(dset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, data.data()) >= 0);
+    REQUIRE(H5Dread(dset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out.data()) >= 0);
+    REQUIRE(out == data);
+  }
+
+  /* Small reads only feed the latency average of the replicas they used */
+  H5VL_replicate_vol_status_t status[2];
+  size_t nreplicas = 2;
+  REQUIRE(H5VL_replicate_vol_get_status(dset, &nreplicas, status) >= 0);
+  REQUIRE((status[0].read_latency_ > 0 || status[1].read_latency_ > 0));
+  REQUIRE(status[0].read_bandwidth_ == 0);
+  REQUIRE(status[1].read_bandwidth_ == 0);
+  H5Dclose(dset);
+  H5Sclose(space);
+  H5Fclose(file);
+  H5Pclose(fapl);
+  RemoveReplicas(path, 2);
+}
@@ -0,0 +1,75 @@
+/*
+ * Byte and bit shuffle pre-filters.
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "shuffle_helpers.h"
+
+namespace {
+
+std::vector<char> Random(size_t size) {
+  std::vector<char> data(size);
+  std::mt19937 rng(7);
+  for (char &c : data) {
+    c = (char)rng();
+  }
+  return data;
+}
+
+}  // namespace
+
+TEST_CASE("ByteShuffle gathers byte planes", "[shuffle_helpers]") {
+  uint32_t in[3] = {0x04030201, 0x08070605, 0x0C0B0A09};
+  char out[12];
+  const char expect[12] = {1, 5, 9, 2, 6, 10, 3, 7, 11, 4, 8, 12};
+  h5::ByteShuffle((const char *)in, out, sizeof(in), 4);
+  REQUIRE(std::vector<char>(out, out + 12) == std::vector<char>(expect, expect + 12));
+}
+
+TEST_CASE("ByteShuffle round-trips every element size and tail", "[shuffle_helpers]") {
+  /* Sizes cover the vectorized blocks of 16 elements, the scalar rest and partial elements */
+  for (size_t elmt_size : {1, 2, 3, 4, 8, 16}) {
+    for (size_t size : {0, 7, 64, 100, 1000, 4099}) {
+      std::vector<char> in = Random(size), mid(size), out(size);
+      h5::ByteShuffle(in.data(), mid.data(), size, elmt_size);
+      h5::ByteUnshuffle(mid.data(), out.data(), size, elmt_size);
+      REQUIRE(out == in);
+    }
+  }
+}
+
+TEST_CASE("BitTranspose splits bytes into bit planes", "[shuffle_helpers]") {
+  std::vector<char> in = Random(256);
+  std::vector<uint8_t> planes(256), back(256);
+  h5::BitTranspose((const uint8_t *)in.data(), planes.data(), 256);
+  for (size_t i = 0; i < 256; ++i) {
+    for (size_t t = 0; t < 8; ++t) {
+      int bit = ((uint8_t)in[i] >> (7 - t)) & 1;
+      REQUIRE(((planes[t * 32 + i / 8] >> (i % 8)) & 1) == bit);
+    }
+  }
+  h5::BitUntranspose(planes.data(), back.data(), 256);
+  REQUIRE(std::vector<char>(back.begin(), back.end()) == in);
+}
+
+TEST_CASE("BitShuffle round-trips every element size and tail", "[shuffle_helpers]") {
+  for (size_t elmt_size : {1, 2, 4, 8}) {
+    for (size_t size : {0, 5, 64, 100, 1000, 4099}) {
+      std::vector<char> in = Random(size), mid(size), out(size);
+      h5::BitShuffle(in.data(), mid.data(), size, elmt_size);
+      h5::BitUnshuffle(mid.data(), out.data(), size, elmt_size);
+      REQUIRE(out == in);
+    }
+  }
+}
+
+TEST_CASE("ParseShuffle maps connector names", "[shuffle_helpers]") {
+  REQUIRE(h5::ParseShuffle("none") == h5::kShuffleNone);
+  REQUIRE(h5::ParseShuffle("byte") == h5::kShuffleByte);
+  REQUIRE(h5::ParseShuffle("bit") == h5::kShuffleBit);
+  REQUIRE(h5::ParseShuffle("auto") == h5::kShuffleAuto);
+  REQUIRE(h5::ParseShuffle("bytes") == -1);
+}